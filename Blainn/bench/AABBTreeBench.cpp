@@ -0,0 +1,204 @@
+#include "pch.h"
+
+#include "Scene/AABBTree.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+using namespace Blainn;
+
+namespace
+{
+	// Proxies are unit boxes at one proxy per 4x4x4 cell whatever their count, so
+	// every size sees the same overlap and only the depth of the tree grows
+	constexpr float CellSize = 4.f;
+	constexpr float ProxyExtent = 0.5f;
+
+	float WorldSize(uint32_t proxyCount)
+	{
+		return std::cbrt(float(proxyCount)) * CellSize;
+	}
+
+	std::vector<XMFLOAT3> RandomPositions(uint32_t count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(0.f, WorldSize(count));
+		std::vector<XMFLOAT3> positions(count);
+		for (XMFLOAT3& p : positions)
+			p = { position(random), position(random), position(random) };
+		return positions;
+	}
+
+	AABB ProxyBox(const XMFLOAT3& center)
+	{
+		return AABB::FromCenterExtents(center, { ProxyExtent, ProxyExtent, ProxyExtent });
+	}
+
+	void FillTree(AABBTree& tree, const std::vector<XMFLOAT3>& positions, std::vector<int32_t>& proxies)
+	{
+		proxies.resize(positions.size());
+		for (size_t i = 0; i < positions.size(); ++i)
+			proxies[i] = tree.CreateProxy(ProxyBox(positions[i]), EntityHandle{});
+	}
+}
+
+// Proxies inserted per second building a tree from nothing
+static void BM_AABBTreeInsert(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	std::mt19937 random(42);
+	std::vector<XMFLOAT3> positions = RandomPositions(count, random);
+	std::vector<int32_t> proxies;
+
+	for (auto _ : state)
+	{
+		AABBTree tree;
+		FillTree(tree, positions, proxies);
+		benchmark::DoNotOptimize(tree.GetHeight());
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AABBTreeInsert)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Proxies moved per second, every proxy moving a step a frame the way the scene
+// moves colliders. Steps are a quarter of the margin, so a proxy leaves its fat
+// AABB and is reinserted every few frames.
+static void BM_AABBTreeMove(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	const float worldSize = WorldSize(count);
+	std::mt19937 random(42);
+	std::vector<XMFLOAT3> positions = RandomPositions(count, random);
+
+	std::uniform_real_distribution<float> direction(-1.f, 1.f);
+	std::vector<XMFLOAT3> velocities(count);
+	for (XMFLOAT3& v : velocities)
+	{
+		XMVECTOR d = XMVector3Normalize(XMVectorSet(direction(random), direction(random), direction(random), 0.f));
+		XMStoreFloat3(&v, XMVectorScale(d, 0.025f));
+	}
+
+	AABBTree tree;
+	std::vector<int32_t> proxies;
+	FillTree(tree, positions, proxies);
+
+	auto step = [&]()
+	{
+		int64_t reinserted = 0;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			XMFLOAT3& p = positions[i];
+			XMFLOAT3& v = velocities[i];
+			p.x += v.x;
+			p.y += v.y;
+			p.z += v.z;
+			// bounce off the walls so the density stays put
+			if (p.x < 0.f || p.x > worldSize) v.x = -v.x;
+			if (p.y < 0.f || p.y > worldSize) v.y = -v.y;
+			if (p.z < 0.f || p.z > worldSize) v.z = -v.z;
+
+			reinserted += tree.MoveProxy(proxies[i], ProxyBox(p), v);
+		}
+		return reinserted;
+	};
+	// no proxy leaves its fat AABB in the first frames after it was created, run
+	// until reinsertions settle so short runs of the big trees measure them too
+	for (int frame = 0; frame < 16; ++frame)
+		step();
+
+	int64_t reinserted = 0;
+	for (auto _ : state)
+		reinserted += step();
+	state.SetItemsProcessed(state.iterations() * count);
+	state.counters["Reinserted"] = benchmark::Counter(double(reinserted), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_AABBTreeMove)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// AABB queries per second, each a box a few cells across
+static void BM_AABBTreeQuery(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	constexpr uint32_t QueryCount = 4096;
+	std::mt19937 random(42);
+	std::vector<XMFLOAT3> positions = RandomPositions(count, random);
+	std::vector<XMFLOAT3> queries = RandomPositions(QueryCount, random);
+	const float scale = WorldSize(count) / WorldSize(QueryCount);
+
+	AABBTree tree;
+	std::vector<int32_t> proxies;
+	FillTree(tree, positions, proxies);
+
+	int64_t hits = 0;
+	for (auto _ : state)
+	{
+		for (const XMFLOAT3& q : queries)
+		{
+			AABB box = AABB::FromCenterExtents({ q.x * scale, q.y * scale, q.z * scale }, { CellSize, CellSize, CellSize });
+			tree.QueryAABB(box, [&](int32_t)
+				{
+					++hits;
+					return true;
+				});
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * QueryCount);
+	state.counters["Hits"] = benchmark::Counter(double(hits) / QueryCount, benchmark::Counter::kAvgIterations);
+	state.counters["Height"] = double(tree.GetHeight());
+	state.counters["AreaRatio"] = double(tree.GetAreaRatio());
+}
+BENCHMARK(BM_AABBTreeQuery)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+// Rays per second through RayCastBatch, closest hit, each ray crossing the world
+static void BM_AABBTreeRayCast(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	constexpr uint32_t RayCount = 1024;
+	const float worldSize = WorldSize(count);
+	std::mt19937 random(42);
+	std::vector<XMFLOAT3> positions = RandomPositions(count, random);
+
+	AABBTree tree;
+	std::vector<int32_t> proxies;
+	FillTree(tree, positions, proxies);
+
+	std::vector<XMFLOAT3> origins = RandomPositions(RayCount, random);
+	std::vector<XMFLOAT3> targets = RandomPositions(RayCount, random);
+	const float scale = worldSize / WorldSize(RayCount);
+	std::vector<AABBTreeRay> rays(RayCount);
+	for (uint32_t i = 0; i < RayCount; ++i)
+	{
+		rays[i].Origin = { origins[i].x * scale, origins[i].y * scale, origins[i].z * scale };
+		rays[i].Direction = {
+			targets[i].x * scale - rays[i].Origin.x,
+			targets[i].y * scale - rays[i].Origin.y,
+			targets[i].z * scale - rays[i].Origin.z };
+		rays[i].MaxDistance = 1.f;
+	}
+
+	std::vector<float> closest(RayCount);
+	for (auto _ : state)
+	{
+		tree.RayCastBatch(rays.data(), RayCount, [&](uint32_t rayIndex, const AABBTreeRay& ray, int32_t proxyId)
+			{
+				// the fat AABB stands in for the collider, the tree is what is measured
+				XMFLOAT3 center;
+				const AABB& box = tree.GetFatAABB(proxyId);
+				center.x = (box.Min.x + box.Max.x) * 0.5f;
+				center.y = (box.Min.y + box.Max.y) * 0.5f;
+				center.z = (box.Min.z + box.Max.z) * 0.5f;
+				XMVECTOR toCenter = XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat3(&ray.Origin));
+				XMVECTOR direction = XMLoadFloat3(&ray.Direction);
+				float t = XMVectorGetX(XMVector3Dot(toCenter, direction)) / XMVectorGetX(XMVector3LengthSq(direction));
+				if (t <= 0.f || t >= ray.MaxDistance)
+					return -1.f;
+				closest[rayIndex] = t;
+				return t;
+			});
+		benchmark::DoNotOptimize(closest.data());
+	}
+	state.SetItemsProcessed(state.iterations() * RayCount);
+}
+BENCHMARK(BM_AABBTreeRayCast)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
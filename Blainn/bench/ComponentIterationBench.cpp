@@ -0,0 +1,103 @@
+#include "pch.h"
+
+#include "Components/Component.h"
+#include "Core/GameObject.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	template<uint32_t N>
+	class BenchComponent : public Component<BenchComponent<N>>
+	{
+	public:
+		BenchComponent(std::shared_ptr<GameObject> owner)
+			: Component<BenchComponent<N>>(owner)
+		{}
+
+		float Value = float(N);
+		uint8_t Payload[16 + 64 * N] = {};
+	};
+
+	// What the render and system passes walk, the others are allocated in between
+	using IteratedComponent = BenchComponent<1>;
+
+	constexpr uint32_t ActorCount = 50000;
+
+	struct Actors
+	{
+		std::vector<std::shared_ptr<GameObject>> Objects;
+		std::vector<std::shared_ptr<ComponentBase>> Components;
+		std::vector<std::string> Names;
+		ComponentManager Manager;
+	};
+
+	template<typename T>
+	std::shared_ptr<T> MakeBenchComponent(std::shared_ptr<GameObject> owner, bool bPooled)
+	{
+		return bPooled ? ComponentManager::MakeComponent<T>(owner) : std::make_shared<T>(owner);
+	}
+
+	// Actors spawned the way a level streams them in, every actor with a few other
+	// components and a name allocated between its components. A third of them is
+	// respawned in shuffled order afterwards, like actors destroyed and spawned
+	// during play.
+	void SpawnActors(Actors& actors, bool bPooled)
+	{
+		actors.Objects.resize(ActorCount);
+		std::vector<std::shared_ptr<IteratedComponent>> iterated(ActorCount);
+		auto spawn = [&actors, &iterated, bPooled](uint32_t i)
+		{
+			actors.Objects[i] = std::make_shared<GameObject>();
+			actors.Components.push_back(MakeBenchComponent<BenchComponent<0>>(actors.Objects[i], bPooled));
+			iterated[i] = MakeBenchComponent<IteratedComponent>(actors.Objects[i], bPooled);
+			actors.Names.push_back("Actor" + std::to_string(i) + std::string(24, '_'));
+			actors.Components.push_back(MakeBenchComponent<BenchComponent<2>>(actors.Objects[i], bPooled));
+		};
+
+		for (uint32_t i = 0; i < ActorCount; ++i)
+			spawn(i);
+
+		std::vector<uint32_t> respawned;
+		for (uint32_t i = 0; i < ActorCount; i += 3)
+			respawned.push_back(i);
+		std::shuffle(respawned.begin(), respawned.end(), std::mt19937(42));
+		for (uint32_t i : respawned)
+			iterated[i].reset();
+		for (uint32_t i : respawned)
+			spawn(i);
+
+		// registered in spawn order, as the scene places them
+		for (auto& component : iterated)
+			actors.Manager.RegisterComponent(component);
+	}
+}
+
+// Passes per second over the 50k components of one type, reading a field of each
+// the way the render and system passes do. Arg 0 allocates every component on its
+// own with make_shared, 1 from the per-type pools ComponentManager::MakeComponent
+// uses.
+static void BM_IterateComponents(benchmark::State& state)
+{
+	Actors actors;
+	SpawnActors(actors, state.range(0) != 0);
+
+	const auto& components = actors.Manager.GetComponents<IteratedComponent>();
+	for (auto _ : state)
+	{
+		float sum = 0.f;
+		for (const auto& component : components)
+			sum += component->Value;
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * components.size());
+}
+BENCHMARK(BM_IterateComponents)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,132 @@
+#include "pch.h"
+
+#include "Components/Component.h"
+#include "Core/GameObject.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	template<uint32_t N>
+	class BenchComponent : public Component<BenchComponent<N>>
+	{
+	public:
+		BenchComponent(std::shared_ptr<GameObject> owner)
+			: Component<BenchComponent<N>>(owner)
+		{}
+
+		uint32_t Value = N;
+	};
+
+	// Never attached, looked up to measure a miss
+	using MissingComponent = BenchComponent<31>;
+
+	constexpr uint32_t ObjectCount = 4096;
+
+	template<uint32_t... N>
+	void AddComponents(GameObject& object, std::integer_sequence<uint32_t, N...>)
+	{
+		(object.AddComponent<BenchComponent<N>>(), ...);
+	}
+
+	// Objects with Count components each, BenchComponent<0> up to
+	// BenchComponent<Count - 1> in that order
+	template<uint32_t Count>
+	std::vector<std::shared_ptr<GameObject>> MakeObjects()
+	{
+		std::vector<std::shared_ptr<GameObject>> objects(ObjectCount);
+		for (auto& object : objects)
+		{
+			object = std::make_shared<GameObject>();
+			AddComponents(*object, std::make_integer_sequence<uint32_t, Count>());
+		}
+		return objects;
+	}
+
+	// The lookup GetComponent replaced, a dynamic_cast over every component
+	template<typename T>
+	T* ScanForComponent(const GameObject& object)
+	{
+		for (const auto& comp : object.GetComponents())
+			if (T* castedComp = dynamic_cast<T*>(comp.get()))
+				return castedComp;
+		return nullptr;
+	}
+
+	void DestroyObjects(std::vector<std::shared_ptr<GameObject>>& objects)
+	{
+		for (auto& object : objects)
+			object->RemoveAllComponents<ComponentBase>();
+	}
+}
+
+// Lookups per second of the first component added, the last one added and one
+// that is not there, once per object. The template argument is the components on
+// every object.
+template<uint32_t Count>
+static void BM_GetComponent(benchmark::State& state)
+{
+	std::vector<std::shared_ptr<GameObject>> objects = MakeObjects<Count>();
+	for (auto _ : state)
+	{
+		for (const auto& object : objects)
+		{
+			benchmark::DoNotOptimize(object->GetComponent<BenchComponent<0>>());
+			benchmark::DoNotOptimize(object->GetComponent<BenchComponent<Count - 1>>());
+			benchmark::DoNotOptimize(object->GetComponent<MissingComponent>());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * ObjectCount * 3);
+	DestroyObjects(objects);
+}
+BENCHMARK_TEMPLATE(BM_GetComponent, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_GetComponent, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_GetComponent, 16)->Unit(benchmark::kMicrosecond);
+
+// Same lookups without the reference count, what per-frame passes use
+template<uint32_t Count>
+static void BM_GetComponentPtr(benchmark::State& state)
+{
+	std::vector<std::shared_ptr<GameObject>> objects = MakeObjects<Count>();
+	for (auto _ : state)
+	{
+		for (const auto& object : objects)
+		{
+			benchmark::DoNotOptimize(object->GetComponentPtr<BenchComponent<0>>());
+			benchmark::DoNotOptimize(object->GetComponentPtr<BenchComponent<Count - 1>>());
+			benchmark::DoNotOptimize(object->GetComponentPtr<MissingComponent>());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * ObjectCount * 3);
+	DestroyObjects(objects);
+}
+BENCHMARK_TEMPLATE(BM_GetComponentPtr, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_GetComponentPtr, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_GetComponentPtr, 16)->Unit(benchmark::kMicrosecond);
+
+// Same lookups through a dynamic_cast scan, for comparison
+template<uint32_t Count>
+static void BM_ScanForComponent(benchmark::State& state)
+{
+	std::vector<std::shared_ptr<GameObject>> objects = MakeObjects<Count>();
+	for (auto _ : state)
+	{
+		for (const auto& object : objects)
+		{
+			benchmark::DoNotOptimize(ScanForComponent<BenchComponent<0>>(*object));
+			benchmark::DoNotOptimize(ScanForComponent<BenchComponent<Count - 1>>(*object));
+			benchmark::DoNotOptimize(ScanForComponent<MissingComponent>(*object));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * ObjectCount * 3);
+	DestroyObjects(objects);
+}
+BENCHMARK_TEMPLATE(BM_ScanForComponent, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_ScanForComponent, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_ScanForComponent, 16)->Unit(benchmark::kMicrosecond);
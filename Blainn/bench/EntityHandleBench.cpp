@@ -0,0 +1,164 @@
+#include "pch.h"
+
+#include "Core/EntityRegistry.h"
+#include "Core/GameObject.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	// Shared by the threads of a benchmark, made and released by thread 0 around
+	// the timed loop
+	std::vector<std::shared_ptr<GameObject>> s_Objects;
+	std::vector<std::weak_ptr<GameObject>> s_WeakObjects;
+	std::vector<EntityHandle> s_Handles;
+
+	void MakeObjects(uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			s_Objects.push_back(std::make_shared<GameObject>());
+			s_WeakObjects.push_back(s_Objects.back());
+			s_Handles.push_back(s_Objects.back()->GetHandle());
+		}
+	}
+
+	void ReleaseObjects()
+	{
+		s_Handles.clear();
+		s_WeakObjects.clear();
+		s_Objects.clear();
+	}
+
+	// The owners the per-frame passes resolve for Katamari's instanced cube grid, in
+	// pass order: every mesh owner for the instance data, every collider's owner for
+	// the collision bounds, then the owners of the point lights. The grid is 26 x 26
+	// cubes with a mesh and a collider each, every cube in a column where
+	// j % 10 == 0 also carries a point light.
+	struct KatamariGrid
+	{
+		std::vector<std::shared_ptr<GameObject>> Cubes;
+		std::vector<std::weak_ptr<GameObject>> WeakOwners;
+		std::vector<EntityHandle> OwnerHandles;
+	};
+
+	KatamariGrid MakeKatamariGrid()
+	{
+		KatamariGrid grid;
+		std::vector<uint8_t> hasLight;
+		for (int i = -50; i <= 50; i += 4)
+		{
+			for (int j = -50; j <= 50; j += 4)
+			{
+				grid.Cubes.push_back(std::make_shared<GameObject>());
+				hasLight.push_back(j % 10 == 0);
+			}
+		}
+
+		auto addOwner = [&grid](const std::shared_ptr<GameObject>& cube)
+		{
+			grid.WeakOwners.push_back(cube);
+			grid.OwnerHandles.push_back(cube->GetHandle());
+		};
+		for (const auto& cube : grid.Cubes)
+			addOwner(cube);
+		for (const auto& cube : grid.Cubes)
+			addOwner(cube);
+		for (size_t i = 0; i < grid.Cubes.size(); ++i)
+			if (hasLight[i])
+				addOwner(grid.Cubes[i]);
+		return grid;
+	}
+}
+
+// Objects reached per second through weak_ptr::lock, the way passes reached their
+// owners before handles. Every lock and release is an atomic read-modify-write on
+// the object's control block, which the threads share. Arg is the objects.
+static void BM_ResolveWeakPtr(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	if (state.thread_index() == 0)
+		MakeObjects(count);
+
+	for (auto _ : state)
+	{
+		for (const std::weak_ptr<GameObject>& weak : s_WeakObjects)
+		{
+			if (std::shared_ptr<GameObject> object = weak.lock())
+				benchmark::DoNotOptimize(object->GetHandle());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+
+	if (state.thread_index() == 0)
+		ReleaseObjects();
+}
+BENCHMARK(BM_ResolveWeakPtr)->Arg(10000)->Arg(100000)->ThreadRange(1, 4)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// Same objects through EntityRegistry::Resolve, an index and a generation compare
+// with nothing written
+static void BM_ResolveHandle(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	if (state.thread_index() == 0)
+		MakeObjects(count);
+
+	const EntityRegistry& registry = EntityRegistry::Get();
+	for (auto _ : state)
+	{
+		for (EntityHandle handle : s_Handles)
+		{
+			if (GameObject* object = registry.Resolve(handle))
+				benchmark::DoNotOptimize(object->GetHandle());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+
+	if (state.thread_index() == 0)
+		ReleaseObjects();
+}
+BENCHMARK(BM_ResolveHandle)->Arg(10000)->Arg(100000)->ThreadRange(1, 4)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// Frames per second of the owner lookups one Katamari frame does over the cube
+// grid. Arg 0 locks weak_ptr like the passes did before handles, every lock and
+// release an atomic read-modify-write on the control block. Arg 1 resolves handles
+// through the registry without writing anything. AtomicsPerFrame counts the atomic
+// operations of a frame.
+static void BM_KatamariGridFrame(benchmark::State& state)
+{
+	const bool bHandles = state.range(0) != 0;
+	KatamariGrid grid = MakeKatamariGrid();
+	const EntityRegistry& registry = EntityRegistry::Get();
+
+	for (auto _ : state)
+	{
+		if (bHandles)
+		{
+			for (EntityHandle handle : grid.OwnerHandles)
+			{
+				if (GameObject* owner = registry.Resolve(handle))
+					benchmark::DoNotOptimize(owner->GetHandle());
+			}
+		}
+		else
+		{
+			for (const std::weak_ptr<GameObject>& weak : grid.WeakOwners)
+			{
+				if (std::shared_ptr<GameObject> owner = weak.lock())
+					benchmark::DoNotOptimize(owner->GetHandle());
+			}
+		}
+	}
+
+	const uint32_t resolves = uint32_t(grid.OwnerHandles.size());
+	state.SetItemsProcessed(state.iterations() * resolves);
+	state.counters["Cubes"] = double(grid.Cubes.size());
+	state.counters["ResolvesPerFrame"] = double(resolves);
+	state.counters["AtomicsPerFrame"] = bHandles ? 0.0 : 2.0 * resolves;
+}
+BENCHMARK(BM_KatamariGridFrame)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,136 @@
+#include "pch.h"
+
+#include "Render/FrameGraph.h"
+#include "Render/NullFrameGraphBackend.h"
+
+#include <benchmark/benchmark.h>
+
+#include <stdexcept>
+
+using namespace Blainn;
+
+namespace
+{
+	constexpr uint32_t CascadeCount = 4;
+
+	// The deferred frame of the rendering backends, cascades, G-buffer, lighting and
+	// present, with a chain of post process passes between lighting and present.
+	// Post process targets alternate between full and half resolution, so the chain
+	// only needs a few of them alive at a time and the rest alias their memory.
+	void BuildDeferredGraph(FrameGraph& graph, uint32_t postPasses)
+	{
+		graph.Reset();
+
+		const FrameGraphTextureDesc shadowDesc = { 2048, 2048, 1, FrameGraphFormat::D32 };
+		const FrameGraphTextureDesc colorDesc = { 1600, 900, 1, FrameGraphFormat::RGBA8 };
+		const FrameGraphTextureDesc packedDesc = { 1600, 900, 1, FrameGraphFormat::RGB10A2 };
+		const FrameGraphTextureDesc depthDesc = { 1600, 900, 1, FrameGraphFormat::D32 };
+		const FrameGraphTextureDesc hdrDesc = { 1600, 900, 1, FrameGraphFormat::RGBA16F };
+		const FrameGraphTextureDesc halfDesc = { 800, 450, 1, FrameGraphFormat::RGBA16F };
+
+		FrameGraphResource gBuffer[] = {
+			graph.CreateTexture("AlbedoOpacity", colorDesc),
+			graph.CreateTexture("NormalSpec", packedDesc),
+			graph.CreateTexture("Reflectance", colorDesc),
+			graph.CreateTexture("EmissiveAmbient", packedDesc),
+		};
+		FrameGraphResource gBufferDepth = graph.CreateTexture("GBufferDepth", depthDesc);
+		FrameGraphResource color = graph.CreateTexture("Color", hdrDesc);
+		FrameGraphResource backBuffer = graph.ImportTexture("BackBuffer", colorDesc, RS_Present, RS_Present);
+
+		FrameGraphResource cascades[CascadeCount];
+		for (FrameGraphResource& cascade : cascades)
+			cascade = graph.CreateTexture("Cascade", shadowDesc);
+
+		uint32_t shadows = graph.AddPass("CascadeShadowMaps", []() {});
+		for (FrameGraphResource cascade : cascades)
+			graph.Write(shadows, cascade, RS_DepthWrite);
+
+		uint32_t geometry = graph.AddPass("Geometry", []() {});
+		for (FrameGraphResource texture : gBuffer)
+			graph.Write(geometry, texture, RS_RenderTarget);
+		graph.Write(geometry, gBufferDepth, RS_DepthWrite);
+
+		uint32_t directionalLights = graph.AddPass("DirectionalLights", []() {});
+		for (FrameGraphResource texture : gBuffer)
+			graph.Read(directionalLights, texture, RS_ShaderRead);
+		graph.Read(directionalLights, gBufferDepth, RS_ShaderRead);
+		for (FrameGraphResource cascade : cascades)
+			graph.Read(directionalLights, cascade, RS_ShaderRead);
+		graph.Write(directionalLights, color, RS_RenderTarget);
+
+		uint32_t pointLights = graph.AddPass("PointLights", []() {});
+		for (FrameGraphResource texture : gBuffer)
+			graph.Read(pointLights, texture, RS_ShaderRead);
+		graph.Read(pointLights, gBufferDepth, RS_ShaderRead);
+		graph.Write(pointLights, color, RS_RenderTarget);
+
+		// nothing reads it, Compile culls it
+		uint32_t debugBuffers = graph.AddPass("DebugBuffers", []() {});
+		graph.Read(debugBuffers, gBuffer[0], RS_ShaderRead);
+		graph.Write(debugBuffers, graph.CreateTexture("Debug", colorDesc), RS_RenderTarget);
+
+		FrameGraphResource last = color;
+		for (uint32_t i = 0; i < postPasses; ++i)
+		{
+			FrameGraphResource target = graph.CreateTexture("PostProcess", i % 2 ? hdrDesc : halfDesc);
+			uint32_t post = graph.AddPass("PostProcess", []() {});
+			graph.Read(post, last, RS_ShaderRead);
+			graph.Read(post, gBufferDepth, RS_ShaderRead);
+			graph.Write(post, target, RS_RenderTarget);
+			last = target;
+		}
+
+		uint32_t present = graph.AddPass("Present", []() {});
+		graph.Read(present, last, RS_CopySource);
+		graph.Write(present, backBuffer, RS_CopyDest);
+
+		if (!graph.Compile())
+			throw std::runtime_error("The frame graph's passes depend on each other in a cycle");
+	}
+}
+
+// Graphs built and compiled per second, the frame graph work every frame does
+// before a pass runs. Arg is the number of post process passes.
+static void BM_FrameGraphCompile(benchmark::State& state)
+{
+	const uint32_t postPasses = uint32_t(state.range(0));
+	FrameGraph graph;
+	for (auto _ : state)
+	{
+		BuildDeferredGraph(graph, postPasses);
+		benchmark::DoNotOptimize(graph.GetExecutionOrder().data());
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	const FrameGraphStats& stats = graph.GetStats();
+	state.counters["Passes"] = double(stats.Passes);
+	state.counters["Culled"] = double(stats.CulledPasses);
+	state.counters["Transitions"] = double(stats.Transitions);
+}
+BENCHMARK(BM_FrameGraphCompile)->Arg(0)->Arg(8)->Arg(64)->Arg(256)->Unit(benchmark::kMicrosecond);
+
+// Frames per second through build, compile and execute on the null backend, with
+// what aliasing saves: transient memory without aliasing and the heap it fits in
+static void BM_FrameGraphAliasing(benchmark::State& state)
+{
+	const uint32_t postPasses = uint32_t(state.range(0));
+	FrameGraph graph;
+	NullFrameGraphBackend backend;
+	for (auto _ : state)
+	{
+		BuildDeferredGraph(graph, postPasses);
+		graph.Execute(&backend);
+		benchmark::DoNotOptimize(backend.GetCommands().data());
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	const FrameGraphStats& stats = graph.GetStats();
+	const NullGraphStats& backendStats = backend.GetStats();
+	state.counters["Transients"] = double(stats.Transients);
+	state.counters["TransientMB"] = double(stats.TransientBytes) / (1024.0 * 1024.0);
+	state.counters["HeapMB"] = double(stats.HeapBytes) / (1024.0 * 1024.0);
+	state.counters["AliasingBarriers"] = double(stats.AliasingBarriers);
+	state.counters["StateMismatches"] = double(backendStats.StateMismatches);
+}
+BENCHMARK(BM_FrameGraphAliasing)->Arg(0)->Arg(8)->Arg(64)->Arg(256)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,186 @@
+#include "Core/JobSystem.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	JobSystemDesc MakeDesc(uint32_t numWorkers)
+	{
+		JobSystemDesc desc;
+		desc.NumWorkers = numWorkers;
+		return desc;
+	}
+
+	uint32_t HardwareThreads()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Concurrency 1 means the calling thread alone, the job system needs one worker at least
+	// so it is measured as a plain loop
+	void ConcurrencyArgs(benchmark::internal::Benchmark* bench)
+	{
+		for (uint32_t threads = 1; threads <= HardwareThreads(); threads *= 2)
+			bench->Arg(threads);
+		if ((HardwareThreads() & (HardwareThreads() - 1)) != 0)
+			bench->Arg(HardwareThreads());
+	}
+
+	float Work(uint32_t i)
+	{
+		float x = float(i);
+		for (int k = 0; k < 16; ++k)
+			x = std::sqrt(x * 1.0001f + 1.0f);
+		return x;
+	}
+}
+
+// Cost of schedule + run + counter for a job that does nothing
+static void BM_EmptyJob(benchmark::State& state)
+{
+	JobSystem jobs(MakeDesc(uint32_t(state.range(0))));
+	constexpr uint32_t Batch = 1024;
+
+	for (auto _ : state)
+	{
+		JobCounter counter;
+		for (uint32_t i = 0; i < Batch; ++i)
+			jobs.Schedule([]() {}, &counter);
+		jobs.Wait(counter);
+	}
+	state.SetItemsProcessed(state.iterations() * Batch);
+}
+BENCHMARK(BM_EmptyJob)->Arg(1)->Arg(3)->Arg(7)->UseRealTime();
+
+static void BM_ParallelForScaling(benchmark::State& state)
+{
+	const uint32_t threads = uint32_t(state.range(0));
+	constexpr uint32_t Count = 1 << 18;
+	std::vector<float> out(Count);
+
+	std::unique_ptr<JobSystem> jobs;
+	if (threads > 1)
+		jobs = std::make_unique<JobSystem>(MakeDesc(threads - 1));
+
+	for (auto _ : state)
+	{
+		auto body = [&out](uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+					out[i] = Work(i);
+			};
+
+		if (jobs)
+			jobs->ParallelFor(0, Count, 1024, body);
+		else
+			body(0, Count);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * Count);
+	state.counters["threads"] = double(threads);
+}
+BENCHMARK(BM_ParallelForScaling)->Apply(ConcurrencyArgs)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_ParallelForGrain(benchmark::State& state)
+{
+	JobSystem jobs;
+	const uint32_t grain = uint32_t(state.range(0));
+	constexpr uint32_t Count = 1 << 16;
+	std::vector<float> out(Count);
+
+	for (auto _ : state)
+	{
+		jobs.ParallelFor(0, Count, grain, [&out](uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+					out[i] = float(i) * 0.5f;
+			});
+		benchmark::DoNotOptimize(out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * Count);
+}
+BENCHMARK(BM_ParallelForGrain)->RangeMultiplier(8)->Range(8, 8 << 12)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_NestedParallelFor(benchmark::State& state)
+{
+	JobSystem jobs;
+	const uint32_t outer = uint32_t(state.range(0));
+	constexpr uint32_t Total = 1 << 16;
+	const uint32_t inner = Total / outer;
+	std::vector<float> out(Total);
+
+	for (auto _ : state)
+	{
+		jobs.ParallelFor(0, outer, 1, [&](uint32_t outerBegin, uint32_t outerEnd)
+			{
+				for (uint32_t o = outerBegin; o < outerEnd; ++o)
+				{
+					jobs.ParallelFor(0, inner, 256, [&, o](uint32_t innerBegin, uint32_t innerEnd)
+						{
+							for (uint32_t i = innerBegin; i < innerEnd; ++i)
+								out[o * inner + i] = Work(i);
+						});
+				}
+			});
+		benchmark::DoNotOptimize(out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * Total);
+}
+BENCHMARK(BM_NestedParallelFor)->Arg(4)->Arg(16)->Arg(64)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// A serial chain of dependent jobs, measures the continuation hand-off latency
+static void BM_DependentChain(benchmark::State& state)
+{
+	JobSystem jobs;
+	const uint32_t length = uint32_t(state.range(0));
+	std::vector<std::unique_ptr<JobCounter>> counters(length);
+
+	for (auto _ : state)
+	{
+		for (auto& counter : counters)
+			counter = std::make_unique<JobCounter>();
+
+		jobs.Schedule([]() {}, counters[0].get());
+		for (uint32_t i = 1; i < length; ++i)
+			jobs.ScheduleAfter(*counters[i - 1], []() {}, counters[i].get());
+		jobs.Wait(*counters.back());
+	}
+	state.SetItemsProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_DependentChain)->Arg(16)->Arg(256)->Arg(4096)->UseRealTime();
+
+// Wide fan-out joined by continuations, the shape of a frame's job graph
+static void BM_FanOutFanIn(benchmark::State& state)
+{
+	JobSystem jobs;
+	const uint32_t width = uint32_t(state.range(0));
+	std::vector<float> out(width);
+
+	for (auto _ : state)
+	{
+		JobCounter producers;
+		for (uint32_t i = 0; i < width; ++i)
+			jobs.Schedule([&out, i]() { out[i] = Work(i); }, &producers);
+
+		float sum = 0.0f;
+		JobCounter consumer;
+		jobs.ScheduleAfter(producers, [&out, &sum]()
+			{
+				for (float value : out)
+					sum += value;
+			}, &consumer);
+		jobs.Wait(consumer);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * width);
+}
+BENCHMARK(BM_FanOutFanIn)->Arg(64)->Arg(1024)->UseRealTime();
@@ -0,0 +1,65 @@
+#include "pch.h"
+
+#include "Core/JobSystem.h"
+#include "Render/LightClusters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+using namespace Blainn;
+
+namespace
+{
+	// Point lights over a street level block in front of a camera at the origin
+	// looking down -Z, some of them behind it or past the sides of the frustum
+	std::vector<XMFLOAT4> RandomLightSpheres(uint32_t count)
+	{
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> x(-150.f, 150.f), y(-5.f, 30.f), z(-300.f, 20.f), radius(2.f, 12.f);
+		std::vector<XMFLOAT4> spheres(count);
+		for (XMFLOAT4& sphere : spheres)
+			sphere = { x(random), y(random), z(random), radius(random) };
+		return spheres;
+	}
+}
+
+// Lights assigned per second with the default 16x9x24 grid. Args are the lights
+// and the threads, 1 runs without the job system.
+static void BM_LightClustersAssign(benchmark::State& state)
+{
+	const uint32_t count = uint32_t(state.range(0));
+	const uint32_t threads = uint32_t(state.range(1));
+	std::vector<XMFLOAT4> spheres = RandomLightSpheres(count);
+
+	std::unique_ptr<JobSystem> jobs;
+	if (threads > 1)
+	{
+		JobSystemDesc desc;
+		desc.NumWorkers = threads - 1;
+		jobs = std::make_unique<JobSystem>(desc);
+	}
+
+	LightClusterView view;
+	XMStoreFloat4x4(&view.View, XMMatrixIdentity());
+	view.FarZ = 250.f;
+
+	LightClusters clusters;
+	for (auto _ : state)
+	{
+		clusters.Assign(view, spheres.data(), count, jobs.get());
+		benchmark::DoNotOptimize(clusters.GetLightIndices().data());
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+
+	const LightClusterStats& stats = clusters.GetStats();
+	state.counters["Visible"] = double(stats.VisibleLights);
+	state.counters["Assignments"] = double(stats.Assignments);
+	state.counters["MaxPerCluster"] = double(stats.MaxLightsPerCluster);
+}
+BENCHMARK(BM_LightClustersAssign)
+	->ArgsProduct({ { 1000, 10000, 50000 }, { 1, 4 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
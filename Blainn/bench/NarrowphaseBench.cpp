@@ -0,0 +1,98 @@
+#include "pch.h"
+
+#include "Core/JobSystem.h"
+#include "Scene/Narrowphase.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	// Shape types on both sides of the pairs
+	enum PairMix
+	{
+		Spheres,
+		Boxes,
+		Capsules,
+		OrientedBoxes,
+		// every shape type against every other, one in four pairs without a kernel
+		Mixed,
+	};
+
+	const char* MixNames[] = { "spheres", "boxes", "capsules", "oriented boxes", "mixed" };
+
+	CollisionShape RandomShape(std::mt19937& random, CollisionShapeType type)
+	{
+		std::uniform_real_distribution<float> position(-2.f, 2.f), size(0.1f, 1.5f);
+		CollisionShape shape;
+		shape.Type = type;
+		shape.Center = { position(random), position(random), position(random) };
+		shape.Extents = { size(random), size(random), size(random) };
+		shape.HalfSegment = { position(random) * 0.5f, position(random) * 0.5f, position(random) * 0.5f };
+		shape.Radius = size(random);
+		if (type == CollisionShapeType::OrientedBox)
+		{
+			float angle = position(random);
+			shape.Orientation = { 0.f, std::sin(angle), 0.f, std::cos(angle) };
+		}
+		return shape;
+	}
+
+	CollisionShapeType MixType(PairMix mix, std::mt19937& random)
+	{
+		switch (mix)
+		{
+		case Spheres: return CollisionShapeType::Sphere;
+		case Boxes: return CollisionShapeType::Box;
+		case Capsules: return CollisionShapeType::Capsule;
+		case OrientedBoxes: return CollisionShapeType::OrientedBox;
+		default: return CollisionShapeType(random() % uint32_t(CollisionShapeType::Count));
+		}
+	}
+}
+
+// Pairs per second through TestPairs, the candidate pairs of one broadphase pass.
+// Args are the pair mix and the threads, 1 runs without the job system.
+static void BM_NarrowphasePairs(benchmark::State& state)
+{
+	const PairMix mix = PairMix(state.range(0));
+	const uint32_t threads = uint32_t(state.range(1));
+	constexpr uint32_t PairCount = 1 << 16;
+
+	std::mt19937 random(42);
+	std::vector<CollisionShape> a(PairCount), b(PairCount);
+	std::vector<NarrowphasePair> pairs(PairCount);
+	for (uint32_t i = 0; i < PairCount; ++i)
+	{
+		a[i] = RandomShape(random, MixType(mix, random));
+		b[i] = RandomShape(random, MixType(mix, random));
+		pairs[i] = { &a[i], &b[i] };
+	}
+
+	std::unique_ptr<JobSystem> jobs;
+	if (threads > 1)
+	{
+		JobSystemDesc desc;
+		desc.NumWorkers = threads - 1;
+		jobs = std::make_unique<JobSystem>(desc);
+	}
+
+	Narrowphase narrowphase;
+	std::vector<uint8_t> touching(PairCount);
+	for (auto _ : state)
+	{
+		narrowphase.TestPairs(pairs.data(), PairCount, touching.data(), jobs.get());
+		benchmark::DoNotOptimize(touching.data());
+	}
+	state.SetItemsProcessed(state.iterations() * PairCount);
+	state.SetLabel(MixNames[mix]);
+}
+BENCHMARK(BM_NarrowphasePairs)
+	->ArgsProduct({ { Spheres, Boxes, Capsules, OrientedBoxes, Mixed }, { 1, 4 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
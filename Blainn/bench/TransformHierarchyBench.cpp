@@ -0,0 +1,164 @@
+#include "pch.h"
+
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Core/GameObject.h"
+#include "Core/JobSystem.h"
+#include "Scene/TransformHierarchy.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+using namespace DirectX::SimpleMath;
+using namespace Blainn;
+
+namespace
+{
+	struct TransformedObject
+	{
+		std::shared_ptr<GameObject> Object;
+		TransformComponent* Transform;
+		// Index of the parent in the object list, objects are listed parents first
+		uint32_t Parent;
+	};
+
+	TransformedObject MakeTransformed(std::shared_ptr<GameObject> object, uint32_t parent, const Vector3& position)
+	{
+		auto transform = object->AddComponent<TransformComponent>();
+		transform->SetLocalPosition(position);
+		return { object, transform.get(), parent };
+	}
+
+	// Groups of 100 like a scene of props, a root with 9 children of 10 children
+	// each, so the hierarchy is 3 levels deep
+	void MakeGroups(uint32_t count, std::vector<TransformedObject>& objects)
+	{
+		const uint32_t end = uint32_t(objects.size()) + count;
+		while (objects.size() < end)
+		{
+			const float x = float(objects.size() % 1000), z = float(objects.size() / 1000);
+			const uint32_t rootIndex = uint32_t(objects.size());
+			TransformedObject root = MakeTransformed(std::make_shared<GameObject>(), TransformHierarchy::NoPosition, { x, 0.f, z });
+			objects.push_back(root);
+			for (uint32_t i = 0; i < 9 && objects.size() < end; ++i)
+			{
+				const uint32_t childIndex = uint32_t(objects.size());
+				TransformedObject child = MakeTransformed(root.Object->AddChild<GameObject>(), rootIndex, { 1.f, float(i), 0.f });
+				objects.push_back(child);
+				for (uint32_t j = 0; j < 10 && objects.size() < end; ++j)
+					objects.push_back(MakeTransformed(child.Object->AddChild<GameObject>(), childIndex, { 0.f, 0.5f, float(j) }));
+			}
+		}
+	}
+
+	// What a scene does as it places the objects, one subtree per root
+	void PlaceObjects(const std::vector<TransformedObject>& objects, TransformHierarchy& hierarchy)
+	{
+		const uint32_t count = uint32_t(objects.size());
+		std::vector<uint32_t> subtreeSizes(count, 1);
+		for (uint32_t i = count; i-- > 0;)
+			if (objects[i].Parent != TransformHierarchy::NoPosition)
+				subtreeSizes[objects[i].Parent] += subtreeSizes[i];
+
+		std::vector<TransformHierarchy::Entry> entries;
+		for (uint32_t root = 0; root < count; root += subtreeSizes[root])
+		{
+			entries.clear();
+			for (uint32_t i = root; i < root + subtreeSizes[root]; ++i)
+				entries.push_back({ objects[i].Transform, objects[i].Parent, subtreeSizes[i] });
+			hierarchy.Insert(root, entries);
+		}
+	}
+
+	void DestroyObjects(std::vector<TransformedObject>& objects, TransformHierarchy& hierarchy)
+	{
+		hierarchy.Erase(0, hierarchy.GetEntryCount());
+		for (TransformedObject& object : objects)
+			object.Object->RemoveAllComponents<ComponentBase>();
+		objects.clear();
+	}
+
+	std::unique_ptr<JobSystem> MakeJobSystem(uint32_t threads)
+	{
+		if (threads <= 1)
+			return nullptr;
+
+		JobSystemDesc desc;
+		desc.NumWorkers = threads - 1;
+		return std::make_unique<JobSystem>(desc);
+	}
+}
+
+// Frames of 100k transforms per second, the hierarchy update the transform system
+// runs every frame. Args are the percentage of transforms whose local position
+// changes every frame and the threads, 1 runs without the job system. The
+// positions are set outside the timed part, only the update is measured.
+static void BM_TransformHierarchyUpdate(benchmark::State& state)
+{
+	constexpr uint32_t Count = 100000;
+	const uint32_t dirtyStride = 100 / uint32_t(state.range(0));
+	std::unique_ptr<JobSystem> jobs = MakeJobSystem(uint32_t(state.range(1)));
+
+	std::vector<TransformedObject> objects;
+	MakeGroups(Count, objects);
+	TransformHierarchy hierarchy;
+	PlaceObjects(objects, hierarchy);
+	hierarchy.Update(jobs.get());
+
+	float offset = 0.f;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		offset += 0.01f;
+		for (uint32_t i = dirtyStride - 1; i < Count; i += dirtyStride)
+		{
+			Vector3 position = objects[i].Transform->GetLocalPosition();
+			position.y = offset;
+			objects[i].Transform->SetLocalPosition(position);
+		}
+		state.ResumeTiming();
+
+		hierarchy.Update(jobs.get());
+	}
+	state.SetItemsProcessed(state.iterations() * Count);
+	state.counters["Updated"] = double(hierarchy.GetUpdatedCount());
+
+	DestroyObjects(objects, hierarchy);
+}
+BENCHMARK(BM_TransformHierarchyUpdate)
+	->ArgsProduct({ { 100, 10 }, { 1, 4 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// Frames per second of one parent with 1,000 children moving every frame, the
+// parent's move and the update that carries it to the children both timed. Arg is
+// the number of transforms in the scene that stay where they are.
+static void BM_TransformHierarchyMovingParent(benchmark::State& state)
+{
+	constexpr uint32_t ChildCount = 1000;
+	std::vector<TransformedObject> objects;
+	MakeGroups(uint32_t(state.range(0)), objects);
+
+	const uint32_t parentIndex = uint32_t(objects.size());
+	TransformedObject parent = MakeTransformed(std::make_shared<GameObject>(), TransformHierarchy::NoPosition, { 0.f, 0.f, 0.f });
+	objects.push_back(parent);
+	for (uint32_t i = 0; i < ChildCount; ++i)
+		objects.push_back(MakeTransformed(parent.Object->AddChild<GameObject>(), parentIndex, { float(i), 0.f, 0.f }));
+
+	TransformHierarchy hierarchy;
+	PlaceObjects(objects, hierarchy);
+	hierarchy.Update(nullptr);
+
+	float offset = 0.f;
+	for (auto _ : state)
+	{
+		offset += 0.01f;
+		parent.Transform->SetLocalPosition({ offset, 0.f, 0.f });
+		hierarchy.Update(nullptr);
+	}
+	state.SetItemsProcessed(state.iterations() * (ChildCount + 1));
+	state.counters["Updated"] = double(hierarchy.GetUpdatedCount());
+
+	DestroyObjects(objects, hierarchy);
+}
+BENCHMARK(BM_TransformHierarchyMovingParent)->Arg(0)->Arg(100000)->Unit(benchmark::kMicrosecond);
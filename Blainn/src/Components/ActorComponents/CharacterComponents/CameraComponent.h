@@ -32,15 +32,29 @@ namespace Blainn
 		{
 			Super::OnUpdate(gt);
 
-			auto owner = GetOwner();
+			GameObject* owner = GetOwnerPtr();
 			if (!owner) return;
 
-			auto transform = owner->GetComponent<TransformComponent>();
+			auto transform = owner->GetComponentPtr<TransformComponent>();
 			if (!transform) return;
 
 			m_Camera.SetPositionAndQuaternion(transform->GetWorldPosition(), transform->GetWorldQuat());
 		}
 
+		// Places the camera between the last two simulation steps of its transform,
+		// for rendering in between fixed steps
+		void Interpolate(float alpha)
+		{
+			GameObject* owner = GetOwnerPtr();
+			if (!owner) return;
+
+			auto transform = owner->GetComponentPtr<TransformComponent>();
+			if (!transform) return;
+
+			Transform blended = transform->GetInterpolatedWorldTransform(alpha);
+			m_Camera.SetPositionAndQuaternion(blended.Position, blended.Quaternion);
+		}
+
 		Camera& GetCamera() { return m_Camera; }
 	private:
 		Camera m_Camera;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CollisionComponent.h"
+
+namespace Blainn
+{
+	// Axis aligned box around the owner's position, ignores its rotation
+	class BoxCollisionComponent : public CollisionComponent
+	{
+		using Super = CollisionComponent;
+	public:
+		BoxCollisionComponent(std::shared_ptr<GameObject> owner, const DirectX::SimpleMath::Vector3& extents)
+			: Super(owner, CollisionShapeType::Box)
+		{
+			m_Shape.Extents = extents;
+		}
+
+		DirectX::SimpleMath::Vector3 GetExtents() const { return m_Shape.Extents; }
+		void SetExtents(const DirectX::SimpleMath::Vector3& extents) { m_Shape.Extents = extents; }
+
+	protected:
+		void UpdateShape(const TransformComponent& transform) override
+		{
+			m_Shape.Center = transform.GetWorldPosition();
+		}
+	};
+}
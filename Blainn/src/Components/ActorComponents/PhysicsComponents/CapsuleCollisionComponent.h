@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CollisionComponent.h"
+
+namespace Blainn
+{
+	// Capsule standing along the owner's up vector. The half height does not include
+	// the caps, the whole capsule is 2 * (halfHeight + radius) tall.
+	class CapsuleCollisionComponent : public CollisionComponent
+	{
+		using Super = CollisionComponent;
+	public:
+		CapsuleCollisionComponent(std::shared_ptr<GameObject> owner, float radius, float halfHeight)
+			: Super(owner, CollisionShapeType::Capsule)
+			, m_HalfHeight(halfHeight)
+		{
+			m_Shape.Radius = radius;
+			m_Shape.HalfSegment = { 0.f, halfHeight, 0.f };
+		}
+
+		float GetRadius() const { return m_Shape.Radius; }
+		void SetRadius(float radius) { m_Shape.Radius = radius; }
+		float GetHalfHeight() const { return m_HalfHeight; }
+		void SetHalfHeight(float halfHeight) { m_HalfHeight = halfHeight; }
+
+	protected:
+		void UpdateShape(const TransformComponent& transform) override
+		{
+			m_Shape.Center = transform.GetWorldPosition();
+			m_Shape.HalfSegment = transform.GetWorldUpVector() * m_HalfHeight;
+		}
+
+	private:
+		float m_HalfHeight;
+	};
+}
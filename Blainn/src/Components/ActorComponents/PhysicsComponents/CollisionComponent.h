@@ -1,7 +1,14 @@
 #pragma once
 
+#include "Components/ActorComponents/TransformComponent.h"
 #include "Components/Component.h"
 #include "Components/ComponentManager.h"
+#include "Core/GameObject.h"
+#include "Scene/CollisionLayers.h"
+#include "Scene/ContactCache.h"
+#include "Scene/Narrowphase.h"
+
+#include "DirectXCollision.h"
 
 #include <functional>
 
@@ -12,24 +19,93 @@ namespace Blainn
 	class CollisionComponent : public Component<CollisionComponent>
 	{
 		using CollisionCallbackFn = std::function<void(std::shared_ptr<CollisionComponent>)>;
+		using ContactCallbackFn = std::function<void(ContactEventType, std::shared_ptr<CollisionComponent>, float timeOfImpact)>;
 		using Super = Component<CollisionComponent>;
 	public:
-		CollisionComponent(std::shared_ptr<GameObject> owner)
+		CollisionComponent(std::shared_ptr<GameObject> owner, CollisionShapeType shapeType)
 			: Super(owner)
-		{}
+		{
+			m_Shape.Type = shapeType;
+		}
 		virtual ~CollisionComponent()
 		{
 		}
 
-		void OnAttach()
+		void OnAttach() override
 		{
 			Super::OnAttach();
+			ResetMotion();
 		}
 
-		virtual void* GetBoundingShape() = 0;
-		
-		virtual bool Intersects(std::shared_ptr<CollisionComponent> collider) = 0;
+		void OnUpdate(const GameTimer& gt) override
+		{
+			RefreshShape();
+		}
 
+		CollisionShapeType GetShapeType() const { return m_Shape.Type; }
+		// World space shape as of the last update, what the narrowphase tests
+		const CollisionShape& GetShape() const { return m_Shape; }
+		// World space box around the shape, for the scene's spatial index
+		DirectX::BoundingBox GetBounds() const
+		{
+			DirectX::BoundingBox bounds;
+			GetShapeBounds(m_Shape, bounds.Center, bounds.Extents);
+			return bounds;
+		}
+
+		// Layer the collider is on, below MaxCollisionLayers. The scene's layer
+		// matrix and both masks have to agree for a pair to be tested at all.
+		void SetCollisionLayer(uint32_t layer)
+		{
+			assert(layer < MaxCollisionLayers);
+			m_CollisionLayer = uint8_t(layer);
+		}
+		uint32_t GetCollisionLayer() const { return m_CollisionLayer; }
+		// Layers this collider collides with, one bit per layer
+		void SetCollisionMask(uint32_t mask) { m_CollisionMask = mask; }
+		uint32_t GetCollisionMask() const { return m_CollisionMask; }
+
+		// Fast colliders are swept from where their shape was in the previous step to
+		// where it is now, so they cannot pass through thin colliders between steps.
+		// Their contacts carry the time of impact and are dispatched in that order.
+		void SetContinuous(bool bContinuous) { m_bContinuous = bContinuous; }
+		bool IsContinuous() const { return m_bContinuous; }
+		// How far the shape moved during the last step
+		DirectX::XMFLOAT3 GetDisplacement() const
+		{
+			return { m_Shape.Center.x - m_PreviousCenter.x, m_Shape.Center.y - m_PreviousCenter.y, m_Shape.Center.z - m_PreviousCenter.z };
+		}
+		// Shape center at a fraction of the last step, where a contact's time of impact
+		// puts it
+		DirectX::XMFLOAT3 GetCenterAt(float time) const
+		{
+			DirectX::XMFLOAT3 displacement = GetDisplacement();
+			return { m_PreviousCenter.x + displacement.x * time, m_PreviousCenter.y + displacement.y * time, m_PreviousCenter.z + displacement.z * time };
+		}
+		// Places the shape where the owner is now and forgets how it got there, so the
+		// next sweep starts from here. The scene calls it when the collider spawns and
+		// when its object is reparented, call it after teleporting an object.
+		void ResetMotion()
+		{
+			RefreshShape();
+			m_PreviousCenter = m_Shape.Center;
+		}
+		// Box around the shape at the start and at the end of the last step
+		DirectX::BoundingBox GetSweptBounds() const
+		{
+			DirectX::BoundingBox bounds = GetBounds();
+			DirectX::BoundingBox previous = bounds;
+			previous.Center = { bounds.Center.x - m_Shape.Center.x + m_PreviousCenter.x,
+				bounds.Center.y - m_Shape.Center.y + m_PreviousCenter.y,
+				bounds.Center.z - m_Shape.Center.z + m_PreviousCenter.z };
+			DirectX::BoundingBox::CreateMerged(bounds, bounds, previous);
+			return bounds;
+		}
+
+		bool Intersects(const CollisionComponent& collider) const { return TestShapes(m_Shape, collider.m_Shape); }
+		bool Intersects(std::shared_ptr<CollisionComponent> collider) const { return collider && Intersects(*collider); }
+
+		// Called once when a contact begins, not for every frame it lasts
 		void SetCollisionCallback(const CollisionCallbackFn& callback)
 		{
 			OnCollisionCallback = callback;
@@ -39,7 +115,48 @@ namespace Blainn
 			if (OnCollisionCallback)
 				OnCollisionCallback(collidingObject);
 		}
+
+		// Called on Begin, every Stay and End. The other collider of an End is null
+		// when it was removed. Structural changes belong in Scene::Defer. The time of
+		// impact is below 1 only for contacts found by sweeping a fast collider.
+		void SetContactCallback(const ContactCallbackFn& callback)
+		{
+			OnContactCallback = callback;
+		}
+		bool HasContactCallback() const { return static_cast<bool>(OnContactCallback); }
+		void OnContact(ContactEventType type, std::shared_ptr<CollisionComponent> other, float timeOfImpact = 1.f)
+		{
+			if (OnContactCallback)
+				OnContactCallback(type, other, timeOfImpact);
+			if (type == ContactEventType::Begin)
+				OnCollision(other);
+		}
+
+	protected:
+		// Places the shape in the world from the owner's transform
+		virtual void UpdateShape(const TransformComponent& transform) = 0;
+
+		void RefreshShape()
+		{
+			GameObject* owner = GetOwnerPtr();
+			if (!owner) return;
+			auto transform = owner->GetComponentPtr<TransformComponent>();
+			if (!transform) return;
+			m_PreviousCenter = m_Shape.Center;
+			UpdateShape(*transform);
+		}
+
+	protected:
+		CollisionShape m_Shape;
+		// Shape center before the last RefreshShape
+		DirectX::XMFLOAT3 m_PreviousCenter{ 0.f, 0.f, 0.f };
+
 	private:
+		uint8_t m_CollisionLayer = 0;
+		uint32_t m_CollisionMask = UINT32_MAX;
+		bool m_bContinuous = false;
+
 		CollisionCallbackFn OnCollisionCallback;
+		ContactCallbackFn OnContactCallback;
 	};
 }
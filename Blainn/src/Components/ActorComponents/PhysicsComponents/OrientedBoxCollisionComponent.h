@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CollisionComponent.h"
+
+namespace Blainn
+{
+	// Box that turns with the owner, extents along the owner's local axes
+	class OrientedBoxCollisionComponent : public CollisionComponent
+	{
+		using Super = CollisionComponent;
+	public:
+		OrientedBoxCollisionComponent(std::shared_ptr<GameObject> owner, const DirectX::SimpleMath::Vector3& extents)
+			: Super(owner, CollisionShapeType::OrientedBox)
+		{
+			m_Shape.Extents = extents;
+		}
+
+		DirectX::SimpleMath::Vector3 GetExtents() const { return m_Shape.Extents; }
+		void SetExtents(const DirectX::SimpleMath::Vector3& extents) { m_Shape.Extents = extents; }
+
+	protected:
+		void UpdateShape(const TransformComponent& transform) override
+		{
+			m_Shape.Center = transform.GetWorldPosition();
+			m_Shape.Orientation = transform.GetWorldQuat();
+		}
+	};
+}
@@ -1,10 +1,6 @@
 #pragma once
 
 #include "CollisionComponent.h"
-#include "Components/ActorComponents/TransformComponent.h"
-#include "Core/GameObject.h"
-
-#include "DirectXCollision.h"
 
 namespace Blainn
 {
@@ -13,48 +9,25 @@ namespace Blainn
 		using Super = CollisionComponent;
 	public:
 		SphereCollisionComponent(std::shared_ptr<GameObject> owner, float radius)
-			: Super(owner)
-		{
-			m_BoundingSphere.Radius = radius;
-		}
-
-		void OnAttach() override
-		{
-			Super::OnAttach();
-			if (!GetOwner()) return;
-			auto transform = GetOwner()->GetComponent<TransformComponent>();
-			if (!transform) return;
-			m_BoundingSphere.Center = transform->GetWorldPosition();
-		}
-
-		void* GetBoundingShape() override { return static_cast<void*>(&m_BoundingSphere); }
-
-		void OnUpdate(const GameTimer& gt) override
-		{
-			if (!GetOwner()) return;
-			auto transform = GetOwner()->GetComponent<TransformComponent>();
-			if (!transform) return;
-			m_BoundingSphere.Center = transform->GetWorldPosition();
-		}
-
-		bool Intersects(std::shared_ptr<CollisionComponent> collider)
+			: Super(owner, CollisionShapeType::Sphere)
 		{
-			auto boundingSphere = static_cast<DirectX::BoundingSphere*>(collider->GetBoundingShape());
-			return m_BoundingSphere.Intersects(*boundingSphere);
+			m_Shape.Radius = radius;
 		}
 
 		float GetRadius()
 		{
-			return m_BoundingSphere.Radius;
+			return m_Shape.Radius;
 		}
 
 		void UpdateRadius(float newRadius)
 		{
-			m_BoundingSphere.Radius = newRadius;
+			m_Shape.Radius = newRadius;
 		}
 
-	private:
-		DirectX::BoundingSphere m_BoundingSphere;
-
+	protected:
+		void UpdateShape(const TransformComponent& transform) override
+		{
+			m_Shape.Center = transform.GetWorldPosition();
+		}
 	};
 }
@@ -5,42 +5,50 @@
 #include "Core/CBIndexManager.h"
 #include "Core/GameObject.h"
 #include "Core/Application.h"
-#include "DX12/DXRenderingContext.h"
-#include "DX12/DXModel.h"
-#include "DX12/DXSceneVisitor.h"
-
-#include <dx12lib/Device.h>
+#include "Render/Model.h"
+#include "Render/RenderingBackend.h"
 
 using namespace Blainn;
 
-Blainn::StaticMeshComponent::StaticMeshComponent(std::shared_ptr<GameObject> owner, const std::filesystem::path& filepath)
+Blainn::StaticMeshComponent::StaticMeshComponent(std::shared_ptr<GameObject> owner, const std::filesystem::path& filepath, MeshMobility mobility)
 	: Super(owner)
+	, m_Mobility(mobility)
 {
-	m_Model = (std::make_shared<DXModel>(filepath));
-	m_Owners.push_back(owner);
+	m_Model = Application::Get().GetRenderingBackend()->LoadModel(filepath);
+	m_Owners.push_back(owner->GetHandle());
 }
 
-std::shared_ptr<StaticMeshComponent> Blainn::StaticMeshComponent::Create(std::shared_ptr<GameObject> owner, const std::filesystem::path& filepath)
+std::vector<std::weak_ptr<StaticMeshComponent>> Blainn::StaticMeshComponent::s_SharedMeshes;
+
+std::shared_ptr<StaticMeshComponent> Blainn::StaticMeshComponent::Create(std::shared_ptr<GameObject> owner, const std::filesystem::path& filepath, MeshMobility mobility)
 {
-	auto& allSMs = ComponentManager::Get().GetComponents<StaticMeshComponent>();
-	auto it = std::find_if(allSMs.begin(), allSMs.end(),
-			[&filepath](std::shared_ptr<StaticMeshComponent> comp)->bool
-			{
-				return comp->GetModel()->GetPath() == filepath;
-			});
+	// components reach a scene's sets only once their owner is placed, objects set up
+	// before that still have to find the mesh to share
+	std::erase_if(s_SharedMeshes, [](const std::weak_ptr<StaticMeshComponent>& mesh) { return mesh.expired(); });
 
-	if (it != allSMs.end())
+	Scene* scene = owner->GetScene();
+	for (const auto& mesh : s_SharedMeshes)
 	{
-		(*it)->m_Owners.push_back(owner);
-		return *it;
+		auto comp = mesh.lock();
+		if (comp->GetModel()->GetPath() != filepath || comp->GetMobility() != mobility)
+			continue;
+
+		// a component is stored by one scene, owners in another one get their own
+		ComponentManager* manager = comp->GetComponentManager();
+		if (manager && scene && manager != &scene->GetComponentManager())
+			continue;
+
+		comp->m_Owners.push_back(owner->GetHandle());
+		return comp;
 	}
 
 	struct Enabler : StaticMeshComponent {
-		Enabler(std::shared_ptr<GameObject> o, const std::filesystem::path& p)
-			: StaticMeshComponent(std::move(o), p) { }
+		Enabler(std::shared_ptr<GameObject> o, const std::filesystem::path& p, MeshMobility m)
+			: StaticMeshComponent(std::move(o), p, m) { }
 	};
 
-	auto newComp = std::make_shared<Enabler>(owner, filepath);
+	auto newComp = ComponentManager::AllocateComponent<Enabler>(owner, filepath, mobility);
+	s_SharedMeshes.push_back(newComp);
 	return newComp;
 }
 
@@ -55,12 +63,7 @@ void Blainn::StaticMeshComponent::OnAttach()
 	Blainn::CBIndexManager::Get().AssignCBIdx(GetOwner()->GetUUID());
 }
 
-void Blainn::StaticMeshComponent::OnRender(dx12lib::Visitor& sceneVisitor)
-{
-	m_Model->Render(sceneVisitor);
-}
-
-std::shared_ptr<DXModel> Blainn::StaticMeshComponent::GetModel() const
+std::shared_ptr<Model> Blainn::StaticMeshComponent::GetModel() const
 {
 	return m_Model;
 }
@@ -4,16 +4,18 @@
 
 #include <filesystem>
 
-namespace dx12lib
-{
-	class Scene;
-	class Visitor;
-}
-
 namespace Blainn
 {
-	class DXModel;
-	class SceneVisitor;
+	class Model;
+
+	// Whether the instances of a mesh may move after they were placed. The shadow
+	// cascades cache the depth of static meshes and draw it again only when a cascade
+	// moves or a static mesh is added, removed or moved after all.
+	enum class MeshMobility : uint8_t
+	{
+		Static,
+		Movable,
+	};
 
 	class StaticMeshComponent : public Blainn::Component<StaticMeshComponent>
 	{
@@ -23,23 +25,32 @@ namespace Blainn
 	public:
 		static std::shared_ptr<StaticMeshComponent> Create(
 			std::shared_ptr<GameObject> owner,
-			const std::filesystem::path& filepath);
+			const std::filesystem::path& filepath,
+			MeshMobility mobility = MeshMobility::Movable);
 
 		~StaticMeshComponent();
 
 		void OnAttach() override;
 
-		void OnRender(dx12lib::Visitor& frameInfo);
+		// Loaded by the application's rendering backend
+		std::shared_ptr<Model> GetModel() const;
 
-		std::shared_ptr<DXModel> GetModel() const;
+		const std::vector<EntityHandle>& GetOwners() const { return m_Owners; }
 
-		const std::vector<std::weak_ptr<GameObject>>& GetOwners() const { return m_Owners; }
+		// Owners of one component share it, objects loading the same model with a
+		// different mobility get a component of their own
+		MeshMobility GetMobility() const { return m_Mobility; }
+		bool IsStatic() const { return m_Mobility == MeshMobility::Static; }
 		
 	private:
-		StaticMeshComponent(std::shared_ptr<GameObject> owner, const std::filesystem::path& filepath);
+		StaticMeshComponent(std::shared_ptr<GameObject> owner, const std::filesystem::path& filepath, MeshMobility mobility);
 
 	private:
-		std::shared_ptr<DXModel> m_Model;
-		std::vector<std::weak_ptr<GameObject>> m_Owners;
+		std::shared_ptr<Model> m_Model;
+		std::vector<EntityHandle> m_Owners;
+		MeshMobility m_Mobility = MeshMobility::Movable;
+
+		// Every live component, the ones owners may share
+		static std::vector<std::weak_ptr<StaticMeshComponent>> s_SharedMeshes;
 	};
 }
@@ -5,8 +5,6 @@
 
 #include <iostream>
 
-extern const int g_NumFrameResources;
-
 namespace Blainn
 {
 	TransformComponent::TransformComponent(std::shared_ptr<GameObject> owner)
@@ -14,23 +12,11 @@ namespace Blainn
 	{
 	}
 
-	void TransformComponent::OnAttach()
-	{
-		Super::OnAttach();
-		MarkDirty();
-	}
-
-	void TransformComponent::OnUpdate(const GameTimer& gt)
-	{
-		Super::OnUpdate(gt);
-		UpdateWorldMatrix();
-	}
-
 	void TransformComponent::SetLocalPosition(const DirectX::SimpleMath::Vector3& newLocalPos)
 	{
 		MarkDirty();
 
-		m_LocalTransform.Position = newLocalPos;
+		LocalPosition() = newLocalPos;
 	}
 
 	void TransformComponent::SetLocalYawPitchRoll(const DirectX::SimpleMath::Vector3& newLocalRot)
@@ -46,22 +32,22 @@ namespace Blainn
 
 		Quaternion localRot = Quaternion::CreateFromYawPitchRoll(yawRad, pitchRad, rollRad);
 		localRot.Normalize();
-		m_LocalTransform.Quaternion = localRot;
+		LocalRotation() = localRot;
 	}
 
 	void TransformComponent::SetLocalQuat(const DirectX::SimpleMath::Quaternion& newLocalRotQuat)
 	{
 		MarkDirty();
 
-		m_LocalTransform.Quaternion = newLocalRotQuat;
-		m_LocalTransform.Quaternion.Normalize();
+		LocalRotation() = newLocalRotQuat;
+		LocalRotation().Normalize();
 	}
 
 	void TransformComponent::SetLocalScale(const DirectX::SimpleMath::Vector3& newLocalScale)
 	{
 		MarkDirty();
 
-		m_LocalTransform.Scale = newLocalScale;
+		LocalScale() = newLocalScale;
 	}
 
 	void TransformComponent::SetLocalPositionYawPitchRoll(const DirectX::SimpleMath::Vector3& newLocalPos, const DirectX::SimpleMath::Vector3& newLocalRot)
@@ -82,24 +68,24 @@ namespace Blainn
 
 		MarkDirty();
 
-		auto owner = GetOwner();
-		auto parentObj = owner ? owner->GetParent() : nullptr;
+		GameObject* owner = GetOwnerPtr();
+		GameObject* parentObj = owner ? owner->GetParentPtr() : nullptr;
 		if (!parentObj) {
-			m_LocalTransform.Position = newWorldPos;
+			LocalPosition() = newWorldPos;
 			return;
 		}
 
 		// Else, invert parent's world matrix:
-		auto parentTransform = parentObj->GetComponent<TransformComponent>();
+		auto parentTransform = parentObj->GetComponentPtr<TransformComponent>();
 		if (!parentTransform) {
-			m_LocalTransform.Position = newWorldPos;
+			LocalPosition() = newWorldPos;
 			return;
 		}
 		Matrix invParent = parentTransform->GetWorldMatrix().Invert();
 
 		// Convert world => local
 		Vector3 localPos = Vector3::Transform(newWorldPos, invParent);
-		m_LocalTransform.Position = localPos;
+		LocalPosition() = localPos;
 	}
 
 	void TransformComponent::SetWorldYawPitchRoll(const DirectX::SimpleMath::Vector3& newWorldRot)
@@ -125,22 +111,22 @@ namespace Blainn
 		MarkDirty();
 
 		// If no parent, local=world:
-		auto owner = GetOwner();
-		auto parentObj = owner ? owner->GetParent() : nullptr;
+		GameObject* owner = GetOwnerPtr();
+		GameObject* parentObj = owner ? owner->GetParentPtr() : nullptr;
 		if (!parentObj) {
-			m_LocalTransform.Quaternion = newWorldQuat;
-			m_LocalTransform.Quaternion.Normalize();
-			m_WorldTransform.Quaternion = newWorldQuat;
-			m_WorldTransform.Quaternion.Normalize();
+			LocalRotation() = newWorldQuat;
+			LocalRotation().Normalize();
+			WorldRotation() = newWorldQuat;
+			WorldRotation().Normalize();
 			return;
 		}
 
-		auto parentTransform = parentObj->GetComponent<TransformComponent>();
+		auto parentTransform = parentObj->GetComponentPtr<TransformComponent>();
 		if (!parentTransform) {
-			m_LocalTransform.Quaternion = newWorldQuat;
-			m_LocalTransform.Quaternion.Normalize();
-			m_WorldTransform.Quaternion = newWorldQuat;
-			m_WorldTransform.Quaternion.Normalize();
+			LocalRotation() = newWorldQuat;
+			LocalRotation().Normalize();
+			WorldRotation() = newWorldQuat;
+			WorldRotation().Normalize();
 			return;
 		}
 
@@ -152,8 +138,8 @@ namespace Blainn
 		Quaternion local = parentWorldRot * newWorldQuat;
 		local.Normalize();
 
-		m_LocalTransform.Quaternion = local;
-		m_WorldTransform.Quaternion = local;
+		LocalRotation() = local;
+		WorldRotation() = local;
 	}
 
 	void TransformComponent::SetWorldScale(const DirectX::SimpleMath::Vector3& newWorldScale)
@@ -162,21 +148,21 @@ namespace Blainn
 
 		MarkDirty();
 
-		auto owner = GetOwner();
-		auto parentObj = owner ? owner->GetParent() : nullptr;
+		GameObject* owner = GetOwnerPtr();
+		GameObject* parentObj = owner ? owner->GetParentPtr() : nullptr;
 		if (!parentObj) {
-			m_LocalTransform.Scale = newWorldScale;
+			LocalScale() = newWorldScale;
 			return;
 		}
 
-		auto parentTransform = parentObj->GetComponent<TransformComponent>();
+		auto parentTransform = parentObj->GetComponentPtr<TransformComponent>();
 		if (!parentTransform) {
-			m_LocalTransform.Scale = newWorldScale;
+			LocalScale() = newWorldScale;
 			return;
 		}
 
 		Vector3 parentWorldScale = parentTransform->GetWorldScale();
-		m_LocalTransform.Scale = newWorldScale / parentWorldScale;
+		LocalScale() = newWorldScale / parentWorldScale;
 	}
 
 	void TransformComponent::SetWorldPositionYawPitchRoll(const DirectX::SimpleMath::Vector3& newWorldPos, const DirectX::SimpleMath::Vector3& newWorldRot)
@@ -194,9 +180,7 @@ namespace Blainn
 	DirectX::SimpleMath::Vector3 TransformComponent::GetWorldYawPitchRoll() const
 	{
 		using namespace DirectX;
-		auto q = m_WorldTransform.Quaternion;
-
-		DirectX::SimpleMath::Vector3 eulerAngles = m_WorldTransform.Quaternion.ToEuler();
+		DirectX::SimpleMath::Vector3 eulerAngles = WorldRotation().ToEuler();
 
 		float yaw = XMConvertToDegrees(eulerAngles.y);
 		float pitch = XMConvertToDegrees(eulerAngles.x);
@@ -207,7 +191,7 @@ namespace Blainn
 	DirectX::SimpleMath::Vector3 TransformComponent::GetLocalYawPitchRoll() const
 	{
 		using namespace DirectX;
-		DirectX::SimpleMath::Vector3 eulerAngles = m_LocalTransform.Quaternion.ToEuler();
+		DirectX::SimpleMath::Vector3 eulerAngles = LocalRotation().ToEuler();
 
 		float yaw = XMConvertToDegrees(eulerAngles.y);
 		float pitch = XMConvertToDegrees(eulerAngles.x);
@@ -215,81 +199,84 @@ namespace Blainn
 		return DirectX::SimpleMath::Vector3(yaw, pitch, roll);
 	}
 
-	void TransformComponent::MarkDirty()
+	Transform TransformComponent::GetPreviousWorldTransform() const
 	{
-		if (!m_bIsTransformDirty)
-		{
-			m_bIsTransformDirty = true;
-
-			if (auto owner = GetOwner())
-			{
-				for (auto& child : owner->GetChildren())
-				{
-					auto childTransform = child->GetComponent<TransformComponent>();
-					if (childTransform)
-						childTransform->MarkDirty();
-				}
-			}
-		}
+		if (!m_Hierarchy)
+			return m_PreviousWorldTransform;
+
+		const TransformHierarchy::History& history = m_Hierarchy->m_History[GetHierarchyPosition()];
+		Transform previous;
+		previous.Position = history.PreviousPosition;
+		previous.Quaternion = history.PreviousRotation;
+		previous.Scale = history.PreviousScale;
+		return previous;
 	}
 
-	void TransformComponent::UpdateWorldMatrix()
+	Transform TransformComponent::GetInterpolatedWorldTransform(float alpha) const
 	{
-		if (!m_bIsTransformDirty)
-			return;
+		using namespace DirectX::SimpleMath;
+
+		Transform current = GetWorldTransform();
+		if (alpha >= 1.f || !MovedInLastStep())
+			return current;
 
+		Transform previous = GetPreviousWorldTransform();
+		Transform blended;
+		blended.Position = Vector3::Lerp(previous.Position, current.Position, alpha);
+		blended.Scale = Vector3::Lerp(previous.Scale, current.Scale, alpha);
+		blended.Quaternion = Quaternion::Slerp(previous.Quaternion, current.Quaternion, alpha);
+		return blended;
+	}
+
+	DirectX::SimpleMath::Matrix TransformComponent::GetInterpolatedWorldMatrix(float alpha) const
+	{
 		using namespace DirectX;
-		using namespace SimpleMath;
-		m_NumFramesDirty = g_NumFrameResources;
-
-		Matrix scale = Matrix::CreateScale(m_LocalTransform.Scale);
-		Matrix rot = Matrix::CreateFromQuaternion(m_LocalTransform.Quaternion);
-		Matrix trans = Matrix::CreateTranslation(m_LocalTransform.Position);
-
-
-		Matrix localMat = (scale * rot * trans);
-
-		if (auto owner = GetOwner())
-		{
-			auto parentObj = owner->GetParent();
-			if (parentObj)
-			{
-				auto parentTransform = parentObj->GetComponent<TransformComponent>();
-				if (parentTransform)
-				{
-					parentTransform->UpdateWorldMatrix();
-					m_WorldMatrix = localMat * parentTransform->GetWorldMatrix();
-				}
-				else
-					m_WorldMatrix = localMat;
-			}
-			else
-				m_WorldMatrix = localMat;
-		}
-		else
-			return;
 
-		DirectX::SimpleMath::Vector3 wPos, wScale;
-		Quaternion wRot;
-		m_WorldMatrix.Decompose(wScale, wRot, wPos);
+		if (alpha >= 1.f || !MovedInLastStep())
+			return GetWorldMatrix();
+
+		// same S * R * T composition as the TransformHierarchy
+		Transform blended = GetInterpolatedWorldTransform(alpha);
+		XMMATRIX world = XMMatrixRotationQuaternion(blended.Quaternion);
+		world.r[0] = XMVectorScale(world.r[0], blended.Scale.x);
+		world.r[1] = XMVectorScale(world.r[1], blended.Scale.y);
+		world.r[2] = XMVectorScale(world.r[2], blended.Scale.z);
+		world.r[3] = XMVectorSelect(g_XMIdentityR3, blended.Position, g_XMSelect1110);
+		return world;
+	}
 
-		m_WorldTransform.Position = wPos;
-		m_WorldTransform.Quaternion = wRot;
-		m_WorldTransform.Scale = wScale;
+	Transform TransformComponent::GetWorldTransform() const
+	{
+		Transform world;
+		world.Position = GetWorldPosition();
+		world.Quaternion = GetWorldQuat();
+		world.Scale = GetWorldScale();
+		return world;
+	}
 
-		//m_RightVector   = Vector3::Transform(Vector3::UnitX, m_WorldMatrix);
-		//m_UpVector      = Vector3::Transform(Vector3::UnitY, m_WorldMatrix);
-		//m_ForwardVector = Vector3::Transform(Vector3::UnitZ, m_WorldMatrix);
+	DirectX::SimpleMath::Vector3 TransformComponent::GetWorldAxis(int row) const
+	{
+		const DirectX::SimpleMath::Matrix& world = GetWorldMatrix();
+		DirectX::SimpleMath::Vector3 axis(world.m[row][0], world.m[row][1], world.m[row][2]);
+		axis.Normalize();
+		return axis;
+	}
 
-		m_RightVector   = { m_WorldMatrix._11, m_WorldMatrix._12, m_WorldMatrix._13 };
-		m_UpVector      = { m_WorldMatrix._21, m_WorldMatrix._22, m_WorldMatrix._23 };
-		m_ForwardVector = { m_WorldMatrix._31, m_WorldMatrix._32, m_WorldMatrix._33 };
+	void TransformComponent::MarkDirty()
+	{
+		// not placed yet, the insert that takes it in queues it
+		if (!m_Hierarchy)
+			return;
 
-		m_RightVector.Normalize();
-		m_UpVector.Normalize();
-		m_ForwardVector.Normalize();
+		uint32_t position = GetHierarchyPosition();
+		// SetWorldQuat writes world data ahead of the hierarchy
+		m_Hierarchy->SnapshotPreviousWorld(position);
+		m_Hierarchy->QueueDirty(position);
+	}
 
-		m_bIsTransformDirty = false;
+	bool TransformComponent::MovedInLastStep() const
+	{
+		return m_Hierarchy && m_Hierarchy->m_History[GetHierarchyPosition()].WorldStep + 1 == m_Hierarchy->GetWorldStep();
 	}
 
 }
@@ -3,13 +3,14 @@
 #include "Components/Component.h"
 #include "Components/ComponentManager.h"
 
+#include "Scene/TransformHierarchy.h"
+
 #include "SimpleMath.h"
 
-extern const int g_NumFrameResources;
+#include <utility>
 
 namespace Blainn
 {
-
 	struct Transform
 	{
 		DirectX::SimpleMath::Vector3 Position = { 0.f, 0.f, 0.f };
@@ -19,14 +20,12 @@ namespace Blainn
 
 	class TransformComponent : public Component<TransformComponent>
 	{
+		friend class TransformHierarchy;
 		using Super = Component<TransformComponent>;
 	public:
 		TransformComponent(std::shared_ptr<GameObject> owner);
 		~TransformComponent() = default;
 
-		void OnAttach() override;
-		void OnUpdate(const GameTimer& gt) override;
-
 		void SetLocalPosition(const DirectX::SimpleMath::Vector3& newLocalPos);
 		void SetLocalYawPitchRoll(const DirectX::SimpleMath::Vector3& newLocalRot);
 		void SetLocalQuat(const DirectX::SimpleMath::Quaternion& newLocalRotQuat);
@@ -55,41 +54,66 @@ namespace Blainn
 			const DirectX::SimpleMath::Quaternion& newWorldQuat
 		);
 
-		DirectX::SimpleMath::Matrix GetWorldMatrix() const { return m_WorldMatrix; }
+		const DirectX::SimpleMath::Matrix& GetWorldMatrix() const { return m_Hierarchy ? m_Hierarchy->m_WorldMatrices[GetHierarchyPosition()] : m_WorldMatrix; }
 
-		DirectX::SimpleMath::Vector3 GetWorldPosition() const { return m_WorldTransform.Position; }
+		DirectX::SimpleMath::Vector3 GetWorldPosition() const { return GetWorldMatrix().Translation(); }
 		DirectX::SimpleMath::Vector3 GetWorldYawPitchRoll() const;
-		DirectX::SimpleMath::Quaternion GetWorldQuat() const { return m_WorldTransform.Quaternion; }
-		DirectX::SimpleMath::Vector3 GetWorldScale() const { return m_WorldTransform.Scale; }
+		DirectX::SimpleMath::Quaternion GetWorldQuat() const { return WorldRotation(); }
+		DirectX::SimpleMath::Vector3 GetWorldScale() const { return m_Hierarchy ? m_Hierarchy->m_WorldScales[GetHierarchyPosition()] : m_WorldTransform.Scale; }
 
-		DirectX::SimpleMath::Vector3 GetLocalPosition() const { return m_LocalTransform.Position; }
+		DirectX::SimpleMath::Vector3 GetLocalPosition() const { return LocalPosition(); }
 		DirectX::SimpleMath::Vector3 GetLocalYawPitchRoll() const;
-		DirectX::SimpleMath::Quaternion GetLocalQuat() const { return m_LocalTransform.Quaternion; }
-		DirectX::SimpleMath::Vector3 GetLocalScale() const { return m_LocalTransform.Scale; }
+		DirectX::SimpleMath::Quaternion GetLocalQuat() const { return LocalRotation(); }
+		DirectX::SimpleMath::Vector3 GetLocalScale() const { return LocalScale(); }
+
+		// Normalized axes of the world matrix
+		DirectX::SimpleMath::Vector3 GetWorldForwardVector() const { return GetWorldAxis(2); }
+		DirectX::SimpleMath::Vector3 GetWorldRightVector() const { return GetWorldAxis(0); }
+		DirectX::SimpleMath::Vector3 GetWorldUpVector() const { return GetWorldAxis(1); }
 
-		DirectX::SimpleMath::Vector3 GetWorldForwardVector() const { return m_ForwardVector; }
-		DirectX::SimpleMath::Vector3 GetWorldRightVector() const { return m_RightVector; }
-		DirectX::SimpleMath::Vector3 GetWorldUpVector() const { return m_UpVector; }
-		
-		//int GetFramesDirty() const { return m_NumFramesDirty; }
-		//void DecreaseFramesDirty() { if (m_NumFramesDirty > 0) m_NumFramesDirty--; }
+		// World TRS before the last simulation step that moved the transform
+		Transform GetPreviousWorldTransform() const;
+		// World state between the previous and the current simulation step, 0 is the
+		// previous one and 1 the current one. Transforms that did not move in the last
+		// step return their current state.
+		Transform GetInterpolatedWorldTransform(float alpha) const;
+		DirectX::SimpleMath::Matrix GetInterpolatedWorldMatrix(float alpha) const;
+
+		// Bumped every time the TransformHierarchy writes new world data
+		uint32_t GetWorldVersion() const { return m_Hierarchy ? m_Hierarchy->m_History[GetHierarchyPosition()].WorldVersion : m_WorldVersion; }
 
-		bool IsTransformDirty() const { return m_bIsTransformDirty; }
 	private:
+		// Placed transforms live in their entry of the scene's TransformHierarchy, the
+		// members below only hold the state while the transform is not placed
+		uint32_t GetHierarchyPosition() const { return m_Hierarchy->m_NodePositions[m_HierarchyNode]; }
+
+		const DirectX::SimpleMath::Vector3& LocalPosition() const { return m_Hierarchy ? m_Hierarchy->m_LocalPositions[GetHierarchyPosition()] : m_LocalTransform.Position; }
+		const DirectX::SimpleMath::Quaternion& LocalRotation() const { return m_Hierarchy ? m_Hierarchy->m_LocalRotations[GetHierarchyPosition()] : m_LocalTransform.Quaternion; }
+		const DirectX::SimpleMath::Vector3& LocalScale() const { return m_Hierarchy ? m_Hierarchy->m_LocalScales[GetHierarchyPosition()] : m_LocalTransform.Scale; }
+		const DirectX::SimpleMath::Quaternion& WorldRotation() const { return m_Hierarchy ? m_Hierarchy->m_WorldRotations[GetHierarchyPosition()] : m_WorldTransform.Quaternion; }
+		DirectX::SimpleMath::Vector3& LocalPosition() { return const_cast<DirectX::SimpleMath::Vector3&>(std::as_const(*this).LocalPosition()); }
+		DirectX::SimpleMath::Quaternion& LocalRotation() { return const_cast<DirectX::SimpleMath::Quaternion&>(std::as_const(*this).LocalRotation()); }
+		DirectX::SimpleMath::Vector3& LocalScale() { return const_cast<DirectX::SimpleMath::Vector3&>(std::as_const(*this).LocalScale()); }
+		DirectX::SimpleMath::Quaternion& WorldRotation() { return const_cast<DirectX::SimpleMath::Quaternion&>(std::as_const(*this).WorldRotation()); }
+
+		Transform GetWorldTransform() const;
+		DirectX::SimpleMath::Vector3 GetWorldAxis(int row) const;
+
+		// O(1): queues the transform with its hierarchy once per update, children are
+		// picked up as the TransformHierarchy walks their contiguous subtree
 		void MarkDirty();
-
-		void UpdateWorldMatrix();
+		bool MovedInLastStep() const;
 	private:
 		Transform m_LocalTransform{};
 		Transform m_WorldTransform{};
+		Transform m_PreviousWorldTransform{};
 		DirectX::SimpleMath::Matrix m_WorldMatrix = DirectX::SimpleMath::Matrix::Identity;
+		uint32_t m_WorldVersion = 0;
 
-		DirectX::SimpleMath::Vector3 m_ForwardVector{};
-		DirectX::SimpleMath::Vector3 m_RightVector{};
-		DirectX::SimpleMath::Vector3 m_UpVector{};
-
-		int m_NumFramesDirty = g_NumFrameResources;
-
-		bool m_bIsTransformDirty = true;
+		// Hierarchy of the scene the transform is placed in, set and cleared by the
+		// hierarchy as the transform enters and leaves its arrays
+		TransformHierarchy* m_Hierarchy = nullptr;
+		// Stable id of the entry, its position changes as the scene reorders
+		uint32_t m_HierarchyNode = UINT32_MAX;
 	};
 }
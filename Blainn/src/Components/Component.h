@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ComponentManager.h"
+#include "Core/EntityRegistry.h"
 
 #include <memory>
 
@@ -10,6 +11,8 @@ namespace Blainn
 	class GameTimer;
 
 	class ComponentBase {
+		friend class ComponentManager;
+		friend class GameObject;
 	public:
 		virtual ~ComponentBase() = default;
 		virtual void OnAttach() {};
@@ -17,12 +20,39 @@ namespace Blainn
 		virtual void OnInit() {};
 		virtual void OnBegin() {};
 		virtual void OnUpdate(const GameTimer& gt) {};
+
+		// Files the component under its family in the manager of the scene its owner
+		// was placed in, the scene unregisters it again when the owner leaves
+		virtual void RegisterWith(ComponentManager& manager) = 0;
+		virtual void Unregister() = 0;
+
+		ComponentHandle GetStorageHandle() const { return m_StorageHandle; }
+		// Null while the owner is not placed in a scene
+		ComponentManager* GetComponentManager() const { return m_Manager; }
+
+		EntityHandle GetOwnerHandle() const { return m_OwnerHandle; }
+		// Resolves the owner through the entity registry, no weak_ptr lock involved.
+		// Use on hot paths, the pointer must not be kept past the current frame.
+		GameObject* GetOwnerPtr() const { return EntityRegistry::Get().Resolve(m_OwnerHandle); }
+
+	private:
+		ComponentHandle m_StorageHandle{};
+		EntityHandle m_OwnerHandle{};
+		ComponentManager* m_Manager = nullptr;
+		// Placed owners, more than one only for shared components
+		uint32_t m_Registrations = 0;
 	};
 
 	template<typename Derived>
 	class Component : public std::enable_shared_from_this<Derived>, public ComponentBase
 	{
 		friend class GameObject;
+	public:
+		// Type the component is registered under in the ComponentManager. Subclasses
+		// of e.g. CollisionComponent share its family, which lets GameObject answer
+		// base-class queries from its slot table.
+		using ComponentFamily = Derived;
+
 	protected:
 		Component(std::shared_ptr<GameObject> owner)
 			: m_OwningObject(owner)
@@ -31,10 +61,11 @@ namespace Blainn
 		virtual ~Component() = default;
 		
 		virtual void OnInit() {}
-		virtual void OnAttach();
 		virtual void OnBegin() {}
 		virtual void OnUpdate(const GameTimer& gt) {}
-		virtual void OnDestroy();
+
+		void RegisterWith(ComponentManager& manager) override;
+		void Unregister() override;
 
 		std::shared_ptr<GameObject> GetOwner() const { return m_OwningObject.lock(); }
 
@@ -43,17 +74,20 @@ namespace Blainn
 	};
 
 	template<typename Derived>
-	inline void Component<Derived>::OnAttach()
+	inline void Component<Derived>::RegisterWith(ComponentManager& manager)
 	{
 		auto derivedPtr = std::static_pointer_cast<Derived>(this->shared_from_this());
-		ComponentManager::Get().RegisterComponent(derivedPtr);
+		manager.RegisterComponent(derivedPtr);
 	}
 
 	template<typename Derived>
-	inline void Component<Derived>::OnDestroy()
+	inline void Component<Derived>::Unregister()
 	{
-		auto derivedPtr = std::static_pointer_cast<Derived>(this->shared_from_this());
-		ComponentManager::Get().UnregisterComponent(derivedPtr);
+		if (ComponentManager* manager = GetComponentManager())
+		{
+			auto derivedPtr = std::static_pointer_cast<Derived>(this->shared_from_this());
+			manager->UnregisterComponent(derivedPtr);
+		}
 	}
 
 }
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <bitset>
+#include <cstdint>
 #include <memory>
-#include <typeindex>
 #include <type_traits>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
+
+#include "ComponentPool.h"
+#include "Core/Handle.h"
 
 // has_static_Create
 // returns true if there is at least one static member function called Create
@@ -20,43 +24,178 @@ namespace Blainn
 	class ComponentBase;
 	class GameObject;
 
+	// Dense per-type id handed out on first use of a component type.
+	// Used to index the component sets and the per-object slot tables without RTTI.
+	using ComponentTypeID = uint32_t;
+	constexpr ComponentTypeID MaxComponentTypes = 128;
+	using ComponentSignature = std::bitset<MaxComponentTypes>;
+
+	namespace Detail
+	{
+		inline ComponentTypeID NextComponentTypeID()
+		{
+			static std::atomic<ComponentTypeID> counter{ 0 };
+			return counter++;
+		}
+	}
+
+	template<typename T>
+	ComponentTypeID GetComponentTypeID()
+	{
+		static const ComponentTypeID id = Detail::NextComponentTypeID();
+		return id;
+	}
+
+	// Stable reference to a component inside its ComponentSet
+	using ComponentHandle = GenerationalHandle<struct ComponentTag>;
+
 	class ComponentSetBase {
 	public:
 		virtual ~ComponentSetBase() = default;
 	};
 
+	// Packed storage for every registered component of one type.
+	// Components live in a dense array that is iterated linearly, the slot table maps
+	// handles to dense indices so removal is an O(1) swap with the last element.
+	// Iteration order is insertion order, perturbed only by swap-removes, so it is
+	// the same from run to run.
 	template<typename T>
 	class ComponentSet : public ComponentSetBase {
 	public:
-		std::unordered_set<std::shared_ptr<T>> Components;
+		ComponentHandle Insert(std::shared_ptr<T> component)
+		{
+			uint32_t slotIndex;
+			if (!m_FreeSlots.empty())
+			{
+				slotIndex = m_FreeSlots.back();
+				m_FreeSlots.pop_back();
+			}
+			else
+			{
+				slotIndex = uint32_t(m_Slots.size());
+				m_Slots.push_back({});
+			}
+
+			Slot& slot = m_Slots[slotIndex];
+			slot.DenseIndex = uint32_t(m_Dense.size());
+
+			m_Dense.push_back(std::move(component));
+			m_DenseToSlot.push_back(slotIndex);
+			m_Version++;
+
+			return { slotIndex, slot.Generation };
+		}
+
+		bool Remove(ComponentHandle handle)
+		{
+			if (!Contains(handle))
+				return false;
+
+			Slot& slot = m_Slots[handle.Index];
+			uint32_t denseIndex = slot.DenseIndex;
+			uint32_t lastIndex = uint32_t(m_Dense.size() - 1);
+
+			if (denseIndex != lastIndex)
+			{
+				m_Dense[denseIndex] = std::move(m_Dense[lastIndex]);
+				m_DenseToSlot[denseIndex] = m_DenseToSlot[lastIndex];
+				m_Slots[m_DenseToSlot[denseIndex]].DenseIndex = denseIndex;
+			}
+			m_Dense.pop_back();
+			m_DenseToSlot.pop_back();
+
+			slot.DenseIndex = InvalidDenseIndex;
+			slot.Generation++;
+			m_FreeSlots.push_back(handle.Index);
+			m_Version++;
+			return true;
+		}
+
+		bool Contains(ComponentHandle handle) const
+		{
+			return handle.Index < m_Slots.size()
+				&& m_Slots[handle.Index].Generation == handle.Generation
+				&& m_Slots[handle.Index].DenseIndex != InvalidDenseIndex;
+		}
+
+		const std::shared_ptr<T>& Resolve(ComponentHandle handle) const
+		{
+			static const std::shared_ptr<T> null = nullptr;
+			return Contains(handle) ? m_Dense[m_Slots[handle.Index].DenseIndex] : null;
+		}
+
+		const std::vector<std::shared_ptr<T>>& GetDense() const { return m_Dense; }
+		size_t Size() const { return m_Dense.size(); }
+		// Bumped on every insert and remove, lets caches built over the dense array notice
+		uint64_t GetVersion() const { return m_Version; }
+
+	private:
+		static constexpr uint32_t InvalidDenseIndex = UINT32_MAX;
+
+		struct Slot
+		{
+			uint32_t DenseIndex = InvalidDenseIndex;
+			uint32_t Generation = 0;
+		};
+
+		std::vector<std::shared_ptr<T>> m_Dense;
+		std::vector<uint32_t> m_DenseToSlot;
+		std::vector<Slot> m_Slots;
+		std::vector<uint32_t> m_FreeSlots;
+		uint64_t m_Version = 0;
 	};
 
+	// Component storage of one scene. Components are registered while their owner is
+	// placed in the scene and unregistered when it leaves, so the scene's systems only
+	// ever see the scene's own components.
 	class ComponentManager
 	{
 	public:
-		static ComponentManager& Get()
-		{
-			static ComponentManager instance;
-			return instance;
-		}
-		
+		ComponentManager() = default;
+		~ComponentManager() = default;
+		ComponentManager(const ComponentManager&) = delete;
+		ComponentManager& operator=(const ComponentManager&) = delete;
+		ComponentManager(const ComponentManager&&) = delete;
+		ComponentManager& operator=(const ComponentManager&&) = delete;
+
 		template<typename T, typename... Args>
-		std::shared_ptr<T> MakeComponent(std::shared_ptr<GameObject> owner, Args&&... args)
+		static std::shared_ptr<T> MakeComponent(std::shared_ptr<GameObject> owner, Args&&... args)
 		{
 			if constexpr (has_static_Create<T>::value)
 			{
 				return T::Create(owner, std::forward<Args>(args)...);
 			}
 			else {
-				return std::make_shared<T>(owner, std::forward<Args>(args)...);
+				return AllocateComponent<T>(owner, std::forward<Args>(args)...);
 			}
 		}
 
+		// Components of one type share pooled chunks, see ComponentBlockPool
+		template<typename T, typename... Args>
+		static std::shared_ptr<T> AllocateComponent(Args&&... args)
+		{
+			return std::allocate_shared<T>(ComponentAllocator<T>(), std::forward<Args>(args)...);
+		}
+
+		// Shared components (static meshes) are registered once per placed owner and
+		// stay until the last of them unregisters
 		template<typename T>
-		void RegisterComponent(std::shared_ptr<T> component)
+		ComponentHandle RegisterComponent(std::shared_ptr<T> component)
 		{
 			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
-			GetOrCreateComponentSet<T>().Components.insert(component);
+			assert((!component->m_Manager || component->m_Manager == this) && "A component is stored by one scene at a time");
+
+			auto& set = GetOrCreateComponentSet<T>();
+			if (component->m_Manager == this && set.Resolve(component->m_StorageHandle) == component)
+			{
+				component->m_Registrations++;
+				return component->m_StorageHandle;
+			}
+
+			component->m_StorageHandle = set.Insert(component);
+			component->m_Manager = this;
+			component->m_Registrations = 1;
+			return component->m_StorageHandle;
 		}
 
 		template<typename T>
@@ -64,60 +203,87 @@ namespace Blainn
 		{
 			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
 			auto* set = GetComponentSet<T>();
-			if (set) set->Components.erase(component);
+			if (component->m_Manager != this || !set || set->Resolve(component->m_StorageHandle) != component)
+				return;
+
+			if (--component->m_Registrations > 0)
+				return;
+
+			set->Remove(component->m_StorageHandle);
+			component->m_StorageHandle = {};
+			component->m_Manager = nullptr;
 		}
 
 		template<typename T>
-		const std::unordered_set<std::shared_ptr<T>>& GetComponents() const
+		std::shared_ptr<T> GetComponent(ComponentHandle handle) const
 		{
 			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
+			const auto* set = GetComponentSet<T>();
+			return set ? set->Resolve(handle) : nullptr;
+		}
 
+		// Raw variant for per-frame passes, no reference count traffic
+		template<typename T>
+		T* GetComponentPtr(ComponentHandle handle) const
+		{
+			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
 			const auto* set = GetComponentSet<T>();
+			return set ? set->Resolve(handle).get() : nullptr;
+		}
+
+		template<typename T>
+		const std::vector<std::shared_ptr<T>>& GetComponents() const
+		{
+			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
 
-			return set ? set->Components : GetEmptySet<T>();
+			const auto* set = GetComponentSet<T>();
+
+			return set ? set->GetDense() : GetEmptySet<T>();
+		}
+
+		template<typename T>
+		uint64_t GetComponentSetVersion() const
+		{
+			const auto* set = GetComponentSet<T>();
+			return set ? set->GetVersion() : 0;
 		}
 
 	private:
 		template<typename T>
 		ComponentSet<T>& GetOrCreateComponentSet()
 		{
-			std::type_index index = typeid(T);
+			ComponentTypeID index = GetComponentTypeID<T>();
+
+			if (index >= m_ComponentMap.size())
+				m_ComponentMap.resize(index + 1);
 
-			auto it = m_ComponentMap.find(index);
-			if (it == m_ComponentMap.end())
+			if (!m_ComponentMap[index])
 			{
 				auto newSet = std::make_shared<ComponentSet<T>>();
 				m_ComponentMap[index] = newSet;
 				return *newSet;
 			}
 
-			return *static_cast<ComponentSet<T>*>(it->second.get());
+			return *static_cast<ComponentSet<T>*>(m_ComponentMap[index].get());
 		}
 
 		template<typename T>
 		ComponentSet<T>* GetComponentSet() const
 		{
-			std::type_index index = typeid(T);
-			auto it = m_ComponentMap.find(index);
-			return (it != m_ComponentMap.end())
-				? static_cast<ComponentSet<T>*>(it->second.get())
+			ComponentTypeID index = GetComponentTypeID<T>();
+			return (index < m_ComponentMap.size())
+				? static_cast<ComponentSet<T>*>(m_ComponentMap[index].get())
 				: nullptr;
 		}
 
 		template<typename T>
-		static const std::unordered_set<std::shared_ptr<T>>& GetEmptySet() {
-			static const std::unordered_set<std::shared_ptr<T>> emptySet;
+		static const std::vector<std::shared_ptr<T>>& GetEmptySet() {
+			static const std::vector<std::shared_ptr<T>> emptySet;
 			return emptySet;
 		}
 
 	private:
-		ComponentManager() = default;
-		~ComponentManager() = default;
-		ComponentManager(const ComponentManager&) = delete;
-		ComponentManager& operator=(const ComponentManager&) = delete;
-		ComponentManager(const ComponentManager&&) = delete;
-		ComponentManager& operator=(const ComponentManager&&) = delete;
-
-		std::unordered_map<std::type_index, std::shared_ptr<ComponentSetBase>> m_ComponentMap;
+		// indexed by ComponentTypeID
+		std::vector<std::shared_ptr<ComponentSetBase>> m_ComponentMap;
 	};
 }
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Blainn
+{
+	// Blocks for objects of type T carved from chunks of BlocksPerChunk. Components of
+	// one type are allocated from the same chunks, so the dense arrays of a
+	// ComponentSet point into a few contiguous ranges instead of all over the heap.
+	// Blocks are handed out in address order until the first free, then most recently
+	// freed first.
+	template<typename T>
+	class ComponentBlockPool
+	{
+	public:
+		static constexpr size_t BlocksPerChunk = 256;
+
+		// Never destroyed, components may be released by other statics during shutdown
+		static ComponentBlockPool& Get()
+		{
+			static ComponentBlockPool* pool = new ComponentBlockPool();
+			return *pool;
+		}
+
+		void* Allocate()
+		{
+			std::lock_guard lock(m_Mutex);
+			if (m_FreeBlocks)
+			{
+				FreeBlock* block = m_FreeBlocks;
+				m_FreeBlocks = block->Next;
+				return block;
+			}
+
+			if (m_ChunkCursor == BlocksPerChunk)
+			{
+				m_Chunks.push_back(std::make_unique<Block[]>(BlocksPerChunk));
+				m_ChunkCursor = 0;
+			}
+			return &m_Chunks.back()[m_ChunkCursor++];
+		}
+
+		void Free(void* pointer)
+		{
+			std::lock_guard lock(m_Mutex);
+			FreeBlock* block = static_cast<FreeBlock*>(pointer);
+			block->Next = m_FreeBlocks;
+			m_FreeBlocks = block;
+		}
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		union Block
+		{
+			FreeBlock Free;
+			alignas(T) std::byte Storage[sizeof(T)];
+		};
+
+		std::mutex m_Mutex;
+		std::vector<std::unique_ptr<Block[]>> m_Chunks;
+		size_t m_ChunkCursor = BlocksPerChunk;
+		FreeBlock* m_FreeBlocks = nullptr;
+	};
+
+	// Allocator handed to std::allocate_shared, which rebinds it to its combined
+	// control block and component, so both share one pooled block
+	template<typename T>
+	class ComponentAllocator
+	{
+	public:
+		using value_type = T;
+
+		ComponentAllocator() = default;
+		template<typename U>
+		ComponentAllocator(const ComponentAllocator<U>&) noexcept {}
+
+		T* allocate(size_t count)
+		{
+			if (count != 1)
+				return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+			return static_cast<T*>(ComponentBlockPool<T>::Get().Allocate());
+		}
+
+		void deallocate(T* pointer, size_t count) noexcept
+		{
+			if (count != 1)
+			{
+				::operator delete(pointer, std::align_val_t(alignof(T)));
+				return;
+			}
+			ComponentBlockPool<T>::Get().Free(pointer);
+		}
+
+		template<typename U>
+		bool operator==(const ComponentAllocator<U>&) const noexcept { return true; }
+	};
+}
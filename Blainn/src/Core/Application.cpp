@@ -3,15 +3,27 @@
 #include "pch.h"
 
 #include "Components/ActorComponents/CharacterComponents/CameraComponent.h"
-#include "DX12/DXRenderingContext.h"
 #include "Input.h"
+#include "JobSystem.h"
+#include "Platform/EventPump.h"
+#include "Platform/Platform.h"
+#include "Platform/ScriptedInput.h"
+#include "Render/NullRenderingBackend.h"
+#include "Render/ShadowCascadeCache.h"
+
+#if defined(_WIN32)
+#include "DX12/DXRenderingContext.h"
 #include "Util/ComboboxSelector.h"
+#include "Window.h"
 
 #include "DX12Lib/DescriptorAllocator.h"
 
+using Microsoft::WRL::ComPtr;
+#endif
+
+#include <chrono>
 #include <iostream>
 
-using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
 extern const int g_NumFrameResources;
@@ -20,15 +32,19 @@ namespace Blainn
 {
 	Application* Application::s_Instance = nullptr;
 
-	Application::Application(HINSTANCE hInstance, const ApplicationDesc& description)
+	Application::Application(NativeInstanceHandle instance, const ApplicationDesc& description)
 	{
 		if (s_Instance)
 		{
+#if defined(_WIN32)
 			MessageBox(nullptr, L"Tried to instantiate a second application", L"Error!", MB_OK);
+#else
+			std::cerr << "Tried to instantiate a second application\n";
+#endif
 			return;
 		}
 
-		m_hInstance = hInstance;
+		m_NativeInstance = instance;
 		m_AppDescription = description;
 		m_ClientWidth = description.WindowWidth;
 		m_ClientHeight = description.WindowHeight;
@@ -41,78 +57,145 @@ namespace Blainn
 
 	bool Application::Initialize()
 	{
-		WindowDesc windowDesc = {};
-		windowDesc.Title = m_AppDescription.Name;
-		windowDesc.Width = m_AppDescription.WindowWidth;
-		windowDesc.Height = m_AppDescription.WindowHeight;
-		windowDesc.Decorated = m_AppDescription.WindowDecorated;
-		windowDesc.Fullscreen = m_AppDescription.Fullscreen;
-		windowDesc.VSync = m_AppDescription.VSync;
-
-		m_Window = std::shared_ptr<Window>(Window::Create(windowDesc));
-		m_Window->SetEventCallback([this](Event& e) { OnEvent(e); });
+		JobSystemDesc jobDesc = {};
+		jobDesc.NumWorkers = m_AppDescription.NumWorkerThreads;
+		jobDesc.PinWorkers = m_AppDescription.PinWorkerThreads;
+		m_JobSystem = std::make_shared<JobSystem>(jobDesc);
+
+#if !defined(_WIN32)
+		// windows and the D3D12 backend only exist on Windows
+		m_AppDescription.Headless = true;
+#else
+		if (!m_AppDescription.Headless)
+		{
+			WindowDesc windowDesc = {};
+			windowDesc.Title = m_AppDescription.Name;
+			windowDesc.Width = m_AppDescription.WindowWidth;
+			windowDesc.Height = m_AppDescription.WindowHeight;
+			windowDesc.Decorated = m_AppDescription.WindowDecorated;
+			windowDesc.Fullscreen = m_AppDescription.Fullscreen;
+			windowDesc.VSync = m_AppDescription.VSync;
+
+			m_Window = std::shared_ptr<Window>(Window::Create(windowDesc));
+			m_Window->SetEventCallback([this](Event& e) { OnEvent(e); });
+
+			if (!m_Window->Init())
+				return false;
+
+			m_EventPump = std::make_shared<Win32EventPump>();
+			m_RenderingContext = std::make_shared<DXRenderingContext>();
+			m_RenderingBackend = m_RenderingContext;
+		}
+		else
+#endif
+		{
+			if (m_InputScript)
+				m_InputScript->SetEventCallback([this](Event& e) { OnEvent(e); });
+			m_EventPump = std::make_shared<HeadlessEventPump>(m_InputScript);
+			m_RenderingBackend = std::make_shared<NullRenderingBackend>();
+		}
 
 		Input::Init();
 
-		if (!m_Window->Init())
-			return false;
-
-		m_RenderingContext = std::make_shared<DXRenderingContext>();
-		m_RenderingContext->Init(m_Window);
+		m_RenderingBackend->Init(m_Window);
+		if (!m_Window)
+			m_RenderingBackend->Resize(m_ClientWidth, m_ClientHeight);
 
-		m_RenderingContext->CreateResources();
+		m_RenderingBackend->CreateResources();
 
 		m_Scene = std::make_shared<Scene>();
 
+		m_FixedTimestep.SetTickRate(m_AppDescription.SimulationTickRate);
+		m_FixedTimestep.SetMaxSubsteps(m_AppDescription.MaxSimulationSubsteps);
+
 		m_bPaused = false;
 		OnResize();
 
 		return true;
 	}
 
+	void Application::SetHeadless(uint32_t frameCount)
+	{
+		m_AppDescription.Headless = true;
+		m_AppDescription.HeadlessFrames = frameCount;
+	}
+
 	int Application::Run()
 	{
 		OnInit();
-		MSG msg = { nullptr };
 
 		m_Timer.Reset();
+		m_SimulationTimer.Reset();
+		m_FixedTimestep.Reset();
+
+		if (m_AppDescription.Headless)
+			return RunHeadless();
 
-		while (msg.message != WM_QUIT)
+		while (m_EventPump->PumpEvents())
 		{
+			m_Timer.Tick();
 
-			if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+			if (!m_bPaused)
 			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
+				CalculateFrameStats();
+				Update(m_Timer);
+				Draw(m_Timer);
 			}
 			else
-			{
-				m_Timer.Tick();
+				Platform::Sleep(10);
+		}
+		return m_EventPump->GetExitCode();
+	}
 
-				if (!m_bPaused)
-				{
-					CalculateFrameStats();
-					Update(m_Timer);
-					Draw(m_Timer);
-				}
-				else
-					Sleep(10);
-			}
+	int Application::RunHeadless()
+	{
+		RenderingStats totals;
+		uint32_t frameCount = 0;
+
+		// frames advance by a fixed time so runs repeat exactly, the wall clock only
+		// goes into the summary
+		auto start = std::chrono::steady_clock::now();
+		while ((m_AppDescription.HeadlessFrames == 0 || frameCount < m_AppDescription.HeadlessFrames) && m_EventPump->PumpEvents())
+		{
+			m_Timer.Step(m_AppDescription.HeadlessFrameTime);
+			Update(m_Timer);
+			Draw(m_Timer);
 
+			totals.Add(m_RenderingBackend->GetStats());
+			frameCount++;
+		}
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (frameCount > 0)
+		{
+			std::cout << m_AppDescription.Name << ": " << frameCount << " headless frames in " << milliseconds << " ms, "
+				<< milliseconds / frameCount << " ms per frame\n"
+				<< "per frame: " << totals.DrawCalls / frameCount << " draws, "
+				<< totals.Instances / frameCount << " instances, "
+				<< totals.Dispatches / frameCount << " dispatches, "
+				<< totals.CommandLists / frameCount << " command lists, "
+				<< totals.UploadBytes / frameCount << " bytes uploaded\n";
+
+			const ShadowCascadeCache& shadowCache = m_RenderingBackend->GetShadowCache();
+			std::cout << "static shadows drawn/reused:";
+			for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+				std::cout << " " << shadowCache.GetStats(i).Rendered << "/" << shadowCache.GetStats(i).Reused;
+			std::cout << "\n";
 		}
-		return (int)msg.wParam;
+		return m_EventPump->GetExitCode();
 	}
 
 	void Application::Close()
 	{
-		PostQuitMessage(0);
+		if (m_EventPump)
+			m_EventPump->RequestQuit(0);
 	}
 
 	void Application::OnResize()
 	{
 		if(m_ClientWidth > 0 && m_ClientHeight > 0)
 		{
-			m_RenderingContext->Resize(m_ClientWidth, m_ClientWidth);
+			m_RenderingBackend->Resize(m_ClientWidth, m_ClientHeight);
 			if(m_Scene->GetMainCamera())
 				m_Scene->GetMainCamera()->GetCamera().SetViewportDimentions(m_ClientWidth, m_ClientHeight);
 		}
@@ -121,26 +204,50 @@ namespace Blainn
 
 	void Application::Update(const GameTimer& timer)
 	{
-		m_RenderingContext->OnUpdate();
+		m_RenderingBackend->OnUpdate();
 
 		Blainn::Input::Update();
 
-		for (Layer* layer : m_LayerStack)
-			layer->OnUpdate(timer);
+		if (!m_AppDescription.FixedTimestep)
+		{
+			Simulate(timer);
+			Input::EndSimulationStep();
+			m_SimulationSteps = 1;
+			m_InterpolationAlpha = 1.f;
+		}
+		else
+		{
+			m_SimulationSteps = m_FixedTimestep.Advance(timer.DeltaTime());
+			for (uint32_t step = 0; step < m_SimulationSteps; ++step)
+			{
+				m_SimulationTimer.Step(m_FixedTimestep.GetStepTime());
+				Simulate(m_SimulationTimer);
+				Input::EndSimulationStep();
+			}
+			m_InterpolationAlpha = m_FixedTimestep.GetAlpha();
+
+			if (m_Scene->GetMainCamera())
+				m_Scene->GetMainCamera()->Interpolate(m_InterpolationAlpha);
+		}
 
-		m_Scene->UpdateScene(timer);
 		if (m_Scene->GetMainCamera())
-			m_RenderingContext->UpdateMainPassConstantBuffers(
+			m_RenderingBackend->UpdateMainPassConstantBuffers(
 				timer, m_Scene->GetMainCamera()->GetCamera()
 			);
-		m_RenderingContext->UpdateObjectsConstantBuffers();
+		m_RenderingBackend->UpdateObjectsConstantBuffers();
+	}
 
-		Input::UpdateMouseDelta(0, 0);
+	void Application::Simulate(const GameTimer& timer)
+	{
+		for (Layer* layer : m_LayerStack)
+			layer->OnUpdate(timer);
+
+		m_Scene->UpdateScene(timer);
 	}
 
 	void Application::Draw(const GameTimer& timer)
 	{
-		m_RenderingContext->Draw();
+		m_RenderingBackend->Draw();
 	}
 
 #pragma region Window Event Callbacks
@@ -167,7 +274,9 @@ namespace Blainn
 			m_ClientWidth = e.GetWidth();
 			m_ClientHeight = e.GetHeight();
 		}
-		if (m_RenderingContext && m_RenderingContext->IsInitialized())
+#if defined(_WIN32)
+		// only the Win32 window sends resize events
+		if (m_RenderingBackend && m_RenderingBackend->IsInitialized())
 		{
 			if (e.GetWParam() == SIZE_MINIMIZED)
 			{
@@ -207,6 +316,7 @@ namespace Blainn
 					OnResize();
 			}
 		}
+#endif
 		return false;
 	}
 
@@ -296,7 +406,9 @@ namespace Blainn
 				L"    fps: " + fpsStr +
 				L"   mspf: " + mspfStr;
 
+#if defined(_WIN32)
 			SetWindowText(m_Window->GetNativeWindow(), windowText.c_str());
+#endif
 
 			// Reset for next average.
 			frameCnt = 0;
@@ -3,25 +3,31 @@
 #include "Events/ApplicationEvent.h"
 #include "Events/KeyEvent.h"
 #include "Events/MouseEvent.h"
+#include "FixedTimestep.h"
 #include "GameTimer.h"
 #include "LayerStack.h"
+#include "Platform/Platform.h"
 #include "Scene/Scene.h"
-#include "Window.h"
 
 #include "Util/MathHelper.h"
-#include "Util/Util.h"
 
+#if defined(_WIN32)
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
 #pragma comment(lib, "dxgi.lib")
+#endif
 
 extern const int g_NumFrameResources;
-extern const UINT32 g_NumObjects;
 
 namespace Blainn
 {
 	class DXRenderingContext;
 	class DXResourceManager;
+	class EventPump;
+	class JobSystem;
+	class RenderingBackend;
+	class ScriptedInput;
+	class Window;
 
 
 	struct ApplicationDesc
@@ -31,17 +37,41 @@ namespace Blainn
 		bool WindowDecorated = false;
 		bool Fullscreen = false;
 		bool VSync = true;
+
+		// 0 picks hardware_concurrency - 1
+		uint32_t NumWorkerThreads = 0;
+		bool PinWorkerThreads = false;
+
+		// Simulates layers and the scene in steps of 1 / SimulationTickRate seconds,
+		// rendering blends between the last two steps. Off, every frame is one step
+		// of whatever the frame took.
+		bool FixedTimestep = false;
+		float SimulationTickRate = 60.f;
+		// Steps per frame at most, time beyond that is dropped
+		uint32_t MaxSimulationSubsteps = 4;
+
+		// No window and no GPU, the null rendering backend runs the CPU side of every
+		// frame. Run returns after HeadlessFrames frames of HeadlessFrameTime seconds
+		// each, 0 runs until Close.
+		bool Headless = false;
+		uint32_t HeadlessFrames = 0;
+		float HeadlessFrameTime = 1.f / 60.f;
 	};
 
 	class Application
 	{
 	public:
-		Application(HINSTANCE hinstance, const ApplicationDesc& description = ApplicationDesc());
+		Application(NativeInstanceHandle instance, const ApplicationDesc& description = ApplicationDesc());
 		virtual ~Application();
 
 		static inline Application& Get() { return *s_Instance; }
 
 		bool Initialize();
+		// Switches to headless before Initialize, for entry points that run without
+		// a window whatever the application asked for
+		void SetHeadless(uint32_t frameCount);
+		// Input played back by headless runs, set before Initialize
+		void SetInputScript(std::shared_ptr<ScriptedInput> script) { m_InputScript = script; }
 
 		int Run();
 		void Close();
@@ -58,17 +88,29 @@ namespace Blainn
 		void PopOverlay(Layer* overlay);
 
 		std::shared_ptr<Scene> GetScene() { return m_Scene; }
-		inline HINSTANCE GetAppInstance() const { return m_hInstance; }
 		inline Window& GetWindow() const { return *m_Window; }
 
-		HINSTANCE GetNativeInstance() const { return m_hInstance; }
+		NativeInstanceHandle GetNativeInstance() const { return m_NativeInstance; }
+		// Null when headless
 		std::shared_ptr<DXRenderingContext> GetRenderingContext() const { return m_RenderingContext; }
+		std::shared_ptr<RenderingBackend> GetRenderingBackend() const { return m_RenderingBackend; }
+		JobSystem& GetJobSystem() const { return *m_JobSystem; }
 
 		float AspectRatio() const;
 
+		// How far the frame being rendered is from the previous simulation step to the
+		// last one, always 1 without a fixed timestep
+		float GetInterpolationAlpha() const { return m_InterpolationAlpha; }
+		// Simulation steps run by the last frame
+		uint32_t GetSimulationSteps() const { return m_SimulationSteps; }
+
 	protected:
+		int RunHeadless();
+
 		virtual void OnResize();
 		virtual void Update(const GameTimer& timer);
+		// One simulation step of the layers and the scene
+		virtual void Simulate(const GameTimer& timer);
 		virtual void Draw(const GameTimer& timer);
 
 		// Window events
@@ -83,14 +125,23 @@ namespace Blainn
 	protected:
 		ApplicationDesc m_AppDescription;
 
-		HINSTANCE m_hInstance;
+		NativeInstanceHandle m_NativeInstance = nullptr;
 
 		static Application* s_Instance;
 
 		std::shared_ptr<Window> m_Window;
+		std::shared_ptr<EventPump> m_EventPump;
+		std::shared_ptr<ScriptedInput> m_InputScript;
+		std::shared_ptr<RenderingBackend> m_RenderingBackend;
 		std::shared_ptr<DXRenderingContext> m_RenderingContext;
+		std::shared_ptr<JobSystem> m_JobSystem;
 
 		GameTimer m_Timer;
+		// Advanced by whole steps in fixed timestep mode
+		GameTimer m_SimulationTimer;
+		FixedTimestep m_FixedTimestep;
+		float m_InterpolationAlpha = 1.f;
+		uint32_t m_SimulationSteps = 0;
 
 		float m_lastFrameTime = 0.f;
 
@@ -106,10 +157,8 @@ namespace Blainn
 		bool m_bFullscreen = false;
 
 		std::shared_ptr<Scene> m_Scene;
-
-		POINT m_LastMousePos;
 	};
 
 
-	Application* CreateApplication(HINSTANCE hInstance);
+	Application* CreateApplication(NativeInstanceHandle instance);
 }
@@ -1,12 +1,13 @@
 #pragma once
 
+#include "Platform/Platform.h"
 #include "UUID.h"
 
 #include <stack>
 #include <stdexcept>
 #include <unordered_map>
 
-extern const UINT32 g_NumObjects;
+extern const uint32_t g_NumObjects;
 
 namespace Blainn
 {
@@ -19,22 +20,22 @@ namespace Blainn
 			return instance;
 		}
 
-		UINT32 GetCBIdx(UUID uuid)
+		uint32_t GetCBIdx(UUID uuid)
 		{
 			auto it = m_UUIDToCBIndex.find(uuid);
 			return (it != m_UUIDToCBIndex.end()) ? it->second : UINT32_MAX;
 		}
 
-		UINT32 AssignCBIdx(UUID uuid)
+		uint32_t AssignCBIdx(UUID uuid)
 		{
-			UINT32 idx = GetCBIdx(uuid);
+			uint32_t idx = GetCBIdx(uuid);
 			if (idx != UINT32_MAX)
 				return idx;
 
 			if (m_FreeBufferIndices.empty())
 				throw std::runtime_error("No free constant buffer indices available");
 
-			UINT32 bufferIndex = m_FreeBufferIndices.top();
+			uint32_t bufferIndex = m_FreeBufferIndices.top();
 			m_FreeBufferIndices.pop();
 			m_UUIDToCBIndex[uuid] = bufferIndex;
 
@@ -46,25 +47,25 @@ namespace Blainn
 			auto it = m_UUIDToCBIndex.find(uuid);
 			if (it != m_UUIDToCBIndex.end())
 			{
-				UINT32 bufferIndex = it->second;
+				uint32_t bufferIndex = it->second;
 				m_FreeBufferIndices.push(bufferIndex);
 				m_UUIDToCBIndex.erase(it);
 			}
 			else 
-				OutputDebugStringW(L"This uuid was not assigned a constant buffer index!");
+				Platform::DebugPrint("This uuid was not assigned a constant buffer index!\n");
 		}
 
 	private:
 		CBIndexManager()
 		{
-			for (UINT32 i = g_NumObjects - 1; i != 0; i--)
+			for (uint32_t i = g_NumObjects - 1; i != 0; i--)
 			{
 				m_FreeBufferIndices.push(i);
 			}
 		}
 
-		std::unordered_map<UUID, UINT32> m_UUIDToCBIndex;
-		std::stack<UINT32> m_FreeBufferIndices;
+		std::unordered_map<UUID, uint32_t> m_UUIDToCBIndex;
+		std::stack<uint32_t> m_FreeBufferIndices;
 
 	};
 }
@@ -85,6 +85,7 @@ Raw delegate payload: 10
 #include <vector>
 #include <memory>
 #include <tuple>
+#include <cstring>
 
 ///////////////////////////////////////////////////////////////
 //////////////////// DEFINES SECTION //////////////////////////
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Handle.h"
+
+namespace Blainn
+{
+	class GameObject;
+
+	using EntityHandle = GenerationalHandle<struct EntityTag>;
+
+	// Every GameObject registers itself here on construction and is released on
+	// destruction. Render and update passes keep EntityHandles instead of weak_ptrs
+	// and resolve them with a plain array lookup.
+	class EntityRegistry
+	{
+	public:
+		static EntityRegistry& Get()
+		{
+			static EntityRegistry instance;
+			return instance;
+		}
+
+		EntityHandle Register(GameObject* object) { return m_Entities.Insert(object); }
+		void Unregister(EntityHandle handle) { m_Entities.Remove(handle); }
+
+		GameObject* Resolve(EntityHandle handle) const { return m_Entities.Resolve(handle); }
+		bool IsAlive(EntityHandle handle) const { return m_Entities.Contains(handle); }
+
+		size_t GetEntityCount() const { return m_Entities.Size(); }
+
+		// Bumped whenever any object changes its parent
+		void OnHierarchyChanged() { m_HierarchyVersion++; }
+		uint64_t GetHierarchyVersion() const { return m_HierarchyVersion; }
+
+	private:
+		EntityRegistry() = default;
+		~EntityRegistry() = default;
+		EntityRegistry(const EntityRegistry&) = delete;
+		EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+		SlotTable<GameObject, EntityTag> m_Entities;
+		uint64_t m_HierarchyVersion = 0;
+	};
+}
@@ -2,20 +2,20 @@
 
 #include "Event.h"
 
+#include <cstdint>
 #include <sstream>
-#include <windows.h>
 
 namespace Blainn
 {
 	class WindowResizeEvent : public Event
 	{
 	public:
-		WindowResizeEvent(WPARAM wParam, unsigned int width, unsigned int height)
+		WindowResizeEvent(uintptr_t wParam, unsigned int width, unsigned int height)
 			: m_wParam(wParam), m_Width(width), m_Height(height) {}
 
 		inline int GetWidth() const { return m_Width; }
 		inline int GetHeight() const { return m_Height; }
-		inline WPARAM GetWParam() const { return m_wParam; }
+		inline uintptr_t GetWParam() const { return m_wParam; }
 
 		std::string ToString() const override
 		{
@@ -29,7 +29,7 @@ namespace Blainn
 
 	private:
 		int m_Width, m_Height;
-		WPARAM m_wParam;
+		uintptr_t m_wParam;
 	};
 
 	class WindowMovedEvent : public Event
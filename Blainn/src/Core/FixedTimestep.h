@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Blainn
+{
+	// Accumulates real frame time and hands it out as whole simulation steps of a
+	// fixed length. What is left over is the interpolation alpha between the last two
+	// simulated states. Frames that would need more than the substep limit drop the
+	// excess time, so a slow frame slows the simulation down instead of making the
+	// next frame even slower.
+	class FixedTimestep
+	{
+	public:
+		void SetTickRate(float ticksPerSecond)
+		{
+			m_StepTime = 1.0 / std::max(ticksPerSecond, 1.f);
+		}
+		float GetTickRate() const { return float(1.0 / m_StepTime); }
+
+		void SetMaxSubsteps(uint32_t maxSubsteps) { m_MaxSubsteps = std::max(maxSubsteps, 1u); }
+		uint32_t GetMaxSubsteps() const { return m_MaxSubsteps; }
+
+		// Adds a frame worth of real time, returns how many steps to simulate now
+		uint32_t Advance(double frameTime)
+		{
+			m_Accumulator += std::max(frameTime, 0.0);
+
+			uint32_t steps = uint32_t(m_Accumulator / m_StepTime);
+			m_DroppedTime = 0.0;
+			if (steps > m_MaxSubsteps)
+			{
+				m_DroppedTime = (steps - m_MaxSubsteps) * m_StepTime;
+				steps = m_MaxSubsteps;
+			}
+			m_Accumulator = std::max(m_Accumulator - m_DroppedTime - steps * m_StepTime, 0.0);
+			return steps;
+		}
+
+		// Discards the accumulated time, after a pause or a long load
+		void Reset() { m_Accumulator = 0.0; m_DroppedTime = 0.0; }
+
+		double GetStepTime() const { return m_StepTime; }
+		// 0 renders the previous simulation step, 1 the last one
+		float GetAlpha() const { return float(std::min(m_Accumulator / m_StepTime, 1.0)); }
+		// Time the last Advance threw away because of the substep limit
+		double GetDroppedTime() const { return m_DroppedTime; }
+
+	private:
+		double m_StepTime = 1.0 / 60.0;
+		double m_Accumulator = 0.0;
+		double m_DroppedTime = 0.0;
+		uint32_t m_MaxSubsteps = 4;
+	};
+}
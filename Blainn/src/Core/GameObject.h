@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Core/EntityRegistry.h"
 #include "Core/GameTimer.h"
 #include "Core/UUID.h"
 #include "Components/Component.h"
@@ -12,8 +13,15 @@ namespace Blainn
 	{
 		friend class Scene;
 	public:
-		GameObject() { OnInit(); }
-		virtual ~GameObject() noexcept {}
+		GameObject()
+			: m_Handle(EntityRegistry::Get().Register(this))
+		{ OnInit(); }
+		virtual ~GameObject() noexcept
+		{
+			if (m_ParentHandle.IsValid() || !m_Children.empty())
+				EntityRegistry::Get().OnHierarchyChanged();
+			EntityRegistry::Get().Unregister(m_Handle);
+		}
 
 		virtual void OnInit() {}
 		virtual void OnBegin() {}
@@ -26,12 +34,22 @@ namespace Blainn
 				child->OnAttach();
 		}
 
+		// Children are not recursed into, the scene ticks every object of a hierarchy
+		// exactly once from its flattened update order
 		virtual void OnUpdate(const GameTimer& gt)
 		{
-			for (auto& component : m_Components)
-				component->OnUpdate(gt);
-			for (auto& child : m_Children)
-				child->OnUpdate(gt);
+			const SystemScheduler* systems = m_ParentScene ? &m_ParentScene->GetSystemScheduler() : nullptr;
+			uint32_t componentTicks = 0;
+			for (size_t i = 0; i < m_Components.size(); ++i)
+			{
+				if (systems && systems->IsSystemDriven(m_ComponentTypes[i].Family))
+					continue;
+				m_Components[i]->OnUpdate(gt);
+				componentTicks++;
+			}
+
+			if (m_ParentScene)
+				m_ParentScene->AddComponentTicks(componentTicks);
 		}
 
 		virtual void OnDestroy() {}
@@ -47,6 +65,9 @@ namespace Blainn
 			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
 			std::vector<std::shared_ptr<T>> foundComponents;
 
+			if (!MayHaveComponent<T>())
+				return foundComponents;
+
 			for (const auto& comp : m_Components)
 				if (std::shared_ptr<T> castedComp = std::dynamic_pointer_cast<T>(comp))
 					foundComponents.push_back(castedComp);
@@ -55,24 +76,71 @@ namespace Blainn
 		}
 
 
+		// Exact types and component families (e.g. CollisionComponent for a
+		// SphereCollisionComponent) resolve through the slot table in constant time.
+		// Only intermediate base classes fall back to a dynamic_cast scan, and only
+		// when a component of the same family is attached at all.
 		template<typename T>
 		std::shared_ptr<T> GetComponent() const
 		{
 			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
+			uint32_t slot = FindComponentSlot(GetComponentTypeID<T>());
+			if (slot != InvalidComponentSlot)
+				return std::static_pointer_cast<T>(m_Components[slot]);
+
+			if (!MayHaveComponent<T>())
+				return nullptr;
+
 			for (const auto& comp : m_Components)
 				if (std::shared_ptr<T> castedComp = std::dynamic_pointer_cast<T>(comp))
 					return castedComp;
 			return nullptr;
 		}
 
+		// Same lookup as GetComponent but without touching the reference count.
+		// Meant for per-frame passes, do not store the returned pointer.
+		template<typename T>
+		T* GetComponentPtr() const
+		{
+			static_assert(std::is_base_of<ComponentBase, T>::value, "Component must be derived from component");
+			uint32_t slot = FindComponentSlot(GetComponentTypeID<T>());
+			if (slot != InvalidComponentSlot)
+				return static_cast<T*>(m_Components[slot].get());
+
+			if (!MayHaveComponent<T>())
+				return nullptr;
+
+			for (const auto& comp : m_Components)
+				if (T* castedComp = dynamic_cast<T*>(comp.get()))
+					return castedComp;
+			return nullptr;
+		}
+
+		template<typename T>
+		bool HasComponent() const
+		{
+			return GetComponent<T>() != nullptr;
+		}
+
+		const ComponentSignature& GetComponentSignature() const { return m_ComponentSignature; }
+
 
 		template<typename T, typename... Args>
 		std::shared_ptr<T> AddComponent(Args&&... args)
 		{
 			static_assert(std::is_base_of<ComponentBase, T>::value, "T must be a component");
-			auto component = ComponentManager::Get().MakeComponent<T>(shared_from_this(), std::forward<Args>(args)...);
+			auto component = ComponentManager::MakeComponent<T>(shared_from_this(), std::forward<Args>(args)...);
+			// shared components (static meshes) keep the object that created them
+			if (!component->m_OwnerHandle.IsValid())
+				component->m_OwnerHandle = m_Handle;
 			component->OnAttach();
+			if (m_ParentScene)
+				component->RegisterWith(m_ParentScene->GetComponentManager());
 			m_Components.push_back(component);
+			m_ComponentTypes.push_back({ GetComponentTypeID<T>(), GetComponentTypeID<typename T::ComponentFamily>() });
+			IndexComponent(uint32_t(m_Components.size() - 1));
+			if (m_ParentScene)
+				m_ParentScene->RefreshTransform(*this);
 			return component;
 		}
 
@@ -80,16 +148,24 @@ namespace Blainn
 		template<typename T>
 		void RemoveAllComponents()
 		{
-			auto it = std::remove_if(m_Components.begin(), m_Components.end(),
-				[](const std::shared_ptr<ComponentBase>& comp)
-				{
-					return dynamic_cast<T*>(comp.get()) != nullptr;
-				});
+			if (!MayHaveComponent<T>())
+				return;
 
-			for (auto i = it; i != m_Components.end(); i++)
-				(*i)->OnDestroy;
+			for (size_t i = m_Components.size(); i-- > 0;)
+			{
+				if (dynamic_cast<T*>(m_Components[i].get()) == nullptr)
+					continue;
 
-			m_Components.erase(it, m_Components.end());
+				m_Components[i]->OnDestroy();
+				if (m_ParentScene)
+					m_Components[i]->Unregister();
+				m_Components.erase(m_Components.begin() + i);
+				m_ComponentTypes.erase(m_ComponentTypes.begin() + i);
+			}
+
+			RebuildComponentSlots();
+			if (m_ParentScene)
+				m_ParentScene->RefreshTransform(*this);
 		}
 
 
@@ -104,7 +180,13 @@ namespace Blainn
 			if (it != m_Components.end())
 			{
 				(*it)->OnDestroy();
+				if (m_ParentScene)
+					(*it)->Unregister();
+				m_ComponentTypes.erase(m_ComponentTypes.begin() + (it - m_Components.begin()));
 				m_Components.erase(it);
+				RebuildComponentSlots();
+				if (m_ParentScene)
+					m_ParentScene->RefreshTransform(*this);
 			}
 		}
 
@@ -116,11 +198,13 @@ namespace Blainn
 
 			auto child = std::make_shared<T>(std::forward<Args>(args)...);
 			child->m_Parent = shared_from_this();
+			child->m_ParentHandle = m_Handle;
+			EntityRegistry::Get().OnHierarchyChanged();
 			m_Children.push_back(child);
 
 			if (m_ParentScene)
 			{
-				child->m_ParentScene = m_ParentScene;
+				m_ParentScene->InsertIntoUpdateOrder(child);
 				m_ParentScene->QueueGameObject(child);
 			}
 			return child;
@@ -132,12 +216,16 @@ namespace Blainn
 			auto it = std::find(m_Children.begin(), m_Children.end(), child);
 			if (it != m_Children.end())
 			{
-				child->m_Parent.reset();
-				if (m_ParentScene)
+				// the scene takes the subtree's size off its ancestors, so the child
+				// leaves the order while it still has a parent
+				if (Scene* scene = child->m_ParentScene)
 				{
-					child->m_ParentScene = nullptr;
-					m_ParentScene->RemoveGameObject(child);
+					scene->RemoveFromUpdateOrder(child.get());
+					scene->RemoveGameObject(child);
 				}
+				child->m_Parent.reset();
+				child->m_ParentHandle = {};
+				EntityRegistry::Get().OnHierarchyChanged();
 				m_Children.erase(it);
 			}
 		}
@@ -145,6 +233,12 @@ namespace Blainn
 
 		void AddChild(std::shared_ptr<GameObject> child)
 		{
+			// within a scene the subtree is moved over in one go, otherwise it leaves
+			// its old scene's order and is inserted into this one's
+			const bool bMoveInScene = m_ParentScene && child->m_ParentScene == m_ParentScene;
+			if (child->m_ParentScene && !bMoveInScene)
+				child->m_ParentScene->RemoveFromUpdateOrder(child.get());
+
 			auto prevParent = child->m_Parent.lock();
 			if (prevParent)
 			{
@@ -153,13 +247,21 @@ namespace Blainn
 					prevParent->m_Children.erase(it);
 
 				child->m_Parent.reset();
+				child->m_ParentHandle = {};
 			}
 
 			child->m_Parent = shared_from_this();
+			child->m_ParentHandle = m_Handle;
+			EntityRegistry::Get().OnHierarchyChanged();
 
 			child->OnAttach();
 
 			m_Children.push_back(child);
+
+			if (bMoveInScene)
+				m_ParentScene->MoveInUpdateOrder(child.get(), prevParent.get());
+			else if (m_ParentScene)
+				m_ParentScene->InsertIntoUpdateOrder(child);
 		}
 
 
@@ -179,23 +281,110 @@ namespace Blainn
 						prevParent->m_Children.erase(it);
 
 					m_Parent.reset();
+					m_ParentHandle = {};
+					EntityRegistry::Get().OnHierarchyChanged();
 				}
+
+				// becomes a root of its scene, its subtree moves to the end of the order
+				if (Scene* scene = m_ParentScene)
+					scene->MoveInUpdateOrder(this, prevParent.get());
 			}
 		}
 
 
 		const std::vector<std::shared_ptr<GameObject>>& GetChildren() const { return m_Children; }
 		UUID GetUUID() const { return m_UUID; }
+		EntityHandle GetHandle() const { return m_Handle; }
 		std::shared_ptr<GameObject> GetParent() const { return m_Parent.lock(); }
+		GameObject* GetParentPtr() const { return EntityRegistry::Get().Resolve(m_ParentHandle); }
+		// Null until the object got registered with a scene
+		Scene* GetScene() const { return m_ParentScene; }
+
+	private:
+		static constexpr uint32_t InvalidComponentSlot = UINT32_MAX;
+
+		// Called by the scene as the object is placed in its update order and taken out
+		void RegisterComponents(ComponentManager& manager)
+		{
+			for (auto& comp : m_Components)
+				comp->RegisterWith(manager);
+		}
+
+		void UnregisterComponents()
+		{
+			for (auto& comp : m_Components)
+				comp->Unregister();
+		}
+
+		struct ComponentTypeIDs
+		{
+			ComponentTypeID Exact;
+			ComponentTypeID Family;
+		};
+
+		template<typename T>
+		bool MayHaveComponent() const
+		{
+			if constexpr (requires { typename T::ComponentFamily; })
+				return HasComponentType(GetComponentTypeID<typename T::ComponentFamily>());
+			else
+				return !m_Components.empty();
+		}
+
+		bool HasComponentType(ComponentTypeID typeID) const
+		{
+			return typeID < MaxComponentTypes && m_ComponentSignature.test(typeID);
+		}
+
+		uint32_t FindComponentSlot(ComponentTypeID typeID) const
+		{
+			return typeID < m_ComponentSlots.size() ? m_ComponentSlots[typeID] : InvalidComponentSlot;
+		}
+
+		// The first component of a type owns its slot, same as the old linear scan returned
+		void IndexComponent(uint32_t componentIndex)
+		{
+			const ComponentTypeIDs& ids = m_ComponentTypes[componentIndex];
+			for (ComponentTypeID typeID : { ids.Exact, ids.Family })
+			{
+				assert(typeID < MaxComponentTypes && "Too many component types, raise MaxComponentTypes");
+				if (typeID >= m_ComponentSlots.size())
+					m_ComponentSlots.resize(typeID + 1, InvalidComponentSlot);
+				if (m_ComponentSlots[typeID] == InvalidComponentSlot)
+					m_ComponentSlots[typeID] = componentIndex;
+				m_ComponentSignature.set(typeID);
+			}
+		}
+
+		void RebuildComponentSlots()
+		{
+			m_ComponentSignature.reset();
+			std::fill(m_ComponentSlots.begin(), m_ComponentSlots.end(), InvalidComponentSlot);
+			for (uint32_t i = 0; i < m_Components.size(); ++i)
+				IndexComponent(i);
+		}
 
 	protected:
 		UUID m_UUID{};
+		EntityHandle m_Handle{};
 
 		std::weak_ptr<GameObject> m_Parent;
+		EntityHandle m_ParentHandle{};
 		std::vector<std::shared_ptr<GameObject>> m_Children;
 		std::vector<std::shared_ptr<ComponentBase>> m_Components;
 
+		// Parallel to m_Components
+		std::vector<ComponentTypeIDs> m_ComponentTypes;
+		// Indexed by ComponentTypeID, holds an index into m_Components
+		std::vector<uint32_t> m_ComponentSlots;
+		ComponentSignature m_ComponentSignature;
+
 		Scene* m_ParentScene = nullptr;
+		// Position in m_ParentScene's update order, kept by the scene
+		uint32_t m_UpdateOrderIndex = UINT32_MAX;
+		// This object and its descendants placed in the update order, which follow
+		// it there contiguously
+		uint32_t m_OrderedSubtreeSize = 0;
 	};
 }
 
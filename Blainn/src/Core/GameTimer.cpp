@@ -3,18 +3,17 @@
 //***************************************************************************************
 #include "pch.h"
 
-#include <windows.h>
 #include "GameTimer.h"
 
+#include "Platform/Platform.h"
+
 namespace Blainn
 {
 	GameTimer::GameTimer()
 		: mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0),
 		mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 	{
-		__int64 countsPerSec;
-		QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-		mSecondsPerCount = 1.0 / (double)countsPerSec;
+		mSecondsPerCount = 1.0 / (double)Platform::GetTicksPerSecond();
 	}
 
 	// Returns the total time elapsed since Reset() was called, NOT counting any
@@ -58,8 +57,7 @@ namespace Blainn
 
 	void GameTimer::Reset()
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		int64_t currTime = Platform::GetTicks();
 
 		mBaseTime = currTime;
 		mPrevTime = currTime;
@@ -69,8 +67,7 @@ namespace Blainn
 
 	void GameTimer::Start()
 	{
-		__int64 startTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+		int64_t startTime = Platform::GetTicks();
 
 
 		// Accumulate the time elapsed between stop and start pairs.
@@ -93,8 +90,7 @@ namespace Blainn
 	{
 		if (!mStopped)
 		{
-			__int64 currTime;
-			QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+			int64_t currTime = Platform::GetTicks();
 
 			mStopTime = currTime;
 			mStopped = true;
@@ -109,8 +105,7 @@ namespace Blainn
 			return;
 		}
 
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		int64_t currTime = Platform::GetTicks();
 		mCurrTime = currTime;
 
 		// Time difference between this frame and the previous.
@@ -128,4 +123,13 @@ namespace Blainn
 		}
 	}
 
+	void GameTimer::Step(double deltaTime)
+	{
+		// whole counts, so TotalTime of a stepped timer does not drift
+		int64_t stepCounts = (int64_t)(deltaTime / mSecondsPerCount + 0.5);
+		mCurrTime = mPrevTime + stepCounts;
+		mPrevTime = mCurrTime;
+		mDeltaTime = stepCounts * mSecondsPerCount;
+	}
+
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 //***************************************************************************************
 // GameTimer.h by Frank Luna (C) 2011 All Rights Reserved.
 //***************************************************************************************
@@ -18,16 +20,19 @@ namespace Blainn
 		void Start(); // Call when unpaused.
 		void Stop();  // Call when paused.
 		void Tick();  // Call every frame.
+		// Advances by a fixed amount instead of reading the clock, for simulation steps.
+		void Step(double deltaTime);
 
 	private:
+		// Counts are Platform::GetTicks ticks
 		double mSecondsPerCount;
 		double mDeltaTime;
 
-		__int64 mBaseTime;
-		__int64 mPausedTime;
-		__int64 mStopTime;
-		__int64 mPrevTime;
-		__int64 mCurrTime;
+		int64_t mBaseTime;
+		int64_t mPausedTime;
+		int64_t mStopTime;
+		int64_t mPrevTime;
+		int64_t mCurrTime;
 
 		bool mStopped;
 	};
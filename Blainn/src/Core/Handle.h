@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Blainn
+{
+	// Index + generation reference into a SlotTable.
+	// The generation of a slot is bumped every time the slot is released, so a handle
+	// that outlived its object fails to resolve instead of pointing at whatever reused
+	// the slot. Checking it is a plain compare, no reference counting involved.
+	template<typename Tag>
+	struct GenerationalHandle
+	{
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		uint32_t Index = InvalidIndex;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Index != InvalidIndex; }
+		bool operator==(const GenerationalHandle& other) const = default;
+	};
+
+	// Central table of non-owning pointers addressed by GenerationalHandle.
+	// Not thread safe for Insert/Remove, resolving from several threads is fine as long
+	// as nothing is inserted or removed at the same time.
+	template<typename T, typename Tag>
+	class SlotTable
+	{
+	public:
+		using HandleType = GenerationalHandle<Tag>;
+
+		HandleType Insert(T* object)
+		{
+			uint32_t index;
+			if (!m_FreeSlots.empty())
+			{
+				index = m_FreeSlots.back();
+				m_FreeSlots.pop_back();
+			}
+			else
+			{
+				index = uint32_t(m_Slots.size());
+				m_Slots.push_back({});
+			}
+
+			m_Slots[index].Object = object;
+			return { index, m_Slots[index].Generation };
+		}
+
+		void Remove(HandleType handle)
+		{
+			if (!Contains(handle))
+				return;
+
+			Slot& slot = m_Slots[handle.Index];
+			slot.Object = nullptr;
+			slot.Generation++;
+			m_FreeSlots.push_back(handle.Index);
+		}
+
+		T* Resolve(HandleType handle) const
+		{
+			return Contains(handle) ? m_Slots[handle.Index].Object : nullptr;
+		}
+
+		bool Contains(HandleType handle) const
+		{
+			return handle.Index < m_Slots.size()
+				&& m_Slots[handle.Index].Generation == handle.Generation
+				&& m_Slots[handle.Index].Object != nullptr;
+		}
+
+		size_t Capacity() const { return m_Slots.size(); }
+		size_t Size() const { return m_Slots.size() - m_FreeSlots.size(); }
+
+	private:
+		struct Slot
+		{
+			T* Object = nullptr;
+			uint32_t Generation = 0;
+		};
+
+		std::vector<Slot> m_Slots;
+		std::vector<uint32_t> m_FreeSlots;
+	};
+}
+
+namespace std
+{
+	template<typename Tag>
+	struct hash<Blainn::GenerationalHandle<Tag>>
+	{
+		std::size_t operator()(const Blainn::GenerationalHandle<Tag>& handle) const
+		{
+			return hash<uint64_t>()((uint64_t(handle.Generation) << 32) | handle.Index);
+		}
+	};
+}
@@ -1,36 +1,71 @@
 #include "pch.h"
 #include "Input.h"
 
-#include "Application.h"
+#include "Platform/Platform.h"
 
 namespace Blainn
 {
-	void Input::Init()
+	namespace
 	{
-		Rid[0].usUsagePage = 0x01; //usage page generic
-		Rid[0].usUsage = 0x02; // usage generic mouse
-		Rid[0].dwFlags = 0;
-		Rid[0].hwndTarget = nullptr;
+		template<typename Data>
+		void SetState(Data& data, KeyState newState)
+		{
+			data.OldState = data.State;
+			data.State = newState;
+		}
+
+		template<typename Data>
+		void ApplyPlatformState(Data& data, KeyState newState)
+		{
+			if (newState == KeyState::Pressed)
+			{
+				// a press and release and press again before a step ran is still one press
+				data.bReleasePending = false;
+				if (data.State == KeyState::Pressed || data.State == KeyState::Held)
+					return;
+			}
+			else if (newState == KeyState::Released && data.State == KeyState::Pressed)
+			{
+				data.bReleasePending = true;
+				return;
+			}
+			SetState(data, newState);
+		}
+
+		template<typename Data>
+		void AdvanceStepState(Data& data)
+		{
+			if (data.State == KeyState::Released)
+				SetState(data, KeyState::None);
+			else if (data.State == KeyState::Pressed)
+				SetState(data, data.bReleasePending ? KeyState::Released : KeyState::Held);
+			data.bReleasePending = false;
+		}
+	}
 
-		if (RegisterRawInputDevices(Rid, _countof(Rid), sizeof(Rid[0])) == FALSE)
-			throw std::runtime_error("Failed to register raw input device");
+	void Input::Init()
+	{
+		s_KeyData.clear();
+		s_MouseData.clear();
+		s_MouseDeltaX = 0;
+		s_MouseDeltaY = 0;
 	}
 
 	void Input::Update()
 	{
-		TransitionPressedKeys();
-		TransitionPressedButtons();
 		if (s_CursorLocked)
-		{
-			RECT rect;
-			GetClientRect(GetActiveWindow(), &rect);
-			POINT center = { (rect.right - rect.left) / 2, (rect.bottom - rect.top) / 2 };
-			ClientToScreen(GetActiveWindow(), &center);
-			SetCursorPos(center.x, center.y);
-		}
+			Platform::CenterCursor();
 		//UpdateMouseDelta();
 	}
 
+	void Input::EndSimulationStep()
+	{
+		TransitionPressedKeys();
+		TransitionPressedButtons();
+		// the mouse moved once, only the first step gets to see it
+		UpdateMouseDelta(0, 0);
+	}
+
 	bool Input::IsKeyPressed(KeyCode key)
 	{
 		return s_KeyData.find(key) != s_KeyData.end() && s_KeyData[key].State == KeyState::Pressed;
@@ -85,8 +120,7 @@ namespace Blainn
 
 	::std::pair<int, int> Input::GetMousePosition()
 	{
-		auto& instance = ::Blainn::Application::Get().GetWindow();
-		return instance.GetCursorPosition();
+		return { s_MouseX, s_MouseY };
 	}
 
 	std::pair<int, int> Input::GetMouseDelta()
@@ -100,6 +134,12 @@ namespace Blainn
 		s_MouseDeltaY = y;
 	}
 
+	void Input::UpdateMousePosition(int x, int y)
+	{
+		s_MouseX = x;
+		s_MouseY = y;
+	}
+
 	void Input::SetCursorMode(CursorMode mode)
 	{
 		if (s_CursorMode == mode)
@@ -108,15 +148,15 @@ namespace Blainn
 		switch (mode)
 		{
 		case Blainn::CursorMode::Normal:
-			ShowCursor(TRUE);
+			Platform::SetCursorVisible(true);
 			s_CursorLocked = false;
 			break;
 		case Blainn::CursorMode::Hidden:
-			while(ShowCursor(FALSE) >= 0);
+			Platform::SetCursorVisible(false);
 			s_CursorLocked = false;
 			break;
 		case Blainn::CursorMode::Locked:
-			while(ShowCursor(FALSE) >= 0);
+			Platform::SetCursorVisible(false);
 			s_CursorLocked = true;
 			break;
 		}
@@ -129,49 +169,41 @@ namespace Blainn
 
 	void Input::TransitionPressedKeys()
 	{
-		for (const auto& [key, keyData] : s_KeyData)
-		{
-			if (keyData.State == KeyState::Pressed)
-				UpdateKeyState(key, KeyState::Held);
-		}
+		for (auto& [key, keyData] : s_KeyData)
+			AdvanceStepState(keyData);
 	}
 
 	void Input::TransitionPressedButtons()
 	{
-		for (const auto& [button, buttonData] : s_MouseData)
-		{
-			if (buttonData.State == KeyState::Pressed)
-				UpdateButtonState(button, KeyState::Held);
-		}
+		for (auto& [button, buttonData] : s_MouseData)
+			AdvanceStepState(buttonData);
 	}
 
 	void Input::UpdateKeyState(KeyCode key, KeyState newState)
 	{
 		auto& keyData = s_KeyData[key];
 		keyData.Key = key;
-		keyData.OldState = keyData.State;
-		keyData.State = newState;
+		ApplyPlatformState(keyData, newState);
 	}
 
 	void Input::UpdateButtonState(MouseButton button, KeyState newState)
 	{
 		auto& buttonData = s_MouseData[button];
 		buttonData.Button = button;
-		buttonData.OldState = buttonData.State;
-		buttonData.State = newState;
+		ApplyPlatformState(buttonData, newState);
 	}
 
 	void Input::ClearReleasedKeys()
 	{
-		for (const auto& [key, keyData] : s_KeyData)
+		for (auto& [key, keyData] : s_KeyData)
 		{
 			if (keyData.State == KeyState::Released)
-				UpdateKeyState(key, KeyState::None);
+				SetState(keyData, KeyState::None);
 		}
-		for (const auto& [button, buttonData] : s_MouseData)
+		for (auto& [button, buttonData] : s_MouseData)
 		{
 			if (buttonData.State == KeyState::Released)
-				UpdateButtonState(button, KeyState::None);
+				SetState(buttonData, KeyState::None);
 		}
 	}
 
@@ -22,6 +22,8 @@ namespace Blainn
 		KeyCode Key;
 		KeyState State = KeyState::None;
 		KeyState OldState = KeyState::None;
+		// Released before a simulation step saw the press
+		bool bReleasePending = false;
 	};
 
 	struct ButtonData
@@ -29,14 +31,22 @@ namespace Blainn
 		MouseButton Button;
 		KeyState State = KeyState::None;
 		KeyState OldState = KeyState::None;
+		// Released before a simulation step saw the press
+		bool bReleasePending = false;
 	};
 
 	class Input
 	{
 	public:
+		// Forgets every key and button state
 		static void Init();
 
+		// Once per frame, before the simulation steps
 		static void Update();
+		// After every simulation step. Every press and release is seen by exactly one
+		// step: pressed keys become held and released keys up. A frame without steps
+		// keeps them for the next step, whenever that runs.
+		static void EndSimulationStep();
 
 		static bool IsKeyPressed(KeyCode keyCode);
 		static bool IsKeyHeld(KeyCode keyCode);
@@ -53,6 +63,8 @@ namespace Blainn
 		static std::pair<int, int> GetMousePosition();
 		static std::pair<int, int> GetMouseDelta();
 		static void UpdateMouseDelta(LONG x, LONG y);
+		// Cursor position in the client area, set by whatever feeds the input
+		static void UpdateMousePosition(int x, int y);
 
 		static void SetCursorMode(CursorMode mode);
 		static CursorMode GetCursorMode();
@@ -60,6 +72,8 @@ namespace Blainn
 		// Internal stuff
 		static void TransitionPressedKeys();
 		static void TransitionPressedButtons();
+		// Presses and releases from the platform. Repeats of a key that is down are
+		// dropped, a release of a press no step has seen yet waits for that step.
 		static void UpdateKeyState(KeyCode key, KeyState newState);
 		static void UpdateButtonState(MouseButton button, KeyState newState);
 		static void ClearReleasedKeys();
@@ -79,11 +93,10 @@ namespace Blainn
 
 		inline static LONG s_MouseDeltaX = 0;
 		inline static LONG s_MouseDeltaY = 0;
+		inline static int s_MouseX = 0;
+		inline static int s_MouseY = 0;
 		inline static bool s_CursorLocked = false;
 
-		inline static CursorMode s_CursorMode;
-		inline static HCURSOR s_OldCursor;
-
-		inline static RAWINPUTDEVICE Rid[1];
+		inline static CursorMode s_CursorMode = CursorMode::Normal;
 	};
 }
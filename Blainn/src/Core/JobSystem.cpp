@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Blainn
+{
+	// Identifies which queue the current thread owns. A thread can only be a worker
+	// of one system, for every other system it counts as an external thread.
+	static thread_local const JobSystem* s_OwnerSystem = nullptr;
+	static thread_local uint32_t s_QueueIndex = 0;
+
+	JobSystem::JobSystem(const JobSystemDesc& desc)
+	{
+		uint32_t numWorkers = desc.NumWorkers;
+		if (numWorkers == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		// queue 0 is shared by the external threads
+		m_Queues.reserve(numWorkers + 1);
+		for (uint32_t i = 0; i < numWorkers + 1; ++i)
+			m_Queues.push_back(std::make_unique<WorkQueue>());
+
+		m_Workers.reserve(numWorkers);
+		for (uint32_t i = 0; i < numWorkers; ++i)
+		{
+			m_Workers.emplace_back([this, i]() { WorkerLoop(i + 1); });
+			if (desc.PinWorkers)
+				PinThread(m_Workers.back(), desc.FirstWorkerCore + i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_bRunning = false;
+		}
+		m_WakeCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+	void JobSystem::Schedule(JobFn job, JobCounter* counter)
+	{
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		Push({ std::move(job), counter });
+	}
+
+	void JobSystem::ScheduleAfter(JobCounter& dependency, JobFn job, JobCounter* counter)
+	{
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_ContinuationMutex);
+			if (!dependency.IsDone())
+			{
+				dependency.m_Continuations.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+
+		Push({ std::move(job), counter });
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		uint32_t queueIndex = GetCurrentThreadIndex();
+		while (!counter.IsDone())
+		{
+			if (!TryRunOneJob(queueIndex))
+				std::this_thread::yield();
+		}
+
+		// The last Finish may still be releasing the continuation mutex, the caller
+		// is free to destroy the counter once we return
+		std::lock_guard<std::mutex> lock(counter.m_ContinuationMutex);
+	}
+
+	void JobSystem::ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize,
+		const std::function<void(uint32_t, uint32_t)>& body)
+	{
+		if (begin >= end)
+			return;
+
+		grainSize = std::max(grainSize, 1u);
+		if (end - begin <= grainSize || m_Workers.empty())
+		{
+			body(begin, end);
+			return;
+		}
+
+		JobCounter counter;
+		// keep the first chunk for the calling thread, it would only spin in Wait otherwise
+		uint32_t firstEnd = begin + grainSize;
+		for (uint32_t chunkBegin = firstEnd; chunkBegin < end; chunkBegin += grainSize)
+		{
+			uint32_t chunkEnd = std::min(chunkBegin + grainSize, end);
+			Schedule([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }, &counter);
+		}
+
+		body(begin, firstEnd);
+		Wait(counter);
+	}
+
+	uint32_t JobSystem::GetCurrentThreadIndex() const
+	{
+		return s_OwnerSystem == this ? s_QueueIndex : 0;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t queueIndex)
+	{
+		s_OwnerSystem = this;
+		s_QueueIndex = queueIndex;
+
+		while (true)
+		{
+			if (TryRunOneJob(queueIndex))
+				continue;
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_WakeCondition.wait(lock, [this]()
+				{
+					return m_QueuedJobs.load(std::memory_order_acquire) > 0 || !m_bRunning;
+				});
+
+			if (!m_bRunning && m_QueuedJobs.load(std::memory_order_acquire) == 0)
+				break;
+		}
+	}
+
+	void JobSystem::Push(Job job)
+	{
+		WorkQueue& queue = *m_Queues[GetCurrentThreadIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.Mutex);
+			queue.Jobs.push_back(std::move(job));
+		}
+
+		m_QueuedJobs.fetch_add(1, std::memory_order_release);
+
+		// Taking the sleep mutex orders the increment with a worker that is about to
+		// evaluate its wait predicate, otherwise the wake up could be lost
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	bool JobSystem::TryPop(uint32_t queueIndex, Job& outJob)
+	{
+		WorkQueue& queue = *m_Queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Jobs.empty())
+			return false;
+
+		outJob = std::move(queue.Jobs.back());
+		queue.Jobs.pop_back();
+		return true;
+	}
+
+	bool JobSystem::TrySteal(uint32_t thiefIndex, Job& outJob)
+	{
+		uint32_t queueCount = uint32_t(m_Queues.size());
+		for (uint32_t offset = 1; offset < queueCount; ++offset)
+		{
+			WorkQueue& victim = *m_Queues[(thiefIndex + offset) % queueCount];
+			std::lock_guard<std::mutex> lock(victim.Mutex);
+			if (victim.Jobs.empty())
+				continue;
+
+			outJob = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			return true;
+		}
+		return false;
+	}
+
+	bool JobSystem::TryRunOneJob(uint32_t queueIndex)
+	{
+		Job job;
+		if (!TryPop(queueIndex, job) && !TrySteal(queueIndex, job))
+			return false;
+
+		m_QueuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+
+		job.Fn();
+		Finish(job);
+		return true;
+	}
+
+	void JobSystem::Finish(Job& job)
+	{
+		JobCounter* counter = job.Counter;
+		if (!counter)
+			return;
+
+		std::vector<std::pair<JobFn, JobCounter*>> continuations;
+		{
+			// Decrement under the lock so ScheduleAfter either sees the counter still
+			// pending and parks its job, or sees it done and pushes it directly
+			std::lock_guard<std::mutex> lock(counter->m_ContinuationMutex);
+			if (counter->m_Pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+			continuations.swap(counter->m_Continuations);
+		}
+
+		for (auto& [fn, continuationCounter] : continuations)
+			Push({ std::move(fn), continuationCounter });
+	}
+
+	void JobSystem::PinThread(std::thread& thread, uint32_t core)
+	{
+#if defined(_WIN32)
+		SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (core % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(core % CPU_SETSIZE, &cpuSet);
+		pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#else
+		(void)thread;
+		(void)core;
+#endif
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Blainn
+{
+	using JobFn = std::function<void()>;
+
+	// Counts the jobs scheduled against it that have not finished yet.
+	// Wait on it, or hang dependent jobs off it with JobSystem::ScheduleAfter.
+	// A counter must outlive every job scheduled against it.
+	class JobCounter
+	{
+		friend class JobSystem;
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+		uint32_t GetPending() const { return m_Pending.load(std::memory_order_acquire); }
+
+	private:
+		std::atomic<uint32_t> m_Pending{ 0 };
+
+		std::mutex m_ContinuationMutex;
+		std::vector<std::pair<JobFn, JobCounter*>> m_Continuations;
+	};
+
+	struct JobSystemDesc
+	{
+		// 0 picks hardware_concurrency - 1, the calling thread is expected to help in Wait
+		uint32_t NumWorkers = 0;
+		// Pin worker i to core FirstWorkerCore + i
+		bool PinWorkers = false;
+		uint32_t FirstWorkerCore = 1;
+	};
+
+	// Work-stealing scheduler shared by the whole engine.
+	// Every worker owns a deque, it pops its own jobs LIFO and steals from the other
+	// deques FIFO when it runs dry. Threads that are not workers (the main thread)
+	// share one extra deque and run jobs while they Wait, so nothing blocks idle.
+	class JobSystem
+	{
+	public:
+		explicit JobSystem(const JobSystemDesc& desc = JobSystemDesc());
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		void Schedule(JobFn job, JobCounter* counter = nullptr);
+		// Runs job once dependency reaches zero
+		void ScheduleAfter(JobCounter& dependency, JobFn job, JobCounter* counter = nullptr);
+
+		// Runs queued jobs on the calling thread until the counter drains
+		void Wait(JobCounter& counter);
+
+		// Splits [begin, end) into chunks of at most grainSize and runs body(chunkBegin, chunkEnd)
+		// on the pool. Returns once every chunk has finished.
+		void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize,
+			const std::function<void(uint32_t, uint32_t)>& body);
+
+		uint32_t GetWorkerCount() const { return uint32_t(m_Workers.size()); }
+		// Workers and the helping thread together
+		uint32_t GetConcurrency() const { return GetWorkerCount() + 1; }
+
+		// 0 for any non-worker thread, 1..N for workers of this system.
+		// Handy for indexing per-thread scratch data.
+		uint32_t GetCurrentThreadIndex() const;
+
+	private:
+		struct Job
+		{
+			JobFn Fn;
+			JobCounter* Counter = nullptr;
+		};
+
+		struct WorkQueue
+		{
+			std::mutex Mutex;
+			std::deque<Job> Jobs;
+		};
+
+		void WorkerLoop(uint32_t queueIndex);
+
+		void Push(Job job);
+		bool TryPop(uint32_t queueIndex, Job& outJob);
+		bool TrySteal(uint32_t thiefIndex, Job& outJob);
+		bool TryRunOneJob(uint32_t queueIndex);
+		void Finish(Job& job);
+
+		static void PinThread(std::thread& thread, uint32_t core);
+
+	private:
+		std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+		std::vector<std::thread> m_Workers;
+
+		std::atomic<uint32_t> m_QueuedJobs{ 0 };
+		std::atomic<bool> m_bRunning{ true };
+
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeCondition;
+	};
+}
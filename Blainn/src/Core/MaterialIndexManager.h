@@ -1,11 +1,12 @@
 #pragma once
 
+#include "Platform/Platform.h"
 #include "UUID.h"
 
 #include <unordered_map>
 #include <stack>
 
-extern const UINT32 g_NumObjects;
+extern const uint32_t g_NumObjects;
 
 namespace Blainn
 {
@@ -19,22 +20,22 @@ namespace Blainn
 			return instance;
 		}
 
-		UINT32 GetMatIdx(UUID uuid)
+		uint32_t GetMatIdx(UUID uuid)
 		{
 			auto it = m_UUIDtoIdx.find(uuid);
 			return (it != m_UUIDtoIdx.end()) ? it->second : UINT32_MAX;
 		}
 
-		UINT32 AssignCBIdx(UUID uuid)
+		uint32_t AssignCBIdx(UUID uuid)
 		{
-			UINT32 idx = GetMatIdx(uuid);
+			uint32_t idx = GetMatIdx(uuid);
 			if (idx != UINT32_MAX)
 				return idx;
 
 			if (m_FreeStack.empty())
 				throw std::runtime_error("No free constant buffer indices available");
 
-			UINT32 bufferIndex = m_FreeStack.top();
+			uint32_t bufferIndex = m_FreeStack.top();
 			m_FreeStack.pop();
 			m_UUIDtoIdx[uuid] = bufferIndex;
 
@@ -46,12 +47,12 @@ namespace Blainn
 			auto it = m_UUIDtoIdx.find(uuid);
 			if (it != m_UUIDtoIdx.end())
 			{
-				UINT32 bufferIndex = it->second;
+				uint32_t bufferIndex = it->second;
 				m_FreeStack.push(bufferIndex);
 				m_UUIDtoIdx.erase(it);
 			}
 			else 
-				OutputDebugStringW(L"This uuid was not assigned a constant buffer index!");
+				Platform::DebugPrint("This uuid was not assigned a constant buffer index!\n");
 		}
 
 	private:
@@ -61,8 +62,8 @@ namespace Blainn
 				m_FreeStack.push(i);
 		}
 
-		std::unordered_map<UUID, UINT32> m_UUIDtoIdx;
-		std::stack<UINT32> m_FreeStack;
+		std::unordered_map<UUID, uint32_t> m_UUIDtoIdx;
+		std::stack<uint32_t> m_FreeStack;
 	};
 
 }
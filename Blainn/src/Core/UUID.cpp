@@ -15,7 +15,7 @@ namespace Blainn
 	{
 	}
 
-	UUID::UUID(UINT64 uuid)
+	UUID::UUID(uint64_t uuid)
 		: m_UUID(uuid)
 	{
 	}
@@ -31,7 +31,7 @@ namespace Blainn
 	{
 	}
 
-	UUID32::UUID32(UINT32 uuid)
+	UUID32::UUID32(uint32_t uuid)
 		: m_UUID(uuid)
 	{
 	}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "basetsd.h"
+#include <cstdint>
 #include <memory>
 
 namespace Blainn
@@ -9,27 +9,27 @@ namespace Blainn
 	{
 	public:
 		UUID();
-		UUID(UINT64 uuid);
+		UUID(uint64_t uuid);
 		UUID(const UUID& other);
 
-		operator UINT64() { return m_UUID; }
-		operator const UINT64() const { return m_UUID; }
+		operator uint64_t() { return m_UUID; }
+		operator const uint64_t() const { return m_UUID; }
 
 	private:
-		UINT64 m_UUID;
+		uint64_t m_UUID;
 	};
 
 	class UUID32
 	{
 	public:
 		UUID32();
-		UUID32(UINT32 uuid);
+		UUID32(uint32_t uuid);
 		UUID32(const UUID32& other);
 
-		operator UINT32 () { return m_UUID; }
-		operator const UINT32() const { return m_UUID; }
+		operator uint32_t () { return m_UUID; }
+		operator const uint32_t() const { return m_UUID; }
 	private:
-		UINT32 m_UUID;
+		uint32_t m_UUID;
 	};
 
 }
@@ -86,6 +86,15 @@ namespace Blainn
 				MessageBox(nullptr, buffer, L"Error", MB_ICONERROR);
 				return false;
 			}
+			// relative mouse motion comes as WM_INPUT
+			RAWINPUTDEVICE rawMouse = {};
+			rawMouse.usUsagePage = 0x01; // usage page generic
+			rawMouse.usUsage = 0x02; // usage generic mouse
+			rawMouse.dwFlags = 0;
+			rawMouse.hwndTarget = nullptr;
+			if (RegisterRawInputDevices(&rawMouse, 1, sizeof(rawMouse)) == FALSE)
+				throw std::runtime_error("Failed to register raw input device");
+
 			m_bIsInitialized = true;
 
 			ShowWindow(m_Window, SW_SHOW);
@@ -312,6 +321,11 @@ namespace Blainn
 
 			return 0;
 		}
+		case WM_MOUSEMOVE:
+		{
+			Input::UpdateMousePosition((short)LOWORD(lParam), (short)HIWORD(lParam));
+			return 0;
+		}
 		case WM_KEYUP:
 		{
 			Input::UpdateKeyState(static_cast<KeyCode>(wParam), KeyState::Released);
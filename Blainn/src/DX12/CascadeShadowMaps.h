@@ -1,6 +1,7 @@
 #pragma once
 
 #include "EffectPSO.h"
+#include "Render/ShadowCascades.h"
 
 #include <array>
 #include <cstdint>
@@ -40,7 +41,8 @@ enum CascadeSlice
 
 namespace Blainn
 {
-	class CascadeShadowMaps
+	// The cascades with a shadow map for each and one for its cached static casters
+	class CascadeShadowMaps : public ShadowCascades
 	{
 	public:
 		CascadeShadowMaps(std::shared_ptr<dx12lib::Device> device, DirectX::XMUINT2 size);
@@ -50,15 +52,12 @@ namespace Blainn
 		dx12lib::RenderTarget& GetRenderTarget(CascadeSlice slice);
 		const dx12lib::RenderTarget& GetRenderTarget(CascadeSlice slice) const;
 
-		DirectX::XMUINT2 GetSize() const;
-		D3D12_VIEWPORT GetViewport() const;
-
-		void UpdateCascadeData(DirectX::SimpleMath::Matrix& invViewProj,
-			DirectX::SimpleMath::Vector3 lightDirection);
-		void UpdateCascadeMatrices(const Blainn::Camera& camera, const DirectX::SimpleMath::Vector3& lightDirection);
-		void UpdateCascadeDistances(const std::vector<float>& distances);
+		// Depth of the static casters only, copied into the slice before the movable
+		// casters are drawn
+		std::shared_ptr<dx12lib::Texture> GetStaticSlice(CascadeSlice slice) const;
+		dx12lib::RenderTarget& GetStaticRenderTarget(CascadeSlice slice);
 
-		CascadeData& GetCascadeData();
+		D3D12_VIEWPORT GetViewport() const;
 
 		std::vector<DXGI_FORMAT> GetShadowMapFormats() const;
 
@@ -67,14 +66,9 @@ namespace Blainn
 	private:
 		using ShadowMapList = std::vector<std::shared_ptr<class ShadowMap>>;
 		ShadowMapList m_ShadowMaps;
+		ShadowMapList m_StaticShadowMaps;
 
-		DirectX::XMUINT2 m_Size;
 		D3D12_VIEWPORT m_Viewport;
-
-		CascadeData m_CascadeData;
-		DirectX::SimpleMath::Vector3 m_LightDirection;
-
-		std::vector<std::pair<float, float>> m_CascadeViewWindows{ {0.f, 0.15f}, {0.14f, 0.35f}, {0.34f, 0.66f}, {0.65f, 1.1f} };
 	};
 
 	class ShadowMapPSO
@@ -97,6 +91,9 @@ namespace Blainn
 			Microsoft::WRL::ComPtr<ID3DBlob> vertexShaderBlob,
 			D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE
 		);
+		// Copies share the root signature and pipeline state but bind their own data,
+		// command lists recorded at the same time each use their own copy
+		ShadowMapPSO(const ShadowMapPSO&) = default;
 
 		void XM_CALLCONV SetWorldMatrices(const std::vector<DirectX::SimpleMath::Matrix>& instanceData)
 		{
@@ -105,6 +102,14 @@ namespace Blainn
 			for(int32_t i = 0; i < instanceData.size(); ++i)
 				m_ObjectData[i].WorldMatrix = instanceData[i];
 
+			m_InstanceDataAddress = 0;
+			m_DirtyFlags |= DF_PerObjectData;
+		}
+		// Binds instanceCount PerObjectData already resident at address, nothing is copied
+		void SetInstanceData(D3D12_GPU_VIRTUAL_ADDRESS address, uint32_t instanceCount)
+		{
+			m_InstanceDataAddress = address;
+			m_InstanceDataCount = instanceCount;
 			m_DirtyFlags |= DF_PerObjectData;
 		}
 		std::vector<DirectX::SimpleMath::Matrix> GetWorldMatrices() const
@@ -116,7 +121,7 @@ namespace Blainn
 		}
 		uint32_t GetInstanceCount() const
 		{
-			return m_ObjectData.size();
+			return m_InstanceDataAddress ? m_InstanceDataCount : uint32_t(m_ObjectData.size());
 		}
 
 		void SetPerPassData(PerPassData& data)
@@ -129,6 +134,12 @@ namespace Blainn
 			return m_PassData;
 		}
 
+		// Root bindings belong to the command list, call before the first Apply on a new one
+		void Invalidate()
+		{
+			m_DirtyFlags = DF_All;
+		}
+
 		void Apply(dx12lib::CommandList& commandList);
 
 	private:
@@ -148,6 +159,9 @@ namespace Blainn
 		std::vector<PerObjectData> m_ObjectData;
 		ShadowMapPSO::PerPassData m_PassData;
 
+		D3D12_GPU_VIRTUAL_ADDRESS m_InstanceDataAddress = 0;
+		uint32_t m_InstanceDataCount = 0;
+
 		uint32_t m_DirtyFlags;
 
 		D3D12_PRIMITIVE_TOPOLOGY_TYPE m_PrimitiveTopologyType;
@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "DXInstanceDataBuffer.h"
+
+#include "Util/d3dx12.h"
+#include "Util/Util.h"
+
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/Device.h>
+
+namespace Blainn
+{
+	DXInstanceDataBuffer::DXInstanceDataBuffer(std::shared_ptr<dx12lib::Device> device)
+		: m_Device(device)
+		, m_Resources(m_MappedData.size())
+	{
+	}
+
+	DXInstanceDataBuffer::~DXInstanceDataBuffer()
+	{
+		for (auto& resource : m_Resources)
+			if (resource)
+				resource->Unmap(0, nullptr);
+	}
+
+	uint64_t DXInstanceDataBuffer::GetGPUAddress(const InstanceRange& range) const
+	{
+		const auto& resource = m_Resources[m_FrameIndex];
+		D3D12_GPU_VIRTUAL_ADDRESS base = resource ? resource->GetGPUVirtualAddress() : 0;
+		return base + InstanceDataBuffer::GetGPUAddress(range);
+	}
+
+	void DXInstanceDataBuffer::AllocateFrameBuffers(uint32_t capacity)
+	{
+		// growing is rare, waiting for the GPU is cheaper than tracking retired buffers
+		if (m_Resources[0])
+			m_Device->GetCommandQueue().Flush();
+
+		auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(UINT64(capacity) * sizeof(PerObjectData));
+
+		for (size_t i = 0; i < m_Resources.size(); ++i)
+		{
+			auto& resource = m_Resources[i];
+			if (resource)
+				resource->Unmap(0, nullptr);
+
+			ThrowIfFailed(m_Device->GetD3D12Device()->CreateCommittedResource(
+				&heapProperties,
+				D3D12_HEAP_FLAG_NONE,
+				&bufferDesc,
+				D3D12_RESOURCE_STATE_GENERIC_READ,
+				nullptr,
+				IID_PPV_ARGS(&resource)));
+			resource->SetName(L"Instance Data Buffer");
+
+			// upload heaps can stay mapped for their whole lifetime
+			CD3DX12_RANGE readRange(0, 0);
+			ThrowIfFailed(resource->Map(0, &readRange, reinterpret_cast<void**>(&m_MappedData[i])));
+		}
+	}
+}
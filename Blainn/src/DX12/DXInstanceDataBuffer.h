@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Render/InstanceDataBuffer.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <memory>
+#include <vector>
+
+namespace dx12lib
+{
+	class Device;
+}
+
+namespace Blainn
+{
+	// Instance data in persistently mapped upload buffers, one per frame in flight,
+	// passes bind a range by its GPU virtual address
+	class DXInstanceDataBuffer : public InstanceDataBuffer
+	{
+	public:
+		explicit DXInstanceDataBuffer(std::shared_ptr<dx12lib::Device> device);
+		~DXInstanceDataBuffer() override;
+
+		uint64_t GetGPUAddress(const InstanceRange& range) const override;
+
+	protected:
+		void AllocateFrameBuffers(uint32_t capacity) override;
+
+	private:
+		std::shared_ptr<dx12lib::Device> m_Device;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_Resources;
+	};
+}
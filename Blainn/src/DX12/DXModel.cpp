@@ -1,9 +1,6 @@
 #include "pch.h"
 #include "DXModel.h"
 
-#include "Core/Application.h"
-#include "Core/MaterialIndexManager.h"
-#include "DX12/DXRenderingContext.h"
 #include "DXSceneVisitor.h"
 
 #include <assimp/Importer.hpp>
@@ -13,19 +10,66 @@
 #include <dx12lib/Device.h>
 #include <dx12lib/CommandList.h>
 #include <dx12lib/CommandQueue.h>
+#include <dx12lib/Material.h>
+#include <dx12lib/Mesh.h>
 #include <dx12lib/Scene.h>
 #include <dx12lib/Texture.h>
+#include <dx12lib/Visitor.h>
 
 namespace Blainn
 {
-	Blainn::DXModel::DXModel(const std::filesystem::path& modelFilePath)
-		: m_ModelFilepath(modelFilePath)
+	class SubmeshCollector : public dx12lib::Visitor
+	{
+	public:
+		explicit SubmeshCollector(std::vector<dx12lib::Mesh*>& meshes)
+			: m_Meshes(meshes)
+		{
+		}
+
+		void Visit(dx12lib::Scene& scene) override {}
+		void Visit(dx12lib::SceneNode& sceneNode) override {}
+		void Visit(dx12lib::Mesh& mesh) override
+		{
+			m_Meshes.push_back(&mesh);
+		}
+
+	private:
+		std::vector<dx12lib::Mesh*>& m_Meshes;
+	};
+
+	Blainn::DXModel::DXModel(const std::filesystem::path& modelFilePath, std::shared_ptr<dx12lib::Device> device)
+		: Model(modelFilePath)
 	{
 		//LoadFromFile(modelFilePath);
-		auto& queue = Application::Get().GetRenderingContext()->GetDevice()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+		auto& queue = device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
 		auto commandList = queue.GetCommandList();
 		m_Scene = commandList->LoadSceneFromFile(modelFilePath);
 		queue.ExecuteCommandList(commandList);
+
+		if (m_Scene)
+		{
+			m_Bounds = m_Scene->GetAABB();
+
+			std::vector<dx12lib::Mesh*> meshes;
+			SubmeshCollector collector(meshes);
+			m_Scene->Accept(collector);
+			for (dx12lib::Mesh* mesh : meshes)
+				AddSubmesh(mesh, mesh->GetMaterial());
+		}
+	}
+
+	void DXModel::AddSubmesh(dx12lib::Mesh* mesh, std::shared_ptr<dx12lib::Material> material)
+	{
+		Model::AddSubmesh(material.get(), material && material->IsTransparent());
+		m_DXSubmeshes.push_back({ mesh, std::move(material) });
+	}
+
+	void DXModel::SetMaterial(uint32_t submeshIndex, std::shared_ptr<dx12lib::Material> material)
+	{
+		DXSubmesh& submesh = m_DXSubmeshes[submeshIndex];
+		submesh.Mesh->SetMaterial(material);
+		AssignMaterial(m_Submeshes[submeshIndex], material.get(), material && material->IsTransparent());
+		submesh.Material = std::move(material);
 	}
 
 	//Blainn::DXModel::DXModel(std::shared_ptr<DXStaticMesh> staticMesh, std::shared_ptr<DXMaterial> material)
@@ -41,7 +85,8 @@ namespace Blainn
 
 	void Blainn::DXModel::Render(dx12lib::Visitor& sceneVisitor)
 	{
-		m_Scene->Accept(sceneVisitor);
+		if (m_Scene)
+			m_Scene->Accept(sceneVisitor);
 	}
 
 	//std::shared_ptr<DXModel> DXModel::ColoredCube(float side, const DirectX::SimpleMath::Color& color, std::shared_ptr<DXMaterial> material)
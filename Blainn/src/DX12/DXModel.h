@@ -5,8 +5,10 @@
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <wrl.h>
 
+#include "Render/Model.h"
 #include "SimpleMath.h"
 
 struct aiNode;
@@ -18,6 +20,9 @@ enum aiTextureType;
 namespace dx12lib
 {
 	class CommandList;
+	class Device;
+	class Material;
+	class Mesh;
 	class Scene;
 	class Texture;
 	class Visitor;
@@ -30,10 +35,17 @@ namespace Blainn
 	class DXTexture;
 	class SceneVisitor;
 
-	class DXModel
+	// The D3D12 side of a submesh, indexed like Model::GetSubmeshes
+	struct DXSubmesh
+	{
+		dx12lib::Mesh* Mesh = nullptr;
+		std::shared_ptr<dx12lib::Material> Material;
+	};
+
+	class DXModel : public Model
 	{
 	public:
-		DXModel(const std::filesystem::path& modelFilePath);
+		DXModel(const std::filesystem::path& modelFilePath, std::shared_ptr<dx12lib::Device> device);
 		//DXModel(std::shared_ptr<DXStaticMesh> staticMesh, std::shared_ptr<DXMaterial> materaial = nullptr);
 
 		void Render(dx12lib::Visitor& sceneVisitor);
@@ -41,12 +53,19 @@ namespace Blainn
 		auto GetScene() { return m_Scene; }
 		auto GetScene() const { return m_Scene; }
 
-		const std::filesystem::path GetPath() const { return m_ModelFilepath; }
+		// Every mesh of the scene, node transforms are ignored like in Render. The
+		// bounds come from the assimp import.
+		const std::vector<DXSubmesh>& GetDXSubmeshes() const { return m_DXSubmeshes; }
+
+		// Swaps the material of a submesh, its mesh draws with it everywhere
+		void SetMaterial(uint32_t submeshIndex, std::shared_ptr<dx12lib::Material> material);
 
 	private:
-		std::filesystem::path m_ModelFilepath;
+		void AddSubmesh(dx12lib::Mesh* mesh, std::shared_ptr<dx12lib::Material> material);
 
+	private:
 		std::shared_ptr<dx12lib::Scene> m_Scene;
+		std::vector<DXSubmesh> m_DXSubmeshes;
 
 	//public:
 	//	static std::shared_ptr<DXModel> ColoredCube(float side = 1.f, const DirectX::SimpleMath::Color& color = {1.f, 0.f, 1.f, 1.f}, std::shared_ptr<DXMaterial> material = nullptr);
@@ -10,7 +10,9 @@
 #include "Components/ActorComponents/TransformComponent.h"
 #include "Components/DebugComponents/WorldGridComponent.h"
 #include "Components/ComponentManager.h"
+#include "Core/Application.h"
 #include "Core/Camera.h"
+#include "Core/EntityRegistry.h"
 #include "Core/GameObject.h"
 #include "Core/GameTimer.h"
 #include "Core/Window.h"
@@ -18,10 +20,16 @@
 #include "DXShader.h"
 #include "DXModel.h"
 #include "EffectPSO.h"
+#include "Render/FrameGraph.h"
+#include "Render/PointLightBatch.h"
+#include "Render/RenderQueue.h"
+#include "Render/ShadowCascadeCache.h"
+#include "Render/ViewCulling.h"
 #include "Scene/Scene.h"
 #include "ShaderTypes.h"
 #include "TexturedQuadPSO.h"
 
+#include <stdexcept>
 #include <unordered_set>
 
 #include <dx12lib/CommandList.h>
@@ -39,6 +47,7 @@
 #include <dx12lib/Texture.h>
 
 #include "D3D12MemAlloc.h"
+#include "DXInstanceDataBuffer.h"
 #include "DeferredLightingPSO.h"
 #include "GBuffer.h"
 #include "GPassPSO.h"
@@ -48,9 +57,6 @@
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
-extern const int g_NumFrameResources = 3;
-extern const UINT32 g_NumObjects = 10000;
-
 inline void GenerateCubeMesh(std::vector<dx12lib::VertexPosition>& vertices, std::vector<UINT>& indices)
 {
 	using namespace dx12lib;
@@ -209,11 +215,16 @@ namespace Blainn
 
 		UINT width = 4096, height = 4096;
 
-		m_CascadeShadowMaps = std::make_shared<Blainn::CascadeShadowMaps>(m_Device, DirectX::XMUINT2{ width, height });
-		m_CascadeShadowMaps->UpdateCascadeDistances({20.f, 50.f, 100.f, 1000.f});
+		m_CascadeShadowMaps = std::make_shared<CascadeShadowMaps>(m_Device, DirectX::XMUINT2{ width, width });
+		CreateFrameData(m_CascadeShadowMaps, std::make_shared<DXInstanceDataBuffer>(m_Device));
 		
 		m_GBuffer = std::make_shared<GBuffer>(m_Device, width, height);
 
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+			m_CascadePSOs.push_back(std::make_shared<ShadowMapPSO>(*m_SMPSO));
+		for (uint32_t i = 0; i < MaxGeometryChunks; ++i)
+			m_GeometryPSOs.push_back(std::make_shared<GPassPSO>(*m_GBuffer->GetGPassPSO()));
+
 		vertexShader = DXShader(L"src\\Shaders\\DeferredShading\\VS_FullScreenQuad.hlsl", true, nullptr, "VS_FullScreenQuad", "vs_5_1");
 		auto pixelShader = DXShader(L"src\\Shaders\\DeferredShading\\PS_DirectionalLight.hlsl", true, nullptr, "PS_DirectionalLight", "ps_5_1");
 		m_DirLightPSO = std::make_shared<DirectLightsPSO>(m_Device, vertexShader.GetByteCode(), pixelShader.GetByteCode());
@@ -225,6 +236,11 @@ namespace Blainn
 		m_PointLightPSO = std::make_shared<PointLightsPSO>(m_Device, vertexShader.GetByteCode(), pixelShader.GetByteCode());
 		m_PointLightPSO->SetGBuffer(m_GBuffer);
 
+		vertexShader = DXShader(L"src\\Shaders\\DeferredShading\\VS_LightVolumes.hlsl", true, nullptr, "VS_LightVolumeInstanced", "vs_5_1");
+		pixelShader = DXShader(L"src\\Shaders\\DeferredShading\\PS_PointLight.hlsl", true, nullptr, "PS_PointLightInstanced", "ps_5_1");
+		m_PointLightBatchPSO = std::make_shared<PointLightsPSO>(m_Device, vertexShader.GetByteCode(), pixelShader.GetByteCode());
+		m_PointLightBatchPSO->SetGBuffer(m_GBuffer);
+
 		vertexShader = DXShader(L"src\\Shaders\\TexturedQuad.hlsl", true, nullptr, "VS_TexturedQuad", "vs_5_1");
 		pixelShader = DXShader(L"src\\Shaders\\TexturedQuad.hlsl", true, nullptr, "PS_TexturedQuad", "ps_5_1");
 		m_TexturedQuadPSO = std::make_shared<TexturedQuadPSO>(m_Device, vertexShader.GetByteCode(), pixelShader.GetByteCode());
@@ -362,25 +378,7 @@ namespace Blainn
 		passCB.TotalTime = gt.TotalTime();
 		passCB.DeltaTime = gt.DeltaTime();
 
-		auto& dirLightComponents = ComponentManager::Get().GetComponents<DirectionalLightComponent>();
-		std::vector<DirectionalLight> dirLights;
-		dirLights.reserve(dirLightComponents.size());
-		for (auto& dl : dirLightComponents)
-		{
-			auto owner = dl->GetOwner();
-			if (!owner)
-				continue;
-		
-			auto transform = owner->GetComponent<TransformComponent>();
-			if (!transform)
-				continue;
-		
-			auto& d = dl->GetDirectionalLight();
-			d.DirectionWS = SimpleMath::Vector4(transform->GetWorldForwardVector());
-
-			m_CascadeShadowMaps->UpdateCascadeMatrices(camera, DirectX::SimpleMath::Vector3(d.DirectionWS));
-			break;
-		}
+		PrepareView(camera);
 
 		m_GBuffer->GetGPassPSO()->SetPerPassData(passCB);
 		
@@ -388,6 +386,7 @@ namespace Blainn
 		m_DirLightPSO->SetCascadeData(m_CascadeShadowMaps->GetCascadeData());
 		
 		m_PointLightPSO->SetPassData(passCB);
+		m_PointLightBatchPSO->SetPassData(passCB);
 	}
 
 
@@ -395,47 +394,137 @@ namespace Blainn
 	{
 		m_SwapChain->WaitForSwapChain();
 
-		const auto& meshes = ComponentManager::Get().GetComponents<StaticMeshComponent>();//scene.GetRenderObjects();
+		const auto& meshes = GetSceneComponents().GetComponents<StaticMeshComponent>();
 
-		auto& commandQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		PrepareInstances(meshes, Application::Get().GetInterpolationAlpha());
+
+		BuildFrameGraph(meshes);
+		m_FrameGraph->Execute(nullptr);
+	}
 
-		CascadeShadowMapsPass(meshes);
-		GeometryPass(meshes);
-		DeferredLightingPass();
+	static FrameGraphTextureDesc GetGraphDesc(const std::shared_ptr<dx12lib::Texture>& texture, FrameGraphFormat format)
+	{
+		D3D12_RESOURCE_DESC desc = texture->GetD3D12ResourceDesc();
+		return { uint32_t(desc.Width), uint32_t(desc.Height), uint32_t(desc.DepthOrArraySize), format };
+	}
+
+	void DXRenderingContext::BuildFrameGraph(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
+	{
+		FrameGraph& graph = *m_FrameGraph;
+		graph.Reset();
 
+		// everything is still allocated up front, dx12lib tracks the resource states
+		// itself, so the graph only orders and culls the passes for now
+		FrameGraphResource cascades[CASCADE_COUNT];
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
 		{
-			auto commandList = commandQueue.GetCommandList();
-			commandList->SetViewport(m_ScreenViewport);
-			commandList->SetScissorRect(m_ScissorRect);
-			commandList->SetRenderTarget(m_RenderTarget);
-		
-			m_TexturedQuadPSO->SetTexture(m_GBuffer->GetTexture(GBuffer::TextureType::AlbedoOpacity));
-			m_TexturedQuadPSO->Apply(*commandList);
-			m_DebugBufferQuads[0]->Draw(*commandList);
-		
-			m_TexturedQuadPSO->SetTexture(m_GBuffer->GetTexture(GBuffer::TextureType::NormalSpec));
-			m_TexturedQuadPSO->Apply(*commandList);
-			m_DebugBufferQuads[1]->Draw(*commandList);
-		
-			m_TexturedQuadPSO->SetTexture(m_GBuffer->GetTexture(GBuffer::TextureType::Depth));
-			m_TexturedQuadPSO->Apply(*commandList);
-			m_DebugBufferQuads[2]->Draw(*commandList);
-		
-			commandQueue.ExecuteCommandList(commandList);
+			cascades[i] = graph.ImportTexture("Cascade", GetGraphDesc(m_CascadeShadowMaps->GetSlice(CascadeSlice(i)), FrameGraphFormat::D32),
+				RS_ShaderRead, RS_ShaderRead);
+		}
+
+		const std::pair<GBuffer::TextureType, FrameGraphFormat> gBufferLayout[] = {
+			{ GBuffer::AlbedoOpacity, FrameGraphFormat::RGBA8 },
+			{ GBuffer::NormalSpec, FrameGraphFormat::RGB10A2 },
+			{ GBuffer::Reflectance, FrameGraphFormat::RGBA8 },
+			{ GBuffer::EmissiveAmbient, FrameGraphFormat::RGB10A2 },
+		};
+		FrameGraphResource gBuffer[std::size(gBufferLayout)];
+		for (uint32_t i = 0; i < uint32_t(std::size(gBufferLayout)); ++i)
+		{
+			gBuffer[i] = graph.ImportTexture("GBuffer", GetGraphDesc(m_GBuffer->GetTexture(gBufferLayout[i].first), gBufferLayout[i].second),
+				RS_ShaderRead, RS_ShaderRead);
+		}
+		FrameGraphResource gBufferDepth = graph.ImportTexture("GBufferDepth",
+			GetGraphDesc(m_GBuffer->GetTexture(GBuffer::Depth), FrameGraphFormat::D32), RS_ShaderRead, RS_ShaderRead);
+
+		FrameGraphResource color = graph.ImportTexture("Color",
+			GetGraphDesc(m_RenderTarget.GetTexture(dx12lib::AttachmentPoint::Color0), FrameGraphFormat::RGBA8), RS_CopySource, RS_CopySource);
+		FrameGraphResource backBuffer = graph.ImportTexture("BackBuffer",
+			GetGraphDesc(m_SwapChain->GetRenderTarget().GetTexture(dx12lib::AttachmentPoint::Color0), FrameGraphFormat::RGBA8), RS_Present, RS_Present);
+
+		uint32_t shadows = graph.AddPass("CascadeShadowMaps", [this, &meshes]() { CascadeShadowMapsPass(meshes); });
+		for (FrameGraphResource cascade : cascades)
+			graph.Write(shadows, cascade, RS_DepthWrite);
+		if (m_ShadowCache->IsActive())
+		{
+			for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+			{
+				FrameGraphResource cache = graph.ImportTexture("StaticCascade",
+					GetGraphDesc(m_CascadeShadowMaps->GetStaticSlice(CascadeSlice(i)), FrameGraphFormat::D32), RS_CopySource, RS_CopySource);
+				if (m_ShadowCache->IsRenderingStatic(i))
+					graph.Write(shadows, cache, RS_DepthWrite);
+				else
+					graph.Read(shadows, cache, RS_CopySource);
+			}
 		}
 
+		uint32_t geometry = graph.AddPass("Geometry", [this]() { GeometryPass(); });
+		for (FrameGraphResource texture : gBuffer)
+			graph.Write(geometry, texture, RS_RenderTarget);
+		graph.Write(geometry, gBufferDepth, RS_DepthWrite);
+
+		uint32_t lighting = graph.AddPass("DeferredLighting", [this]() { DeferredLightingPass(); });
+		for (FrameGraphResource texture : gBuffer)
+			graph.Read(lighting, texture, RS_ShaderRead);
+		graph.Read(lighting, gBufferDepth, RS_ShaderRead);
+		for (FrameGraphResource cascade : cascades)
+			graph.Read(lighting, cascade, RS_ShaderRead);
+		graph.Write(lighting, color, RS_RenderTarget);
+
+		uint32_t debugBuffers = graph.AddPass("DebugBuffers", [this]() { DebugBuffersPass(); });
+		graph.Read(debugBuffers, gBuffer[0], RS_ShaderRead);
+		graph.Read(debugBuffers, gBuffer[1], RS_ShaderRead);
+		graph.Read(debugBuffers, gBufferDepth, RS_ShaderRead);
+		graph.Write(debugBuffers, color, RS_RenderTarget);
+
+		uint32_t present = graph.AddPass("Present", [this]() { PresentPass(); });
+		graph.Read(present, color, RS_CopySource);
+		graph.Write(present, backBuffer, RS_CopyDest);
+
+		// the passes are the same every frame, a cycle is a bug in the graph above
+		if (!graph.Compile())
+			throw std::runtime_error("The frame graph's passes depend on each other in a cycle");
+	}
+
+	void DXRenderingContext::DebugBuffersPass()
+	{
+		auto& commandQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		auto commandList = commandQueue.GetCommandList();
+		commandList->SetViewport(m_ScreenViewport);
+		commandList->SetScissorRect(m_ScissorRect);
+		commandList->SetRenderTarget(m_RenderTarget);
+
+		m_TexturedQuadPSO->SetTexture(m_GBuffer->GetTexture(GBuffer::TextureType::AlbedoOpacity));
+		m_TexturedQuadPSO->Apply(*commandList);
+		m_DebugBufferQuads[0]->Draw(*commandList);
+
+		m_TexturedQuadPSO->SetTexture(m_GBuffer->GetTexture(GBuffer::TextureType::NormalSpec));
+		m_TexturedQuadPSO->Apply(*commandList);
+		m_DebugBufferQuads[1]->Draw(*commandList);
+
+		m_TexturedQuadPSO->SetTexture(m_GBuffer->GetTexture(GBuffer::TextureType::Depth));
+		m_TexturedQuadPSO->Apply(*commandList);
+		m_DebugBufferQuads[2]->Draw(*commandList);
+
+		commandQueue.ExecuteCommandList(commandList);
+		m_Stats.DrawCalls += 3;
+		m_Stats.Instances += 3;
+		m_Stats.CommandLists++;
+	}
+
+	void DXRenderingContext::PresentPass()
+	{
+		auto& commandQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
 		auto commandList = commandQueue.GetCommandList();
 
 		auto swapChainBackBuffer = m_SwapChain->GetRenderTarget().GetTexture(dx12lib::AttachmentPoint::Color0);
 		auto renderTarget = m_RenderTarget.GetTexture(dx12lib::AttachmentPoint::Color0);
 
-		D3D12_RESOURCE_DESC srcDesc = renderTarget->GetD3D12ResourceDesc();
-		D3D12_RESOURCE_DESC dstDesc = swapChainBackBuffer->GetD3D12ResourceDesc();
-
 		//commandList->ResolveSubresource(swapChainBackBuffer, renderTarget);
 		commandList->CopyResource(swapChainBackBuffer, renderTarget);
 
 		commandQueue.ExecuteCommandList(commandList);
+		m_Stats.CommandLists++;
 
 		m_SwapChain->Present(renderTarget);
 	}
@@ -451,78 +540,109 @@ namespace Blainn
 		m_GBuffer->GetRenderTarget().Resize(newWidth, newHeight);
 	}
 
+	std::shared_ptr<Model> DXRenderingContext::LoadModel(const std::filesystem::path& modelFilePath)
+	{
+		return std::make_shared<DXModel>(modelFilePath, m_Device);
+	}
+
 	void DXRenderingContext::CascadeShadowMapsPass(
-		const std::unordered_set<std::shared_ptr<StaticMeshComponent>>& meshes)
+		const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
 	{
 		auto& commandQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
 
+		// lists are taken here, only the recording runs on the workers
 		std::vector<std::shared_ptr<dx12lib::CommandList>> shadowCommandLists(CASCADE_COUNT);
+		for (auto& commandList : shadowCommandLists)
+			commandList = commandQueue.GetCommandList();
 
-		for(int32_t i = 0; i < CASCADE_COUNT; ++i)
+		const auto& cascadeData = m_CascadeShadowMaps->GetCascadeData();
+		const bool bCached = m_ShadowCache->IsActive();
+		RenderingStats cascadeStats[CASCADE_COUNT];
+		RecordLists(CASCADE_COUNT, [&](uint32_t i)
 		{
-			auto commandList = commandQueue.GetCommandList();
-			shadowCommandLists[i] = commandList;
+			dx12lib::CommandList& commandList = *shadowCommandLists[i];
+			ShadowMapPSO& shadowPSO = *m_CascadePSOs[i];
+			shadowPSO.Invalidate();
 
-			ShadowVisitor shadowPass(*commandList, *m_SMPSO);
+			ShadowVisitor shadowPass(commandList, shadowPSO);
 
-			auto sliceData = m_CascadeShadowMaps->GetCascadeData();
 			ShadowMapPSO::PerPassData smPassData;
-			smPassData.ViewProj = sliceData.viewProjMats[i];
+			smPassData.ViewProj = cascadeData.viewProjMats[i];
 
-			m_SMPSO->SetPerPassData(smPassData);
-			commandList->SetViewport(m_CascadeShadowMaps->GetViewport());
-			commandList->SetScissorRect(m_ScissorRect);
+			shadowPSO.SetPerPassData(smPassData);
+			commandList.SetViewport(m_CascadeShadowMaps->GetViewport());
+			commandList.SetScissorRect(m_ScissorRect);
 
-			auto& rt = m_CascadeShadowMaps->GetRenderTarget(CascadeSlice(i));
+			auto drawCasters = [&](bool bStatic)
+			{
+				for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+				{
+					if (bCached && meshes[meshIndex]->IsStatic() != bStatic)
+						continue;
 
-			commandList->ClearDepthStencilTexture(
-				rt.GetTexture(dx12lib::AttachmentPoint::DepthStencil),
-				D3D12_CLEAR_FLAG_DEPTH);
+					const InstanceRange& range = m_InstanceData->GetViewRange(FirstCascadeView + i, meshIndex);
+					if (range.Count == 0)
+						continue;
 
-			commandList->SetRenderTarget(rt);
+					shadowPSO.SetInstanceData(m_InstanceData->GetGPUAddress(range), range.Count);
+					// the D3D12 backend only loads DXModels
+					static_cast<DXModel&>(*meshes[meshIndex]->GetModel()).Render(shadowPass);
+				}
+			};
 
-			for (auto& it : meshes)
+			auto& rt = m_CascadeShadowMaps->GetRenderTarget(CascadeSlice(i));
+			if (bCached)
 			{
-				auto owners = it->GetOwners();
-				if (owners.empty())
-					continue;
-
-				std::vector<DirectX::SimpleMath::Matrix> worldMats;
-				worldMats.reserve(owners.size());
-				for (auto weakOwner : owners)
+				// the static casters only when the cache is stale, the cascade starts
+				// from a copy of it either way
+				if (m_ShadowCache->IsRenderingStatic(i))
 				{
-					auto owner = weakOwner.lock();
-					auto transform = owner->GetComponent<TransformComponent>();
-					if (!transform)
-						continue;
-
-					auto ttr = transform->GetWorldMatrix().Transpose();
-					worldMats.push_back(ttr);
+					auto& staticRT = m_CascadeShadowMaps->GetStaticRenderTarget(CascadeSlice(i));
+					commandList.ClearDepthStencilTexture(
+						staticRT.GetTexture(dx12lib::AttachmentPoint::DepthStencil),
+						D3D12_CLEAR_FLAG_DEPTH);
+					commandList.SetRenderTarget(staticRT);
+					drawCasters(true);
 				}
 
-				m_SMPSO->SetWorldMatrices(worldMats);
-				it->OnRender(shadowPass);
+				commandList.CopyResource(
+					rt.GetTexture(dx12lib::AttachmentPoint::DepthStencil),
+					m_CascadeShadowMaps->GetStaticSlice(CascadeSlice(i)));
 			}
-		}
+			else
+			{
+				commandList.ClearDepthStencilTexture(
+					rt.GetTexture(dx12lib::AttachmentPoint::DepthStencil),
+					D3D12_CLEAR_FLAG_DEPTH);
+			}
+
+			commandList.SetRenderTarget(rt);
+			drawCasters(false);
+			cascadeStats[i].DrawCalls = shadowPass.GetDrawCalls();
+			cascadeStats[i].Instances = shadowPass.GetInstances();
+			cascadeStats[i].CommandLists++;
+		});
 
 		commandQueue.ExecuteCommandLists(shadowCommandLists);
+		for (const RenderingStats& stats : cascadeStats)
+			m_Stats.Add(stats);
 	}
 
-	void DXRenderingContext::GeometryPass(const std::unordered_set<std::shared_ptr<StaticMeshComponent>>& meshes)
+	void DXRenderingContext::GeometryPass()
 	{
 		auto& commandQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
 
-		auto commandList = commandQueue.GetCommandList();
-
-		m_GBuffer->ClearRenderTarget(commandList);
+		std::vector<RecordingChunk> chunks;
+		SplitGeometryBatches(chunks);
 
-		commandList->SetViewport(m_ScreenViewport);
-		commandList->SetScissorRect(m_ScissorRect);
-		commandList->SetRenderTarget(m_GBuffer->GetRenderTarget());
+		std::vector<std::shared_ptr<dx12lib::CommandList>> commandLists(chunks.size());
+		for (auto& commandList : commandLists)
+			commandList = commandQueue.GetCommandList();
 
-		GeometryVisitor geometryPass(*commandList, *m_GBuffer->GetGPassPSO());
+		// lists execute in submission order, clearing in the first one is enough
+		m_GBuffer->ClearRenderTarget(commandLists[0]);
 
-		// auto& pointLightComponents = ComponentManager::Get().GetComponents<PointLightComponent>();
+		// auto& pointLightComponents = GetSceneComponents().GetComponents<PointLightComponent>();
 		// for (auto& pl : pointLightComponents)
 		// {
 		// 	auto owner = pl->GetOwner();
@@ -545,30 +665,51 @@ namespace Blainn
 		// 	m_SphereLightVolumeMesh->Draw(*commandList);
 		// }
 
-		for (auto& it : meshes)
-		{
-			auto owners = it->GetOwners();
-			if (owners.empty())
-				continue;
+		PerPassData passData = m_GBuffer->GetGPassPSO()->GetPerPassData();
+		const InstanceRange& ordered = m_InstanceData->GetOrderedRange();
+		const std::vector<uint32_t>& items = m_GeometryQueue->GetValues();
+		const std::vector<RenderBatch>& batches = m_GeometryQueue->GetBatches();
 
-			std::vector<DirectX::SimpleMath::Matrix> worldMats;
-			worldMats.reserve(owners.size());
-			for (auto weakOwner : owners)
+		std::vector<RenderingStats> chunkStats(chunks.size());
+		RecordLists(uint32_t(chunks.size()), [&](uint32_t chunkIndex)
+		{
+			dx12lib::CommandList& commandList = *commandLists[chunkIndex];
+			commandList.SetViewport(m_ScreenViewport);
+			commandList.SetScissorRect(m_ScissorRect);
+			commandList.SetRenderTarget(m_GBuffer->GetRenderTarget());
+
+			GPassPSO& gPassPSO = *m_GeometryPSOs[chunkIndex];
+			gPassPSO.SetPerPassData(passData);
+			gPassPSO.Invalidate();
+
+			// batches come sorted by material, a material is only bound when it changes
+			const RecordingChunk& chunk = chunks[chunkIndex];
+			const dx12lib::Material* boundMaterial = nullptr;
+			for (uint32_t i = chunk.FirstBatch; i < chunk.FirstBatch + chunk.BatchCount; ++i)
 			{
-				auto owner = weakOwner.lock();
-				auto transform = owner->GetComponent<TransformComponent>();
-				if (!transform)
-					continue;
+				const RenderBatch& batch = batches[i];
+				const DrawItem& item = m_DrawItems[items[batch.First]];
+				const DXSubmesh& submesh = static_cast<const DXModel*>(item.SourceModel)->GetDXSubmeshes()[item.SubmeshIndex];
+				if (submesh.Material.get() != boundMaterial)
+				{
+					gPassPSO.SetMaterial(submesh.Material);
+					boundMaterial = submesh.Material.get();
+				}
+
+				InstanceRange range = { ordered.Offset + batch.First, batch.Count };
+				gPassPSO.SetInstanceData(m_InstanceData->GetGPUAddress(range), range.Count);
+				gPassPSO.Apply(commandList);
 
-				auto ttr = transform->GetWorldMatrix().Transpose();
-				worldMats.push_back(ttr);
+				submesh.Mesh->Draw(commandList, batch.Count);
+				chunkStats[chunkIndex].DrawCalls++;
+				chunkStats[chunkIndex].Instances += batch.Count;
 			}
+			chunkStats[chunkIndex].CommandLists++;
+		});
 
-			m_GBuffer->GetGPassPSO()->SetWorldMatrices(worldMats);
-			it->OnRender(geometryPass);
-		}
-		
-		commandQueue.ExecuteCommandList(commandList);
+		commandQueue.ExecuteCommandLists(commandLists);
+		for (const RenderingStats& stats : chunkStats)
+			m_Stats.Add(stats);
 	}
 
 	void DXRenderingContext::DeferredLightingPass()
@@ -596,14 +737,14 @@ namespace Blainn
 		commandList->SetScissorRect(m_ScissorRect);
 		commandList->SetRenderTarget(m_RenderTarget);
 		
-		auto& dirLightComponents = ComponentManager::Get().GetComponents<DirectionalLightComponent>();
+		auto& dirLightComponents = GetSceneComponents().GetComponents<DirectionalLightComponent>();
 		for (auto& dl : dirLightComponents)
 		{
-			auto owner = dl->GetOwner();
+			GameObject* owner = dl->GetOwnerPtr();
 			if (!owner)
 				continue;
 		
-			auto transform = owner->GetComponent<TransformComponent>();
+			auto transform = owner->GetComponentPtr<TransformComponent>();
 			if (!transform)
 				continue;
 		
@@ -614,10 +755,13 @@ namespace Blainn
 			m_DirLightPSO->Apply(*commandList);
 			commandList->SetVertexBuffer(0, m_FullQuadVertexBuffer);
 			commandList->Draw(4);
+			m_Stats.DrawCalls++;
+			m_Stats.Instances++;
 			
 			//dirLights.push_back(d);
 		}
 		commandQueue.ExecuteCommandList(commandList);
+		m_Stats.CommandLists++;
 	}
 
 	void DXRenderingContext::PointLightsPass()
@@ -628,29 +772,37 @@ namespace Blainn
 		commandList->SetViewport(m_ScreenViewport);
 		commandList->SetScissorRect(m_ScissorRect);
 		commandList->SetRenderTarget(m_RenderTarget);
-		auto& pointLightComponents = ComponentManager::Get().GetComponents<PointLightComponent>();
-		for (auto& pl : pointLightComponents)
+		m_PointLightDrawCalls = 0;
+		const auto& instances = m_PointLightBatch->GetInstances();
+		if (m_bBatchPointLights)
 		{
-			auto owner = pl->GetOwner();
-			if (!owner)
-				continue;
-		
-			auto transform = owner->GetComponent<TransformComponent>();
-			if (!transform)
-				continue;
-		
-			auto l = pl->GetPointLight();
-			l.PositionWS = SimpleMath::Vector4(transform->GetWorldPosition());
-			SimpleMath::Matrix T = SimpleMath::Matrix::CreateTranslation(SimpleMath::Vector3(l.PositionWS));
-			SimpleMath::Matrix S = SimpleMath::Matrix::CreateScale(l.Radius + 0.1f);
-			SimpleMath::Matrix W = (S * T).Transpose();
-			m_PointLightPSO->SetLightData(l);
-			m_PointLightPSO->SetObjectData({W});
-			m_PointLightPSO->Apply(*commandList);
-
-			m_SphereLightVolumeMesh->Draw(*commandList);
+			if (!instances.empty())
+			{
+				m_PointLightBatchPSO->SetLightInstances(instances);
+				m_PointLightBatchPSO->Apply(*commandList);
+
+				m_SphereLightVolumeMesh->Draw(*commandList, uint32_t(instances.size()));
+				m_PointLightDrawCalls++;
+				m_Stats.UploadBytes += instances.size() * sizeof(PointLightInstance);
+			}
+		}
+		else
+		{
+			for (const PointLightInstance& instance : instances)
+			{
+				m_PointLightPSO->SetLightData(instance.Light);
+				m_PointLightPSO->SetObjectData({ SimpleMath::Matrix(XMLoadFloat4x4(&instance.World)) });
+				m_PointLightPSO->Apply(*commandList);
+
+				m_SphereLightVolumeMesh->Draw(*commandList);
+				m_PointLightDrawCalls++;
+			}
 		}
 		commandQueue.ExecuteCommandList(commandList);
+
+		m_Stats.DrawCalls += m_PointLightDrawCalls;
+		m_Stats.Instances += uint32_t(instances.size());
+		m_Stats.CommandLists++;
 	}
 
 	void DXRenderingContext::SpotLightsPass()
@@ -6,12 +6,17 @@
 #include <d3d12.h>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 #include <wrl.h>
 
 #include "Util/d3dx12.h"
 
 #include "dx12lib/RenderTarget.h"
 
+#include "Render/RenderingBackend.h"
+#include "Scene/Light.h"
+#include "ShaderTypes.h"
+
 namespace dx12lib
 {
 	class Mesh;
@@ -30,7 +35,6 @@ namespace Blainn
 }
 
 extern const int g_NumFrameResources;
-extern const UINT32 g_NumObjects;
 
 namespace dx12lib
 {
@@ -46,6 +50,7 @@ namespace dx12lib
 namespace Blainn
 {
 	class GBuffer;
+	class GPassPSO;
 	class CascadeShadowMaps;
 	class Camera;
 	class DXDevice;
@@ -60,34 +65,38 @@ namespace Blainn
 	class StaticMeshComponent;
 	class Window;
 
-	class DXRenderingContext
+	class DXRenderingContext : public RenderingBackend
 	{
 	public:
 		DXRenderingContext() = default;
 		~DXRenderingContext();
 
-		void Init(std::shared_ptr<Window> wnd);
-		void CreateResources();
+		void Init(std::shared_ptr<Window> wnd) override;
+		void CreateResources() override;
 
-		void Draw();
+		void Draw() override;
 
-		void OnUpdate();
-		void UpdateObjectsConstantBuffers();
+		void OnUpdate() override;
+		void UpdateObjectsConstantBuffers() override;
 		void UpdateMaterialsConstantBuffers(std::unordered_set<DXMaterial*> materials);
 		void UpdateMainPassConstantBuffers(
 			const GameTimer& gt, const Camera& camera
-		);
+		) override;
 
-		void Resize(int newWidth, int newHeight);
+		void Resize(int newWidth, int newHeight) override;
 
-		bool IsInitialized() const { return m_bIsInitialized; }
+		// Loads a DXModel onto the device
+		std::shared_ptr<Model> LoadModel(const std::filesystem::path& modelFilePath) override;
 
 		std::shared_ptr<dx12lib::Device> GetDevice() const { return m_Device; }
 		
 	protected:
-		void CascadeShadowMapsPass(const std::unordered_set<std::shared_ptr<StaticMeshComponent>>& meshes);
-		void GeometryPass(const std::unordered_set<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void CascadeShadowMapsPass(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void BuildFrameGraph(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void GeometryPass();
 		void DeferredLightingPass();
+		void DebugBuffersPass();
+		void PresentPass();
 
 		void DirectionalLightsPass();
 		void PointLightsPass();
@@ -101,17 +110,23 @@ namespace Blainn
 		std::shared_ptr<dx12lib::SwapChain> m_SwapChain;
 
 		dx12lib::RenderTarget m_RenderTarget;
-		std::shared_ptr<CascadeShadowMaps> m_CascadeShadowMaps;
 
 		std::shared_ptr<dx12lib::RootSignature> m_RootSignature;
 
 		std::shared_ptr<GBuffer> m_GBuffer;
+		// The backend's m_ShadowCascades, with the shadow maps
+		std::shared_ptr<CascadeShadowMaps> m_CascadeShadowMaps;
 
 		std::unordered_map<std::string, std::shared_ptr<EffectPSO>> m_PSOs;
 		std::shared_ptr<ShadowMapPSO> m_SMPSO;
+		// Copies of m_SMPSO and the G-buffer pass PSO for the lists recorded in parallel,
+		// one per cascade and one per geometry chunk
+		std::vector<std::shared_ptr<ShadowMapPSO>> m_CascadePSOs;
+		std::vector<std::shared_ptr<GPassPSO>> m_GeometryPSOs;
 		
 		std::shared_ptr<DirectLightsPSO> m_DirLightPSO;
 		std::shared_ptr<PointLightsPSO> m_PointLightPSO;
+		std::shared_ptr<PointLightsPSO> m_PointLightBatchPSO;
 		std::shared_ptr<SpotLightsPSO> m_SpotLighPSO;
 		std::shared_ptr<TexturedQuadPSO> m_TexturedQuadPSO;
 
@@ -125,7 +140,5 @@ namespace Blainn
 
 		DXGI_FORMAT m_BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 		DXGI_FORMAT m_DepthStencilFormat = DXGI_FORMAT_D32_FLOAT;
-
-		bool m_bIsInitialized = false;
 	};
 }
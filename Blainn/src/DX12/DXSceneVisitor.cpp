@@ -67,6 +67,8 @@ void ShadowVisitor::Visit(dx12lib::Mesh& mesh)
 	{
 		m_ShadowPSO.Apply(m_CommandList);
 		mesh.Draw(m_CommandList, m_ShadowPSO.GetInstanceCount());
+		m_DrawCalls++;
+		m_Instances += m_ShadowPSO.GetInstanceCount();
 	}
 }
 
@@ -48,9 +48,17 @@ namespace Blainn
 		void Visit(dx12lib::SceneNode& sceneNode) override;
 		void Visit(dx12lib::Mesh& mesh) override;
 
+		// Transparent meshes cast no shadows and are skipped, these only count the
+		// meshes drawn
+		uint32_t GetDrawCalls() const { return m_DrawCalls; }
+		uint32_t GetInstances() const { return m_Instances; }
+
 	private:
 		dx12lib::CommandList&	m_CommandList;
 		ShadowMapPSO&			m_ShadowPSO;
+
+		uint32_t m_DrawCalls = 0;
+		uint32_t m_Instances = 0;
 	};
 
 	class GeometryVisitor : public dx12lib::Visitor
@@ -262,6 +262,7 @@ PointLightsPSO::PointLightsPSO(std::shared_ptr<dx12lib::Device>& device,
     rootParameters[RootParameters::LightVolumeCB	].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
     rootParameters[RootParameters::PointLightCB		].InitAsConstantBufferView(1, 1, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL);
 	rootParameters[RootParameters::GBufferTextures	].InitAsDescriptorTable(1, &gBufferDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParameters[RootParameters::LightInstancesSB	].InitAsShaderResourceView(0, 1, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_ALL);
 
     auto staticSamplers = GetStaticSamplers();
 
@@ -370,6 +371,13 @@ void PointLightsPSO::Apply(dx12lib::CommandList& commandList)
 		commandList.SetGraphicsDynamicConstantBuffer(RootParameters::LightVolumeCB, m_ObjectData);
 	}
 
+	// one upload for every light of the batch
+	if ((m_DirtyFlags & DF_LightInstances) && m_LightInstances && !m_LightInstances->empty())
+	{
+		commandList.SetGraphicsDynamicStructuredBuffer(RootParameters::LightInstancesSB,
+			m_LightInstances->size(), sizeof(PointLightInstance), m_LightInstances->data());
+	}
+
     if (m_GBuffer)
     {
         using TextureType = GBuffer::TextureType;
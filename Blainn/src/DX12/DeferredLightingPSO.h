@@ -1,6 +1,7 @@
 #pragma once
 #include "ShaderTypes.h"
 #include "Scene/Light.h"
+#include "Render/PointLightBatch.h"
 
 namespace Blainn
 {
@@ -131,9 +132,12 @@ namespace Blainn
 			// Texture2D SceneDepthTexture			: register(t4);
 			LightVolumeCB = 2, // ConstantBuffer<PerInstanceData> PerInstanceCB : register(b1, space0);
 			PointLightCB = 3,  // ConstantBuffer<PointLight> PointLightCB : register( b1, space1 );
+			LightInstancesSB = 4, // StructuredBuffer<PointLightInstance> LightInstancesSB : register( t0, space1 );
 			NumRootParameters
 		};
 	
+		// The per light shaders read LightVolumeCB and PointLightCB, the instanced ones
+		// read every light of the batch from LightInstancesSB
 		PointLightsPSO(std::shared_ptr<dx12lib::Device>& device,
 			Microsoft::WRL::ComPtr<ID3DBlob> vertexShader, Microsoft::WRL::ComPtr<ID3DBlob> pixelShader);
 
@@ -160,6 +164,17 @@ namespace Blainn
 			m_DirtyFlags |= DF_ObjectData;
 		}
 
+		// Batched mode, the instances must stay alive until Apply
+		void SetLightInstances(const std::vector<PointLightInstance>& instances)
+		{
+			m_LightInstances = &instances;
+			m_DirtyFlags |= DF_LightInstances;
+		}
+		uint32_t GetLightInstanceCount() const
+		{
+			return m_LightInstances ? uint32_t(m_LightInstances->size()) : 0;
+		}
+
 		void SetGBuffer(const std::shared_ptr<GBuffer>& gBuffer)
 		{
 			m_GBuffer = gBuffer;
@@ -171,10 +186,12 @@ namespace Blainn
 			DF_None = 0,
 			DF_PassData = (1 << 0),
 			DF_LightData = (1 << 1),
-			DF_ObjectData = (1 << 1),
+			DF_ObjectData = (1 << 2),
+			DF_LightInstances = (1 << 3),
 			DF_All	= DF_PassData
 					| DF_LightData
 					| DF_ObjectData
+					| DF_LightInstances
 		};
 		uint32_t m_DirtyFlags;
 	
@@ -188,6 +205,7 @@ namespace Blainn
 		PerObjectData m_ObjectData;
 		PerPassData m_PassData;
 		PointLight m_LightData;
+		const std::vector<PointLightInstance>* m_LightInstances = nullptr;
 	};
 
 	class SpotLightsPSO
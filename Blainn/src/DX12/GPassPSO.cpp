@@ -97,7 +97,12 @@ void Blainn::GPassPSO::Apply(dx12lib::CommandList& commandList)
 	commandList.SetGraphicsRootSignature(m_RootSignature);
 
 	if (m_DirtyFlags & DF_PerObjectData)
-		commandList.SetGraphicsDynamicStructuredBuffer(RootParameters::PerObjectDataSB, m_ObjectData);
+	{
+		if (m_InstanceDataAddress)
+			commandList.GetD3D12CommandList()->SetGraphicsRootShaderResourceView(RootParameters::PerObjectDataSB, m_InstanceDataAddress);
+		else
+			commandList.SetGraphicsDynamicStructuredBuffer(RootParameters::PerObjectDataSB, m_ObjectData);
+	}
 
 	if (m_DirtyFlags & DF_PerPassData)
 		commandList.SetGraphicsDynamicConstantBuffer(RootParameters::PerPassDataCB, m_PassData);
@@ -122,6 +127,8 @@ void Blainn::GPassPSO::Apply(dx12lib::CommandList& commandList)
 			BindTexture(commandList, RootParameters::Textures, 7, m_Material->GetTexture(TextureType::Opacity));
 		}
 	}
+
+	m_DirtyFlags = DF_None;
 }
 
 void Blainn::GPassPSO::BindTexture(dx12lib::CommandList& commandList, RootParameters rootParameter, uint32_t offset,
@@ -40,6 +40,9 @@ namespace Blainn
 		GPassPSO(std::shared_ptr<dx12lib::Device> device,
 			Microsoft::WRL::ComPtr<ID3DBlob> vertexShaderBlob, Microsoft::WRL::ComPtr<ID3DBlob> pixelShaderBlob,
 			D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+		// Copies share the root signature and pipeline state but bind their own data,
+		// command lists recorded at the same time each use their own copy
+		GPassPSO(const GPassPSO&) = default;
 		virtual ~GPassPSO() {}
 
 		const std::shared_ptr<dx12lib::Material>& GetMaterial() const
@@ -66,11 +69,19 @@ namespace Blainn
 			for(int32_t i = 0; i < instanceData.size(); ++i)
 				m_ObjectData[i].WorldMatrix = instanceData[i];
 
+			m_InstanceDataAddress = 0;
+			m_DirtyFlags |= DF_PerObjectData;
+		}
+		// Binds instanceCount PerObjectData already resident at address, nothing is copied
+		void SetInstanceData(D3D12_GPU_VIRTUAL_ADDRESS address, uint32_t instanceCount)
+		{
+			m_InstanceDataAddress = address;
+			m_InstanceDataCount = instanceCount;
 			m_DirtyFlags |= DF_PerObjectData;
 		}
 		uint32_t GetInstanceCount() const
 		{
-			return m_ObjectData.size();
+			return m_InstanceDataAddress ? m_InstanceDataCount : uint32_t(m_ObjectData.size());
 		}
 		PerPassData& GetPerPassData()
 		{
@@ -82,6 +93,12 @@ namespace Blainn
 			m_DirtyFlags |= DF_PerPassData;
 		}
 
+		// Root bindings belong to the command list, call before the first Apply on a new one
+		void Invalidate()
+		{
+			m_DirtyFlags = DF_All;
+		}
+
 		void Apply(dx12lib::CommandList& commandList);
 	protected:
 		enum DirtyFlags
@@ -110,6 +127,9 @@ namespace Blainn
 		
 		std::vector<PerObjectData> m_ObjectData;
 		PerPassData m_PassData;
+
+		D3D12_GPU_VIRTUAL_ADDRESS m_InstanceDataAddress = 0;
+		uint32_t m_InstanceDataCount = 0;
 		
 		dx12lib::CommandList* m_pPreviousCommandList;
 
@@ -7,9 +7,47 @@
 #include <fstream>
 #endif // 
 
-extern Blainn::Application* Blainn::CreateApplication(HINSTANCE hInstance);
+extern Blainn::Application* Blainn::CreateApplication(Blainn::NativeInstanceHandle instance);
 bool g_ApplicationRunning = true;
 
+#if defined(BLAINN_HEADLESS)
+#include "Platform/ScriptedInput.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Console entry for runs without a window or GPU. "--frames N" stops after N frames,
+// "--input file" plays back a ScriptedInput file.
+int main(int argc, char** argv)
+{
+	uint32_t frameCount = 0;
+	std::shared_ptr<Blainn::ScriptedInput> script;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--frames") == 0)
+			frameCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--input") == 0)
+		{
+			script = std::make_shared<Blainn::ScriptedInput>();
+			if (!script->Load(argv[++i]))
+			{
+				std::cerr << "Failed to load input script " << argv[i] << "\n";
+				return -1;
+			}
+		}
+	}
+
+	Blainn::Application* app = Blainn::CreateApplication(nullptr);
+	if (!app)
+		return -1;
+	app->SetHeadless(frameCount);
+	app->SetInputScript(script);
+	if (!app->Initialize())
+		return -1;
+	return app->Run();
+}
+#else
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 		PSTR pCmdLine, int nCmdShow)
 {
@@ -37,3 +75,4 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 		return -1;
 	}
 }
+#endif
@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "EventPump.h"
+
+#include "ScriptedInput.h"
+
+namespace Blainn
+{
+#if defined(_WIN32)
+	bool Win32EventPump::PumpEvents()
+	{
+		MSG msg = { nullptr };
+		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+		{
+			if (msg.message == WM_QUIT)
+			{
+				m_ExitCode = int(msg.wParam);
+				return false;
+			}
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+		return true;
+	}
+
+	void Win32EventPump::RequestQuit(int exitCode)
+	{
+		PostQuitMessage(exitCode);
+	}
+#endif
+
+	HeadlessEventPump::HeadlessEventPump(std::shared_ptr<ScriptedInput> script)
+		: m_Script(std::move(script))
+	{
+	}
+
+	bool HeadlessEventPump::PumpEvents()
+	{
+		if (m_bQuitRequested)
+			return false;
+
+		if (m_Script)
+			m_Script->Play(m_Frame);
+		m_Frame++;
+		return true;
+	}
+
+	void HeadlessEventPump::RequestQuit(int exitCode)
+	{
+		m_ExitCode = exitCode;
+		m_bQuitRequested = true;
+	}
+}
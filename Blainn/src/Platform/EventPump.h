@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace Blainn
+{
+	class ScriptedInput;
+
+	// Hands what the OS queued for the application to the windows and Input, once per
+	// frame before the update.
+	class EventPump
+	{
+	public:
+		virtual ~EventPump() = default;
+
+		// Dispatches everything queued since the last call, false once the application
+		// should quit
+		virtual bool PumpEvents() = 0;
+		virtual void RequestQuit(int exitCode) = 0;
+		// What Run returns after PumpEvents returned false
+		virtual int GetExitCode() const = 0;
+	};
+
+#if defined(_WIN32)
+	// The thread's Win32 message queue, windows get their messages through their WndProc
+	class Win32EventPump : public EventPump
+	{
+	public:
+		bool PumpEvents() override;
+		void RequestQuit(int exitCode) override;
+		int GetExitCode() const override { return m_ExitCode; }
+
+	private:
+		int m_ExitCode = 0;
+	};
+#endif
+
+	// For runs without a window. Nothing comes from the OS, the input is the script's
+	// events for the current frame.
+	class HeadlessEventPump : public EventPump
+	{
+	public:
+		explicit HeadlessEventPump(std::shared_ptr<ScriptedInput> script = nullptr);
+
+		bool PumpEvents() override;
+		void RequestQuit(int exitCode) override;
+		int GetExitCode() const override { return m_ExitCode; }
+
+		// Frames pumped so far
+		uint32_t GetFrame() const { return m_Frame; }
+
+	private:
+		std::shared_ptr<ScriptedInput> m_Script;
+		uint32_t m_Frame = 0;
+		int m_ExitCode = 0;
+		bool m_bQuitRequested = false;
+	};
+}
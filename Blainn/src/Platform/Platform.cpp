@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "Platform.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace Blainn
+{
+	// steady_clock is QueryPerformanceCounter with MSVC and clock_gettime(CLOCK_MONOTONIC)
+	// with libstdc++ and libc++
+	using PlatformClock = std::chrono::steady_clock;
+
+	int64_t Platform::GetTicks()
+	{
+		return int64_t(PlatformClock::now().time_since_epoch().count());
+	}
+
+	int64_t Platform::GetTicksPerSecond()
+	{
+		return int64_t(PlatformClock::period::den / PlatformClock::period::num);
+	}
+
+	void Platform::Sleep(uint32_t milliseconds)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	}
+
+	void Platform::DebugPrint(const char* message)
+	{
+#if defined(_WIN32)
+		OutputDebugStringA(message);
+#else
+		std::fputs(message, stderr);
+#endif
+	}
+
+	void Platform::SetCursorVisible(bool bVisible)
+	{
+#if defined(_WIN32)
+		// ShowCursor keeps a display count, only its sign matters
+		if (bVisible)
+			while (ShowCursor(TRUE) < 0);
+		else
+			while (ShowCursor(FALSE) >= 0);
+#endif
+	}
+
+	void Platform::CenterCursor()
+	{
+#if defined(_WIN32)
+		HWND window = GetActiveWindow();
+		if (!window)
+			return;
+
+		RECT rect;
+		GetClientRect(window, &rect);
+		POINT center = { (rect.right - rect.left) / 2, (rect.bottom - rect.top) / 2 };
+		ClientToScreen(window, &center);
+		SetCursorPos(center.x, center.y);
+#endif
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Blainn
+{
+	// What the OS hands the program at startup, the HINSTANCE on Windows. Null for
+	// console and headless entry points.
+	using NativeInstanceHandle = void*;
+
+	// The few OS calls the engine core makes. Everything here also builds where there
+	// is no window, the cursor functions then do nothing.
+	class Platform
+	{
+	public:
+		// Monotonic high resolution clock, never goes back and ignores wall clock changes
+		static int64_t GetTicks();
+		static int64_t GetTicksPerSecond();
+
+		static void Sleep(uint32_t milliseconds);
+
+		// To the debugger's output on Windows, to stderr everywhere else
+		static void DebugPrint(const char* message);
+
+		static void SetCursorVisible(bool bVisible);
+		// Moves the cursor to the center of the active window
+		static void CenterCursor();
+	};
+}
@@ -0,0 +1,161 @@
+#include "pch.h"
+#include "ScriptedInput.h"
+
+#include "Core/Events/KeyEvent.h"
+#include "Core/Events/MouseEvent.h"
+#include "Core/Input.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace Blainn
+{
+	void ScriptedInput::PressKey(uint32_t frame, KeyCode key)
+	{
+		Add({ frame, ScriptedInputEvent::KeyDown, uint32_t(key) });
+	}
+
+	void ScriptedInput::ReleaseKey(uint32_t frame, KeyCode key)
+	{
+		Add({ frame, ScriptedInputEvent::KeyUp, uint32_t(key) });
+	}
+
+	void ScriptedInput::HoldKey(uint32_t frame, uint32_t frameCount, KeyCode key)
+	{
+		PressKey(frame, key);
+		ReleaseKey(frame + std::max(frameCount, 1u), key);
+	}
+
+	void ScriptedInput::PressButton(uint32_t frame, MouseButton button)
+	{
+		Add({ frame, ScriptedInputEvent::ButtonDown, uint32_t(button) });
+	}
+
+	void ScriptedInput::ReleaseButton(uint32_t frame, MouseButton button)
+	{
+		Add({ frame, ScriptedInputEvent::ButtonUp, uint32_t(button) });
+	}
+
+	void ScriptedInput::MoveMouse(uint32_t frame, int32_t deltaX, int32_t deltaY)
+	{
+		Add({ frame, ScriptedInputEvent::MouseMove, 0, deltaX, deltaY });
+	}
+
+	bool ScriptedInput::Load(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return false;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			size_t start = line.find_first_not_of(" \t\r");
+			if (start == std::string::npos || line[start] == '#')
+				continue;
+
+			std::istringstream stream(line);
+			uint32_t frame;
+			std::string type;
+			if (!(stream >> frame >> type))
+				return false;
+
+			if (type == "move")
+			{
+				int32_t x, y;
+				if (!(stream >> x >> y))
+					return false;
+				MoveMouse(frame, x, y);
+				continue;
+			}
+
+			uint32_t code;
+			std::string state;
+			if (!(stream >> code >> state) || (state != "down" && state != "up"))
+				return false;
+
+			bool bDown = state == "down";
+			if (type == "key")
+				Add({ frame, bDown ? ScriptedInputEvent::KeyDown : ScriptedInputEvent::KeyUp, code });
+			else if (type == "button")
+				Add({ frame, bDown ? ScriptedInputEvent::ButtonDown : ScriptedInputEvent::ButtonUp, code });
+			else
+				return false;
+		}
+		return true;
+	}
+
+	void ScriptedInput::Play(uint32_t frame)
+	{
+		auto first = std::lower_bound(m_Events.begin(), m_Events.end(), frame,
+			[](const ScriptedInputEvent& e, uint32_t f) { return e.Frame < f; });
+
+		for (auto it = first; it != m_Events.end() && it->Frame == frame; ++it)
+		{
+			switch (it->EventType)
+			{
+			case ScriptedInputEvent::KeyDown:
+			{
+				KeyCode key = KeyCode(it->Code);
+				Input::UpdateKeyState(key, KeyState::Pressed);
+				Input::OnKeyPressedDelegate.Broadcast(key);
+				KeyPressedEvent event(int(it->Code), 0);
+				if (m_EventCallback)
+					m_EventCallback(event);
+				break;
+			}
+			case ScriptedInputEvent::KeyUp:
+			{
+				KeyCode key = KeyCode(it->Code);
+				Input::UpdateKeyState(key, KeyState::Released);
+				Input::OnKeyReleasedDelegate.Broadcast(key);
+				KeyReleasedEvent event(int(it->Code));
+				if (m_EventCallback)
+					m_EventCallback(event);
+				break;
+			}
+			case ScriptedInputEvent::ButtonDown:
+			{
+				MouseButton button = MouseButton(it->Code);
+				auto [x, y] = Input::GetMousePosition();
+				Input::UpdateButtonState(button, KeyState::Pressed);
+				Input::OnMouseButtonPressedDelegate.Broadcast(button);
+				MouseButtonDownEvent event(button, x, y);
+				if (m_EventCallback)
+					m_EventCallback(event);
+				break;
+			}
+			case ScriptedInputEvent::ButtonUp:
+			{
+				MouseButton button = MouseButton(it->Code);
+				auto [x, y] = Input::GetMousePosition();
+				Input::UpdateButtonState(button, KeyState::Released);
+				Input::OnMouseButtonReleasedDelegate.Broadcast(button);
+				MouseButtonReleasedEvent event(button, x, y);
+				if (m_EventCallback)
+					m_EventCallback(event);
+				break;
+			}
+			case ScriptedInputEvent::MouseMove:
+			{
+				auto [x, y] = Input::GetMousePosition();
+				Input::UpdateMousePosition(x + it->X, y + it->Y);
+				Input::UpdateMouseDelta(it->X, it->Y);
+				Input::OnMouseMovedDelegate.Broadcast(it->X, it->Y);
+				MouseMovedEvent event(it->X, it->Y);
+				if (m_EventCallback)
+					m_EventCallback(event);
+				break;
+			}
+			}
+		}
+	}
+
+	void ScriptedInput::Add(const ScriptedInputEvent& event)
+	{
+		auto position = std::upper_bound(m_Events.begin(), m_Events.end(), event.Frame,
+			[](uint32_t f, const ScriptedInputEvent& e) { return f < e.Frame; });
+		m_Events.insert(position, event);
+	}
+}
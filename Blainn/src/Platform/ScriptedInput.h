@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Core/KeyCodes.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Blainn
+{
+	class Event;
+
+	struct ScriptedInputEvent
+	{
+		enum Type : uint32_t
+		{
+			KeyDown,
+			KeyUp,
+			ButtonDown,
+			ButtonUp,
+			// X and Y are the relative motion
+			MouseMove,
+		};
+
+		uint32_t Frame = 0;
+		Type EventType = KeyDown;
+		// KeyCode or MouseButton value
+		uint32_t Code = 0;
+		int32_t X = 0;
+		int32_t Y = 0;
+	};
+
+	// Input written down ahead of time and played back by frame, so runs without a
+	// window drive the same game code a player would. Playing an event does what the
+	// window does for a real one: Input gets the new state, the Input delegate is
+	// broadcast and the event goes to the event callback.
+	class ScriptedInput
+	{
+	public:
+		using EventCallbackFn = std::function<void(Event&)>;
+
+		void PressKey(uint32_t frame, KeyCode key);
+		void ReleaseKey(uint32_t frame, KeyCode key);
+		// Pressed on frame and released frameCount frames later
+		void HoldKey(uint32_t frame, uint32_t frameCount, KeyCode key);
+		void PressButton(uint32_t frame, MouseButton button);
+		void ReleaseButton(uint32_t frame, MouseButton button);
+		void MoveMouse(uint32_t frame, int32_t deltaX, int32_t deltaY);
+
+		// One event per line, "<frame> key <code> down|up", "<frame> button <code> down|up"
+		// or "<frame> move <dx> <dy>". Codes are KeyCode and MouseButton values, lines
+		// starting with # are skipped. False when the file can't be read or a line is bad.
+		bool Load(const std::string& path);
+		void Clear() { m_Events.clear(); }
+
+		void SetEventCallback(const EventCallbackFn& callback) { m_EventCallback = callback; }
+
+		// Plays every event of frame in the order they were added
+		void Play(uint32_t frame);
+
+		// Frame after the last event
+		uint32_t GetLength() const { return m_Events.empty() ? 0 : m_Events.back().Frame + 1; }
+		const std::vector<ScriptedInputEvent>& GetEvents() const { return m_Events; }
+
+	private:
+		void Add(const ScriptedInputEvent& event);
+
+	private:
+		// Sorted by frame, events of one frame in the order they were added
+		std::vector<ScriptedInputEvent> m_Events;
+		EventCallbackFn m_EventCallback;
+	};
+}
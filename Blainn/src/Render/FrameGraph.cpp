@@ -0,0 +1,416 @@
+#include "pch.h"
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <queue>
+
+namespace Blainn
+{
+	uint32_t GetFormatSize(FrameGraphFormat format)
+	{
+		switch (format)
+		{
+		case FrameGraphFormat::RGBA8:
+		case FrameGraphFormat::RGB10A2:
+		case FrameGraphFormat::R32F:
+		case FrameGraphFormat::D32:
+			return 4;
+		case FrameGraphFormat::RGBA16F:
+			return 8;
+		}
+		return 0;
+	}
+
+	static uint64_t GetTextureSize(const FrameGraphTextureDesc& desc)
+	{
+		uint64_t size = uint64_t(desc.Width) * desc.Height * desc.ArraySize * GetFormatSize(desc.Format);
+		return (size + FrameGraph::PlacementAlignment - 1) & ~(FrameGraph::PlacementAlignment - 1);
+	}
+
+	void FrameGraph::Reset()
+	{
+		m_Passes.clear();
+		m_Resources.clear();
+		m_Order.clear();
+		m_Barriers.clear();
+		m_FinalBarriers.clear();
+		m_Placements.clear();
+		m_AliasedFrom.clear();
+		m_bCompiled = false;
+		m_Stats = {};
+	}
+
+	FrameGraphResource FrameGraph::CreateTexture(const std::string& name, const FrameGraphTextureDesc& desc)
+	{
+		Resource& resource = m_Resources.emplace_back();
+		resource.Name = name;
+		resource.Desc = desc;
+		m_bCompiled = false;
+		return FrameGraphResource(m_Resources.size() - 1);
+	}
+
+	FrameGraphResource FrameGraph::ImportTexture(const std::string& name, const FrameGraphTextureDesc& desc,
+		uint32_t initialState, uint32_t finalState)
+	{
+		FrameGraphResource handle = CreateTexture(name, desc);
+		Resource& resource = m_Resources[handle];
+		resource.bImported = true;
+		resource.InitialState = initialState;
+		resource.FinalState = finalState;
+		return handle;
+	}
+
+	uint32_t FrameGraph::AddPass(const std::string& name, ExecuteFunction execute)
+	{
+		Pass& pass = m_Passes.emplace_back();
+		pass.Name = name;
+		pass.Execute = std::move(execute);
+		m_bCompiled = false;
+		return uint32_t(m_Passes.size() - 1);
+	}
+
+	void FrameGraph::Read(uint32_t pass, FrameGraphResource resource, uint32_t state)
+	{
+		assert((state & RS_WriteStates) == 0 && "Reads can't use a write state");
+		AddAccess(pass, resource, state, false);
+	}
+
+	void FrameGraph::Write(uint32_t pass, FrameGraphResource resource, uint32_t state)
+	{
+		AddAccess(pass, resource, state, true);
+	}
+
+	void FrameGraph::SetSideEffect(uint32_t pass)
+	{
+		m_Passes[pass].bSideEffect = true;
+		m_bCompiled = false;
+	}
+
+	void FrameGraph::AddAccess(uint32_t pass, FrameGraphResource resource, uint32_t state, bool bWrite)
+	{
+		assert(pass < m_Passes.size() && resource < m_Resources.size());
+
+		m_Passes[pass].Accesses.push_back({ resource, state, bWrite });
+
+		std::vector<uint32_t>& passes = bWrite ? m_Resources[resource].Writers : m_Resources[resource].Readers;
+		if (passes.empty() || passes.back() != pass)
+			passes.push_back(pass);
+		m_bCompiled = false;
+	}
+
+	bool FrameGraph::Compile()
+	{
+		m_Order.clear();
+		m_Barriers.clear();
+		m_FinalBarriers.clear();
+		m_Placements.clear();
+		m_Stats = {};
+		m_Stats.Passes = GetPassCount();
+
+		for (Resource& resource : m_Resources)
+		{
+			resource.FirstUse = ~0u;
+			resource.LastUse = 0;
+		}
+
+		CullPasses();
+		if (!SortPasses())
+			return false;
+		ComputeLifetimes();
+		PlaceTransients();
+		BuildBarriers();
+
+		m_bCompiled = true;
+		return true;
+	}
+
+	void FrameGraph::CullPasses()
+	{
+		std::vector<uint32_t> stack;
+		for (uint32_t i = 0; i < m_Passes.size(); ++i)
+		{
+			Pass& pass = m_Passes[i];
+			pass.bKept = pass.bSideEffect;
+			for (const Access& access : pass.Accesses)
+				pass.bKept |= access.bWrite && m_Resources[access.Resource].bImported;
+
+			if (pass.bKept)
+				stack.push_back(i);
+		}
+
+		// everything that wrote a resource a kept pass touches has to run before it,
+		// earlier writers included since a write may only cover part of the resource
+		while (!stack.empty())
+		{
+			uint32_t i = stack.back();
+			stack.pop_back();
+
+			for (const Access& access : m_Passes[i].Accesses)
+			{
+				for (uint32_t writer : m_Resources[access.Resource].Writers)
+				{
+					if (m_Passes[writer].bKept)
+						continue;
+					m_Passes[writer].bKept = true;
+					stack.push_back(writer);
+				}
+			}
+		}
+
+		for (const Pass& pass : m_Passes)
+			m_Stats.CulledPasses += pass.bKept ? 0 : 1;
+	}
+
+	bool FrameGraph::SortPasses()
+	{
+		const uint32_t passCount = GetPassCount();
+		std::vector<std::vector<uint32_t>> dependents(passCount);
+		std::vector<uint32_t> dependencyCount(passCount, 0);
+
+		auto addEdge = [&](uint32_t from, uint32_t to)
+			{
+				if (from == to)
+					return;
+				dependents[from].push_back(to);
+				dependencyCount[to]++;
+			};
+
+		std::vector<uint32_t> writers;
+		for (const Resource& resource : m_Resources)
+		{
+			writers.clear();
+			for (uint32_t writer : resource.Writers)
+			{
+				if (m_Passes[writer].bKept)
+					writers.push_back(writer);
+			}
+			if (writers.empty())
+				continue;
+
+			for (uint32_t i = 1; i < writers.size(); ++i)
+				addEdge(writers[i - 1], writers[i]);
+
+			for (uint32_t reader : resource.Readers)
+			{
+				if (m_Passes[reader].bKept && std::find(writers.begin(), writers.end(), reader) == writers.end())
+					addEdge(writers.back(), reader);
+			}
+		}
+
+		// among the passes that are ready the one added first goes first, so
+		// independent passes keep the order they were written in
+		std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+		uint32_t keptCount = 0;
+		for (uint32_t i = 0; i < passCount; ++i)
+		{
+			if (!m_Passes[i].bKept)
+				continue;
+			keptCount++;
+			if (dependencyCount[i] == 0)
+				ready.push(i);
+		}
+
+		while (!ready.empty())
+		{
+			uint32_t pass = ready.top();
+			ready.pop();
+			m_Order.push_back(pass);
+
+			for (uint32_t dependent : dependents[pass])
+			{
+				if (--dependencyCount[dependent] == 0)
+					ready.push(dependent);
+			}
+		}
+
+		assert(m_Order.size() == keptCount && "Frame graph passes depend on each other in a cycle");
+		return m_Order.size() == keptCount;
+	}
+
+	void FrameGraph::ComputeLifetimes()
+	{
+		for (uint32_t position = 0; position < m_Order.size(); ++position)
+		{
+			for (const Access& access : m_Passes[m_Order[position]].Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				resource.FirstUse = std::min(resource.FirstUse, position);
+				resource.LastUse = std::max(resource.LastUse, position);
+			}
+		}
+	}
+
+	void FrameGraph::PlaceTransients()
+	{
+		m_AliasedFrom.assign(m_Resources.size(), InvalidFrameGraphResource);
+
+		std::vector<FrameGraphResource> transients;
+		for (FrameGraphResource i = 0; i < m_Resources.size(); ++i)
+		{
+			if (!m_Resources[i].bImported && m_Resources[i].FirstUse != ~0u)
+				transients.push_back(i);
+		}
+
+		// largest first packs tighter, the index keeps the result deterministic
+		std::sort(transients.begin(), transients.end(), [&](FrameGraphResource a, FrameGraphResource b)
+			{
+				uint64_t sizeA = GetTextureSize(m_Resources[a].Desc);
+				uint64_t sizeB = GetTextureSize(m_Resources[b].Desc);
+				return sizeA != sizeB ? sizeA > sizeB : a < b;
+			});
+
+		std::vector<FrameGraphPlacement> conflicts;
+		for (FrameGraphResource handle : transients)
+		{
+			const Resource& resource = m_Resources[handle];
+			uint64_t size = GetTextureSize(resource.Desc);
+
+			// memory of everything alive at the same time is taken
+			conflicts.clear();
+			for (const FrameGraphPlacement& placed : m_Placements)
+			{
+				const Resource& other = m_Resources[placed.Resource];
+				if (other.FirstUse <= resource.LastUse && resource.FirstUse <= other.LastUse)
+					conflicts.push_back(placed);
+			}
+			std::sort(conflicts.begin(), conflicts.end(), [](const FrameGraphPlacement& a, const FrameGraphPlacement& b)
+				{
+					return a.Offset < b.Offset;
+				});
+
+			uint64_t offset = 0;
+			for (const FrameGraphPlacement& conflict : conflicts)
+			{
+				if (offset + size <= conflict.Offset)
+					break;
+				offset = std::max(offset, conflict.Offset + conflict.Size);
+			}
+
+			m_Placements.push_back({ handle, offset, size });
+			m_Stats.Transients++;
+			m_Stats.TransientBytes += size;
+			m_Stats.HeapBytes = std::max(m_Stats.HeapBytes, offset + size);
+		}
+
+		// the latest earlier user of the same memory needs an aliasing barrier against it,
+		// known only once everything is placed since smaller resources go in later
+		for (const FrameGraphPlacement& placement : m_Placements)
+		{
+			const Resource& resource = m_Resources[placement.Resource];
+			FrameGraphResource& aliased = m_AliasedFrom[placement.Resource];
+			for (const FrameGraphPlacement& placed : m_Placements)
+			{
+				const Resource& other = m_Resources[placed.Resource];
+				bool bOverlaps = placed.Offset < placement.Offset + placement.Size && placement.Offset < placed.Offset + placed.Size;
+				if (!bOverlaps || other.LastUse >= resource.FirstUse)
+					continue;
+				if (aliased == InvalidFrameGraphResource || other.LastUse > m_Resources[aliased].LastUse)
+					aliased = placed.Resource;
+			}
+		}
+
+		std::sort(m_Placements.begin(), m_Placements.end(), [](const FrameGraphPlacement& a, const FrameGraphPlacement& b)
+			{
+				return a.Resource < b.Resource;
+			});
+	}
+
+	void FrameGraph::BuildBarriers()
+	{
+		std::vector<uint32_t> states(m_Resources.size());
+		for (FrameGraphResource i = 0; i < m_Resources.size(); ++i)
+			states[i] = m_Resources[i].InitialState;
+
+		m_Barriers.resize(m_Order.size());
+		for (uint32_t position = 0; position < m_Order.size(); ++position)
+		{
+			const Pass& pass = m_Passes[m_Order[position]];
+			std::vector<FrameGraphBarrier>& barriers = m_Barriers[position];
+
+			for (uint32_t i = 0; i < pass.Accesses.size(); ++i)
+			{
+				FrameGraphResource handle = pass.Accesses[i].Resource;
+
+				// one state per resource and pass, reads combine, writes replace them
+				bool bSeen = false;
+				uint32_t readState = 0;
+				uint32_t writeState = 0;
+				for (uint32_t j = 0; j < pass.Accesses.size(); ++j)
+				{
+					const Access& access = pass.Accesses[j];
+					if (access.Resource != handle)
+						continue;
+					if (j < i)
+					{
+						bSeen = true;
+						break;
+					}
+					(access.bWrite ? writeState : readState) |= access.State;
+				}
+				if (bSeen)
+					continue;
+
+				uint32_t state = writeState ? writeState : readState;
+				const Resource& resource = m_Resources[handle];
+
+				if (!resource.bImported && resource.FirstUse == position && m_AliasedFrom[handle] != InvalidFrameGraphResource)
+				{
+					FrameGraphBarrier& barrier = barriers.emplace_back();
+					barrier.BarrierType = FrameGraphBarrier::Aliasing;
+					barrier.Resource = handle;
+					barrier.AliasedFrom = m_AliasedFrom[handle];
+					m_Stats.AliasingBarriers++;
+				}
+
+				if (states[handle] != state)
+				{
+					barriers.push_back({ FrameGraphBarrier::Transition, handle, InvalidFrameGraphResource, states[handle], state });
+					states[handle] = state;
+					m_Stats.Transitions++;
+				}
+			}
+		}
+
+		for (FrameGraphResource i = 0; i < m_Resources.size(); ++i)
+		{
+			const Resource& resource = m_Resources[i];
+			if (!resource.bImported || states[i] == resource.FinalState)
+				continue;
+			m_FinalBarriers.push_back({ FrameGraphBarrier::Transition, i, InvalidFrameGraphResource, states[i], resource.FinalState });
+			m_Stats.Transitions++;
+		}
+	}
+
+	void FrameGraph::Execute(FrameGraphBackend* backend)
+	{
+		assert(m_bCompiled && "Compile the frame graph before executing it");
+
+		if (backend)
+			backend->BeginFrame(*this);
+
+		for (uint32_t position = 0; position < m_Order.size(); ++position)
+		{
+			uint32_t pass = m_Order[position];
+			if (backend)
+			{
+				if (!m_Barriers[position].empty())
+					backend->SubmitBarriers(*this, m_Barriers[position]);
+				backend->BeginPass(*this, pass);
+			}
+
+			if (m_Passes[pass].Execute)
+				m_Passes[pass].Execute();
+
+			if (backend)
+				backend->EndPass(*this, pass);
+		}
+
+		if (backend)
+		{
+			if (!m_FinalBarriers.empty())
+				backend->SubmitBarriers(*this, m_FinalBarriers);
+			backend->EndFrame(*this);
+		}
+	}
+}
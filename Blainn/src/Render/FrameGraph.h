@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Blainn
+{
+	class FrameGraphBackend;
+
+	using FrameGraphResource = uint32_t;
+	static constexpr FrameGraphResource InvalidFrameGraphResource = ~0u;
+
+	enum class FrameGraphFormat : uint32_t
+	{
+		RGBA8,
+		RGB10A2,
+		RGBA16F,
+		R32F,
+		D32,
+	};
+
+	uint32_t GetFormatSize(FrameGraphFormat format);
+
+	struct FrameGraphTextureDesc
+	{
+		uint32_t Width = 1;
+		uint32_t Height = 1;
+		uint32_t ArraySize = 1;
+		FrameGraphFormat Format = FrameGraphFormat::RGBA8;
+	};
+
+	// Bit flags, a pass reading a resource in several ways needs all of them at once
+	enum ResourceState : uint32_t
+	{
+		RS_Undefined = 0,
+		RS_RenderTarget = 1 << 0,
+		RS_DepthWrite = 1 << 1,
+		RS_DepthRead = 1 << 2,
+		RS_ShaderRead = 1 << 3,
+		RS_CopySource = 1 << 4,
+		RS_CopyDest = 1 << 5,
+		RS_Present = 1 << 6,
+
+		RS_WriteStates = RS_RenderTarget | RS_DepthWrite | RS_CopyDest,
+	};
+
+	struct FrameGraphBarrier
+	{
+		enum Type : uint32_t
+		{
+			Transition,
+			// Resource takes over memory AliasedFrom used earlier in the frame
+			Aliasing,
+		};
+
+		Type BarrierType = Transition;
+		FrameGraphResource Resource = InvalidFrameGraphResource;
+		FrameGraphResource AliasedFrom = InvalidFrameGraphResource;
+		uint32_t Before = RS_Undefined;
+		uint32_t After = RS_Undefined;
+	};
+
+	// Where a transient lives in the frame's transient heap
+	struct FrameGraphPlacement
+	{
+		FrameGraphResource Resource = InvalidFrameGraphResource;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+	};
+
+	struct FrameGraphStats
+	{
+		uint32_t Passes = 0;
+		// Passes nothing kept depends on
+		uint32_t CulledPasses = 0;
+		uint32_t Transitions = 0;
+		uint32_t AliasingBarriers = 0;
+		uint32_t Transients = 0;
+		// Transient memory without and with aliasing
+		uint64_t TransientBytes = 0;
+		uint64_t HeapBytes = 0;
+	};
+
+	// Passes declare what they read and write, Compile works out everything else:
+	// which passes run and in what order, the state transitions batched in front of
+	// every pass and where in one heap the transient resources are placed, so that
+	// transients whose lifetimes do not overlap share memory.
+	//
+	// The order between passes follows from the resources alone. Writers of a
+	// resource run in the order they were added, and a resource is complete once its
+	// last writer ran, so every pass that only reads it waits for all of them. Passes
+	// are kept when they write an imported resource, are marked with SetSideEffect or
+	// write something a kept pass reads.
+	//
+	// Nothing here knows about a graphics API, Execute hands the barriers and the
+	// placements to a FrameGraphBackend.
+	class FrameGraph
+	{
+	public:
+		using ExecuteFunction = std::function<void()>;
+
+		// Placed resources are aligned like D3D12's default placement alignment
+		static constexpr uint64_t PlacementAlignment = 64 * 1024;
+
+		// Drops every pass and resource, the graph is built again every frame
+		void Reset();
+
+		// Lives only for the frame, memory is assigned by Compile
+		FrameGraphResource CreateTexture(const std::string& name, const FrameGraphTextureDesc& desc);
+		// Owned elsewhere and never aliased. The resource is in initialState when the
+		// frame starts and is put in finalState when it ends.
+		FrameGraphResource ImportTexture(const std::string& name, const FrameGraphTextureDesc& desc,
+			uint32_t initialState, uint32_t finalState);
+
+		uint32_t AddPass(const std::string& name, ExecuteFunction execute);
+		void Read(uint32_t pass, FrameGraphResource resource, uint32_t state);
+		void Write(uint32_t pass, FrameGraphResource resource, uint32_t state);
+		// Never culled, for passes whose output is not a resource
+		void SetSideEffect(uint32_t pass);
+
+		// False when the dependencies form a cycle
+		bool Compile();
+		// Runs the kept passes in order, backend may be null
+		void Execute(FrameGraphBackend* backend);
+
+		uint32_t GetPassCount() const { return uint32_t(m_Passes.size()); }
+		uint32_t GetResourceCount() const { return uint32_t(m_Resources.size()); }
+		const std::string& GetPassName(uint32_t pass) const { return m_Passes[pass].Name; }
+		const std::string& GetResourceName(FrameGraphResource resource) const { return m_Resources[resource].Name; }
+		const FrameGraphTextureDesc& GetDesc(FrameGraphResource resource) const { return m_Resources[resource].Desc; }
+		bool IsImported(FrameGraphResource resource) const { return m_Resources[resource].bImported; }
+		// Undefined for transients
+		uint32_t GetInitialState(FrameGraphResource resource) const { return m_Resources[resource].InitialState; }
+
+		// Valid after Compile
+		const std::vector<uint32_t>& GetExecutionOrder() const { return m_Order; }
+		// Barriers in front of the pass at that position of the execution order
+		const std::vector<FrameGraphBarrier>& GetBarriers(uint32_t orderIndex) const { return m_Barriers[orderIndex]; }
+		// Barriers after the last pass, imported resources going to their final state
+		const std::vector<FrameGraphBarrier>& GetFinalBarriers() const { return m_FinalBarriers; }
+		const std::vector<FrameGraphPlacement>& GetPlacements() const { return m_Placements; }
+		uint64_t GetHeapSize() const { return m_Stats.HeapBytes; }
+
+		const FrameGraphStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Access
+		{
+			FrameGraphResource Resource;
+			uint32_t State;
+			bool bWrite;
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			ExecuteFunction Execute;
+			std::vector<Access> Accesses;
+			bool bSideEffect = false;
+			bool bKept = false;
+		};
+
+		struct Resource
+		{
+			std::string Name;
+			FrameGraphTextureDesc Desc;
+			bool bImported = false;
+			uint32_t InitialState = RS_Undefined;
+			uint32_t FinalState = RS_Undefined;
+
+			std::vector<uint32_t> Writers;
+			std::vector<uint32_t> Readers;
+			// Positions in the execution order
+			uint32_t FirstUse = ~0u;
+			uint32_t LastUse = 0;
+		};
+
+		void AddAccess(uint32_t pass, FrameGraphResource resource, uint32_t state, bool bWrite);
+
+		void CullPasses();
+		bool SortPasses();
+		void ComputeLifetimes();
+		void PlaceTransients();
+		void BuildBarriers();
+
+	private:
+		std::vector<Pass> m_Passes;
+		std::vector<Resource> m_Resources;
+
+		std::vector<uint32_t> m_Order;
+		std::vector<std::vector<FrameGraphBarrier>> m_Barriers;
+		std::vector<FrameGraphBarrier> m_FinalBarriers;
+		std::vector<FrameGraphPlacement> m_Placements;
+		// Transient whose memory a resource reuses, per resource
+		std::vector<FrameGraphResource> m_AliasedFrom;
+		bool m_bCompiled = false;
+
+		FrameGraphStats m_Stats;
+	};
+
+	// What Execute drives. A D3D12 backend turns the placements into placed resources
+	// and the barriers into ResourceBarrier calls.
+	class FrameGraphBackend
+	{
+	public:
+		virtual ~FrameGraphBackend() = default;
+
+		virtual void BeginFrame(const FrameGraph& graph) = 0;
+		virtual void SubmitBarriers(const FrameGraph& graph, const std::vector<FrameGraphBarrier>& barriers) = 0;
+		virtual void BeginPass(const FrameGraph& graph, uint32_t pass) = 0;
+		virtual void EndPass(const FrameGraph& graph, uint32_t pass) = 0;
+		virtual void EndFrame(const FrameGraph& graph) = 0;
+	};
+}
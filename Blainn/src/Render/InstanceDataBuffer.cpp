@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "InstanceDataBuffer.h"
+
+#include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Core/EntityRegistry.h"
+#include "Core/GameObject.h"
+#include "Model.h"
+
+#include <algorithm>
+#include <cstring>
+
+extern const int g_NumFrameResources;
+
+namespace Blainn
+{
+	// Frame buffers are allocated by the first Upload, virtual calls don't reach a
+	// subclass from the constructor
+	static constexpr uint32_t s_MinCapacity = 1024;
+
+	InstanceDataBuffer::InstanceDataBuffer()
+		: m_MappedData(g_NumFrameResources, nullptr)
+	{
+	}
+
+	InstanceDataBuffer::~InstanceDataBuffer() = default;
+
+	void InstanceDataBuffer::Build(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes, float alpha)
+	{
+		using namespace DirectX;
+
+		m_FrameIndex = (m_FrameIndex + 1) % m_MappedData.size();
+
+		// a range that grew, shrank or moved means instances came or went
+		uint32_t instanceCount = 0;
+		m_Ranges.resize(meshes.size());
+		m_MeshesChanged.assign(meshes.size(), 0);
+		m_PreviousRanges = m_Ranges;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			m_Ranges[i].Offset = instanceCount;
+			m_Ranges[i].Count = 0;
+			instanceCount += uint32_t(meshes[i]->GetOwners().size());
+		}
+
+		m_Instances.resize(instanceCount);
+		m_FramesDirty.resize(instanceCount, uint8_t(g_NumFrameResources));
+		m_Bounds.Resize(instanceCount);
+
+		auto& registry = EntityRegistry::Get();
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			const BoundingBox& localBounds = meshes[i]->GetModel()->GetBounds();
+
+			InstanceRange& range = m_Ranges[i];
+			for (EntityHandle ownerHandle : meshes[i]->GetOwners())
+			{
+				// a shared mesh stays in the scene while any of its owners is placed
+				GameObject* owner = registry.Resolve(ownerHandle);
+				TransformComponent* transform = owner && owner->GetScene() ? owner->GetComponentPtr<TransformComponent>() : nullptr;
+				if (!transform)
+					continue;
+
+				uint32_t slot = range.Offset + range.Count++;
+
+				const SimpleMath::Matrix world = transform->GetInterpolatedWorldMatrix(alpha);
+				m_Bounds.Set(slot, localBounds.Center, localBounds.Extents, world);
+
+				XMFLOAT4X4 transposed;
+				XMStoreFloat4x4(&transposed, XMMatrixTranspose(XMLoadFloat4x4(&world)));
+				if (std::memcmp(&m_Instances[slot].WorldMatrix, &transposed, sizeof(transposed)) != 0)
+				{
+					m_Instances[slot].WorldMatrix = transposed;
+					m_FramesDirty[slot] = uint8_t(g_NumFrameResources);
+					m_MeshesChanged[i] = 1;
+				}
+			}
+
+			if (range.Offset != m_PreviousRanges[i].Offset || range.Count != m_PreviousRanges[i].Count)
+				m_MeshesChanged[i] = 1;
+
+			// the slots of unresolved or unplaced owners are left unused and never pass culling
+			for (uint32_t slot = range.Offset + range.Count; slot < range.Offset + meshes[i]->GetOwners().size(); ++slot)
+				m_Bounds.SetEmpty(slot);
+		}
+	}
+
+	void InstanceDataBuffer::Upload(const ViewCulling& culling)
+	{
+		uint32_t instanceCount = GetInstanceCount();
+		uint32_t meshCount = uint32_t(m_Ranges.size());
+		uint32_t viewCount = culling.GetViewCount();
+
+		// visible lists are ascending and every mesh owns a contiguous block of slots,
+		// so one walk over a list splits it per mesh
+		m_ViewInstances.clear();
+		m_ViewRanges.resize(size_t(viewCount) * meshCount);
+		for (uint32_t view = 0; view < viewCount; ++view)
+		{
+			const std::vector<uint32_t>& visible = culling.GetVisible(view);
+			size_t cursor = 0;
+			for (uint32_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+			{
+				const InstanceRange& range = m_Ranges[meshIndex];
+				size_t first = cursor;
+				while (cursor < visible.size() && visible[cursor] < range.Offset + range.Count)
+					cursor++;
+
+				InstanceRange& viewRange = m_ViewRanges[size_t(view) * meshCount + meshIndex];
+				uint32_t visibleCount = uint32_t(cursor - first);
+				if (visibleCount == range.Count)
+				{
+					viewRange = range;
+					continue;
+				}
+
+				viewRange.Offset = instanceCount + uint32_t(m_ViewInstances.size());
+				viewRange.Count = visibleCount;
+				m_ViewInstances.insert(m_ViewInstances.end(), visible.begin() + first, visible.begin() + cursor);
+			}
+		}
+
+		m_OrderedRange.Offset = instanceCount + uint32_t(m_ViewInstances.size());
+		m_OrderedRange.Count = uint32_t(m_OrderedInstances.size());
+
+		uint32_t totalCount = m_OrderedRange.Offset + m_OrderedRange.Count;
+		if (totalCount > m_Capacity || m_Capacity == 0)
+			Reserve(totalCount);
+
+		PerObjectData* mapped = m_MappedData[m_FrameIndex];
+		m_UploadedCount = 0;
+		for (uint32_t slot = 0; slot < instanceCount; ++slot)
+		{
+			if (m_FramesDirty[slot] == 0)
+				continue;
+
+			mapped[slot] = m_Instances[slot];
+			m_FramesDirty[slot]--;
+			m_UploadedCount++;
+		}
+
+		// view copies and the ordered instances change with the camera, they are
+		// rewritten every frame
+		PerObjectData* viewMapped = mapped + instanceCount;
+		for (uint32_t slot : m_ViewInstances)
+			*viewMapped++ = m_Instances[slot];
+		for (uint32_t slot : m_OrderedInstances)
+			*viewMapped++ = m_Instances[slot];
+		m_UploadedCount += uint32_t(m_ViewInstances.size() + m_OrderedInstances.size());
+	}
+
+	uint64_t InstanceDataBuffer::GetGPUAddress(const InstanceRange& range) const
+	{
+		return uint64_t(range.Offset) * sizeof(PerObjectData);
+	}
+
+	void InstanceDataBuffer::AllocateFrameBuffers(uint32_t capacity)
+	{
+		m_SystemMemory.resize(m_MappedData.size());
+		for (size_t i = 0; i < m_MappedData.size(); ++i)
+		{
+			m_SystemMemory[i].resize(capacity);
+			m_MappedData[i] = m_SystemMemory[i].data();
+		}
+	}
+
+	void InstanceDataBuffer::Reserve(uint32_t instanceCount)
+	{
+		uint32_t newCapacity = std::max({ instanceCount, m_Capacity * 2, s_MinCapacity });
+		AllocateFrameBuffers(newCapacity);
+
+		m_Capacity = newCapacity;
+		// the new buffers hold nothing yet
+		std::fill(m_FramesDirty.begin(), m_FramesDirty.end(), uint8_t(g_NumFrameResources));
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "DX12/ShaderTypes.h"
+#include "ViewCulling.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Blainn
+{
+	class StaticMeshComponent;
+
+	// Instances of one mesh inside the frame's instance array
+	struct InstanceRange
+	{
+		uint32_t Offset = 0;
+		uint32_t Count = 0;
+	};
+
+	// Builds the transposed world matrix and world bounds of every static mesh instance
+	// once per frame. The matrices live in persistently mapped upload buffers, one per
+	// frame in flight, and passes bind a mesh's range by GPU address instead of copying
+	// the matrices into their own dynamic buffers. A CPU copy of the last written matrices
+	// is kept so only instances that actually moved are written again, each for
+	// g_NumFrameResources frames until every frame buffer has seen the change.
+	//
+	// After culling, every view gets its own range per mesh. A mesh whose instances are
+	// all visible reuses the shared range, otherwise its visible instances are copied
+	// behind the shared ones.
+	//
+	// The frame buffers live in system memory and the GPU addresses are byte offsets
+	// into them, for backends that only run the CPU side. A GPU backend overrides
+	// AllocateFrameBuffers and GetGPUAddress to place them in its own memory.
+	class InstanceDataBuffer
+	{
+	public:
+		InstanceDataBuffer();
+		virtual ~InstanceDataBuffer();
+
+		// Call once per frame before culling. Instances are placed alpha of the way
+		// from their previous to their current simulation step.
+		void Build(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes, float alpha = 1.f);
+		// Slots a pass wants to draw in its own order, written behind the view copies by
+		// the next Upload. Slots may repeat.
+		void SetOrderedInstances(const std::vector<uint32_t>& slots) { m_OrderedInstances = slots; }
+		// Lays out the visible instances of every view and writes the frame buffer,
+		// call after culling and before any pass records draws
+		void Upload(const ViewCulling& culling);
+
+		// Indexed like the meshes handed to Build
+		const InstanceRange& GetRange(uint32_t meshIndex) const { return m_Ranges[meshIndex]; }
+		// Instances of the mesh moved, were added or removed or changed slots in the last Build
+		bool HasMeshChanged(uint32_t meshIndex) const { return m_MeshesChanged[meshIndex] != 0; }
+		const InstanceRange& GetViewRange(uint32_t view, uint32_t meshIndex) const
+		{
+			return m_ViewRanges[view * m_Ranges.size() + meshIndex];
+		}
+		// Where the ordered instances landed, valid after Upload
+		const InstanceRange& GetOrderedRange() const { return m_OrderedRange; }
+		// Where the range starts in the current frame buffer
+		virtual uint64_t GetGPUAddress(const InstanceRange& range) const;
+
+		// One entry per instance slot, unused slots are empty
+		const CullingBounds& GetBounds() const { return m_Bounds; }
+
+		const std::vector<PerObjectData>& GetInstances() const { return m_Instances; }
+		uint32_t GetInstanceCount() const { return uint32_t(m_Instances.size()); }
+		// Instances written to the GPU by the last Upload, view copies included
+		uint32_t GetUploadedCount() const { return m_UploadedCount; }
+
+	protected:
+		// Replaces every frame buffer with one holding capacity instances and points
+		// m_MappedData at them, nothing of the old buffers is kept
+		virtual void AllocateFrameBuffers(uint32_t capacity);
+
+	private:
+		void Reserve(uint32_t instanceCount);
+
+	protected:
+		// Where the CPU writes each frame buffer
+		std::vector<PerObjectData*> m_MappedData;
+		uint32_t m_FrameIndex = 0;
+
+	private:
+		std::vector<std::vector<PerObjectData>> m_SystemMemory;
+		uint32_t m_Capacity = 0;
+
+		std::vector<InstanceRange> m_Ranges;
+		std::vector<uint8_t> m_MeshesChanged;
+		std::vector<InstanceRange> m_PreviousRanges;
+		// m_Ranges.size() entries per view
+		std::vector<InstanceRange> m_ViewRanges;
+		// Slots copied behind the shared instances for partially visible meshes
+		std::vector<uint32_t> m_ViewInstances;
+		std::vector<uint32_t> m_OrderedInstances;
+		InstanceRange m_OrderedRange;
+
+		std::vector<PerObjectData> m_Instances;
+		CullingBounds m_Bounds;
+		// Frame buffers that still hold an outdated copy of the instance
+		std::vector<uint8_t> m_FramesDirty;
+
+		uint32_t m_UploadedCount = 0;
+	};
+}
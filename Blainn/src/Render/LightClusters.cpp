@@ -0,0 +1,297 @@
+#include "pch.h"
+#include "LightClusters.h"
+
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BLAINN_CLUSTERS_SSE
+#endif
+
+namespace Blainn
+{
+	// Lights transformed per job
+	static constexpr uint32_t LightGrainSize = 1024;
+
+	LightClusters::LightClusters()
+	{
+		SetGridSize(m_TilesX, m_TilesY, m_Slices);
+	}
+
+	void LightClusters::SetGridSize(uint32_t tilesX, uint32_t tilesY, uint32_t slices)
+	{
+		assert(tilesX > 0 && tilesX <= MaxTilesX && tilesY > 0 && slices > 0);
+		m_TilesX = tilesX;
+		m_TilesY = tilesY;
+		m_Slices = slices;
+		m_PaddedTilesX = (tilesX + 3) & ~3u;
+		m_bGridDirty = true;
+	}
+
+	uint32_t LightClusters::GetSlice(float viewDepth) const
+	{
+		if (viewDepth <= m_GridNearZ)
+			return 0;
+		float slice = std::log(viewDepth) * m_SliceScale + m_SliceBias;
+		return std::min(uint32_t(std::max(slice, 0.f)), m_Slices - 1);
+	}
+
+	void LightClusters::BuildGrid(const LightClusterView& view)
+	{
+		if (!m_bGridDirty && view.FovY == m_GridFovY && view.AspectRatio == m_GridAspectRatio &&
+			view.NearZ == m_GridNearZ && view.FarZ == m_GridFarZ)
+			return;
+
+		m_GridFovY = view.FovY;
+		m_GridAspectRatio = view.AspectRatio;
+		m_GridNearZ = view.NearZ;
+		m_GridFarZ = view.FarZ;
+		m_bGridDirty = false;
+
+		float logRange = std::log(view.FarZ / view.NearZ);
+		m_SliceScale = float(m_Slices) / logRange;
+		m_SliceBias = -float(m_Slices) * std::log(view.NearZ) / logRange;
+
+		const float tanY = std::tan(0.5f * view.FovY);
+		const float tanX = tanY * view.AspectRatio;
+
+		m_SliceNear.resize(m_Slices);
+		m_SliceFar.resize(m_Slices);
+		m_TileMinX.resize(size_t(m_Slices) * m_PaddedTilesX);
+		m_TileMaxX.resize(size_t(m_Slices) * m_PaddedTilesX);
+		m_TileMinY.resize(size_t(m_Slices) * m_TilesY);
+		m_TileMaxY.resize(size_t(m_Slices) * m_TilesY);
+
+		for (uint32_t slice = 0; slice < m_Slices; ++slice)
+		{
+			float nearDepth = view.NearZ * std::pow(view.FarZ / view.NearZ, float(slice) / m_Slices);
+			float farDepth = view.NearZ * std::pow(view.FarZ / view.NearZ, float(slice + 1) / m_Slices);
+			m_SliceNear[slice] = nearDepth;
+			m_SliceFar[slice] = farDepth;
+
+			// a froxel widens with depth, its box spans both ends of the slice
+			for (uint32_t x = 0; x < m_PaddedTilesX; ++x)
+			{
+				size_t index = size_t(slice) * m_PaddedTilesX + x;
+				if (x >= m_TilesX)
+				{
+					// padding never passes the distance test
+					m_TileMinX[index] = std::numeric_limits<float>::infinity();
+					m_TileMaxX[index] = -std::numeric_limits<float>::infinity();
+					continue;
+				}
+				float left = (-1.f + 2.f * x / m_TilesX) * tanX;
+				float right = (-1.f + 2.f * (x + 1) / m_TilesX) * tanX;
+				m_TileMinX[index] = std::min(left * nearDepth, left * farDepth);
+				m_TileMaxX[index] = std::max(right * nearDepth, right * farDepth);
+			}
+			for (uint32_t y = 0; y < m_TilesY; ++y)
+			{
+				size_t index = size_t(slice) * m_TilesY + y;
+				float top = (1.f - 2.f * y / m_TilesY) * tanY;
+				float bottom = (1.f - 2.f * (y + 1) / m_TilesY) * tanY;
+				m_TileMinY[index] = std::min(bottom * nearDepth, bottom * farDepth);
+				m_TileMaxY[index] = std::max(top * nearDepth, top * farDepth);
+			}
+		}
+	}
+
+	void LightClusters::Assign(const LightClusterView& view, const DirectX::XMFLOAT4* lightSpheres, uint32_t lightCount, JobSystem* jobSystem)
+	{
+		BuildGrid(view);
+
+		m_Stats = {};
+		m_Stats.Lights = lightCount;
+
+		// view space and slice range of every light, lights outside the frustum get
+		// an empty range
+		m_ViewLights.resize(lightCount);
+		m_FirstSlice.resize(lightCount);
+		m_LastSlice.resize(lightCount);
+
+		const float tanY = std::tan(0.5f * view.FovY);
+		const float tanX = tanY * view.AspectRatio;
+		const float invLengthX = 1.f / std::sqrt(1.f + tanX * tanX);
+		const float invLengthY = 1.f / std::sqrt(1.f + tanY * tanY);
+		const DirectX::XMFLOAT4X4& v = view.View;
+
+		auto transformLights = [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const DirectX::XMFLOAT4& sphere = lightSpheres[i];
+					float x = sphere.x * v._11 + sphere.y * v._21 + sphere.z * v._31 + v._41;
+					float y = sphere.x * v._12 + sphere.y * v._22 + sphere.z * v._32 + v._42;
+					float depth = -(sphere.x * v._13 + sphere.y * v._23 + sphere.z * v._33 + v._43);
+					float radius = sphere.w;
+					m_ViewLights[i] = { x, y, depth, radius };
+
+					// side planes go through the eye, |x| <= tanX * depth inside
+					bool bOutside = depth + radius < view.NearZ || depth - radius > view.FarZ ||
+						(std::abs(x) - tanX * depth) * invLengthX > radius ||
+						(std::abs(y) - tanY * depth) * invLengthY > radius;
+					if (bOutside)
+					{
+						m_FirstSlice[i] = 1;
+						m_LastSlice[i] = 0;
+						continue;
+					}
+					m_FirstSlice[i] = GetSlice(std::max(depth - radius, view.NearZ));
+					m_LastSlice[i] = GetSlice(std::min(depth + radius, view.FarZ));
+				}
+			};
+		if (jobSystem)
+			jobSystem->ParallelFor(0, lightCount, LightGrainSize, transformLights);
+		else
+			transformLights(0, lightCount);
+
+		// compact in place, visible lights keep their order
+		m_VisibleLights.clear();
+		for (uint32_t i = 0; i < lightCount; ++i)
+		{
+			if (m_FirstSlice[i] > m_LastSlice[i])
+				continue;
+			uint32_t visible = uint32_t(m_VisibleLights.size());
+			m_ViewLights[visible] = m_ViewLights[i];
+			m_FirstSlice[visible] = m_FirstSlice[i];
+			m_LastSlice[visible] = m_LastSlice[i];
+			m_VisibleLights.push_back(i);
+		}
+		uint32_t visibleCount = uint32_t(m_VisibleLights.size());
+		m_Stats.VisibleLights = visibleCount;
+
+		// bin the visible lights by every slice they reach
+		m_SliceLightOffsets.assign(m_Slices + 1, 0);
+		for (uint32_t i = 0; i < visibleCount; ++i)
+			for (uint32_t slice = m_FirstSlice[i]; slice <= m_LastSlice[i]; ++slice)
+				m_SliceLightOffsets[slice + 1]++;
+		for (uint32_t slice = 0; slice < m_Slices; ++slice)
+			m_SliceLightOffsets[slice + 1] += m_SliceLightOffsets[slice];
+
+		m_SliceLights.resize(m_SliceLightOffsets[m_Slices]);
+		std::vector<uint32_t> cursors(m_SliceLightOffsets.begin(), m_SliceLightOffsets.end() - 1);
+		for (uint32_t i = 0; i < visibleCount; ++i)
+			for (uint32_t slice = m_FirstSlice[i]; slice <= m_LastSlice[i]; ++slice)
+				m_SliceLights[cursors[slice]++] = i;
+
+		// every slice owns its clusters, so neither pass needs any synchronization
+		m_SliceAssignments.resize(m_Slices);
+		if (jobSystem)
+			jobSystem->ParallelFor(0, m_Slices, 1, [this](uint32_t begin, uint32_t end) { for (uint32_t s = begin; s < end; ++s) AssignSlice(s); });
+		else
+			for (uint32_t slice = 0; slice < m_Slices; ++slice)
+				AssignSlice(slice);
+
+		m_SliceIndexOffsets.resize(m_Slices + 1);
+		m_SliceIndexOffsets[0] = 0;
+		for (uint32_t slice = 0; slice < m_Slices; ++slice)
+			m_SliceIndexOffsets[slice + 1] = m_SliceIndexOffsets[slice] + uint32_t(m_SliceAssignments[slice].size());
+
+		m_Clusters.resize(GetClusterCount());
+		m_LightIndices.resize(m_SliceIndexOffsets[m_Slices]);
+		if (jobSystem)
+			jobSystem->ParallelFor(0, m_Slices, 1, [this](uint32_t begin, uint32_t end) { for (uint32_t s = begin; s < end; ++s) WriteSlice(s); });
+		else
+			for (uint32_t slice = 0; slice < m_Slices; ++slice)
+				WriteSlice(slice);
+
+		m_Stats.Assignments = uint32_t(m_LightIndices.size());
+		for (const ClusterRange& cluster : m_Clusters)
+		{
+			m_Stats.OccupiedClusters += cluster.Count > 0 ? 1 : 0;
+			m_Stats.MaxLightsPerCluster = std::max(m_Stats.MaxLightsPerCluster, cluster.Count);
+		}
+	}
+
+	void LightClusters::AssignSlice(uint32_t slice)
+	{
+		std::vector<ClusterLight>& assignments = m_SliceAssignments[slice];
+		assignments.clear();
+
+		const float nearDepth = m_SliceNear[slice];
+		const float farDepth = m_SliceFar[slice];
+		const float* minX = m_TileMinX.data() + size_t(slice) * m_PaddedTilesX;
+		const float* maxX = m_TileMaxX.data() + size_t(slice) * m_PaddedTilesX;
+		const float* minY = m_TileMinY.data() + size_t(slice) * m_TilesY;
+		const float* maxY = m_TileMaxY.data() + size_t(slice) * m_TilesY;
+
+		for (uint32_t entry = m_SliceLightOffsets[slice]; entry < m_SliceLightOffsets[slice + 1]; ++entry)
+		{
+			uint32_t light = m_SliceLights[entry];
+			const DirectX::XMFLOAT4& sphere = m_ViewLights[light];
+
+			// squared distance from the center to a froxel box adds up per axis, the
+			// depth part is the same for the whole slice
+			float dz = std::max({ nearDepth - sphere.z, 0.f, sphere.z - farDepth });
+			float remaining = sphere.w * sphere.w - dz * dz;
+			if (remaining < 0.f)
+				continue;
+
+			// the column distances are the same for every row of the slice
+			alignas(16) float columnDistances[MaxTilesX];
+			for (uint32_t x = 0; x < m_PaddedTilesX; ++x)
+			{
+				float dx = std::max({ minX[x] - sphere.x, 0.f, sphere.x - maxX[x] });
+				columnDistances[x] = dx * dx;
+			}
+			// an infinite radius would let the padding through as well
+			const uint64_t validColumns = m_TilesX < 64 ? (uint64_t(1) << m_TilesX) - 1 : ~uint64_t(0);
+
+			for (uint32_t y = 0; y < m_TilesY; ++y)
+			{
+				float dy = std::max({ minY[y] - sphere.y, 0.f, sphere.y - maxY[y] });
+				float rowRemaining = remaining - dy * dy;
+				if (rowRemaining < 0.f)
+					continue;
+
+				uint64_t columns = 0;
+#if defined(BLAINN_CLUSTERS_SSE)
+				const __m128 rowRemainingX = _mm_set1_ps(rowRemaining);
+				for (uint32_t x = 0; x < m_PaddedTilesX; x += 4)
+					columns |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(_mm_load_ps(columnDistances + x), rowRemainingX))) << x;
+#else
+				for (uint32_t x = 0; x < m_TilesX; ++x)
+					columns |= uint64_t(columnDistances[x] <= rowRemaining) << x;
+#endif
+				columns &= validColumns;
+
+				uint32_t rowCluster = y * m_TilesX;
+				for (; columns != 0; columns &= columns - 1)
+					assignments.push_back({ rowCluster + uint32_t(std::countr_zero(columns)), light });
+			}
+		}
+	}
+
+	void LightClusters::WriteSlice(uint32_t slice)
+	{
+		// counting sort by cluster, stable so lights stay ascending per cluster
+		const uint32_t clustersPerSlice = m_TilesX * m_TilesY;
+		ClusterRange* clusters = m_Clusters.data() + size_t(slice) * clustersPerSlice;
+		for (uint32_t i = 0; i < clustersPerSlice; ++i)
+			clusters[i] = { 0, 0 };
+
+		const std::vector<ClusterLight>& assignments = m_SliceAssignments[slice];
+		for (const ClusterLight& assignment : assignments)
+			clusters[assignment.Cluster].Count++;
+
+		uint32_t offset = m_SliceIndexOffsets[slice];
+		for (uint32_t i = 0; i < clustersPerSlice; ++i)
+		{
+			clusters[i].Offset = offset;
+			offset += clusters[i].Count;
+			clusters[i].Count = 0;
+		}
+
+		for (const ClusterLight& assignment : assignments)
+		{
+			ClusterRange& cluster = clusters[assignment.Cluster];
+			m_LightIndices[cluster.Offset + cluster.Count++] = assignment.Light;
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	class JobSystem;
+
+	// What the cluster grid is built from
+	struct LightClusterView
+	{
+		// Right handed view matrix for row vectors, looking down -Z like SimpleMath's
+		// CreateLookAt
+		DirectX::XMFLOAT4X4 View;
+		// Vertical field of view in radians
+		float FovY = DirectX::XM_PIDIV4;
+		float AspectRatio = 16.f / 9.f;
+		float NearZ = 0.1f;
+		float FarZ = 1000.f;
+	};
+
+	struct ClusterRange
+	{
+		// Into GetLightIndices
+		uint32_t Offset = 0;
+		uint32_t Count = 0;
+	};
+
+	struct LightClusterStats
+	{
+		uint32_t Lights = 0;
+		// Lights whose sphere touches the view frustum
+		uint32_t VisibleLights = 0;
+		// Light indices over all clusters
+		uint32_t Assignments = 0;
+		uint32_t OccupiedClusters = 0;
+		uint32_t MaxLightsPerCluster = 0;
+	};
+
+	// Splits the view frustum into a froxel grid, screen tiles times depth slices that
+	// grow exponentially from the near to the far plane, and assigns every light's
+	// bounding sphere to the froxels it touches. Slices are assigned in parallel, one
+	// light against a whole row of tiles at a time with SIMD, and the result is a
+	// compact light index list with an offset and count per cluster.
+	//
+	// Only plain bounding spheres go in, so point lights and the bounds of spot lights
+	// can share the grid. Lights outside the frustum are left out of the visible list
+	// the cluster indices point into.
+	class LightClusters
+	{
+	public:
+		static constexpr uint32_t MaxTilesX = 64;
+
+		LightClusters();
+
+		// Cluster (0, 0, 0) is the top left tile of the slice at the near plane
+		void SetGridSize(uint32_t tilesX, uint32_t tilesY, uint32_t slices);
+		uint32_t GetTilesX() const { return m_TilesX; }
+		uint32_t GetTilesY() const { return m_TilesY; }
+		uint32_t GetSlices() const { return m_Slices; }
+		uint32_t GetClusterCount() const { return m_TilesX * m_TilesY * m_Slices; }
+		uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t slice) const { return (slice * m_TilesY + y) * m_TilesX + x; }
+
+		// lightSpheres holds world space centers in xyz and radii in w.
+		// jobSystem may be null.
+		void Assign(const LightClusterView& view, const DirectX::XMFLOAT4* lightSpheres, uint32_t lightCount, JobSystem* jobSystem);
+
+		const std::vector<ClusterRange>& GetClusters() const { return m_Clusters; }
+		// Indices into GetVisibleLights, ascending within every cluster
+		const std::vector<uint32_t>& GetLightIndices() const { return m_LightIndices; }
+		// Indices of the lights handed to Assign that touch the frustum, ascending
+		const std::vector<uint32_t>& GetVisibleLights() const { return m_VisibleLights; }
+
+		// slice = floor(log(viewDepth) * scale + bias), for looking clusters up in a shader
+		float GetSliceScale() const { return m_SliceScale; }
+		float GetSliceBias() const { return m_SliceBias; }
+		uint32_t GetSlice(float viewDepth) const;
+
+		const LightClusterStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct ClusterLight
+		{
+			uint32_t Cluster;
+			uint32_t Light;
+		};
+
+		void BuildGrid(const LightClusterView& view);
+		void AssignSlice(uint32_t slice);
+		void WriteSlice(uint32_t slice);
+
+	private:
+		uint32_t m_TilesX = 16;
+		uint32_t m_TilesY = 9;
+		uint32_t m_Slices = 24;
+		// m_TilesX rounded up for the SIMD rows
+		uint32_t m_PaddedTilesX = 16;
+
+		// Grid the bounds below were built for
+		float m_GridFovY = 0.f;
+		float m_GridAspectRatio = 0.f;
+		float m_GridNearZ = 0.f;
+		float m_GridFarZ = 0.f;
+		bool m_bGridDirty = true;
+
+		float m_SliceScale = 0.f;
+		float m_SliceBias = 0.f;
+
+		// View space bounds of every froxel, x per tile column and y per tile row
+		// of every slice, depth per slice
+		std::vector<float> m_TileMinX;
+		std::vector<float> m_TileMaxX;
+		std::vector<float> m_TileMinY;
+		std::vector<float> m_TileMaxY;
+		std::vector<float> m_SliceNear;
+		std::vector<float> m_SliceFar;
+
+		// Visible lights in view space, x, y, depth and radius
+		std::vector<DirectX::XMFLOAT4> m_ViewLights;
+		std::vector<uint32_t> m_FirstSlice;
+		std::vector<uint32_t> m_LastSlice;
+		std::vector<uint32_t> m_VisibleLights;
+
+		// Visible lights per slice, m_SliceLightOffsets[s]..m_SliceLightOffsets[s + 1]
+		std::vector<uint32_t> m_SliceLightOffsets;
+		std::vector<uint32_t> m_SliceLights;
+
+		std::vector<std::vector<ClusterLight>> m_SliceAssignments;
+		std::vector<uint32_t> m_SliceIndexOffsets;
+
+		std::vector<ClusterRange> m_Clusters;
+		std::vector<uint32_t> m_LightIndices;
+
+		LightClusterStats m_Stats;
+	};
+}
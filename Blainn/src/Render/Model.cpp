@@ -0,0 +1,43 @@
+#include "pch.h"
+#include "Model.h"
+
+#include <unordered_map>
+
+namespace Blainn
+{
+	// Models are loaded on the main thread
+	static uint32_t s_NextMeshId = 0;
+	static uint32_t s_NextMaterialId = 0;
+	static std::unordered_map<const void*, uint32_t> s_MaterialIds;
+
+	Model::Model(const std::filesystem::path& modelFilePath)
+		: m_ModelFilepath(modelFilePath)
+	{
+	}
+
+	std::shared_ptr<Model> Model::CreatePlaceholder(const std::filesystem::path& modelFilePath)
+	{
+		auto model = std::make_shared<Model>(modelFilePath);
+		model->m_Bounds = DirectX::BoundingBox({ 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f });
+		model->AddSubmesh(nullptr, false);
+		return model;
+	}
+
+	Submesh& Model::AddSubmesh(const void* material, bool bTransparent)
+	{
+		Submesh& submesh = m_Submeshes.emplace_back();
+		submesh.MeshId = s_NextMeshId++;
+		AssignMaterial(submesh, material, bTransparent);
+		return submesh;
+	}
+
+	void Model::AssignMaterial(Submesh& submesh, const void* material, bool bTransparent)
+	{
+		// meshes of a model often share materials
+		auto [it, bInserted] = s_MaterialIds.try_emplace(material, s_NextMaterialId);
+		if (bInserted)
+			s_NextMaterialId++;
+		submesh.MaterialId = it->second;
+		submesh.bTransparent = bTransparent;
+	}
+}
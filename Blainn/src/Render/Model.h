@@ -0,0 +1,53 @@
+#pragma once
+
+#include <DirectXCollision.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace Blainn
+{
+	// One mesh of a model with the ids the render queue sorts by. Ids are unique
+	// across all loaded models.
+	struct Submesh
+	{
+		uint32_t MeshId = 0;
+		uint32_t MaterialId = 0;
+		// Drawn in the transparent bucket and never into the shadow maps
+		bool bTransparent = false;
+	};
+
+	// What the engine core knows of a loaded model, its bounds and its submeshes.
+	// Models come from RenderingBackend::LoadModel, a backend that draws them loads
+	// a model type of its own and keeps its GPU data for every submesh, indexed like
+	// GetSubmeshes.
+	class Model
+	{
+	public:
+		explicit Model(const std::filesystem::path& modelFilePath);
+		virtual ~Model() = default;
+
+		// A unit box with one opaque submesh standing in for the file, for backends
+		// that load nothing
+		static std::shared_ptr<Model> CreatePlaceholder(const std::filesystem::path& modelFilePath);
+
+		const std::filesystem::path& GetPath() const { return m_ModelFilepath; }
+		// Local space bounds of every mesh in the model
+		const DirectX::BoundingBox& GetBounds() const { return m_Bounds; }
+		// Every mesh of the model, node transforms are ignored
+		const std::vector<Submesh>& GetSubmeshes() const { return m_Submeshes; }
+
+	protected:
+		// Takes a new mesh id. Submeshes passing the same material share a material id,
+		// material is only compared, never dereferenced.
+		Submesh& AddSubmesh(const void* material, bool bTransparent);
+		void AssignMaterial(Submesh& submesh, const void* material, bool bTransparent);
+
+	protected:
+		std::filesystem::path m_ModelFilepath;
+		DirectX::BoundingBox m_Bounds;
+		std::vector<Submesh> m_Submeshes;
+	};
+}
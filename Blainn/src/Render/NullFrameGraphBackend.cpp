@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "NullFrameGraphBackend.h"
+
+namespace Blainn
+{
+	void NullFrameGraphBackend::BeginFrame(const FrameGraph& graph)
+	{
+		m_Commands.clear();
+		m_Stats.Frames++;
+
+		if (graph.GetHeapSize() > m_HeapSize)
+		{
+			m_HeapSize = graph.GetHeapSize();
+			m_Stats.HeapBytes = m_HeapSize;
+			m_Stats.HeapResizes++;
+		}
+
+		for (const FrameGraphPlacement& placement : graph.GetPlacements())
+		{
+			m_Commands.push_back({ NullGraphCommand::PlaceResource, placement.Resource, placement.Offset });
+			m_Stats.PlacedResources++;
+		}
+
+		m_States.resize(graph.GetResourceCount());
+		for (FrameGraphResource i = 0; i < graph.GetResourceCount(); ++i)
+			m_States[i] = graph.GetInitialState(i);
+	}
+
+	void NullFrameGraphBackend::SubmitBarriers(const FrameGraph& graph, const std::vector<FrameGraphBarrier>& barriers)
+	{
+		m_Stats.BarrierBatches++;
+
+		for (const FrameGraphBarrier& barrier : barriers)
+		{
+			if (barrier.BarrierType == FrameGraphBarrier::Aliasing)
+			{
+				m_Commands.push_back({ NullGraphCommand::Aliasing, barrier.Resource, barrier.AliasedFrom });
+				m_Stats.AliasingBarriers++;
+				// the memory's previous contents are gone
+				m_States[barrier.Resource] = RS_Undefined;
+				continue;
+			}
+
+			if (m_States[barrier.Resource] != barrier.Before)
+				m_Stats.StateMismatches++;
+			m_States[barrier.Resource] = barrier.After;
+
+			m_Commands.push_back({ NullGraphCommand::Transition, barrier.Resource, barrier.After });
+			m_Stats.Transitions++;
+		}
+	}
+
+	void NullFrameGraphBackend::BeginPass(const FrameGraph& graph, uint32_t pass)
+	{
+		m_Commands.push_back({ NullGraphCommand::BeginPass, pass, 0 });
+		m_Stats.Passes++;
+	}
+
+	void NullFrameGraphBackend::EndPass(const FrameGraph& graph, uint32_t pass)
+	{
+		m_Commands.push_back({ NullGraphCommand::EndPass, pass, 0 });
+	}
+
+	void NullFrameGraphBackend::EndFrame(const FrameGraph& graph)
+	{
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FrameGraph.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	struct NullGraphCommand
+	{
+		enum Type : uint32_t
+		{
+			PlaceResource,
+			Transition,
+			Aliasing,
+			BeginPass,
+			EndPass,
+		};
+
+		Type CommandType;
+		// Resource or pass
+		uint32_t Target;
+		// Heap offset, the state after a transition or the resource aliased from
+		uint64_t Value;
+	};
+
+	struct NullGraphStats
+	{
+		uint32_t Frames = 0;
+		uint32_t Passes = 0;
+		uint32_t Transitions = 0;
+		uint32_t AliasingBarriers = 0;
+		// Barrier batches, a real backend makes one ResourceBarrier call per batch
+		uint32_t BarrierBatches = 0;
+		uint32_t PlacedResources = 0;
+		// The heap is kept between frames and only grows
+		uint64_t HeapBytes = 0;
+		uint32_t HeapResizes = 0;
+		// Transitions whose before state was not the state the resource was in
+		uint32_t StateMismatches = 0;
+	};
+
+	// Frame graph backend without a GPU. Records what a real backend would be asked
+	// to do into a command stream, keeps a transient heap the way a D3D12 backend
+	// would and checks every transition against the state it tracked the resource in.
+	class NullFrameGraphBackend : public FrameGraphBackend
+	{
+	public:
+		void BeginFrame(const FrameGraph& graph) override;
+		void SubmitBarriers(const FrameGraph& graph, const std::vector<FrameGraphBarrier>& barriers) override;
+		void BeginPass(const FrameGraph& graph, uint32_t pass) override;
+		void EndPass(const FrameGraph& graph, uint32_t pass) override;
+		void EndFrame(const FrameGraph& graph) override;
+
+		// Commands of the last frame
+		const std::vector<NullGraphCommand>& GetCommands() const { return m_Commands; }
+		// Counters over all frames since the last ResetStats
+		const NullGraphStats& GetStats() const { return m_Stats; }
+		void ResetStats() { m_Stats = {}; }
+
+	private:
+		std::vector<NullGraphCommand> m_Commands;
+		std::vector<uint32_t> m_States;
+		uint64_t m_HeapSize = 0;
+
+		NullGraphStats m_Stats;
+	};
+}
@@ -0,0 +1,300 @@
+#include "pch.h"
+#include "NullRenderingBackend.h"
+
+#include "Components/ActorComponents/DirectionalLightComponent.h"
+#include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ComponentManager.h"
+#include "Core/Application.h"
+#include "FrameGraph.h"
+#include "InstanceDataBuffer.h"
+#include "Model.h"
+#include "PointLightBatch.h"
+#include "RenderQueue.h"
+#include "ShadowCascadeCache.h"
+#include "ShadowCascades.h"
+
+#include <stdexcept>
+
+namespace Blainn
+{
+	// Stand-ins for the meshes the D3D12 backend draws itself
+	static constexpr uint32_t FullScreenQuadMesh = ~0u;
+	static constexpr uint32_t LightVolumeMesh = ~0u - 1;
+	static constexpr uint32_t DebugQuadMesh = ~0u - 2;
+
+	static void RecordTo(std::vector<NullRenderCommand>& commands, NullRenderCommand::Type type, uint32_t arg0 = 0, uint32_t arg1 = 0)
+	{
+		commands.push_back({ type, arg0, arg1 });
+	}
+
+	void NullRenderingBackend::Init(std::shared_ptr<Window> wnd)
+	{
+		// nothing is presented, the size comes from Resize
+		m_bIsInitialized = true;
+	}
+
+	void NullRenderingBackend::CreateResources()
+	{
+		CreateFrameData(std::make_shared<ShadowCascades>(DirectX::XMUINT2{ m_ShadowMapSize, m_ShadowMapSize }),
+			std::make_shared<InstanceDataBuffer>());
+	}
+
+	void NullRenderingBackend::UpdateMainPassConstantBuffers(const GameTimer& gt, const Camera& camera)
+	{
+		PrepareView(camera);
+	}
+
+	void NullRenderingBackend::Draw()
+	{
+		const auto& meshes = GetSceneComponents().GetComponents<StaticMeshComponent>();
+
+		PrepareInstances(meshes, Application::Get().GetInterpolationAlpha());
+
+		m_Commands.clear();
+		Record(NullRenderCommand::Upload, uint32_t(m_Stats.UploadBytes));
+
+		BuildFrameGraph(meshes);
+		m_FrameGraph->Execute(&m_GraphBackend);
+	}
+
+	void NullRenderingBackend::Resize(int newWidth, int newHeight)
+	{
+		m_Width = uint32_t(std::max(newWidth, 1));
+		m_Height = uint32_t(std::max(newHeight, 1));
+	}
+
+	void NullRenderingBackend::BuildFrameGraph(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
+	{
+		FrameGraph& graph = *m_FrameGraph;
+		graph.Reset();
+
+		const FrameGraphTextureDesc shadowDesc = { m_ShadowMapSize, m_ShadowMapSize, 1, FrameGraphFormat::D32 };
+		const FrameGraphTextureDesc colorDesc = { m_Width, m_Height, 1, FrameGraphFormat::RGBA8 };
+		const FrameGraphTextureDesc packedDesc = { m_Width, m_Height, 1, FrameGraphFormat::RGB10A2 };
+		const FrameGraphTextureDesc depthDesc = { m_Width, m_Height, 1, FrameGraphFormat::D32 };
+
+		FrameGraphResource gBuffer[] = {
+			graph.CreateTexture("AlbedoOpacity", colorDesc),
+			graph.CreateTexture("NormalSpec", packedDesc),
+			graph.CreateTexture("Reflectance", colorDesc),
+			graph.CreateTexture("EmissiveAmbient", packedDesc),
+		};
+		FrameGraphResource gBufferDepth = graph.CreateTexture("GBufferDepth", depthDesc);
+		FrameGraphResource color = graph.CreateTexture("Color", colorDesc);
+		FrameGraphResource backBuffer = graph.ImportTexture("BackBuffer", colorDesc, RS_Present, RS_Present);
+
+		FrameGraphResource cascades[CASCADE_COUNT];
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+			cascades[i] = graph.CreateTexture("Cascade", shadowDesc);
+
+		uint32_t shadows = graph.AddPass("CascadeShadowMaps", [this, &meshes]() { CascadeShadowMapsPass(meshes); });
+		for (FrameGraphResource cascade : cascades)
+			graph.Write(shadows, cascade, RS_DepthWrite);
+		if (m_ShadowCache->IsActive())
+		{
+			for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+			{
+				FrameGraphResource cache = graph.ImportTexture("StaticCascade", shadowDesc, RS_CopySource, RS_CopySource);
+				if (m_ShadowCache->IsRenderingStatic(i))
+					graph.Write(shadows, cache, RS_DepthWrite);
+				else
+					graph.Read(shadows, cache, RS_CopySource);
+			}
+		}
+
+		uint32_t geometry = graph.AddPass("Geometry", [this]() { GeometryPass(); });
+		for (FrameGraphResource texture : gBuffer)
+			graph.Write(geometry, texture, RS_RenderTarget);
+		graph.Write(geometry, gBufferDepth, RS_DepthWrite);
+
+		uint32_t directionalLights = graph.AddPass("DirectionalLights", [this]() { DirectionalLightsPass(); });
+		for (FrameGraphResource texture : gBuffer)
+			graph.Read(directionalLights, texture, RS_ShaderRead);
+		graph.Read(directionalLights, gBufferDepth, RS_ShaderRead);
+		for (FrameGraphResource cascade : cascades)
+			graph.Read(directionalLights, cascade, RS_ShaderRead);
+		graph.Write(directionalLights, color, RS_RenderTarget);
+
+		uint32_t pointLights = graph.AddPass("PointLights", [this]() { PointLightsPass(); });
+		for (FrameGraphResource texture : gBuffer)
+			graph.Read(pointLights, texture, RS_ShaderRead);
+		graph.Read(pointLights, gBufferDepth, RS_ShaderRead);
+		graph.Write(pointLights, color, RS_RenderTarget);
+
+		uint32_t debugBuffers = graph.AddPass("DebugBuffers", [this]() { DebugBuffersPass(); });
+		graph.Read(debugBuffers, gBuffer[0], RS_ShaderRead);
+		graph.Read(debugBuffers, gBuffer[1], RS_ShaderRead);
+		graph.Read(debugBuffers, gBufferDepth, RS_ShaderRead);
+		graph.Write(debugBuffers, color, RS_RenderTarget);
+
+		uint32_t present = graph.AddPass("Present", [this]() { PresentPass(); });
+		graph.Read(present, color, RS_CopySource);
+		graph.Write(present, backBuffer, RS_CopyDest);
+
+		// the passes are the same every frame, a cycle is a bug in the graph above
+		if (!graph.Compile())
+			throw std::runtime_error("The frame graph's passes depend on each other in a cycle");
+	}
+
+	void NullRenderingBackend::CascadeShadowMapsPass(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
+	{
+		BeginLists(CASCADE_COUNT);
+
+		const bool bCached = m_ShadowCache->IsActive();
+		RenderingStats cascadeStats[CASCADE_COUNT];
+		RecordLists(CASCADE_COUNT, [&](uint32_t i)
+		{
+			std::vector<NullRenderCommand>& commands = m_ListCommands[i];
+			auto drawCasters = [&](bool bStatic)
+			{
+				for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+				{
+					if (bCached && meshes[meshIndex]->IsStatic() != bStatic)
+						continue;
+
+					const InstanceRange& range = m_InstanceData->GetViewRange(FirstCascadeView + i, meshIndex);
+					if (range.Count == 0)
+						continue;
+
+					RecordTo(commands, NullRenderCommand::SetInstances, range.Offset, range.Count);
+					for (const Submesh& submesh : meshes[meshIndex]->GetModel()->GetSubmeshes())
+					{
+						// transparent submeshes cast no shadows, like in the D3D12 backend
+						if (submesh.bTransparent)
+							continue;
+
+						RecordTo(commands, NullRenderCommand::Draw, submesh.MeshId, range.Count);
+						cascadeStats[i].DrawCalls++;
+						cascadeStats[i].Instances += range.Count;
+					}
+				}
+			};
+
+			if (bCached)
+			{
+				if (m_ShadowCache->IsRenderingStatic(i))
+					drawCasters(true);
+				RecordTo(commands, NullRenderCommand::CopyShadowCache, i);
+			}
+			drawCasters(false);
+			cascadeStats[i].CommandLists++;
+		});
+
+		SubmitLists();
+		for (const RenderingStats& stats : cascadeStats)
+			m_Stats.Add(stats);
+	}
+
+	void NullRenderingBackend::GeometryPass()
+	{
+		std::vector<RecordingChunk> chunks;
+		SplitGeometryBatches(chunks);
+		BeginLists(uint32_t(chunks.size()));
+
+		const InstanceRange& ordered = m_InstanceData->GetOrderedRange();
+		const std::vector<RenderBatch>& batches = m_GeometryQueue->GetBatches();
+
+		std::vector<RenderingStats> chunkStats(chunks.size());
+		RecordLists(uint32_t(chunks.size()), [&](uint32_t chunkIndex)
+		{
+			std::vector<NullRenderCommand>& commands = m_ListCommands[chunkIndex];
+			const RecordingChunk& chunk = chunks[chunkIndex];
+
+			// every list binds its first material itself
+			uint32_t boundMaterial = ~0u;
+			for (uint32_t i = chunk.FirstBatch; i < chunk.FirstBatch + chunk.BatchCount; ++i)
+			{
+				const RenderBatch& batch = batches[i];
+				uint32_t material = DrawKey::GetMaterial(batch.Key);
+				if (material != boundMaterial)
+				{
+					RecordTo(commands, NullRenderCommand::SetMaterial, material);
+					boundMaterial = material;
+				}
+
+				RecordTo(commands, NullRenderCommand::SetInstances, ordered.Offset + batch.First, batch.Count);
+				RecordTo(commands, NullRenderCommand::Draw, DrawKey::GetMesh(batch.Key), batch.Count);
+				chunkStats[chunkIndex].DrawCalls++;
+				chunkStats[chunkIndex].Instances += batch.Count;
+			}
+			chunkStats[chunkIndex].CommandLists++;
+		});
+
+		SubmitLists();
+		for (const RenderingStats& stats : chunkStats)
+			m_Stats.Add(stats);
+	}
+
+	void NullRenderingBackend::DirectionalLightsPass()
+	{
+		for (auto& dl : GetSceneComponents().GetComponents<DirectionalLightComponent>())
+		{
+			if (!dl->GetOwnerPtr())
+				continue;
+
+			Record(NullRenderCommand::Draw, FullScreenQuadMesh, 1);
+			m_Stats.DrawCalls++;
+			m_Stats.Instances++;
+		}
+		m_Stats.CommandLists++;
+	}
+
+	void NullRenderingBackend::PointLightsPass()
+	{
+		m_PointLightDrawCalls = 0;
+		const auto& instances = m_PointLightBatch->GetInstances();
+		if (m_bBatchPointLights)
+		{
+			if (!instances.empty())
+			{
+				uint32_t bytes = uint32_t(instances.size() * sizeof(PointLightInstance));
+				Record(NullRenderCommand::Upload, bytes);
+				Record(NullRenderCommand::Draw, LightVolumeMesh, uint32_t(instances.size()));
+				m_PointLightDrawCalls++;
+				m_Stats.UploadBytes += bytes;
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < instances.size(); ++i)
+			{
+				Record(NullRenderCommand::Draw, LightVolumeMesh, 1);
+				m_PointLightDrawCalls++;
+			}
+		}
+
+		m_Stats.DrawCalls += m_PointLightDrawCalls;
+		m_Stats.Instances += uint32_t(instances.size());
+		m_Stats.CommandLists++;
+	}
+
+	void NullRenderingBackend::DebugBuffersPass()
+	{
+		for (uint32_t i = 0; i < 3; ++i)
+			Record(NullRenderCommand::Draw, DebugQuadMesh, 1);
+		m_Stats.DrawCalls += 3;
+		m_Stats.Instances += 3;
+		m_Stats.CommandLists++;
+	}
+
+	void NullRenderingBackend::PresentPass()
+	{
+		m_Stats.CommandLists++;
+	}
+
+	void NullRenderingBackend::BeginLists(uint32_t count)
+	{
+		// streams keep their capacity from frame to frame
+		if (m_ListCommands.size() < count)
+			m_ListCommands.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+			m_ListCommands[i].clear();
+		m_ListCount = count;
+	}
+
+	void NullRenderingBackend::SubmitLists()
+	{
+		for (uint32_t i = 0; i < m_ListCount; ++i)
+			m_Commands.insert(m_Commands.end(), m_ListCommands[i].begin(), m_ListCommands[i].end());
+	}
+}
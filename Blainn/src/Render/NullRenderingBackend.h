@@ -0,0 +1,94 @@
+#pragma once
+
+#include "NullFrameGraphBackend.h"
+#include "RenderingBackend.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Blainn
+{
+	// What a pass recorded, in place of a GPU command list. Pass boundaries are in the
+	// frame graph backend's stream.
+	struct NullRenderCommand
+	{
+		enum Type : uint32_t
+		{
+			// Arg0 is the material id
+			SetMaterial,
+			// Arg0 and Arg1 are the offset and count in the instance buffer
+			SetInstances,
+			// Arg0 is the mesh id, Arg1 the instance count
+			Draw,
+			// Arg0 is the byte count
+			Upload,
+			// Arg0 is the cascade its cached static casters are copied into, draws
+			// before it in the same list went into the cache
+			CopyShadowCache,
+		};
+
+		Type CommandType;
+		uint32_t Arg0;
+		uint32_t Arg1;
+	};
+
+	// Backend without a GPU. Everything a frame does on the CPU runs like it does for
+	// D3D12, building and culling the instances, the geometry queue, the light clusters
+	// and batches and the frame graph, and the passes record into a command stream
+	// instead of command lists. The targets D3D12 allocates up front are frame graph
+	// transients here, so the graph stats show what aliasing them would save.
+	//
+	// The cascades and the geometry chunks are recorded in parallel into one stream
+	// per list and appended in submission order, so the draws come out in the same
+	// order whether the frame was recorded in parallel or not, only every chunk binds
+	// its first material again.
+	//
+	// The static shadow caches persist from frame to frame, so they are imported into
+	// the frame graph while the cascades themselves stay transient.
+	class NullRenderingBackend : public RenderingBackend
+	{
+	public:
+		void Init(std::shared_ptr<Window> wnd) override;
+		void CreateResources() override;
+
+		void UpdateMainPassConstantBuffers(const GameTimer& gt, const Camera& camera) override;
+
+		void Draw() override;
+		void Resize(int newWidth, int newHeight) override;
+
+		// Commands of the last frame
+		const std::vector<NullRenderCommand>& GetCommands() const { return m_Commands; }
+		// Barriers and transient heap of the frame graph, counted over all frames
+		const NullFrameGraphBackend& GetGraphBackend() const { return m_GraphBackend; }
+
+	private:
+		void BuildFrameGraph(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+
+		void CascadeShadowMapsPass(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void GeometryPass();
+		void DirectionalLightsPass();
+		void PointLightsPass();
+		void DebugBuffersPass();
+		void PresentPass();
+
+		void Record(NullRenderCommand::Type type, uint32_t arg0 = 0, uint32_t arg1 = 0)
+		{
+			m_Commands.push_back({ type, arg0, arg1 });
+		}
+		// Takes count lists, each recorded into its own stream
+		void BeginLists(uint32_t count);
+		// Appends the lists' streams in order, like submitting them together
+		void SubmitLists();
+
+	private:
+		NullFrameGraphBackend m_GraphBackend;
+		std::vector<NullRenderCommand> m_Commands;
+		std::vector<std::vector<NullRenderCommand>> m_ListCommands;
+		uint32_t m_ListCount = 0;
+
+		uint32_t m_Width = 1;
+		uint32_t m_Height = 1;
+		uint32_t m_ShadowMapSize = 4096;
+	};
+}
@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "PointLightBatch.h"
+
+#include "ViewCulling.h"
+
+namespace Blainn
+{
+	static_assert(sizeof(PointLightInstance) == 144, "PointLightInstance must match the shaders' layout");
+
+	void PointLightBatch::Build(const PointLight* lights, uint32_t lightCount, const CullingFrustum* frustum)
+	{
+		m_Stats = {};
+		m_Stats.Lights = lightCount;
+
+		m_Instances.clear();
+		m_Instances.reserve(lightCount);
+		for (uint32_t i = 0; i < lightCount; ++i)
+		{
+			const PointLight& light = lights[i];
+			const DirectX::XMFLOAT3 center = { light.PositionWS.x, light.PositionWS.y, light.PositionWS.z };
+			if (frustum && !IsSphereVisible(*frustum, center, light.Radius))
+			{
+				m_Stats.Culled++;
+				continue;
+			}
+
+			// scale then translate, already transposed
+			float scale = light.Radius + VolumeMargin;
+			PointLightInstance& instance = m_Instances.emplace_back();
+			instance.World = {
+				scale, 0.f, 0.f, center.x,
+				0.f, scale, 0.f, center.y,
+				0.f, 0.f, scale, center.z,
+				0.f, 0.f, 0.f, 1.f };
+			instance.Light = light;
+		}
+
+		m_Stats.Instances = uint32_t(m_Instances.size());
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Scene/Light.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	struct CullingFrustum;
+
+	// One instance of the point light volume, laid out like the shaders'
+	// StructuredBuffer<PointLightInstance>
+	struct PointLightInstance
+	{
+		// Volume scale and translation, transposed for the shaders
+		DirectX::XMFLOAT4X4 World;
+		PointLight Light;
+	};
+
+	struct PointLightBatchStats
+	{
+		uint32_t Lights = 0;
+		uint32_t Culled = 0;
+		uint32_t Instances = 0;
+	};
+
+	// Packs every visible point light with its volume matrix into one array, so the
+	// light pass uploads a single structured buffer and draws all volumes with one
+	// instanced draw instead of binding constants per light. Knows nothing about the
+	// GPU.
+	class PointLightBatch
+	{
+	public:
+		// The sphere mesh is scaled a little past the radius so its flat facets still
+		// cover the whole light
+		static constexpr float VolumeMargin = 0.1f;
+
+		// Lights need PositionWS set. Lights whose radius sphere lies outside frustum
+		// are skipped, frustum may be null to keep all of them.
+		void Build(const PointLight* lights, uint32_t lightCount, const CullingFrustum* frustum);
+
+		const std::vector<PointLightInstance>& GetInstances() const { return m_Instances; }
+		uint32_t GetInstanceCount() const { return uint32_t(m_Instances.size()); }
+		const PointLightBatchStats& GetStats() const { return m_Stats; }
+
+	private:
+		std::vector<PointLightInstance> m_Instances;
+		PointLightBatchStats m_Stats;
+	};
+}
@@ -0,0 +1,219 @@
+#include "pch.h"
+#include "RenderQueue.h"
+
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+namespace Blainn
+{
+	static constexpr uint32_t RadixBits = 8;
+	static constexpr uint32_t RadixSize = 1u << RadixBits;
+	// Below this many items per chunk splitting the sort costs more than it saves
+	static constexpr uint32_t MinItemsPerChunk = 4096;
+
+	static constexpr uint32_t BucketShift = 64 - DrawKey::BucketBits;
+	// Opaque layout
+	static constexpr uint32_t OpaquePipelineShift = BucketShift - DrawKey::PipelineBits;
+	static constexpr uint32_t OpaqueMaterialShift = OpaquePipelineShift - DrawKey::MaterialBits;
+	static constexpr uint32_t OpaqueMeshShift = OpaqueMaterialShift - DrawKey::MeshBits;
+	// Transparent layout
+	static constexpr uint32_t TransparentDepthShift = BucketShift - DrawKey::DepthBits;
+	static constexpr uint32_t TransparentPipelineShift = TransparentDepthShift - DrawKey::PipelineBits;
+	static constexpr uint32_t TransparentMaterialShift = TransparentPipelineShift - DrawKey::MaterialBits;
+	static_assert(TransparentMaterialShift == DrawKey::MeshBits && OpaqueMeshShift == DrawKey::DepthBits,
+		"Draw key fields must fill all 64 bits");
+
+	static uint64_t Field(uint64_t key, uint32_t shift, uint32_t bits)
+	{
+		return (key >> shift) & ((uint64_t(1) << bits) - 1);
+	}
+
+	uint64_t DrawKey::Make(RenderBucket bucket, uint32_t pipeline, uint32_t material, uint32_t mesh,
+		float depth, float nearZ, float farZ)
+	{
+		assert(pipeline < MaxPipelines && material < MaxMaterials && mesh < MaxMeshes);
+
+		float normalized = std::clamp((depth - nearZ) / (farZ - nearZ), 0.f, 1.f);
+		uint64_t quantized = uint64_t(normalized * float(MaxDepth));
+
+		uint64_t key = uint64_t(bucket) << BucketShift;
+		if (bucket == RenderBucket::Transparent)
+		{
+			key |= uint64_t(MaxDepth - quantized) << TransparentDepthShift;
+			key |= uint64_t(pipeline) << TransparentPipelineShift;
+			key |= uint64_t(material) << TransparentMaterialShift;
+			key |= uint64_t(mesh);
+		}
+		else
+		{
+			key |= uint64_t(pipeline) << OpaquePipelineShift;
+			key |= uint64_t(material) << OpaqueMaterialShift;
+			key |= uint64_t(mesh) << OpaqueMeshShift;
+			key |= quantized;
+		}
+		return key;
+	}
+
+	uint32_t DrawKey::GetPipeline(uint64_t key)
+	{
+		bool bTransparent = GetBucket(key) == RenderBucket::Transparent;
+		return uint32_t(Field(key, bTransparent ? TransparentPipelineShift : OpaquePipelineShift, PipelineBits));
+	}
+
+	uint32_t DrawKey::GetMaterial(uint64_t key)
+	{
+		bool bTransparent = GetBucket(key) == RenderBucket::Transparent;
+		return uint32_t(Field(key, bTransparent ? TransparentMaterialShift : OpaqueMaterialShift, MaterialBits));
+	}
+
+	uint32_t DrawKey::GetMesh(uint64_t key)
+	{
+		bool bTransparent = GetBucket(key) == RenderBucket::Transparent;
+		return uint32_t(Field(key, bTransparent ? 0 : OpaqueMeshShift, MeshBits));
+	}
+
+	uint64_t DrawKey::GetState(uint64_t key)
+	{
+		bool bTransparent = GetBucket(key) == RenderBucket::Transparent;
+		uint64_t depthMask = uint64_t(MaxDepth) << (bTransparent ? TransparentDepthShift : 0);
+		return key & ~depthMask;
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_Keys.clear();
+		m_Values.clear();
+		m_Batches.clear();
+		m_Stats = {};
+	}
+
+	void RenderQueue::Reserve(uint32_t itemCount)
+	{
+		m_Keys.reserve(itemCount);
+		m_Values.reserve(itemCount);
+	}
+
+	void RenderQueue::Sort(JobSystem* jobSystem)
+	{
+		m_Stats = {};
+		m_Stats.Items = GetItemCount();
+
+		RadixSort(jobSystem);
+		BuildBatches();
+	}
+
+	void RenderQueue::RadixSort(JobSystem* jobSystem)
+	{
+		const uint32_t count = GetItemCount();
+		if (count < 2)
+			return;
+
+		// digits every key shares would be a plain copy, skip them
+		uint64_t varying = 0;
+		for (uint64_t key : m_Keys)
+			varying |= key ^ m_Keys[0];
+		if (varying == 0)
+			return;
+
+		uint32_t chunkCount = 1;
+		if (jobSystem)
+			chunkCount = std::clamp(count / MinItemsPerChunk, 1u, jobSystem->GetConcurrency());
+		const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+		m_ScratchKeys.resize(count);
+		m_ScratchValues.resize(count);
+		m_Histograms.resize(size_t(chunkCount) * RadixSize);
+
+		auto forEachChunk = [&](const std::function<void(uint32_t, uint32_t, uint32_t)>& body)
+			{
+				auto runChunks = [&](uint32_t firstChunk, uint32_t lastChunk)
+					{
+						for (uint32_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+							body(chunk, chunk * chunkSize, std::min((chunk + 1) * chunkSize, count));
+					};
+				if (jobSystem && chunkCount > 1)
+					jobSystem->ParallelFor(0, chunkCount, 1, runChunks);
+				else
+					runChunks(0, chunkCount);
+			};
+
+		for (uint32_t shift = 0; shift < 64; shift += RadixBits)
+		{
+			if (((varying >> shift) & (RadixSize - 1)) == 0)
+				continue;
+			m_Stats.SortPasses++;
+
+			forEachChunk([&](uint32_t chunk, uint32_t begin, uint32_t end)
+				{
+					uint32_t* histogram = m_Histograms.data() + size_t(chunk) * RadixSize;
+					std::fill(histogram, histogram + RadixSize, 0u);
+					for (uint32_t i = begin; i < end; ++i)
+						histogram[(m_Keys[i] >> shift) & (RadixSize - 1)]++;
+				});
+
+			// digit major, chunk minor, so equal digits keep their chunk order and the
+			// sort stays stable
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < RadixSize; ++digit)
+			{
+				for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+				{
+					uint32_t& counter = m_Histograms[size_t(chunk) * RadixSize + digit];
+					uint32_t digitCount = counter;
+					counter = offset;
+					offset += digitCount;
+				}
+			}
+
+			forEachChunk([&](uint32_t chunk, uint32_t begin, uint32_t end)
+				{
+					uint32_t* offsets = m_Histograms.data() + size_t(chunk) * RadixSize;
+					for (uint32_t i = begin; i < end; ++i)
+					{
+						uint32_t destination = offsets[(m_Keys[i] >> shift) & (RadixSize - 1)]++;
+						m_ScratchKeys[destination] = m_Keys[i];
+						m_ScratchValues[destination] = m_Values[i];
+					}
+				});
+
+			m_Keys.swap(m_ScratchKeys);
+			m_Values.swap(m_ScratchValues);
+		}
+	}
+
+	void RenderQueue::BuildBatches()
+	{
+		m_Batches.clear();
+
+		const uint32_t count = GetItemCount();
+		for (uint32_t i = 0; i < count; )
+		{
+			uint64_t state = DrawKey::GetState(m_Keys[i]);
+			uint32_t end = i + 1;
+			while (end < count && DrawKey::GetState(m_Keys[end]) == state)
+				end++;
+
+			if (m_Batches.empty())
+			{
+				m_Stats.PipelineChanges++;
+				m_Stats.MaterialChanges++;
+				m_Stats.MeshChanges++;
+			}
+			else
+			{
+				uint64_t previous = m_Batches.back().Key;
+				m_Stats.PipelineChanges += DrawKey::GetPipeline(previous) != DrawKey::GetPipeline(state) ? 1 : 0;
+				m_Stats.MaterialChanges += DrawKey::GetMaterial(previous) != DrawKey::GetMaterial(state) ? 1 : 0;
+				m_Stats.MeshChanges += DrawKey::GetMesh(previous) != DrawKey::GetMesh(state) ? 1 : 0;
+			}
+
+			m_Batches.push_back({ m_Keys[i], i, end - i });
+			i = end;
+		}
+
+		m_Stats.Batches = uint32_t(m_Batches.size());
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	class JobSystem;
+
+	// Buckets are drawn in order, opaque first
+	enum class RenderBucket : uint32_t
+	{
+		Opaque = 0,
+		Transparent = 1,
+	};
+
+	// Packs the draw state into a 64 bit key so sorting the keys groups draws by state.
+	// Opaque keys are bucket | pipeline | material | mesh | depth, so identical draws end
+	// up next to each other and front to back among themselves. Transparent keys move the
+	// depth right behind the bucket and invert it, back to front matters more than state.
+	struct DrawKey
+	{
+		static constexpr uint32_t BucketBits = 2;
+		static constexpr uint32_t PipelineBits = 6;
+		static constexpr uint32_t MaterialBits = 16;
+		static constexpr uint32_t MeshBits = 16;
+		static constexpr uint32_t DepthBits = 24;
+
+		static constexpr uint32_t MaxPipelines = 1u << PipelineBits;
+		static constexpr uint32_t MaxMaterials = 1u << MaterialBits;
+		static constexpr uint32_t MaxMeshes = 1u << MeshBits;
+		static constexpr uint32_t MaxDepth = (1u << DepthBits) - 1;
+
+		// depth is the view depth, quantized linearly between nearZ and farZ
+		static uint64_t Make(RenderBucket bucket, uint32_t pipeline, uint32_t material, uint32_t mesh,
+			float depth, float nearZ, float farZ);
+
+		static RenderBucket GetBucket(uint64_t key) { return RenderBucket(key >> (64 - BucketBits)); }
+		static uint32_t GetPipeline(uint64_t key);
+		static uint32_t GetMaterial(uint64_t key);
+		static uint32_t GetMesh(uint64_t key);
+		// Everything but the depth, keys with the same state can share an instanced draw
+		static uint64_t GetState(uint64_t key);
+	};
+
+	// Run of sorted items with the same state
+	struct RenderBatch
+	{
+		uint64_t Key = 0;
+		// Into GetValues
+		uint32_t First = 0;
+		uint32_t Count = 0;
+	};
+
+	struct RenderQueueStats
+	{
+		uint32_t Items = 0;
+		// Instanced draws after merging
+		uint32_t Batches = 0;
+		// State switches between consecutive batches, the first batch counts as one
+		uint32_t PipelineChanges = 0;
+		uint32_t MaterialChanges = 0;
+		uint32_t MeshChanges = 0;
+		// Radix passes that ran, digits every key shares are skipped
+		uint32_t SortPasses = 0;
+	};
+
+	// Collects a key and a value per draw item every frame, radix sorts them in parallel
+	// and merges consecutive items with the same state into batches. Values are whatever
+	// the caller needs to find the item again, an instance slot or an index.
+	class RenderQueue
+	{
+	public:
+		void Clear();
+		void Reserve(uint32_t itemCount);
+		void Push(uint64_t key, uint32_t value)
+		{
+			m_Keys.push_back(key);
+			m_Values.push_back(value);
+		}
+
+		// Stable LSD radix sort over 8 bit digits, then builds the batches.
+		// jobSystem may be null.
+		void Sort(JobSystem* jobSystem);
+
+		uint32_t GetItemCount() const { return uint32_t(m_Keys.size()); }
+		// Sorted after Sort
+		const std::vector<uint64_t>& GetKeys() const { return m_Keys; }
+		const std::vector<uint32_t>& GetValues() const { return m_Values; }
+		const std::vector<RenderBatch>& GetBatches() const { return m_Batches; }
+
+		const RenderQueueStats& GetStats() const { return m_Stats; }
+
+	private:
+		void RadixSort(JobSystem* jobSystem);
+		void BuildBatches();
+
+	private:
+		std::vector<uint64_t> m_Keys;
+		std::vector<uint32_t> m_Values;
+		std::vector<uint64_t> m_ScratchKeys;
+		std::vector<uint32_t> m_ScratchValues;
+		// 256 counters per chunk
+		std::vector<uint32_t> m_Histograms;
+
+		std::vector<RenderBatch> m_Batches;
+		RenderQueueStats m_Stats;
+	};
+}
@@ -0,0 +1,262 @@
+#include "pch.h"
+#include "RenderingBackend.h"
+
+#include "Components/ActorComponents/DirectionalLightComponent.h"
+#include "Components/ActorComponents/PointLightComponent.h"
+#include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Components/ComponentManager.h"
+#include "Core/Application.h"
+#include "Core/Camera.h"
+#include "Core/GameObject.h"
+#include "FrameGraph.h"
+#include "InstanceDataBuffer.h"
+#include "LightClusters.h"
+#include "Model.h"
+#include "PointLightBatch.h"
+#include "RenderQueue.h"
+#include "ShadowCascadeCache.h"
+#include "ShadowCascades.h"
+#include "ViewCulling.h"
+
+extern const int g_NumFrameResources = 3;
+extern const uint32_t g_NumObjects = 10000;
+
+namespace Blainn
+{
+	RenderingBackend::RenderingBackend() = default;
+
+	RenderingBackend::~RenderingBackend() = default;
+
+	std::shared_ptr<Model> RenderingBackend::LoadModel(const std::filesystem::path& modelFilePath)
+	{
+		return Model::CreatePlaceholder(modelFilePath);
+	}
+
+	void RenderingBackend::CreateFrameData(std::shared_ptr<ShadowCascades> cascades, std::shared_ptr<InstanceDataBuffer> instanceData)
+	{
+		m_ShadowCascades = cascades;
+		m_ShadowCascades->UpdateCascadeDistances({20.f, 50.f, 100.f, 1000.f});
+		m_ShadowCache = std::make_shared<ShadowCascadeCache>();
+
+		m_InstanceData = instanceData;
+		m_ViewCulling = std::make_shared<ViewCulling>();
+		m_ViewCulling->SetViewCount(NumCullingViews);
+		m_LightClusters = std::make_shared<LightClusters>();
+		m_PointLightBatch = std::make_shared<PointLightBatch>();
+		m_GeometryQueue = std::make_shared<RenderQueue>();
+		m_FrameGraph = std::make_shared<FrameGraph>();
+	}
+
+	const ComponentManager& RenderingBackend::GetSceneComponents()
+	{
+		return Application::Get().GetScene()->GetComponentManager();
+	}
+
+	void RenderingBackend::PrepareView(const Camera& camera)
+	{
+		using namespace DirectX;
+
+		m_CameraView = camera.GetViewMatrix();
+		m_CameraViewProj = camera.GetViewMatrix() * camera.GetProjectionMatrix();
+		m_CameraNearZ = camera.GetNearPlane();
+		m_CameraFarZ = camera.GetFarPlane();
+
+		// the first directional light casts the shadows
+		auto& dirLightComponents = GetSceneComponents().GetComponents<DirectionalLightComponent>();
+		for (auto& dl : dirLightComponents)
+		{
+			GameObject* owner = dl->GetOwnerPtr();
+			if (!owner)
+				continue;
+
+			auto transform = owner->GetComponentPtr<TransformComponent>();
+			if (!transform)
+				continue;
+
+			auto& d = dl->GetDirectionalLight();
+			d.DirectionWS = SimpleMath::Vector4(transform->GetWorldForwardVector());
+
+			m_ShadowCascades->UpdateCascadeMatrices(camera, DirectX::SimpleMath::Vector3(d.DirectionWS));
+			break;
+		}
+
+		// cascades reusing their cached static casters keep the matrix they were drawn with
+		m_ShadowCache->SetEnabled(m_bCacheStaticShadows);
+		m_ShadowCache->UpdateMatrices(m_ShadowCascades->GetCascadeData(), m_ShadowCascades->GetSize().x);
+
+		PreparePointLights(camera);
+	}
+
+	void RenderingBackend::PrepareInstances(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes, float alpha)
+	{
+		m_Stats = {};
+
+		// shared by the shadow cascades and the geometry pass
+		m_InstanceData->Build(meshes, alpha);
+		ScheduleShadowCache(meshes);
+		CullInstances(meshes);
+
+		m_Stats.UploadBytes += uint64_t(m_InstanceData->GetUploadedCount()) * sizeof(PerObjectData);
+	}
+
+	void RenderingBackend::ScheduleShadowCache(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
+	{
+		// the caches hold every static mesh as it was, any of them moving, coming or
+		// going makes them stale
+		bool bStaticChanged = false;
+		uint32_t staticCount = 0;
+		for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+		{
+			const StaticMeshComponent* mesh = meshes[meshIndex].get();
+			if (!mesh->IsStatic())
+				continue;
+
+			if (staticCount >= m_StaticMeshes.size() || m_StaticMeshes[staticCount] != mesh || m_InstanceData->HasMeshChanged(meshIndex))
+				bStaticChanged = true;
+			if (staticCount < m_StaticMeshes.size())
+				m_StaticMeshes[staticCount] = mesh;
+			else
+				m_StaticMeshes.push_back(mesh);
+			staticCount++;
+		}
+		if (staticCount != m_StaticMeshes.size())
+			bStaticChanged = true;
+		m_StaticMeshes.resize(staticCount);
+
+		m_ShadowCache->Schedule(m_ShadowCascades->GetCascadeData(), staticCount, bStaticChanged);
+	}
+
+	void RenderingBackend::CullInstances(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
+	{
+		m_ViewCulling->SetFrustum(CameraView, CullingFrustum::FromViewProjection(m_CameraViewProj));
+
+		// cascade matrices are kept transposed for the shaders
+		const auto& cascadeData = m_ShadowCascades->GetCascadeData();
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+			m_ViewCulling->SetFrustum(FirstCascadeView + i, CullingFrustum::FromViewProjection(cascadeData.viewProjMats[i].Transpose()));
+
+		m_ViewCulling->Cull(m_InstanceData->GetBounds(), &Application::Get().GetJobSystem());
+		BuildGeometryQueue(meshes);
+		m_InstanceData->Upload(*m_ViewCulling);
+	}
+
+	void RenderingBackend::BuildGeometryQueue(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes)
+	{
+		m_GeometryQueue->Clear();
+		m_DrawItems.clear();
+
+		const std::vector<uint32_t>& visible = m_ViewCulling->GetVisible(CameraView);
+		const std::vector<PerObjectData>& instances = m_InstanceData->GetInstances();
+		const DirectX::XMFLOAT4X4& view = m_CameraView;
+
+		// visible slots are ascending like the mesh ranges, one walk splits them per mesh
+		size_t cursor = 0;
+		for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+		{
+			const InstanceRange& range = m_InstanceData->GetRange(meshIndex);
+			const Model* model = meshes[meshIndex]->GetModel().get();
+			const std::vector<Submesh>& submeshes = model->GetSubmeshes();
+			for (; cursor < visible.size() && visible[cursor] < range.Offset + range.Count; ++cursor)
+			{
+				uint32_t slot = visible[cursor];
+
+				// the matrices are stored transposed, the translation is the last column
+				const DirectX::XMFLOAT4X4& world = instances[slot].WorldMatrix;
+				float depth = -(world._14 * view._13 + world._24 * view._23 + world._34 * view._33 + view._43);
+
+				for (uint32_t submeshIndex = 0; submeshIndex < submeshes.size(); ++submeshIndex)
+				{
+					const Submesh& submesh = submeshes[submeshIndex];
+					RenderBucket bucket = submesh.bTransparent ? RenderBucket::Transparent : RenderBucket::Opaque;
+					uint64_t key = DrawKey::Make(bucket, 0, submesh.MaterialId, submesh.MeshId, depth, m_CameraNearZ, m_CameraFarZ);
+					m_GeometryQueue->Push(key, uint32_t(m_DrawItems.size()));
+					m_DrawItems.push_back({ slot, model, submeshIndex });
+				}
+			}
+		}
+
+		m_GeometryQueue->Sort(&Application::Get().GetJobSystem());
+
+		// every batch draws a contiguous run of these
+		m_DrawInstances.clear();
+		for (uint32_t item : m_GeometryQueue->GetValues())
+			m_DrawInstances.push_back(m_DrawItems[item].Slot);
+		m_InstanceData->SetOrderedInstances(m_DrawInstances);
+	}
+
+	void RenderingBackend::PreparePointLights(const Camera& camera)
+	{
+		using namespace DirectX;
+
+		auto& pointLightComponents = GetSceneComponents().GetComponents<PointLightComponent>();
+		m_PointLights.clear();
+		m_PointLightSpheres.clear();
+		for (auto& pl : pointLightComponents)
+		{
+			GameObject* owner = pl->GetOwnerPtr();
+			if (!owner)
+				continue;
+
+			auto transform = owner->GetComponentPtr<TransformComponent>();
+			if (!transform)
+				continue;
+
+			auto l = pl->GetPointLight();
+			l.PositionWS = SimpleMath::Vector4(transform->GetWorldPosition());
+			m_PointLights.push_back(l);
+			m_PointLightSpheres.push_back({ l.PositionWS.x, l.PositionWS.y, l.PositionWS.z, l.Radius });
+		}
+
+		LightClusterView clusterView;
+		clusterView.View = camera.GetViewMatrix();
+		clusterView.FovY = XMConvertToRadians(camera.GetFieldOfView());
+		clusterView.AspectRatio = camera.GetAspectRatio();
+		clusterView.NearZ = camera.GetNearPlane();
+		clusterView.FarZ = camera.GetFarPlane();
+		m_LightClusters->Assign(clusterView, m_PointLightSpheres.data(), uint32_t(m_PointLightSpheres.size()), &Application::Get().GetJobSystem());
+
+		// volumes of lights outside the camera frustum never reach the screen
+		CullingFrustum frustum = CullingFrustum::FromViewProjection(m_CameraViewProj);
+		m_PointLightBatch->Build(m_PointLights.data(), uint32_t(m_PointLights.size()), &frustum);
+	}
+
+	void RenderingBackend::SplitGeometryBatches(std::vector<RecordingChunk>& chunks) const
+	{
+		chunks.clear();
+		uint32_t batchCount = uint32_t(m_GeometryQueue->GetBatches().size());
+
+		uint32_t chunkCount = 1;
+		if (m_bParallelRecording)
+		{
+			chunkCount = std::min({ MaxGeometryChunks, Application::Get().GetJobSystem().GetConcurrency(),
+				(batchCount + MinBatchesPerChunk - 1) / MinBatchesPerChunk });
+			chunkCount = std::max(chunkCount, 1u);
+		}
+
+		// the first chunks take one batch more when they don't divide evenly
+		uint32_t first = 0;
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			uint32_t count = batchCount / chunkCount + (i < batchCount % chunkCount ? 1 : 0);
+			chunks.push_back({ first, count });
+			first += count;
+		}
+	}
+
+	void RenderingBackend::RecordLists(uint32_t count, const std::function<void(uint32_t)>& record)
+	{
+		if (!m_bParallelRecording || count < 2)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+				record(i);
+			return;
+		}
+
+		Application::Get().GetJobSystem().ParallelFor(0, count, 1, [&record](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+				record(i);
+		});
+	}
+}
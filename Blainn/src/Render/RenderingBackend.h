@@ -0,0 +1,199 @@
+#pragma once
+
+#include "DX12/ShaderTypes.h"
+#include "Scene/Light.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Blainn
+{
+	class Camera;
+	class ComponentManager;
+	class FrameGraph;
+	class GameTimer;
+	class InstanceDataBuffer;
+	class LightClusters;
+	class Model;
+	class PointLightBatch;
+	class RenderQueue;
+	class ShadowCascadeCache;
+	class ShadowCascades;
+	class StaticMeshComponent;
+	class ViewCulling;
+	class Window;
+
+	// Work the last frame submitted
+	struct RenderingStats
+	{
+		uint32_t DrawCalls = 0;
+		// Instances over all draw calls
+		uint32_t Instances = 0;
+		uint32_t Dispatches = 0;
+		uint32_t CommandLists = 0;
+		// Instance data and light instances written for the GPU
+		uint64_t UploadBytes = 0;
+
+		void Add(const RenderingStats& other)
+		{
+			DrawCalls += other.DrawCalls;
+			Instances += other.Instances;
+			Dispatches += other.Dispatches;
+			CommandLists += other.CommandLists;
+			UploadBytes += other.UploadBytes;
+		}
+	};
+
+	// Batches of the geometry queue one command list records
+	struct RecordingChunk
+	{
+		uint32_t FirstBatch = 0;
+		uint32_t BatchCount = 0;
+	};
+
+	// What the application drives every frame. The CPU side of a frame, building and
+	// culling the instances, sorting the geometry draws and packing the lights, is
+	// shared here, the implementations only record and submit the passes.
+	class RenderingBackend
+	{
+	public:
+		// Views culled every frame, cascade i is FirstCascadeView + i
+		enum CullingViews
+		{
+			CameraView = 0,
+			FirstCascadeView = 1,
+			NumCullingViews = FirstCascadeView + CASCADE_COUNT
+		};
+
+		RenderingBackend();
+		virtual ~RenderingBackend();
+
+		// wnd may be null for backends that present nothing
+		virtual void Init(std::shared_ptr<Window> wnd) = 0;
+		virtual void CreateResources() = 0;
+
+		virtual void OnUpdate() {}
+		virtual void UpdateObjectsConstantBuffers() {}
+		virtual void UpdateMainPassConstantBuffers(const GameTimer& gt, const Camera& camera) = 0;
+
+		virtual void Draw() = 0;
+		virtual void Resize(int newWidth, int newHeight) = 0;
+
+		// Models a backend draws carry its GPU data, StaticMeshComponent loads through
+		// here. Without an override the model is a placeholder box and nothing is read.
+		virtual std::shared_ptr<Model> LoadModel(const std::filesystem::path& modelFilePath);
+
+		bool IsInitialized() const { return m_bIsInitialized; }
+
+		// Visible lists and counters of the last frame, indexed by CullingViews
+		const ViewCulling& GetViewCulling() const { return *m_ViewCulling; }
+		// Point lights of the last frame binned into the camera's froxels
+		const LightClusters& GetLightClusters() const { return *m_LightClusters; }
+		// Passes of the last frame in the order they ran
+		const FrameGraph& GetFrameGraph() const { return *m_FrameGraph; }
+		// Sorted and batched geometry pass draws of the last frame
+		const RenderQueue& GetGeometryQueue() const { return *m_GeometryQueue; }
+		// Visible point lights of the last frame as drawn by the light pass
+		const PointLightBatch& GetPointLightBatch() const { return *m_PointLightBatch; }
+
+		// Draws all point light volumes with one instanced draw, or one draw per light
+		void SetBatchPointLights(bool bBatch) { m_bBatchPointLights = bBatch; }
+		bool IsBatchingPointLights() const { return m_bBatchPointLights; }
+		// Draw calls the last point light pass submitted
+		uint32_t GetPointLightDrawCalls() const { return m_PointLightDrawCalls; }
+
+		// Records the shadow cascades and the chunks of the geometry pass on job
+		// workers, each into its own command list. Off, the same lists are recorded
+		// one after another on the calling thread.
+		void SetParallelRecording(bool bParallel) { m_bParallelRecording = bParallel; }
+		bool IsRecordingInParallel() const { return m_bParallelRecording; }
+
+		// Draws the static meshes of a shadow cascade into a cache and reuses it until
+		// the cascade moves, see ShadowCascadeCache. Off, every cascade draws every
+		// caster every frame.
+		void SetCacheStaticShadows(bool bCache) { m_bCacheStaticShadows = bCache; }
+		bool IsCachingStaticShadows() const { return m_bCacheStaticShadows; }
+		// Which cascades drew their static casters last frame, with per cascade counters
+		const ShadowCascadeCache& GetShadowCache() const { return *m_ShadowCache; }
+
+		const RenderingStats& GetStats() const { return m_Stats; }
+
+	protected:
+		// The geometry pass is split into this many command lists at most
+		static constexpr uint32_t MaxGeometryChunks = 8;
+		// Fewer batches than this are not worth another command list
+		static constexpr uint32_t MinBatchesPerChunk = 64;
+
+		// Splits the geometry queue's batches into contiguous chunks, one when not
+		// recording in parallel. Chunks are submitted in order, so the queue's sort
+		// order holds across them.
+		void SplitGeometryBatches(std::vector<RecordingChunk>& chunks) const;
+		// Calls record for every index below count. In parallel the calls run on job
+		// workers and must only touch state of their own index.
+		void RecordLists(uint32_t count, const std::function<void(uint32_t)>& record);
+
+		// Takes the cascades and the instance buffer of the backend, a GPU backend
+		// passes its own with the shadow maps and the instance data in GPU memory
+		void CreateFrameData(std::shared_ptr<ShadowCascades> cascades, std::shared_ptr<InstanceDataBuffer> instanceData);
+
+		// Components of the application's scene, the one that gets drawn
+		static const ComponentManager& GetSceneComponents();
+
+		// Camera state for the frame, the shadow cascades and the point lights
+		void PrepareView(const Camera& camera);
+		// Builds, culls and uploads the instances and fills the geometry queue, call
+		// before recording any pass
+		void PrepareInstances(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes, float alpha);
+
+		void ScheduleShadowCache(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void CullInstances(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void BuildGeometryQueue(const std::vector<std::shared_ptr<StaticMeshComponent>>& meshes);
+		void PreparePointLights(const Camera& camera);
+
+	protected:
+		std::shared_ptr<ShadowCascades> m_ShadowCascades;
+		std::shared_ptr<ShadowCascadeCache> m_ShadowCache;
+		// Static meshes the caches were drawn with
+		std::vector<const StaticMeshComponent*> m_StaticMeshes;
+		bool m_bCacheStaticShadows = true;
+
+		std::shared_ptr<InstanceDataBuffer> m_InstanceData;
+		std::shared_ptr<ViewCulling> m_ViewCulling;
+		DirectX::XMFLOAT4X4 m_CameraView{};
+		DirectX::XMFLOAT4X4 m_CameraViewProj{};
+		float m_CameraNearZ = 0.1f;
+		float m_CameraFarZ = 1000.f;
+
+		// One item per visible instance and submesh, the queue's values index m_DrawItems
+		struct DrawItem
+		{
+			uint32_t Slot;
+			// The item draws SourceModel->GetSubmeshes()[SubmeshIndex]
+			const Model* SourceModel;
+			uint32_t SubmeshIndex;
+		};
+		std::shared_ptr<RenderQueue> m_GeometryQueue;
+		std::shared_ptr<FrameGraph> m_FrameGraph;
+		std::vector<DrawItem> m_DrawItems;
+		// Instance slots in queue order
+		std::vector<uint32_t> m_DrawInstances;
+
+		// Every point light of the frame, the clusters' visible lights index into it
+		std::vector<PointLight> m_PointLights;
+		std::vector<DirectX::XMFLOAT4> m_PointLightSpheres;
+		std::shared_ptr<LightClusters> m_LightClusters;
+		std::shared_ptr<PointLightBatch> m_PointLightBatch;
+		bool m_bBatchPointLights = true;
+		uint32_t m_PointLightDrawCalls = 0;
+
+		RenderingStats m_Stats;
+		bool m_bParallelRecording = true;
+
+		bool m_bIsInitialized = false;
+	};
+}
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "ShadowCascadeCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Blainn
+{
+	// The far cascades cover more of the scene per texel and can wait longer, the
+	// phases keep the cascades sharing a period from being due on the same frame
+	static constexpr uint32_t s_UpdatePeriods[CASCADE_COUNT] = { 1, 2, 2, 4 };
+	static constexpr uint32_t s_UpdatePhases[CASCADE_COUNT] = { 0, 0, 1, 2 };
+	static_assert(CASCADE_COUNT == 4, "update periods are given per cascade");
+
+	// How far, in texels, the corners of the current cascade box land from where
+	// the cached matrix puts them. Matrices are transposed like CascadeData.
+	static float GetDriftTexels(const DirectX::SimpleMath::Matrix& cached, const DirectX::SimpleMath::Matrix& current, uint32_t mapSize)
+	{
+		using namespace DirectX::SimpleMath;
+
+		const Matrix currentToCached = current.Transpose().Invert() * cached.Transpose();
+
+		float drift = 0.f;
+		for (uint32_t z = 0; z < 2; ++z)
+		{
+			for (uint32_t y = 0; y < 2; ++y)
+			{
+				for (uint32_t x = 0; x < 2; ++x)
+				{
+					const Vector4 corner(2.f * x - 1.f, 2.f * y - 1.f, float(z), 1.f);
+					Vector4 p = Vector4::Transform(corner, currentToCached);
+					p /= p.w;
+					drift = std::max({ drift, std::abs(p.x - corner.x), std::abs(p.y - corner.y) });
+				}
+			}
+		}
+
+		// clip space spans the map twice
+		return drift * 0.5f * float(mapSize);
+	}
+
+	uint32_t ShadowCascadeCache::GetUpdatePeriod(uint32_t cascade)
+	{
+		return s_UpdatePeriods[cascade];
+	}
+
+	void ShadowCascadeCache::UpdateMatrices(CascadeData& cascadeData, uint32_t mapSize)
+	{
+		m_Frame++;
+
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+		{
+			Cascade& cascade = m_Cascades[i];
+			if (!m_bActive || !cascade.bValid)
+			{
+				cascade.bDue = true;
+				continue;
+			}
+
+			float drift = GetDriftTexels(cascade.ViewProj, cascadeData.viewProjMats[i], mapSize);
+			bool bSlot = m_Frame % s_UpdatePeriods[i] == s_UpdatePhases[i];
+			cascade.bDue = drift > MaxDriftTexels || (drift >= 1.f && bSlot);
+			if (!cascade.bDue)
+				cascadeData.viewProjMats[i] = cascade.ViewProj;
+		}
+	}
+
+	void ShadowCascadeCache::Schedule(const CascadeData& cascadeData, uint32_t staticMeshCount, bool bStaticChanged)
+	{
+		m_bActive = m_bEnabled && staticMeshCount > 0;
+		if (!m_bActive)
+		{
+			Invalidate();
+			return;
+		}
+
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+		{
+			Cascade& cascade = m_Cascades[i];
+			cascade.bRenderStatic = !cascade.bValid || cascade.bDue || bStaticChanged;
+			if (!cascade.bRenderStatic)
+			{
+				cascade.Stats.Reused++;
+				continue;
+			}
+
+			cascade.ViewProj = cascadeData.viewProjMats[i];
+			cascade.bValid = true;
+			cascade.Stats.Rendered++;
+		}
+	}
+
+	void ShadowCascadeCache::Invalidate()
+	{
+		for (Cascade& cascade : m_Cascades)
+		{
+			cascade.bValid = false;
+			cascade.bRenderStatic = false;
+		}
+	}
+
+	void ShadowCascadeCache::ResetStats()
+	{
+		for (Cascade& cascade : m_Cascades)
+			cascade.Stats = {};
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "DX12/ShaderTypes.h"
+
+#include <cstdint>
+
+namespace Blainn
+{
+	// Frames a cascade drew its static casters and frames it reused the cached ones
+	struct ShadowCacheStats
+	{
+		uint32_t Rendered = 0;
+		uint32_t Reused = 0;
+	};
+
+	// Decides when the shadow cascades draw their static casters again. The static
+	// casters of a cascade are drawn into a cache of their own, which is copied into
+	// the cascade every frame before the movable casters are drawn on top.
+	//
+	// The cached depth only lines up with the light matrix it was drawn with, so a
+	// cascade keeps that matrix, for culling and for the lighting pass too, until it
+	// is due. A cascade is due once it moved a texel or more and its slot in the
+	// round robin comes up, cascade i gets a slot every GetUpdatePeriod(i) frames.
+	// Moving more than MaxDriftTexels makes it due at once, so a camera cut never
+	// samples shadows of the old view.
+	class ShadowCascadeCache
+	{
+	public:
+		static constexpr float MaxDriftTexels = 64.f;
+
+		// Frames between two slots of the cascade, 1, 2, 2 and 4
+		static uint32_t GetUpdatePeriod(uint32_t cascade);
+
+		// Disabled, every cascade draws all its casters with its own matrix every frame
+		void SetEnabled(bool bEnabled) { m_bEnabled = bEnabled; }
+		bool IsEnabled() const { return m_bEnabled; }
+
+		// Call once the cascade matrices of the frame are computed. Cascades that are
+		// not due get their cached matrix back.
+		void UpdateMatrices(CascadeData& cascadeData, uint32_t mapSize);
+		// Call after the instances are built. bStaticChanged forces every cascade to
+		// draw its static casters again, there is nothing to cache without any.
+		void Schedule(const CascadeData& cascadeData, uint32_t staticMeshCount, bool bStaticChanged);
+		// Cached depth is lost, the targets were recreated
+		void Invalidate();
+
+		// Whether the cascades use the cache this frame, off they draw every caster
+		bool IsActive() const { return m_bActive; }
+		// Whether the cascade draws its static casters into the cache this frame
+		bool IsRenderingStatic(uint32_t cascade) const { return m_Cascades[cascade].bRenderStatic; }
+
+		// Counted over the frames the cache was active
+		const ShadowCacheStats& GetStats(uint32_t cascade) const { return m_Cascades[cascade].Stats; }
+		void ResetStats();
+
+	private:
+		struct Cascade
+		{
+			// Transposed like CascadeData
+			DirectX::SimpleMath::Matrix ViewProj;
+			bool bValid = false;
+			bool bDue = false;
+			bool bRenderStatic = false;
+			ShadowCacheStats Stats;
+		};
+
+		Cascade m_Cascades[CASCADE_COUNT];
+		uint32_t m_Frame = 0;
+		bool m_bEnabled = true;
+		bool m_bActive = false;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "DX12/ShaderTypes.h"
+
+#include <DirectXMath.h>
+
+#include <utility>
+#include <vector>
+
+namespace Blainn
+{
+	class Camera;
+
+	// Light matrices and split distances of the directional light's shadow cascades.
+	// The backends share them for culling and caching, a backend drawing the shadows
+	// extends this with its shadow maps.
+	class ShadowCascades
+	{
+	public:
+		explicit ShadowCascades(DirectX::XMUINT2 size);
+		virtual ~ShadowCascades() = default;
+
+		// Shadow map size of every cascade in texels
+		DirectX::XMUINT2 GetSize() const { return m_Size; }
+
+		void UpdateCascadeData(DirectX::SimpleMath::Matrix& invViewProj,
+			DirectX::SimpleMath::Vector3 lightDirection);
+		void UpdateCascadeMatrices(const Camera& camera, const DirectX::SimpleMath::Vector3& lightDirection);
+		void UpdateCascadeDistances(const std::vector<float>& distances);
+
+		CascadeData& GetCascadeData() { return m_CascadeData; }
+
+	protected:
+		DirectX::XMUINT2 m_Size;
+
+		CascadeData m_CascadeData = {};
+		DirectX::SimpleMath::Vector3 m_LightDirection;
+
+		std::vector<std::pair<float, float>> m_CascadeViewWindows{ {0.f, 0.15f}, {0.14f, 0.35f}, {0.34f, 0.66f}, {0.65f, 1.1f} };
+	};
+}
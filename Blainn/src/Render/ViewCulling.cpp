@@ -0,0 +1,231 @@
+#include "pch.h"
+#include "ViewCulling.h"
+
+#include "Core/JobSystem.h"
+
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BLAINN_CULLING_SSE
+#endif
+
+namespace Blainn
+{
+	CullingFrustum CullingFrustum::FromViewProjection(const DirectX::XMFLOAT4X4& m)
+	{
+		// Gribb/Hartmann, with row vectors clip.j = dot(p, column j)
+		CullingFrustum frustum;
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			for (int side = 0; side < 2; ++side)
+			{
+				float sign = side == 0 ? 1.f : -1.f;
+				frustum.Planes[axis * 2 + side] = {
+					m.m[0][3] + sign * m.m[0][axis],
+					m.m[1][3] + sign * m.m[1][axis],
+					m.m[2][3] + sign * m.m[2][axis],
+					m.m[3][3] + sign * m.m[3][axis] };
+			}
+		}
+		// near is z >= 0, far is z <= w
+		frustum.Planes[4] = { m.m[0][2], m.m[1][2], m.m[2][2], m.m[3][2] };
+		frustum.Planes[5] = { m.m[0][3] - m.m[0][2], m.m[1][3] - m.m[1][2], m.m[2][3] - m.m[2][2], m.m[3][3] - m.m[3][2] };
+
+		for (auto& plane : frustum.Planes)
+		{
+			float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0.f)
+			{
+				plane.x /= length;
+				plane.y /= length;
+				plane.z /= length;
+				plane.w /= length;
+			}
+		}
+		return frustum;
+	}
+
+	void CullingBounds::Resize(uint32_t count)
+	{
+		uint32_t paddedCount = (count + BatchSize - 1) / BatchSize * BatchSize;
+		m_Count = count;
+
+		m_CenterX.resize(paddedCount);
+		m_CenterY.resize(paddedCount);
+		m_CenterZ.resize(paddedCount);
+		m_ExtentX.resize(paddedCount);
+		m_ExtentY.resize(paddedCount);
+		m_ExtentZ.resize(paddedCount);
+
+		for (uint32_t i = count; i < paddedCount; ++i)
+			SetEmpty(i);
+	}
+
+	void CullingBounds::Set(uint32_t index, const DirectX::XMFLOAT3& c, const DirectX::XMFLOAT3& e,
+		const DirectX::XMFLOAT4X4& w)
+	{
+		// center goes through the full transform, extents through the absolute 3x3 part
+		m_CenterX[index] = c.x * w._11 + c.y * w._21 + c.z * w._31 + w._41;
+		m_CenterY[index] = c.x * w._12 + c.y * w._22 + c.z * w._32 + w._42;
+		m_CenterZ[index] = c.x * w._13 + c.y * w._23 + c.z * w._33 + w._43;
+
+		m_ExtentX[index] = e.x * std::abs(w._11) + e.y * std::abs(w._21) + e.z * std::abs(w._31);
+		m_ExtentY[index] = e.x * std::abs(w._12) + e.y * std::abs(w._22) + e.z * std::abs(w._32);
+		m_ExtentZ[index] = e.x * std::abs(w._13) + e.y * std::abs(w._23) + e.z * std::abs(w._33);
+	}
+
+	void CullingBounds::SetEmpty(uint32_t index)
+	{
+		m_CenterX[index] = 0.f;
+		m_CenterY[index] = 0.f;
+		m_CenterZ[index] = 0.f;
+		m_ExtentX[index] = -FLT_MAX;
+		m_ExtentY[index] = -FLT_MAX;
+		m_ExtentZ[index] = -FLT_MAX;
+	}
+
+	uint32_t CullBounds(const CullingBounds& bounds, const CullingFrustum& frustum, uint32_t* outVisible)
+	{
+		const float* cx = bounds.m_CenterX.data();
+		const float* cy = bounds.m_CenterY.data();
+		const float* cz = bounds.m_CenterZ.data();
+		const float* ex = bounds.m_ExtentX.data();
+		const float* ey = bounds.m_ExtentY.data();
+		const float* ez = bounds.m_ExtentZ.data();
+
+		uint32_t paddedCount = bounds.GetPaddedCount();
+		uint32_t visibleCount = 0;
+
+		// A box is outside once center distance plus projected extents is negative for
+		// any plane. Indices are written unconditionally and kept by advancing the cursor
+		// with the lane's bit, so the compaction does not branch per instance.
+#if defined(__AVX__)
+		__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			const auto& plane = frustum.Planes[p];
+			planeX[p] = _mm256_set1_ps(plane.x);
+			planeY[p] = _mm256_set1_ps(plane.y);
+			planeZ[p] = _mm256_set1_ps(plane.z);
+			planeW[p] = _mm256_set1_ps(plane.w);
+			absX[p] = _mm256_set1_ps(std::abs(plane.x));
+			absY[p] = _mm256_set1_ps(std::abs(plane.y));
+			absZ[p] = _mm256_set1_ps(std::abs(plane.z));
+		}
+
+		const __m256 zero = _mm256_setzero_ps();
+		for (uint32_t i = 0; i < paddedCount; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+			__m256 rx = _mm256_loadu_ps(ex + i), ry = _mm256_loadu_ps(ey + i), rz = _mm256_loadu_ps(ez + i);
+
+			__m256 outside = zero;
+			for (int p = 0; p < 6; ++p)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, planeX[p]), _mm256_mul_ps(y, planeY[p])),
+					_mm256_add_ps(_mm256_mul_ps(z, planeZ[p]), planeW[p]));
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, absX[p]), _mm256_mul_ps(ry, absY[p])),
+					_mm256_mul_ps(rz, absZ[p]));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+			}
+
+			uint32_t visibleMask = ~uint32_t(_mm256_movemask_ps(outside)) & 0xFFu;
+			for (uint32_t lane = 0; lane < 8; ++lane)
+			{
+				outVisible[visibleCount] = i + lane;
+				visibleCount += (visibleMask >> lane) & 1u;
+			}
+		}
+#elif defined(BLAINN_CULLING_SSE)
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			const auto& plane = frustum.Planes[p];
+			planeX[p] = _mm_set1_ps(plane.x);
+			planeY[p] = _mm_set1_ps(plane.y);
+			planeZ[p] = _mm_set1_ps(plane.z);
+			planeW[p] = _mm_set1_ps(plane.w);
+			absX[p] = _mm_set1_ps(std::abs(plane.x));
+			absY[p] = _mm_set1_ps(std::abs(plane.y));
+			absZ[p] = _mm_set1_ps(std::abs(plane.z));
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		for (uint32_t i = 0; i < paddedCount; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+			__m128 rx = _mm_loadu_ps(ex + i), ry = _mm_loadu_ps(ey + i), rz = _mm_loadu_ps(ez + i);
+
+			__m128 outside = zero;
+			for (int p = 0; p < 6; ++p)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+					_mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, absX[p]), _mm_mul_ps(ry, absY[p])),
+					_mm_mul_ps(rz, absZ[p]));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			uint32_t visibleMask = ~uint32_t(_mm_movemask_ps(outside)) & 0xFu;
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				outVisible[visibleCount] = i + lane;
+				visibleCount += (visibleMask >> lane) & 1u;
+			}
+		}
+#else
+		for (uint32_t i = 0; i < paddedCount; ++i)
+		{
+			bool outside = false;
+			for (const auto& plane : frustum.Planes)
+			{
+				float distance = cx[i] * plane.x + cy[i] * plane.y + cz[i] * plane.z + plane.w;
+				float radius = ex[i] * std::abs(plane.x) + ey[i] * std::abs(plane.y) + ez[i] * std::abs(plane.z);
+				outside |= distance + radius < 0.f;
+			}
+			outVisible[visibleCount] = i;
+			visibleCount += outside ? 0u : 1u;
+		}
+#endif
+
+		return visibleCount;
+	}
+
+	bool IsSphereVisible(const CullingFrustum& frustum, const DirectX::XMFLOAT3& center, float radius)
+	{
+		for (const auto& plane : frustum.Planes)
+			if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+				return false;
+		return true;
+	}
+
+	void ViewCulling::Cull(const CullingBounds& bounds, JobSystem* jobSystem)
+	{
+		auto cullView = [this, &bounds](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t viewIndex = begin; viewIndex < end; ++viewIndex)
+				{
+					View& view = m_Views[viewIndex];
+					view.Visible.resize(bounds.GetPaddedCount());
+					uint32_t visibleCount = bounds.GetPaddedCount() > 0
+						? CullBounds(bounds, view.Frustum, view.Visible.data())
+						: 0;
+					view.Visible.resize(visibleCount);
+
+					view.Stats.Tested = bounds.GetCount();
+					view.Stats.Visible = visibleCount;
+					view.Stats.Culled = bounds.GetCount() - visibleCount;
+				}
+			};
+
+		uint32_t viewCount = GetViewCount();
+		if (jobSystem)
+			jobSystem->ParallelFor(0, viewCount, 1, cullView);
+		else
+			cullView(0, viewCount);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	class JobSystem;
+
+	// Six normalized planes pointing inwards, a point p is inside when
+	// dot(plane.xyz, p) + plane.w >= 0 for every plane
+	struct CullingFrustum
+	{
+		DirectX::XMFLOAT4 Planes[6];
+
+		// viewProj maps row vectors to D3D clip space (z in [0, 1]), not transposed
+		static CullingFrustum FromViewProjection(const DirectX::XMFLOAT4X4& viewProj);
+	};
+
+	// World space AABBs as center and extents in structure of arrays layout, padded
+	// so the culling kernels can always load full batches. Padding and empty slots
+	// carry negative extents and never pass a plane test.
+	class CullingBounds
+	{
+	public:
+		static constexpr uint32_t BatchSize = 8;
+
+		void Resize(uint32_t count);
+
+		// Transforms a local AABB by a row vector world matrix
+		void Set(uint32_t index, const DirectX::XMFLOAT3& localCenter, const DirectX::XMFLOAT3& localExtents,
+			const DirectX::XMFLOAT4X4& world);
+		void SetEmpty(uint32_t index);
+
+		uint32_t GetCount() const { return m_Count; }
+		uint32_t GetPaddedCount() const { return uint32_t(m_CenterX.size()); }
+
+	private:
+		friend uint32_t CullBounds(const CullingBounds&, const CullingFrustum&, uint32_t*);
+
+		uint32_t m_Count = 0;
+
+		std::vector<float> m_CenterX;
+		std::vector<float> m_CenterY;
+		std::vector<float> m_CenterZ;
+		std::vector<float> m_ExtentX;
+		std::vector<float> m_ExtentY;
+		std::vector<float> m_ExtentZ;
+	};
+
+	struct CullingStats
+	{
+		uint32_t Tested = 0;
+		uint32_t Visible = 0;
+		uint32_t Culled = 0;
+	};
+
+	// Tests every bound against the frustum, 8 at a time with AVX or 4 at a time with SSE,
+	// and writes the indices of the visible ones in ascending order. outVisible must have
+	// room for GetPaddedCount() indices. Returns how many were written.
+	uint32_t CullBounds(const CullingBounds& bounds, const CullingFrustum& frustum, uint32_t* outVisible);
+
+	// Single sphere, false only when it lies fully behind one of the planes
+	bool IsSphereVisible(const CullingFrustum& frustum, const DirectX::XMFLOAT3& center, float radius);
+
+	// Culls one set of bounds against several views (the camera, shadow cascades) and
+	// keeps a compact visible list and counters per view. Views run in parallel.
+	class ViewCulling
+	{
+	public:
+		void SetViewCount(uint32_t viewCount) { m_Views.resize(viewCount); }
+		void SetFrustum(uint32_t view, const CullingFrustum& frustum) { m_Views[view].Frustum = frustum; }
+
+		// jobSystem may be null
+		void Cull(const CullingBounds& bounds, JobSystem* jobSystem);
+
+		uint32_t GetViewCount() const { return uint32_t(m_Views.size()); }
+		// Ascending indices into the culled bounds
+		const std::vector<uint32_t>& GetVisible(uint32_t view) const { return m_Views[view].Visible; }
+		const CullingStats& GetStats(uint32_t view) const { return m_Views[view].Stats; }
+
+	private:
+		struct View
+		{
+			CullingFrustum Frustum{};
+			std::vector<uint32_t> Visible;
+			CullingStats Stats;
+		};
+
+		std::vector<View> m_Views;
+	};
+}
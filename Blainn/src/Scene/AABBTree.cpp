@@ -0,0 +1,394 @@
+#include "pch.h"
+#include "AABBTree.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BLAINN_AABBTREE_SSE
+#endif
+
+namespace Blainn
+{
+	AABBTree::AABBTree(float margin)
+		: m_Margin(margin)
+	{
+	}
+
+	int32_t AABBTree::CreateProxy(const AABB& aabb, EntityHandle userData)
+	{
+		int32_t proxyId = AllocateNode();
+		Node& node = m_Nodes[proxyId];
+		node.Box = AABB::FromCenterExtents(
+			{ (aabb.Min.x + aabb.Max.x) * 0.5f, (aabb.Min.y + aabb.Max.y) * 0.5f, (aabb.Min.z + aabb.Max.z) * 0.5f },
+			{ (aabb.Max.x - aabb.Min.x) * 0.5f + m_Margin, (aabb.Max.y - aabb.Min.y) * 0.5f + m_Margin, (aabb.Max.z - aabb.Min.z) * 0.5f + m_Margin });
+		node.UserData = userData;
+		node.Height = 0;
+
+		InsertLeaf(proxyId);
+		m_ProxyCount++;
+		return proxyId;
+	}
+
+	void AABBTree::DestroyProxy(int32_t proxyId)
+	{
+		assert(m_Nodes[proxyId].IsLeaf() && m_Nodes[proxyId].Height == 0);
+		RemoveLeaf(proxyId);
+		FreeNode(proxyId);
+		m_ProxyCount--;
+	}
+
+	bool AABBTree::MoveProxy(int32_t proxyId, const AABB& aabb, const DirectX::XMFLOAT3& displacement)
+	{
+		Node& node = m_Nodes[proxyId];
+		assert(node.IsLeaf() && node.Height == 0);
+		if (node.Box.Contains(aabb))
+			return false;
+
+		RemoveLeaf(proxyId);
+
+		AABB fat = aabb;
+		fat.Min = { fat.Min.x - m_Margin, fat.Min.y - m_Margin, fat.Min.z - m_Margin };
+		fat.Max = { fat.Max.x + m_Margin, fat.Max.y + m_Margin, fat.Max.z + m_Margin };
+
+		// predict where the proxy is heading
+		constexpr float DisplacementMultiplier = 4.f;
+		float d[3] = { displacement.x * DisplacementMultiplier, displacement.y * DisplacementMultiplier, displacement.z * DisplacementMultiplier };
+		float* mins[3] = { &fat.Min.x, &fat.Min.y, &fat.Min.z };
+		float* maxs[3] = { &fat.Max.x, &fat.Max.y, &fat.Max.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (d[axis] < 0.f)
+				*mins[axis] += d[axis];
+			else
+				*maxs[axis] += d[axis];
+		}
+
+		m_Nodes[proxyId].Box = fat;
+		InsertLeaf(proxyId);
+		return true;
+	}
+
+	float AABBTree::GetAreaRatio() const
+	{
+		if (m_Root == NullNode)
+			return 0.f;
+
+		float rootArea = m_Nodes[m_Root].Box.GetArea();
+		float totalArea = 0.f;
+		for (const Node& node : m_Nodes)
+			if (node.Height >= 0)
+				totalArea += node.Box.GetArea();
+
+		return rootArea > 0.f ? totalArea / rootArea : 0.f;
+	}
+
+	void AABBTree::Validate() const
+	{
+		if (m_Root != NullNode)
+		{
+			assert(m_Nodes[m_Root].Parent == NullNode);
+			ValidateNode(m_Root);
+		}
+
+		uint32_t freeCount = 0;
+		for (int32_t free = m_FreeList; free != NullNode; free = m_Nodes[free].Parent)
+			freeCount++;
+		uint32_t leafCount = 0;
+		for (const Node& node : m_Nodes)
+			if (node.Height == 0)
+				leafCount++;
+
+		assert(leafCount == m_ProxyCount);
+		assert(m_Root == NullNode || freeCount + 2 * m_ProxyCount - 1 == m_Nodes.size());
+		(void)freeCount;
+		(void)leafCount;
+	}
+
+	int32_t AABBTree::AllocateNode()
+	{
+		if (m_FreeList == NullNode)
+		{
+			m_Nodes.emplace_back();
+			return int32_t(m_Nodes.size() - 1);
+		}
+
+		int32_t nodeId = m_FreeList;
+		m_FreeList = m_Nodes[nodeId].Parent;
+		m_Nodes[nodeId] = Node{};
+		return nodeId;
+	}
+
+	void AABBTree::FreeNode(int32_t nodeId)
+	{
+		Node& node = m_Nodes[nodeId];
+		node.Parent = m_FreeList;
+		node.Height = -1;
+		m_FreeList = nodeId;
+	}
+
+	void AABBTree::InsertLeaf(int32_t leaf)
+	{
+		if (m_Root == NullNode)
+		{
+			m_Root = leaf;
+			m_Nodes[leaf].Parent = NullNode;
+			return;
+		}
+
+		// descend towards the sibling that grows the total area the least
+		const AABB leafBox = m_Nodes[leaf].Box;
+		int32_t index = m_Root;
+		while (!m_Nodes[index].IsLeaf())
+		{
+			const Node& node = m_Nodes[index];
+
+			float area = node.Box.GetArea();
+			float combinedArea = AABB::Combine(node.Box, leafBox).GetArea();
+
+			// pairing with this node creates a parent of combinedArea, descending pushes
+			// the growth onto every ancestor
+			float cost = 2.f * combinedArea;
+			float inheritanceCost = 2.f * (combinedArea - area);
+
+			auto descendCost = [&](int32_t childId)
+				{
+					const Node& child = m_Nodes[childId];
+					float grownArea = AABB::Combine(leafBox, child.Box).GetArea();
+					return child.IsLeaf()
+						? grownArea + inheritanceCost
+						: grownArea - child.Box.GetArea() + inheritanceCost;
+				};
+
+			float cost1 = descendCost(node.Child1);
+			float cost2 = descendCost(node.Child2);
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? node.Child1 : node.Child2;
+		}
+
+		int32_t sibling = index;
+		int32_t oldParent = m_Nodes[sibling].Parent;
+
+		int32_t newParent = AllocateNode();
+		Node& parentNode = m_Nodes[newParent];
+		parentNode.Parent = oldParent;
+		parentNode.Box = AABB::Combine(leafBox, m_Nodes[sibling].Box);
+		parentNode.Height = m_Nodes[sibling].Height + 1;
+		parentNode.Child1 = sibling;
+		parentNode.Child2 = leaf;
+		m_Nodes[sibling].Parent = newParent;
+		m_Nodes[leaf].Parent = newParent;
+
+		if (oldParent == NullNode)
+			m_Root = newParent;
+		else if (m_Nodes[oldParent].Child1 == sibling)
+			m_Nodes[oldParent].Child1 = newParent;
+		else
+			m_Nodes[oldParent].Child2 = newParent;
+
+		// refit and rebalance the ancestors
+		for (index = m_Nodes[leaf].Parent; index != NullNode; index = m_Nodes[index].Parent)
+		{
+			index = Balance(index);
+
+			Node& node = m_Nodes[index];
+			node.Height = 1 + std::max(m_Nodes[node.Child1].Height, m_Nodes[node.Child2].Height);
+			node.Box = AABB::Combine(m_Nodes[node.Child1].Box, m_Nodes[node.Child2].Box);
+		}
+	}
+
+	void AABBTree::RemoveLeaf(int32_t leaf)
+	{
+		if (leaf == m_Root)
+		{
+			m_Root = NullNode;
+			return;
+		}
+
+		int32_t parent = m_Nodes[leaf].Parent;
+		int32_t grandParent = m_Nodes[parent].Parent;
+		int32_t sibling = m_Nodes[parent].Child1 == leaf ? m_Nodes[parent].Child2 : m_Nodes[parent].Child1;
+
+		FreeNode(parent);
+		if (grandParent == NullNode)
+		{
+			m_Root = sibling;
+			m_Nodes[sibling].Parent = NullNode;
+			return;
+		}
+
+		// the sibling takes the parent's place
+		if (m_Nodes[grandParent].Child1 == parent)
+			m_Nodes[grandParent].Child1 = sibling;
+		else
+			m_Nodes[grandParent].Child2 = sibling;
+		m_Nodes[sibling].Parent = grandParent;
+
+		for (int32_t index = grandParent; index != NullNode; index = m_Nodes[index].Parent)
+		{
+			index = Balance(index);
+
+			Node& node = m_Nodes[index];
+			node.Box = AABB::Combine(m_Nodes[node.Child1].Box, m_Nodes[node.Child2].Box);
+			node.Height = 1 + std::max(m_Nodes[node.Child1].Height, m_Nodes[node.Child2].Height);
+		}
+	}
+
+	// Rotates the taller child of A up when the children of A differ in height by more
+	// than one. Returns the node now sitting where A was.
+	int32_t AABBTree::Balance(int32_t iA)
+	{
+		Node& A = m_Nodes[iA];
+		if (A.IsLeaf() || A.Height < 2)
+			return iA;
+
+		int32_t iB = A.Child1;
+		int32_t iC = A.Child2;
+		Node& B = m_Nodes[iB];
+		Node& C = m_Nodes[iC];
+
+		int32_t balance = C.Height - B.Height;
+
+		// C is lifted, one of its children is handed down to A
+		auto rotateUp = [this, iA](int32_t iLift, int32_t iStay)
+			{
+				Node& A = m_Nodes[iA];
+				Node& lifted = m_Nodes[iLift];
+				Node& stay = m_Nodes[iStay];
+
+				int32_t iF = lifted.Child1;
+				int32_t iG = lifted.Child2;
+				Node& F = m_Nodes[iF];
+				Node& G = m_Nodes[iG];
+
+				lifted.Child1 = iA;
+				lifted.Parent = A.Parent;
+				A.Parent = iLift;
+
+				if (lifted.Parent == NullNode)
+					m_Root = iLift;
+				else if (m_Nodes[lifted.Parent].Child1 == iA)
+					m_Nodes[lifted.Parent].Child1 = iLift;
+				else
+					m_Nodes[lifted.Parent].Child2 = iLift;
+
+				// keep the taller grandchild up with the lifted node
+				int32_t iKeep = F.Height > G.Height ? iF : iG;
+				int32_t iGive = F.Height > G.Height ? iG : iF;
+				Node& keep = m_Nodes[iKeep];
+				Node& give = m_Nodes[iGive];
+
+				lifted.Child2 = iKeep;
+				if (A.Child1 == iLift)
+					A.Child1 = iGive;
+				else
+					A.Child2 = iGive;
+				give.Parent = iA;
+
+				A.Box = AABB::Combine(stay.Box, give.Box);
+				lifted.Box = AABB::Combine(A.Box, keep.Box);
+
+				A.Height = 1 + std::max(stay.Height, give.Height);
+				lifted.Height = 1 + std::max(A.Height, keep.Height);
+				return iLift;
+			};
+
+		if (balance > 1)
+			return rotateUp(iC, iB);
+		if (balance < -1)
+			return rotateUp(iB, iC);
+		return iA;
+	}
+
+	void AABBTree::ValidateNode(int32_t nodeId) const
+	{
+		const Node& node = m_Nodes[nodeId];
+		if (node.IsLeaf())
+		{
+			assert(node.Height == 0);
+			return;
+		}
+
+		const Node& child1 = m_Nodes[node.Child1];
+		const Node& child2 = m_Nodes[node.Child2];
+		assert(child1.Parent == nodeId && child2.Parent == nodeId);
+		assert(node.Height == 1 + std::max(child1.Height, child2.Height));
+		assert(node.Box.Contains(child1.Box) && node.Box.Contains(child2.Box));
+		(void)child1;
+		(void)child2;
+
+		ValidateNode(node.Child1);
+		ValidateNode(node.Child2);
+	}
+
+	DirectX::XMFLOAT3 AABBTree::GetInverseDirection(const DirectX::XMFLOAT3& direction)
+	{
+		// a zero component would turn the slab test into 0 * inf
+		auto inverse = [](float value) { return 1.f / (value != 0.f ? value : 1e-30f); };
+		return { inverse(direction.x), inverse(direction.y), inverse(direction.z) };
+	}
+
+	bool AABBTree::RayHitsAABB(const AABBTreeRay& ray, const DirectX::XMFLOAT3& inv, const AABB& box)
+	{
+		float tx1 = (box.Min.x - ray.Origin.x) * inv.x, tx2 = (box.Max.x - ray.Origin.x) * inv.x;
+		float ty1 = (box.Min.y - ray.Origin.y) * inv.y, ty2 = (box.Max.y - ray.Origin.y) * inv.y;
+		float tz1 = (box.Min.z - ray.Origin.z) * inv.z, tz2 = (box.Max.z - ray.Origin.z) * inv.z;
+
+		float tMin = std::max({ std::min(tx1, tx2), std::min(ty1, ty2), std::min(tz1, tz2), 0.f });
+		float tMax = std::min({ std::max(tx1, tx2), std::max(ty1, ty2), std::max(tz1, tz2), ray.MaxDistance });
+		return tMin <= tMax;
+	}
+
+	void AABBTree::FillRayPacket(RayPacket& packet, const AABBTreeRay* rays, uint32_t count)
+	{
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			// unused lanes repeat the first ray and stay masked out
+			const AABBTreeRay& ray = rays[lane < count ? lane : 0];
+			DirectX::XMFLOAT3 inv = GetInverseDirection(ray.Direction);
+			packet.OriginX[lane] = ray.Origin.x;
+			packet.OriginY[lane] = ray.Origin.y;
+			packet.OriginZ[lane] = ray.Origin.z;
+			packet.InvDirX[lane] = inv.x;
+			packet.InvDirY[lane] = inv.y;
+			packet.InvDirZ[lane] = inv.z;
+			packet.MaxDistance[lane] = ray.MaxDistance;
+		}
+	}
+
+	uint32_t AABBTree::TestRayPacket(const RayPacket& packet, uint32_t activeMask, const AABB& box)
+	{
+#if defined(BLAINN_AABBTREE_SSE)
+		__m128 ox = _mm_load_ps(packet.OriginX), oy = _mm_load_ps(packet.OriginY), oz = _mm_load_ps(packet.OriginZ);
+		__m128 ix = _mm_load_ps(packet.InvDirX), iy = _mm_load_ps(packet.InvDirY), iz = _mm_load_ps(packet.InvDirZ);
+
+		__m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.Min.x), ox), ix);
+		__m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.Max.x), ox), ix);
+		__m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.Min.y), oy), iy);
+		__m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.Max.y), oy), iy);
+		__m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.Min.z), oz), iz);
+		__m128 tz2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.Max.z), oz), iz);
+
+		__m128 tMin = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)),
+			_mm_max_ps(_mm_min_ps(tz1, tz2), _mm_setzero_ps()));
+		__m128 tMax = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)),
+			_mm_min_ps(_mm_max_ps(tz1, tz2), _mm_load_ps(packet.MaxDistance)));
+
+		return uint32_t(_mm_movemask_ps(_mm_cmple_ps(tMin, tMax))) & activeMask;
+#else
+		uint32_t hitMask = 0;
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			AABBTreeRay ray;
+			ray.Origin = { packet.OriginX[lane], packet.OriginY[lane], packet.OriginZ[lane] };
+			ray.MaxDistance = packet.MaxDistance[lane];
+			DirectX::XMFLOAT3 inv = { packet.InvDirX[lane], packet.InvDirY[lane], packet.InvDirZ[lane] };
+			if (RayHitsAABB(ray, inv, box))
+				hitMask |= 1u << lane;
+		}
+		return hitMask & activeMask;
+#endif
+	}
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+#include "Core/EntityRegistry.h"
+#include "Render/ViewCulling.h"
+
+#include <DirectXMath.h>
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	struct AABB
+	{
+		DirectX::XMFLOAT3 Min{ 0.f, 0.f, 0.f };
+		DirectX::XMFLOAT3 Max{ 0.f, 0.f, 0.f };
+
+		bool Contains(const AABB& other) const
+		{
+			return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z
+				&& other.Max.x <= Max.x && other.Max.y <= Max.y && other.Max.z <= Max.z;
+		}
+		bool Overlaps(const AABB& other) const
+		{
+			return Min.x <= other.Max.x && other.Min.x <= Max.x
+				&& Min.y <= other.Max.y && other.Min.y <= Max.y
+				&& Min.z <= other.Max.z && other.Min.z <= Max.z;
+		}
+		// Half the surface area, only ever compared against other areas
+		float GetArea() const
+		{
+			float dx = Max.x - Min.x, dy = Max.y - Min.y, dz = Max.z - Min.z;
+			return dx * dy + dy * dz + dz * dx;
+		}
+
+		static AABB Combine(const AABB& a, const AABB& b)
+		{
+			return {
+				{ std::fmin(a.Min.x, b.Min.x), std::fmin(a.Min.y, b.Min.y), std::fmin(a.Min.z, b.Min.z) },
+				{ std::fmax(a.Max.x, b.Max.x), std::fmax(a.Max.y, b.Max.y), std::fmax(a.Max.z, b.Max.z) } };
+		}
+		static AABB FromCenterExtents(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents)
+		{
+			return {
+				{ center.x - extents.x, center.y - extents.y, center.z - extents.z },
+				{ center.x + extents.x, center.y + extents.y, center.z + extents.z } };
+		}
+	};
+
+	struct AABBTreeRay
+	{
+		DirectX::XMFLOAT3 Origin{ 0.f, 0.f, 0.f };
+		// Does not need to be normalized, distances are in multiples of it
+		DirectX::XMFLOAT3 Direction{ 0.f, 0.f, 1.f };
+		float MaxDistance = FLT_MAX;
+	};
+
+	// Dynamic bounding volume hierarchy over fat AABBs, after Box2D's b2DynamicTree.
+	// Proxies are leaves whose AABB is enlarged by a margin, so small moves do not touch
+	// the tree at all. Leaves that leave their fat AABB are removed and reinserted with
+	// a surface area heuristic, and every ancestor is refitted and rebalanced with AVL
+	// style rotations on the way back up.
+	//
+	// Queries take a callback and never allocate. AABB, sphere and frustum callbacks
+	// receive a proxy id and return false to stop. Ray callbacks receive the clipped ray
+	// and the proxy id and return a distance: 0 stops, a negative value skips the proxy,
+	// anything else becomes the ray's new MaxDistance. RayCastBatch tests four rays
+	// against a node at once with SSE.
+	class AABBTree
+	{
+	public:
+		static constexpr int32_t NullNode = -1;
+		static constexpr uint32_t MaxStackDepth = 256;
+
+		explicit AABBTree(float margin = 0.1f);
+
+		int32_t CreateProxy(const AABB& aabb, EntityHandle userData);
+		void DestroyProxy(int32_t proxyId);
+		// Returns true when the proxy left its fat AABB and was reinserted. The fat AABB
+		// is stretched along displacement so steadily moving proxies reinsert less often.
+		bool MoveProxy(int32_t proxyId, const AABB& aabb, const DirectX::XMFLOAT3& displacement = { 0.f, 0.f, 0.f });
+
+		const AABB& GetFatAABB(int32_t proxyId) const { return m_Nodes[proxyId].Box; }
+		EntityHandle GetUserData(int32_t proxyId) const { return m_Nodes[proxyId].UserData; }
+
+		template<typename Fn>
+		void QueryAABB(const AABB& aabb, Fn&& callback) const;
+		template<typename Fn>
+		void QuerySphere(const DirectX::XMFLOAT3& center, float radius, Fn&& callback) const;
+		template<typename Fn>
+		void QueryFrustum(const CullingFrustum& frustum, Fn&& callback) const;
+
+		template<typename Fn>
+		void RayCast(const AABBTreeRay& ray, Fn&& callback) const;
+		// callback(rayIndex, clippedRay, proxyId), same return values as RayCast
+		template<typename Fn>
+		void RayCastBatch(const AABBTreeRay* rays, uint32_t rayCount, Fn&& callback) const;
+
+		uint32_t GetProxyCount() const { return m_ProxyCount; }
+		int32_t GetHeight() const { return m_Root == NullNode ? 0 : m_Nodes[m_Root].Height; }
+		// Sum of all node areas over the root area, a measure of tree quality
+		float GetAreaRatio() const;
+		// Asserts the structure, parent links, heights and bounds are consistent
+		void Validate() const;
+
+	private:
+		struct Node
+		{
+			AABB Box;
+			// Next free node while the node is on the free list
+			int32_t Parent = NullNode;
+			int32_t Child1 = NullNode;
+			int32_t Child2 = NullNode;
+			// 0 for leaves, -1 for free nodes
+			int32_t Height = -1;
+			EntityHandle UserData{};
+
+			bool IsLeaf() const { return Child1 == NullNode; }
+		};
+
+		// Four rays in SoA layout, inverse directions precomputed
+		struct alignas(16) RayPacket
+		{
+			float OriginX[4], OriginY[4], OriginZ[4];
+			float InvDirX[4], InvDirY[4], InvDirZ[4];
+			float MaxDistance[4];
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t node);
+
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+		int32_t Balance(int32_t node);
+
+		void ValidateNode(int32_t node) const;
+
+		static bool RayHitsAABB(const AABBTreeRay& ray, const DirectX::XMFLOAT3& invDirection, const AABB& box);
+		static DirectX::XMFLOAT3 GetInverseDirection(const DirectX::XMFLOAT3& direction);
+		static void FillRayPacket(RayPacket& packet, const AABBTreeRay* rays, uint32_t count);
+		// Bit i is set when active lane i hits the box within its MaxDistance
+		static uint32_t TestRayPacket(const RayPacket& packet, uint32_t activeMask, const AABB& box);
+
+	private:
+		std::vector<Node> m_Nodes;
+		int32_t m_Root = NullNode;
+		int32_t m_FreeList = NullNode;
+		uint32_t m_ProxyCount = 0;
+
+		float m_Margin;
+	};
+
+	template<typename Fn>
+	void AABBTree::QueryAABB(const AABB& aabb, Fn&& callback) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		int32_t stack[MaxStackDepth];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = m_Root;
+		while (stackSize > 0)
+		{
+			const Node& node = m_Nodes[stack[--stackSize]];
+			if (!node.Box.Overlaps(aabb))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				if (!callback(int32_t(&node - m_Nodes.data())))
+					return;
+				continue;
+			}
+
+			assert(stackSize + 2 <= MaxStackDepth);
+			stack[stackSize++] = node.Child1;
+			stack[stackSize++] = node.Child2;
+		}
+	}
+
+	template<typename Fn>
+	void AABBTree::QuerySphere(const DirectX::XMFLOAT3& center, float radius, Fn&& callback) const
+	{
+		float radiusSq = radius * radius;
+		AABB bounds = AABB::FromCenterExtents(center, { radius, radius, radius });
+		QueryAABB(bounds, [&](int32_t proxyId)
+			{
+				// closest point of the box to the center
+				const AABB& box = m_Nodes[proxyId].Box;
+				float dx = center.x - std::fmax(box.Min.x, std::fmin(center.x, box.Max.x));
+				float dy = center.y - std::fmax(box.Min.y, std::fmin(center.y, box.Max.y));
+				float dz = center.z - std::fmax(box.Min.z, std::fmin(center.z, box.Max.z));
+				if (dx * dx + dy * dy + dz * dz > radiusSq)
+					return true;
+				return bool(callback(proxyId));
+			});
+	}
+
+	template<typename Fn>
+	void AABBTree::QueryFrustum(const CullingFrustum& frustum, Fn&& callback) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		// the high bit marks subtrees already known to be fully inside
+		constexpr uint32_t InsideBit = 0x80000000u;
+
+		uint32_t stack[MaxStackDepth];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = uint32_t(m_Root);
+		while (stackSize > 0)
+		{
+			uint32_t entry = stack[--stackSize];
+			const Node& node = m_Nodes[entry & ~InsideBit];
+			bool inside = (entry & InsideBit) != 0;
+
+			if (!inside)
+			{
+				float cx = (node.Box.Min.x + node.Box.Max.x) * 0.5f, ex = (node.Box.Max.x - node.Box.Min.x) * 0.5f;
+				float cy = (node.Box.Min.y + node.Box.Max.y) * 0.5f, ey = (node.Box.Max.y - node.Box.Min.y) * 0.5f;
+				float cz = (node.Box.Min.z + node.Box.Max.z) * 0.5f, ez = (node.Box.Max.z - node.Box.Min.z) * 0.5f;
+
+				bool outside = false;
+				inside = true;
+				for (const auto& plane : frustum.Planes)
+				{
+					float distance = cx * plane.x + cy * plane.y + cz * plane.z + plane.w;
+					float radius = ex * std::abs(plane.x) + ey * std::abs(plane.y) + ez * std::abs(plane.z);
+					if (distance + radius < 0.f)
+					{
+						outside = true;
+						break;
+					}
+					inside &= distance - radius >= 0.f;
+				}
+				if (outside)
+					continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				if (!callback(int32_t(entry & ~InsideBit)))
+					return;
+				continue;
+			}
+
+			assert(stackSize + 2 <= MaxStackDepth);
+			uint32_t flag = inside ? InsideBit : 0u;
+			stack[stackSize++] = uint32_t(node.Child1) | flag;
+			stack[stackSize++] = uint32_t(node.Child2) | flag;
+		}
+	}
+
+	template<typename Fn>
+	void AABBTree::RayCast(const AABBTreeRay& ray, Fn&& callback) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		AABBTreeRay clipped = ray;
+		DirectX::XMFLOAT3 invDirection = GetInverseDirection(ray.Direction);
+
+		int32_t stack[MaxStackDepth];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = m_Root;
+		while (stackSize > 0)
+		{
+			int32_t nodeId = stack[--stackSize];
+			const Node& node = m_Nodes[nodeId];
+			if (!RayHitsAABB(clipped, invDirection, node.Box))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				float distance = callback(static_cast<const AABBTreeRay&>(clipped), nodeId);
+				if (distance == 0.f)
+					return;
+				if (distance > 0.f && distance < clipped.MaxDistance)
+					clipped.MaxDistance = distance;
+				continue;
+			}
+
+			assert(stackSize + 2 <= MaxStackDepth);
+			stack[stackSize++] = node.Child1;
+			stack[stackSize++] = node.Child2;
+		}
+	}
+
+	template<typename Fn>
+	void AABBTree::RayCastBatch(const AABBTreeRay* rays, uint32_t rayCount, Fn&& callback) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		for (uint32_t first = 0; first < rayCount; first += 4)
+		{
+			uint32_t laneCount = rayCount - first < 4 ? rayCount - first : 4;
+
+			RayPacket packet;
+			FillRayPacket(packet, rays + first, laneCount);
+			AABBTreeRay clipped[4];
+			for (uint32_t lane = 0; lane < laneCount; ++lane)
+				clipped[lane] = rays[first + lane];
+
+			uint32_t activeMask = (1u << laneCount) - 1;
+
+			int32_t stack[MaxStackDepth];
+			uint32_t stackSize = 0;
+			stack[stackSize++] = m_Root;
+			while (stackSize > 0 && activeMask != 0)
+			{
+				int32_t nodeId = stack[--stackSize];
+				const Node& node = m_Nodes[nodeId];
+				uint32_t hitMask = TestRayPacket(packet, activeMask, node.Box);
+				if (hitMask == 0)
+					continue;
+
+				if (!node.IsLeaf())
+				{
+					assert(stackSize + 2 <= MaxStackDepth);
+					stack[stackSize++] = node.Child1;
+					stack[stackSize++] = node.Child2;
+					continue;
+				}
+
+				for (uint32_t lane = 0; lane < laneCount; ++lane)
+				{
+					if ((hitMask & (1u << lane)) == 0)
+						continue;
+
+					float distance = callback(first + lane, static_cast<const AABBTreeRay&>(clipped[lane]), nodeId);
+					if (distance == 0.f)
+						activeMask &= ~(1u << lane);
+					else if (distance > 0.f && distance < clipped[lane].MaxDistance)
+					{
+						clipped[lane].MaxDistance = distance;
+						packet.MaxDistance[lane] = distance;
+					}
+				}
+			}
+		}
+	}
+}
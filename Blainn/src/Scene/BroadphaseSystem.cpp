@@ -0,0 +1,97 @@
+#include "pch.h"
+#include "BroadphaseSystem.h"
+
+#include "Components/ActorComponents/PhysicsComponents/CollisionComponent.h"
+
+namespace Blainn
+{
+	static AABB GetCollisionAABB(const CollisionComponent& collision)
+	{
+		// fast colliders cover the whole way they moved
+		DirectX::BoundingBox bounds = collision.IsContinuous() ? collision.GetSweptBounds() : collision.GetBounds();
+		return AABB::FromCenterExtents(bounds.Center, bounds.Extents);
+	}
+
+	BroadphaseSystem::BroadphaseSystem()
+		: System("Broadphase")
+	{
+		Reads<CollisionComponent>();
+	}
+
+	void BroadphaseSystem::OnUpdate(const GameTimer& gt, JobSystem* jobSystem)
+	{
+		auto& componentManager = GetComponentManager();
+
+		// shapes can grow without moving, so every proxy gets its bounds refreshed
+		for (uint32_t i = uint32_t(m_Tracked.size()); i-- > 0;)
+		{
+			CollisionComponent* collision = componentManager.GetComponentPtr<CollisionComponent>(m_Tracked[i].Collision);
+			if (!collision)
+			{
+				Untrack(i);
+				continue;
+			}
+			m_SweepAndPrune.MoveProxy(m_Tracked[i].Proxy, GetCollisionAABB(*collision));
+			m_SweepAndPrune.SetFilter(m_Tracked[i].Proxy, GetFilter(*collision));
+		}
+
+		uint64_t collisionSetVersion = componentManager.GetComponentSetVersion<CollisionComponent>();
+		if (collisionSetVersion != m_CollisionSetVersion)
+		{
+			TrackNewCollisions();
+			m_CollisionSetVersion = collisionSetVersion;
+		}
+
+		m_SweepAndPrune.UpdatePairs(jobSystem);
+		SetComponentTicks(m_SweepAndPrune.GetProxyCount());
+	}
+
+	void BroadphaseSystem::TrackNewCollisions()
+	{
+		for (const auto& collision : GetComponentManager().GetComponents<CollisionComponent>())
+		{
+			ComponentHandle handle = collision->GetStorageHandle();
+			if (handle.Index < m_TrackedBySlot.size())
+			{
+				uint32_t trackedIndex = m_TrackedBySlot[handle.Index];
+				if (trackedIndex != UINT32_MAX && m_Tracked[trackedIndex].Collision == handle)
+					continue;
+			}
+			else
+			{
+				m_TrackedBySlot.resize(handle.Index + 1, UINT32_MAX);
+			}
+
+			TrackedCollision tracked;
+			tracked.Collision = handle;
+			tracked.Proxy = m_SweepAndPrune.CreateProxy(GetCollisionAABB(*collision), handle, GetFilter(*collision));
+
+			m_TrackedBySlot[handle.Index] = uint32_t(m_Tracked.size());
+			m_Tracked.push_back(tracked);
+		}
+	}
+
+	CollisionFilter BroadphaseSystem::GetFilter(const CollisionComponent& collision) const
+	{
+		CollisionFilter filter;
+		filter.LayerBit = 1u << collision.GetCollisionLayer();
+		filter.Mask = collision.GetCollisionMask();
+		if (m_LayerMatrix)
+			filter.Mask &= m_LayerMatrix->GetRow(collision.GetCollisionLayer());
+		return filter;
+	}
+
+	void BroadphaseSystem::Untrack(uint32_t trackedIndex)
+	{
+		TrackedCollision& tracked = m_Tracked[trackedIndex];
+		m_SweepAndPrune.DestroyProxy(tracked.Proxy);
+		m_TrackedBySlot[tracked.Collision.Index] = UINT32_MAX;
+
+		if (trackedIndex != m_Tracked.size() - 1)
+		{
+			tracked = m_Tracked.back();
+			m_TrackedBySlot[tracked.Collision.Index] = trackedIndex;
+		}
+		m_Tracked.pop_back();
+	}
+}
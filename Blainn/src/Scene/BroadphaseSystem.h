@@ -0,0 +1,52 @@
+#pragma once
+
+#include "SweepAndPrune.h"
+#include "System.h"
+
+#include <vector>
+
+namespace Blainn
+{
+	class CollisionComponent;
+
+	// Keeps one sweep and prune proxy per CollisionComponent, refreshed from the
+	// shape bounds every update, and leaves the overlapping pairs for the scene's
+	// narrowphase. Runs after the collision shapes followed their transforms.
+	// Pairs whose layers do not collide are dropped by the sweep itself.
+	class BroadphaseSystem : public System
+	{
+	public:
+		BroadphaseSystem();
+
+		void OnUpdate(const GameTimer& gt, JobSystem* jobSystem) override;
+
+		// Layer matrix the collider masks are narrowed by, all layers collide without one
+		void SetLayerMatrix(const CollisionLayerMatrix* layerMatrix) { m_LayerMatrix = layerMatrix; }
+
+		const SweepAndPrune& GetSweepAndPrune() const { return m_SweepAndPrune; }
+		// Pairs whose bounds overlapped in the last update
+		const std::vector<BroadphasePair>& GetPairs() const { return m_SweepAndPrune.GetPairs(); }
+		ComponentHandle GetCollision(uint32_t proxyId) const { return m_SweepAndPrune.GetUserData(proxyId); }
+
+	private:
+		struct TrackedCollision
+		{
+			ComponentHandle Collision;
+			uint32_t Proxy = SweepAndPrune::NullProxy;
+		};
+
+		void TrackNewCollisions();
+		void Untrack(uint32_t trackedIndex);
+		CollisionFilter GetFilter(const CollisionComponent& collision) const;
+
+	private:
+		SweepAndPrune m_SweepAndPrune;
+		const CollisionLayerMatrix* m_LayerMatrix = nullptr;
+
+		std::vector<TrackedCollision> m_Tracked;
+		// Indexed by ComponentHandle::Index, holds an index into m_Tracked
+		std::vector<uint32_t> m_TrackedBySlot;
+
+		uint64_t m_CollisionSetVersion = UINT64_MAX;
+	};
+}
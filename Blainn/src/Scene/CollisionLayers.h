@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+namespace Blainn
+{
+	static constexpr uint32_t MaxCollisionLayers = 32;
+
+	// What the broadphase checks before a pair of overlapping boxes becomes a
+	// candidate. Both sides have to accept each other.
+	struct CollisionFilter
+	{
+		// Bit of the collider's own layer
+		uint32_t LayerBit = 1u;
+		// Layers it collides with, already narrowed by the scene's layer matrix
+		uint32_t Mask = UINT32_MAX;
+
+		bool Accepts(const CollisionFilter& other) const
+		{
+			return (LayerBit & other.Mask) != 0 && (other.LayerBit & Mask) != 0;
+		}
+	};
+
+	// Symmetric layer against layer table, every layer collides with every layer
+	// until told otherwise
+	class CollisionLayerMatrix
+	{
+	public:
+		CollisionLayerMatrix()
+		{
+			for (uint32_t& row : m_Rows)
+				row = UINT32_MAX;
+		}
+
+		void SetLayersCollide(uint32_t layerA, uint32_t layerB, bool bCollide)
+		{
+			assert(layerA < MaxCollisionLayers && layerB < MaxCollisionLayers);
+			if (bCollide)
+			{
+				m_Rows[layerA] |= 1u << layerB;
+				m_Rows[layerB] |= 1u << layerA;
+			}
+			else
+			{
+				m_Rows[layerA] &= ~(1u << layerB);
+				m_Rows[layerB] &= ~(1u << layerA);
+			}
+		}
+
+		bool DoLayersCollide(uint32_t layerA, uint32_t layerB) const { return (m_Rows[layerA] >> layerB) & 1u; }
+		// Layers that layer collides with, as a mask
+		uint32_t GetRow(uint32_t layer) const { return m_Rows[layer]; }
+
+	private:
+		uint32_t m_Rows[MaxCollisionLayers];
+	};
+}
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "ContactCache.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Blainn
+{
+	bool ContactCache::IsLess(const ContactPair& a, const ContactPair& b)
+	{
+		uint64_t keyA = GetHandleKey(a.CollisionA), keyB = GetHandleKey(b.CollisionA);
+		if (keyA != keyB)
+			return keyA < keyB;
+		return GetHandleKey(a.CollisionB) < GetHandleKey(b.CollisionB);
+	}
+
+	void ContactCache::Update(std::vector<ContactPair>& touching)
+	{
+		for (ContactPair& pair : touching)
+			if (GetHandleKey(pair.CollisionB) < GetHandleKey(pair.CollisionA))
+				std::swap(pair.CollisionA, pair.CollisionB);
+		std::sort(touching.begin(), touching.end(), IsLess);
+
+		std::swap(m_PreviousContacts, m_Contacts);
+		m_Contacts.assign(touching.begin(), touching.end());
+
+		m_Events.clear();
+		m_BeginCount = 0;
+		m_EndCount = 0;
+
+		// Ends go out first, a handler reacting to a Begin then sees every pair that
+		// stopped touching as already gone
+		size_t current = 0;
+		for (const ContactPair& pair : m_PreviousContacts)
+		{
+			while (current < m_Contacts.size() && IsLess(m_Contacts[current], pair))
+				current++;
+
+			if (current == m_Contacts.size() || IsLess(pair, m_Contacts[current]))
+			{
+				m_Events.push_back({ ContactEventType::End, pair.CollisionA, pair.CollisionB });
+				m_EndCount++;
+			}
+		}
+
+		size_t previous = 0;
+		size_t firstContact = m_Events.size();
+		bool bHasSwept = false;
+		for (const ContactPair& pair : m_Contacts)
+		{
+			while (previous < m_PreviousContacts.size() && IsLess(m_PreviousContacts[previous], pair))
+				previous++;
+
+			bool bWasTouching = previous < m_PreviousContacts.size() && !IsLess(pair, m_PreviousContacts[previous]);
+			m_Events.push_back({ bWasTouching ? ContactEventType::Stay : ContactEventType::Begin, pair.CollisionA, pair.CollisionB, pair.TimeOfImpact });
+			if (!bWasTouching)
+				m_BeginCount++;
+			bHasSwept |= pair.TimeOfImpact < 1.f;
+		}
+
+		// swept contacts go out in the order they happened during the step
+		if (bHasSwept)
+		{
+			std::stable_sort(m_Events.begin() + firstContact, m_Events.end(),
+				[](const ContactEvent& a, const ContactEvent& b) { return a.TimeOfImpact < b.TimeOfImpact; });
+		}
+	}
+}
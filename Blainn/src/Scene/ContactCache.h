@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Components/ComponentManager.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	enum class ContactEventType : uint8_t
+	{
+		Begin,
+		Stay,
+		End
+	};
+
+	struct ContactPair
+	{
+		ComponentHandle CollisionA;
+		ComponentHandle CollisionB;
+		// Fraction of the step at which the pair started touching, 1 unless swept
+		float TimeOfImpact = 1.f;
+	};
+
+	struct ContactEvent
+	{
+		ContactEventType Type;
+		ComponentHandle CollisionA;
+		ComponentHandle CollisionB;
+		float TimeOfImpact = 1.f;
+	};
+
+	// Remembers which collider pairs touched in the last step and turns the touching
+	// pairs of the next step into Begin, Stay and End events. Both lists are kept
+	// sorted by pair key, so the diff is one merge walk without any hashing.
+	class ContactCache
+	{
+	public:
+		// touching is reordered, the order of the two handles inside a pair does not matter
+		void Update(std::vector<ContactPair>& touching);
+
+		// Events of the last Update, Ends first, then Begins and Stays by time of impact
+		// and in pair order among equal times
+		const std::vector<ContactEvent>& GetEvents() const { return m_Events; }
+		const std::vector<ContactPair>& GetContacts() const { return m_Contacts; }
+
+		uint32_t GetBeginCount() const { return m_BeginCount; }
+		uint32_t GetEndCount() const { return m_EndCount; }
+
+	private:
+		static uint64_t GetHandleKey(ComponentHandle handle) { return (uint64_t(handle.Index) << 32) | handle.Generation; }
+		static bool IsLess(const ContactPair& a, const ContactPair& b);
+
+	private:
+		std::vector<ContactPair> m_Contacts;
+		std::vector<ContactPair> m_PreviousContacts;
+		std::vector<ContactEvent> m_Events;
+
+		uint32_t m_BeginCount = 0;
+		uint32_t m_EndCount = 0;
+	};
+}
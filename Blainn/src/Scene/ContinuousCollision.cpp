@@ -0,0 +1,321 @@
+#include "pch.h"
+#include "ContinuousCollision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Blainn
+{
+	using DirectX::XMFLOAT3;
+	using DirectX::XMFLOAT4;
+
+	static constexpr float SweepEpsilon = 1e-8f;
+	// Bounding box walks of non-sphere pairs never take more steps than this
+	static constexpr int MaxSweepSteps = 64;
+	// Walk step as a fraction of the thinner shape's half size
+	static constexpr float SweepStepScale = 0.25f;
+	static constexpr int BisectionSteps = 6;
+
+	static float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	static XMFLOAT3 Add(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	static XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	static XMFLOAT3 Scale(const XMFLOAT3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	static XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	static float GetAxis(const XMFLOAT3& v, int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+	static XMFLOAT3 Rotate(const XMFLOAT4& q, const XMFLOAT3& v)
+	{
+		// v + 2w (q x v) + 2 q x (q x v)
+		XMFLOAT3 axis{ q.x, q.y, q.z };
+		XMFLOAT3 t = Scale(Cross(axis, v), 2.f);
+		XMFLOAT3 u = Cross(axis, t);
+		return { v.x + q.w * t.x + u.x, v.y + q.w * t.y + u.y, v.z + q.w * t.z + u.z };
+	}
+
+	// The queries below trace origin + t * direction for t in [0, 1]
+
+	static bool RaySphere(const XMFLOAT3& origin, const XMFLOAT3& direction, const XMFLOAT3& center, float radius, float& outTime)
+	{
+		XMFLOAT3 m = Sub(origin, center);
+		float c = Dot(m, m) - radius * radius;
+		if (c <= 0.f)
+		{
+			outTime = 0.f;
+			return true;
+		}
+
+		float a = Dot(direction, direction);
+		float b = Dot(m, direction);
+		if (a <= SweepEpsilon || b >= 0.f)
+			return false;
+
+		float discriminant = b * b - a * c;
+		if (discriminant < 0.f)
+			return false;
+
+		float t = (-b - std::sqrt(discriminant)) / a;
+		if (t > 1.f)
+			return false;
+		outTime = std::max(t, 0.f);
+		return true;
+	}
+
+	// Entry and exit of the slabs, the entry is 0 when the origin starts inside
+	static bool RayAABB(const XMFLOAT3& origin, const XMFLOAT3& direction, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax,
+		float& outEnter, float& outExit)
+	{
+		float enter = 0.f, exit = 1.f;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float o = GetAxis(origin, axis), d = GetAxis(direction, axis);
+			float low = GetAxis(boxMin, axis), high = GetAxis(boxMax, axis);
+			if (std::abs(d) <= SweepEpsilon)
+			{
+				if (o < low || o > high)
+					return false;
+				continue;
+			}
+
+			float inverse = 1.f / d;
+			float t1 = (low - o) * inverse, t2 = (high - o) * inverse;
+			if (t1 > t2)
+				std::swap(t1, t2);
+			enter = std::max(enter, t1);
+			exit = std::min(exit, t2);
+			if (enter > exit)
+				return false;
+		}
+		outEnter = enter;
+		outExit = exit;
+		return true;
+	}
+
+	// A capsule is a finite cylinder plus two end spheres, the first one the ray
+	// enters is where it enters the capsule
+	static bool RayCapsule(const XMFLOAT3& origin, const XMFLOAT3& direction, const XMFLOAT3& p, const XMFLOAT3& q, float radius,
+		float& outTime)
+	{
+		float best = std::numeric_limits<float>::infinity();
+		float t;
+		if (RaySphere(origin, direction, p, radius, t))
+			best = t;
+		if (RaySphere(origin, direction, q, radius, t))
+			best = std::min(best, t);
+
+		XMFLOAT3 axis = Sub(q, p);
+		float axisSq = Dot(axis, axis);
+		if (axisSq > SweepEpsilon)
+		{
+			XMFLOAT3 m = Sub(origin, p);
+			float mAxis = Dot(m, axis) / axisSq, dAxis = Dot(direction, axis) / axisSq;
+			XMFLOAT3 mPerp = Sub(m, Scale(axis, mAxis));
+			XMFLOAT3 dPerp = Sub(direction, Scale(axis, dAxis));
+
+			float a = Dot(dPerp, dPerp);
+			float b = Dot(mPerp, dPerp);
+			float c = Dot(mPerp, mPerp) - radius * radius;
+			if (c <= 0.f && mAxis >= 0.f && mAxis <= 1.f)
+			{
+				outTime = 0.f;
+				return true;
+			}
+			if (a > SweepEpsilon && c > 0.f)
+			{
+				float discriminant = b * b - a * c;
+				if (discriminant >= 0.f)
+				{
+					t = (-b - std::sqrt(discriminant)) / a;
+					float s = mAxis + t * dAxis;
+					if (t >= 0.f && t <= 1.f && s >= 0.f && s <= 1.f)
+						best = std::min(best, t);
+				}
+			}
+		}
+
+		if (best > 1.f)
+			return false;
+		outTime = best;
+		return true;
+	}
+
+	static XMFLOAT3 GetCorner(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, int corner)
+	{
+		return {
+			(corner & 1) ? boxMax.x : boxMin.x,
+			(corner & 2) ? boxMax.y : boxMin.y,
+			(corner & 4) ? boxMax.z : boxMin.z };
+	}
+
+	// After Ericson's IntersectMovingSphereAABB: the box grown by the radius is hit
+	// first, then the rounded edges and corners are fixed up with capsule tests
+	static bool SweepSphereBox(const XMFLOAT3& center, float radius, const XMFLOAT3& displacement,
+		const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, float& outTime)
+	{
+		float dx = std::max({ boxMin.x - center.x, 0.f, center.x - boxMax.x });
+		float dy = std::max({ boxMin.y - center.y, 0.f, center.y - boxMax.y });
+		float dz = std::max({ boxMin.z - center.z, 0.f, center.z - boxMax.z });
+		if (dx * dx + dy * dy + dz * dz <= radius * radius)
+		{
+			outTime = 0.f;
+			return true;
+		}
+
+		XMFLOAT3 grownMin{ boxMin.x - radius, boxMin.y - radius, boxMin.z - radius };
+		XMFLOAT3 grownMax{ boxMax.x + radius, boxMax.y + radius, boxMax.z + radius };
+		float enter, exit;
+		if (!RayAABB(center, displacement, grownMin, grownMax, enter, exit))
+			return false;
+
+		XMFLOAT3 point = Add(center, Scale(displacement, enter));
+		int below = 0, above = 0;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (GetAxis(point, axis) < GetAxis(boxMin, axis)) below |= 1 << axis;
+			if (GetAxis(point, axis) > GetAxis(boxMax, axis)) above |= 1 << axis;
+		}
+		int outside = below | above;
+
+		// face region, the grown box is exact there
+		if (outside == 0 || outside == 1 || outside == 2 || outside == 4)
+		{
+			outTime = enter;
+			return true;
+		}
+
+		// edge region, the edge runs along the one axis the point is inside of
+		if (outside != 7)
+			return RayCapsule(center, displacement, GetCorner(boxMin, boxMax, below ^ 7), GetCorner(boxMin, boxMax, above), radius, outTime);
+
+		// corner region, the first of the three edges meeting there
+		XMFLOAT3 corner = GetCorner(boxMin, boxMax, above);
+		float best = std::numeric_limits<float>::infinity();
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float t;
+			if (RayCapsule(center, displacement, corner, GetCorner(boxMin, boxMax, above ^ (1 << axis)), radius, t))
+				best = std::min(best, t);
+		}
+		if (best > 1.f)
+			return false;
+		outTime = best;
+		return true;
+	}
+
+	bool SweepSphere(const XMFLOAT3& center, float radius, const XMFLOAT3& displacement, const CollisionShape& shape, float& outTime)
+	{
+		switch (shape.Type)
+		{
+		case CollisionShapeType::Sphere:
+			return RaySphere(center, displacement, shape.Center, radius + shape.Radius, outTime);
+		case CollisionShapeType::Box:
+			return SweepSphereBox(center, radius, displacement, Sub(shape.Center, shape.Extents), Add(shape.Center, shape.Extents), outTime);
+		case CollisionShapeType::OrientedBox:
+		{
+			// in the box's frame it is an axis aligned box around the origin
+			XMFLOAT4 inverse{ -shape.Orientation.x, -shape.Orientation.y, -shape.Orientation.z, shape.Orientation.w };
+			XMFLOAT3 localCenter = Rotate(inverse, Sub(center, shape.Center));
+			XMFLOAT3 localDisplacement = Rotate(inverse, displacement);
+			XMFLOAT3 negative{ -shape.Extents.x, -shape.Extents.y, -shape.Extents.z };
+			return SweepSphereBox(localCenter, radius, localDisplacement, negative, shape.Extents, outTime);
+		}
+		case CollisionShapeType::Capsule:
+			return RayCapsule(center, displacement, Sub(shape.Center, shape.HalfSegment), Add(shape.Center, shape.HalfSegment),
+				radius + shape.Radius, outTime);
+		default:
+			return false;
+		}
+	}
+
+	bool SweepAABB(const XMFLOAT3& centerA, const XMFLOAT3& extentsA, const XMFLOAT3& displacement,
+		const XMFLOAT3& centerB, const XMFLOAT3& extentsB, float& outTime)
+	{
+		// the center of A against B grown by the extents of A
+		XMFLOAT3 extents = Add(extentsA, extentsB);
+		float exit;
+		return RayAABB(centerA, displacement, Sub(centerB, extents), Add(centerB, extents), outTime, exit);
+	}
+
+	// Half of the thinnest dimension
+	static float GetShapeThickness(const CollisionShape& shape)
+	{
+		switch (shape.Type)
+		{
+		case CollisionShapeType::Sphere:
+		case CollisionShapeType::Capsule:
+			return shape.Radius;
+		default:
+			return std::min({ shape.Extents.x, shape.Extents.y, shape.Extents.z });
+		}
+	}
+
+	bool SweepShapes(const CollisionShape& a, const XMFLOAT3& displacementA, const CollisionShape& b, const XMFLOAT3& displacementB,
+		float& outTime)
+	{
+		// B stands still at its start, A moves by the difference
+		XMFLOAT3 relative = Sub(displacementA, displacementB);
+		CollisionShape startA = a;
+		startA.Center = Sub(a.Center, displacementA);
+		CollisionShape startB = b;
+		startB.Center = Sub(b.Center, displacementB);
+
+		if (a.Type == CollisionShapeType::Sphere)
+			return SweepSphere(startA.Center, a.Radius, relative, startB, outTime);
+		if (b.Type == CollisionShapeType::Sphere)
+			return SweepSphere(startB.Center, b.Radius, Scale(relative, -1.f), startA, outTime);
+
+		if (a.Type == CollisionShapeType::Box && b.Type == CollisionShapeType::Box)
+			return SweepAABB(startA.Center, a.Extents, relative, startB.Center, b.Extents, outTime);
+
+		XMFLOAT3 centerA, extentsA, centerB, extentsB;
+		GetShapeBounds(startA, centerA, extentsA);
+		GetShapeBounds(startB, centerB, extentsB);
+		XMFLOAT3 extents = Add(extentsA, extentsB);
+		float enter, exit;
+		if (!RayAABB(centerA, relative, Sub(centerB, extents), Add(centerB, extents), enter, exit))
+			return false;
+
+		auto touchingAt = [&](float t)
+			{
+				CollisionShape movedA = startA;
+				movedA.Center = Add(startA.Center, Scale(relative, t));
+				return TestShapes(movedA, startB);
+			};
+
+		float distance = std::sqrt(Dot(relative, relative)) * (exit - enter);
+		// steps this short only miss grazing contacts at a corner or edge
+		float stepLength = std::max(std::min(GetShapeThickness(a), GetShapeThickness(b)) * SweepStepScale, SweepEpsilon);
+		int steps = std::min(int(std::ceil(distance / stepLength)), MaxSweepSteps);
+		float stepTime = steps > 0 ? (exit - enter) / steps : 0.f;
+
+		float previous = enter;
+		for (int step = 0; step <= steps; ++step)
+		{
+			float t = step == steps ? exit : enter + step * stepTime;
+			if (!touchingAt(t))
+			{
+				previous = t;
+				continue;
+			}
+			if (step == 0)
+			{
+				outTime = t;
+				return true;
+			}
+
+			// the first touching time lies between the last two samples
+			float low = previous, high = t;
+			for (int i = 0; i < BisectionSteps; ++i)
+			{
+				float mid = 0.5f * (low + high);
+				if (touchingAt(mid))
+					high = mid;
+				else
+					low = mid;
+			}
+			outTime = high;
+			return true;
+		}
+		return false;
+	}
+}
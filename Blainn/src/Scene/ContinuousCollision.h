@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Narrowphase.h"
+
+#include <DirectXMath.h>
+
+namespace Blainn
+{
+	// Time of impact queries for shapes that translate during a step. Times are
+	// fractions of the step, 0 when the shapes already touch at its start.
+
+	// Sphere at center moving by displacement against a static shape, exact for every
+	// shape type
+	bool SweepSphere(const DirectX::XMFLOAT3& center, float radius, const DirectX::XMFLOAT3& displacement,
+		const CollisionShape& shape, float& outTime);
+
+	// Box moving by displacement against a static box, both as center and half extents
+	bool SweepAABB(const DirectX::XMFLOAT3& centerA, const DirectX::XMFLOAT3& extentsA, const DirectX::XMFLOAT3& displacement,
+		const DirectX::XMFLOAT3& centerB, const DirectX::XMFLOAT3& extentsB, float& outTime);
+
+	// Two shapes given where they ended the step, each moved by its displacement.
+	// Rotation during the step is ignored. Pairs with a sphere and box pairs are swept
+	// exactly. Any other pair sweeps its bounding boxes and walks the overlapping
+	// interval in steps well below the thinner shape's size, which can only miss a
+	// shallow graze of a corner or an edge.
+	bool SweepShapes(const CollisionShape& a, const DirectX::XMFLOAT3& displacementA,
+		const CollisionShape& b, const DirectX::XMFLOAT3& displacementB, float& outTime);
+}
@@ -0,0 +1,539 @@
+#include "pch.h"
+#include "Narrowphase.h"
+
+#include "Core/JobSystem.h"
+
+#include <DirectXCollision.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BLAINN_NARROWPHASE_SSE
+#endif
+
+namespace Blainn
+{
+	using DirectX::XMFLOAT3;
+	using DirectX::XMFLOAT4;
+
+	static constexpr float SegmentEpsilon = 1e-8f;
+
+	static float Clamp01(float value) { return std::min(std::max(value, 0.f), 1.f); }
+	static float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	static XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	static XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	static XMFLOAT3 Rotate(const XMFLOAT4& q, const XMFLOAT3& v)
+	{
+		// v + 2w (q x v) + 2 q x (q x v)
+		XMFLOAT3 axis{ q.x, q.y, q.z };
+		XMFLOAT3 t = Cross(axis, v);
+		t = { 2.f * t.x, 2.f * t.y, 2.f * t.z };
+		XMFLOAT3 u = Cross(axis, t);
+		return { v.x + q.w * t.x + u.x, v.y + q.w * t.y + u.y, v.z + q.w * t.z + u.z };
+	}
+
+	static DirectX::BoundingSphere ToSphere(const CollisionShape& shape) { return DirectX::BoundingSphere(shape.Center, shape.Radius); }
+	static DirectX::BoundingBox ToBox(const CollisionShape& shape) { return DirectX::BoundingBox(shape.Center, shape.Extents); }
+	static DirectX::BoundingOrientedBox ToOrientedBox(const CollisionShape& shape)
+	{
+		return DirectX::BoundingOrientedBox(shape.Center, shape.Extents, shape.Orientation);
+	}
+
+	// Squared distance between the segments p1 + s d1 and p2 + t d2, s and t in [0, 1],
+	// after Ericson's ClosestPtSegmentSegment. The SIMD kernel blends the same branches.
+	static float SegmentSegmentDistanceSq(const XMFLOAT3& p1, const XMFLOAT3& d1, const XMFLOAT3& p2, const XMFLOAT3& d2)
+	{
+		XMFLOAT3 r = Sub(p1, p2);
+		float a = Dot(d1, d1), e = Dot(d2, d2), f = Dot(d2, r);
+
+		float s = 0.f, t = 0.f;
+		if (a > SegmentEpsilon || e > SegmentEpsilon)
+		{
+			if (a <= SegmentEpsilon)
+			{
+				t = Clamp01(f / e);
+			}
+			else
+			{
+				float c = Dot(d1, r);
+				if (e <= SegmentEpsilon)
+				{
+					s = Clamp01(-c / a);
+				}
+				else
+				{
+					float b = Dot(d1, d2);
+					float denom = a * e - b * b;
+					s = denom != 0.f ? Clamp01((b * f - c * e) / denom) : 0.f;
+					t = (b * s + f) / e;
+					if (t < 0.f)
+					{
+						t = 0.f;
+						s = Clamp01(-c / a);
+					}
+					else if (t > 1.f)
+					{
+						t = 1.f;
+						s = Clamp01((b - c) / a);
+					}
+				}
+			}
+		}
+
+		XMFLOAT3 delta{
+			r.x + d1.x * s - d2.x * t,
+			r.y + d1.y * s - d2.y * t,
+			r.z + d1.z * s - d2.z * t };
+		return Dot(delta, delta);
+	}
+
+	static float PointBoxDistanceSq(const XMFLOAT3& point, const XMFLOAT3& extents)
+	{
+		float dx = std::max(std::abs(point.x) - extents.x, 0.f);
+		float dy = std::max(std::abs(point.y) - extents.y, 0.f);
+		float dz = std::max(std::abs(point.z) - extents.z, 0.f);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	// The distance from a point sliding along a segment to a convex box is convex in
+	// the segment parameter, so a golden section search finds the closest approach
+	static float SegmentBoxDistanceSq(const CollisionShape& capsule, const XMFLOAT3& boxCenter, const XMFLOAT3& boxExtents,
+		const XMFLOAT4& boxOrientation)
+	{
+		XMFLOAT4 inverse{ -boxOrientation.x, -boxOrientation.y, -boxOrientation.z, boxOrientation.w };
+		XMFLOAT3 center = Rotate(inverse, Sub(capsule.Center, boxCenter));
+		XMFLOAT3 half = Rotate(inverse, capsule.HalfSegment);
+
+		auto distanceAt = [&](float t)
+			{
+				float k = 2.f * t - 1.f;
+				return PointBoxDistanceSq({ center.x + half.x * k, center.y + half.y * k, center.z + half.z * k }, boxExtents);
+			};
+
+		constexpr float invPhi = 0.618034f;
+		float low = 0.f, high = 1.f;
+		float t1 = high - invPhi, t2 = low + invPhi;
+		float f1 = distanceAt(t1), f2 = distanceAt(t2);
+		for (int i = 0; i < 32; ++i)
+		{
+			if (f1 <= f2)
+			{
+				high = t2;
+				t2 = t1;
+				f2 = f1;
+				t1 = high - invPhi * (high - low);
+				f1 = distanceAt(t1);
+			}
+			else
+			{
+				low = t1;
+				t1 = t2;
+				f1 = f2;
+				t2 = low + invPhi * (high - low);
+				f2 = distanceAt(t2);
+			}
+		}
+		return std::min({ f1, f2, distanceAt(0.f), distanceAt(1.f) });
+	}
+
+	static bool SphereSphere(const CollisionShape& a, const CollisionShape& b) { return ToSphere(a).Intersects(ToSphere(b)); }
+	static bool SphereBox(const CollisionShape& a, const CollisionShape& b) { return ToSphere(a).Intersects(ToBox(b)); }
+	static bool SphereOrientedBox(const CollisionShape& a, const CollisionShape& b) { return ToSphere(a).Intersects(ToOrientedBox(b)); }
+	static bool BoxBox(const CollisionShape& a, const CollisionShape& b) { return ToBox(a).Intersects(ToBox(b)); }
+	static bool BoxOrientedBox(const CollisionShape& a, const CollisionShape& b) { return ToBox(a).Intersects(ToOrientedBox(b)); }
+	static bool OrientedBoxOrientedBox(const CollisionShape& a, const CollisionShape& b) { return ToOrientedBox(a).Intersects(ToOrientedBox(b)); }
+
+	static bool SphereCapsule(const CollisionShape& a, const CollisionShape& b)
+	{
+		XMFLOAT3 start{ b.Center.x - b.HalfSegment.x, b.Center.y - b.HalfSegment.y, b.Center.z - b.HalfSegment.z };
+		XMFLOAT3 segment{ 2.f * b.HalfSegment.x, 2.f * b.HalfSegment.y, 2.f * b.HalfSegment.z };
+		XMFLOAT3 toCenter = Sub(a.Center, start);
+
+		float t = Clamp01(Dot(toCenter, segment) / std::max(Dot(segment, segment), SegmentEpsilon));
+		XMFLOAT3 delta{ toCenter.x - segment.x * t, toCenter.y - segment.y * t, toCenter.z - segment.z * t };
+		float radius = a.Radius + b.Radius;
+		return Dot(delta, delta) <= radius * radius;
+	}
+
+	static bool BoxCapsule(const CollisionShape& a, const CollisionShape& b)
+	{
+		return SegmentBoxDistanceSq(b, a.Center, a.Extents, { 0.f, 0.f, 0.f, 1.f }) <= b.Radius * b.Radius;
+	}
+
+	static bool OrientedBoxCapsule(const CollisionShape& a, const CollisionShape& b)
+	{
+		return SegmentBoxDistanceSq(b, a.Center, a.Extents, a.Orientation) <= b.Radius * b.Radius;
+	}
+
+	static bool CapsuleCapsule(const CollisionShape& a, const CollisionShape& b)
+	{
+		XMFLOAT3 startA{ a.Center.x - a.HalfSegment.x, a.Center.y - a.HalfSegment.y, a.Center.z - a.HalfSegment.z };
+		XMFLOAT3 startB{ b.Center.x - b.HalfSegment.x, b.Center.y - b.HalfSegment.y, b.Center.z - b.HalfSegment.z };
+		XMFLOAT3 segmentA{ 2.f * a.HalfSegment.x, 2.f * a.HalfSegment.y, 2.f * a.HalfSegment.z };
+		XMFLOAT3 segmentB{ 2.f * b.HalfSegment.x, 2.f * b.HalfSegment.y, 2.f * b.HalfSegment.z };
+
+		float radius = a.Radius + b.Radius;
+		return SegmentSegmentDistanceSq(startA, segmentA, startB, segmentB) <= radius * radius;
+	}
+
+	using ShapeTestFn = bool(*)(const CollisionShape&, const CollisionShape&);
+
+	// Indexed by GetCombinationIndex, only filled for A.Type <= B.Type
+	static const ShapeTestFn s_ShapeTests[int(CollisionShapeType::Count) * int(CollisionShapeType::Count)] = {
+		// Sphere			Box				OrientedBox				Capsule
+		SphereSphere,		SphereBox,		SphereOrientedBox,		SphereCapsule,			// Sphere
+		nullptr,			BoxBox,			BoxOrientedBox,			BoxCapsule,				// Box
+		nullptr,			nullptr,		OrientedBoxOrientedBox,	OrientedBoxCapsule,		// OrientedBox
+		nullptr,			nullptr,		nullptr,				CapsuleCapsule,			// Capsule
+	};
+
+	void GetShapeBounds(const CollisionShape& shape, XMFLOAT3& outCenter, XMFLOAT3& outExtents)
+	{
+		outCenter = shape.Center;
+		switch (shape.Type)
+		{
+		case CollisionShapeType::Sphere:
+			outExtents = { shape.Radius, shape.Radius, shape.Radius };
+			break;
+		case CollisionShapeType::Box:
+			outExtents = shape.Extents;
+			break;
+		case CollisionShapeType::OrientedBox:
+		{
+			// extents through the absolute rotation matrix
+			XMFLOAT3 axisX = Rotate(shape.Orientation, { 1.f, 0.f, 0.f });
+			XMFLOAT3 axisY = Rotate(shape.Orientation, { 0.f, 1.f, 0.f });
+			XMFLOAT3 axisZ = Rotate(shape.Orientation, { 0.f, 0.f, 1.f });
+			const XMFLOAT3& e = shape.Extents;
+			outExtents = {
+				std::abs(axisX.x) * e.x + std::abs(axisY.x) * e.y + std::abs(axisZ.x) * e.z,
+				std::abs(axisX.y) * e.x + std::abs(axisY.y) * e.y + std::abs(axisZ.y) * e.z,
+				std::abs(axisX.z) * e.x + std::abs(axisY.z) * e.y + std::abs(axisZ.z) * e.z };
+			break;
+		}
+		case CollisionShapeType::Capsule:
+			outExtents = {
+				std::abs(shape.HalfSegment.x) + shape.Radius,
+				std::abs(shape.HalfSegment.y) + shape.Radius,
+				std::abs(shape.HalfSegment.z) + shape.Radius };
+			break;
+		default:
+			outExtents = { 0.f, 0.f, 0.f };
+			break;
+		}
+	}
+
+	bool TestShapes(const CollisionShape& a, const CollisionShape& b)
+	{
+		if (a.Type > b.Type)
+			return s_ShapeTests[Narrowphase::GetCombinationIndex(b.Type, a.Type)](b, a);
+		return s_ShapeTests[Narrowphase::GetCombinationIndex(a.Type, b.Type)](a, b);
+	}
+
+#if defined(BLAINN_NARROWPHASE_SSE)
+	// One side of a chunk of pairs, Extent holds the box extents or the capsule's
+	// half segment depending on the shape type
+	struct ShapeChunk
+	{
+		alignas(16) float CenterX[Narrowphase::ChunkSize];
+		alignas(16) float CenterY[Narrowphase::ChunkSize];
+		alignas(16) float CenterZ[Narrowphase::ChunkSize];
+		alignas(16) float ExtentX[Narrowphase::ChunkSize];
+		alignas(16) float ExtentY[Narrowphase::ChunkSize];
+		alignas(16) float ExtentZ[Narrowphase::ChunkSize];
+		alignas(16) float Radius[Narrowphase::ChunkSize];
+
+		void Set(uint32_t i, const CollisionShape& shape)
+		{
+			const XMFLOAT3& extent = shape.Type == CollisionShapeType::Capsule ? shape.HalfSegment : shape.Extents;
+			CenterX[i] = shape.Center.x;
+			CenterY[i] = shape.Center.y;
+			CenterZ[i] = shape.Center.z;
+			ExtentX[i] = extent.x;
+			ExtentY[i] = extent.y;
+			ExtentZ[i] = extent.z;
+			Radius[i] = shape.Radius;
+		}
+
+		void Copy(uint32_t to, uint32_t from)
+		{
+			CenterX[to] = CenterX[from];
+			CenterY[to] = CenterY[from];
+			CenterZ[to] = CenterZ[from];
+			ExtentX[to] = ExtentX[from];
+			ExtentY[to] = ExtentY[from];
+			ExtentZ[to] = ExtentZ[from];
+			Radius[to] = Radius[from];
+		}
+	};
+
+	struct Vec4x3
+	{
+		__m128 X, Y, Z;
+	};
+
+	static inline Vec4x3 LoadCenter(const ShapeChunk& c, uint32_t i) { return { _mm_load_ps(c.CenterX + i), _mm_load_ps(c.CenterY + i), _mm_load_ps(c.CenterZ + i) }; }
+	static inline Vec4x3 LoadExtent(const ShapeChunk& c, uint32_t i) { return { _mm_load_ps(c.ExtentX + i), _mm_load_ps(c.ExtentY + i), _mm_load_ps(c.ExtentZ + i) }; }
+	static inline Vec4x3 Add(const Vec4x3& a, const Vec4x3& b) { return { _mm_add_ps(a.X, b.X), _mm_add_ps(a.Y, b.Y), _mm_add_ps(a.Z, b.Z) }; }
+	static inline Vec4x3 Sub(const Vec4x3& a, const Vec4x3& b) { return { _mm_sub_ps(a.X, b.X), _mm_sub_ps(a.Y, b.Y), _mm_sub_ps(a.Z, b.Z) }; }
+	static inline Vec4x3 Scale(const Vec4x3& a, __m128 s) { return { _mm_mul_ps(a.X, s), _mm_mul_ps(a.Y, s), _mm_mul_ps(a.Z, s) }; }
+	static inline __m128 Dot(const Vec4x3& a, const Vec4x3& b)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.X, b.X), _mm_mul_ps(a.Y, b.Y)), _mm_mul_ps(a.Z, b.Z));
+	}
+	static inline __m128 Select(__m128 mask, __m128 ifTrue, __m128 ifFalse) { return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse)); }
+	static inline __m128 Clamp01(__m128 value) { return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f)); }
+
+	static inline void StoreMask(__m128 mask, uint8_t* out)
+	{
+		uint32_t bits = uint32_t(_mm_movemask_ps(mask));
+		out[0] = uint8_t(bits & 1u);
+		out[1] = uint8_t((bits >> 1) & 1u);
+		out[2] = uint8_t((bits >> 2) & 1u);
+		out[3] = uint8_t((bits >> 3) & 1u);
+	}
+
+	static void SphereSphereKernel(const ShapeChunk& a, const ShapeChunk& b, uint32_t count, uint8_t* out)
+	{
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			Vec4x3 delta = Sub(LoadCenter(a, i), LoadCenter(b, i));
+			__m128 radius = _mm_add_ps(_mm_load_ps(a.Radius + i), _mm_load_ps(b.Radius + i));
+			StoreMask(_mm_cmple_ps(Dot(delta, delta), _mm_mul_ps(radius, radius)), out + i);
+		}
+	}
+
+	static void SphereBoxKernel(const ShapeChunk& a, const ShapeChunk& b, uint32_t count, uint8_t* out)
+	{
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			Vec4x3 center = LoadCenter(a, i);
+			Vec4x3 boxCenter = LoadCenter(b, i), boxExtent = LoadExtent(b, i);
+			Vec4x3 boxMin = Sub(boxCenter, boxExtent), boxMax = Add(boxCenter, boxExtent);
+
+			// offset to the closest point of the box, per axis, like DirectXCollision
+			Vec4x3 minDelta = Sub(center, boxMin), maxDelta = Sub(center, boxMax);
+			__m128 zero = _mm_setzero_ps();
+			Vec4x3 d{
+				Select(_mm_cmpgt_ps(center.X, boxMax.X), maxDelta.X, Select(_mm_cmplt_ps(center.X, boxMin.X), minDelta.X, zero)),
+				Select(_mm_cmpgt_ps(center.Y, boxMax.Y), maxDelta.Y, Select(_mm_cmplt_ps(center.Y, boxMin.Y), minDelta.Y, zero)),
+				Select(_mm_cmpgt_ps(center.Z, boxMax.Z), maxDelta.Z, Select(_mm_cmplt_ps(center.Z, boxMin.Z), minDelta.Z, zero)) };
+
+			__m128 radius = _mm_load_ps(a.Radius + i);
+			StoreMask(_mm_cmple_ps(Dot(d, d), _mm_mul_ps(radius, radius)), out + i);
+		}
+	}
+
+	static void BoxBoxKernel(const ShapeChunk& a, const ShapeChunk& b, uint32_t count, uint8_t* out)
+	{
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			Vec4x3 centerA = LoadCenter(a, i), extentA = LoadExtent(a, i);
+			Vec4x3 centerB = LoadCenter(b, i), extentB = LoadExtent(b, i);
+			Vec4x3 minA = Sub(centerA, extentA), maxA = Add(centerA, extentA);
+			Vec4x3 minB = Sub(centerB, extentB), maxB = Add(centerB, extentB);
+
+			__m128 overlap = _mm_and_ps(
+				_mm_and_ps(_mm_and_ps(_mm_cmple_ps(minA.X, maxB.X), _mm_cmple_ps(minB.X, maxA.X)),
+					_mm_and_ps(_mm_cmple_ps(minA.Y, maxB.Y), _mm_cmple_ps(minB.Y, maxA.Y))),
+				_mm_and_ps(_mm_cmple_ps(minA.Z, maxB.Z), _mm_cmple_ps(minB.Z, maxA.Z)));
+			StoreMask(overlap, out + i);
+		}
+	}
+
+	static void SphereCapsuleKernel(const ShapeChunk& a, const ShapeChunk& b, uint32_t count, uint8_t* out)
+	{
+		const __m128 two = _mm_set1_ps(2.f);
+		const __m128 epsilon = _mm_set1_ps(SegmentEpsilon);
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			Vec4x3 half = LoadExtent(b, i);
+			Vec4x3 start = Sub(LoadCenter(b, i), half);
+			Vec4x3 segment = Scale(half, two);
+			Vec4x3 toCenter = Sub(LoadCenter(a, i), start);
+
+			__m128 t = Clamp01(_mm_div_ps(Dot(toCenter, segment), _mm_max_ps(Dot(segment, segment), epsilon)));
+			Vec4x3 delta = Sub(toCenter, Scale(segment, t));
+
+			__m128 radius = _mm_add_ps(_mm_load_ps(a.Radius + i), _mm_load_ps(b.Radius + i));
+			StoreMask(_mm_cmple_ps(Dot(delta, delta), _mm_mul_ps(radius, radius)), out + i);
+		}
+	}
+
+	static void CapsuleCapsuleKernel(const ShapeChunk& a, const ShapeChunk& b, uint32_t count, uint8_t* out)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 two = _mm_set1_ps(2.f);
+		const __m128 epsilon = _mm_set1_ps(SegmentEpsilon);
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			Vec4x3 halfA = LoadExtent(a, i), halfB = LoadExtent(b, i);
+			Vec4x3 p1 = Sub(LoadCenter(a, i), halfA), p2 = Sub(LoadCenter(b, i), halfB);
+			Vec4x3 d1 = Scale(halfA, two), d2 = Scale(halfB, two);
+			Vec4x3 r = Sub(p1, p2);
+
+			__m128 sa = Dot(d1, d1), e = Dot(d2, d2), f = Dot(d2, r);
+			__m128 c = Dot(d1, r), b2 = Dot(d1, d2);
+			__m128 degenerateA = _mm_cmple_ps(sa, epsilon);
+			__m128 degenerateE = _mm_cmple_ps(e, epsilon);
+			// denominators of lanes that take another branch, kept finite
+			__m128 safeA = Select(degenerateA, one, sa);
+			__m128 safeE = Select(degenerateE, one, e);
+
+			// both segments proper, every branch of the scalar version computed and blended
+			__m128 denom = _mm_sub_ps(_mm_mul_ps(sa, e), _mm_mul_ps(b2, b2));
+			__m128 denomValid = _mm_cmpneq_ps(denom, zero);
+			__m128 s = Select(denomValid,
+				Clamp01(_mm_div_ps(_mm_sub_ps(_mm_mul_ps(b2, f), _mm_mul_ps(c, e)), Select(denomValid, denom, one))), zero);
+			__m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(b2, s), f), safeE);
+			__m128 sBelow = Clamp01(_mm_div_ps(_mm_sub_ps(zero, c), safeA));
+			__m128 sAbove = Clamp01(_mm_div_ps(_mm_sub_ps(b2, c), safeA));
+			s = Select(_mm_cmplt_ps(t, zero), sBelow, Select(_mm_cmpgt_ps(t, one), sAbove, s));
+			t = Clamp01(t);
+
+			// a point for the first segment, or the second, or both
+			__m128 tPointA = Clamp01(_mm_div_ps(f, safeE));
+			s = Select(degenerateA, zero, Select(degenerateE, sBelow, s));
+			t = Select(degenerateA, Select(degenerateE, zero, tPointA), Select(degenerateE, zero, t));
+
+			Vec4x3 delta = Sub(Add(r, Scale(d1, s)), Scale(d2, t));
+			__m128 radius = _mm_add_ps(_mm_load_ps(a.Radius + i), _mm_load_ps(b.Radius + i));
+			StoreMask(_mm_cmple_ps(Dot(delta, delta), _mm_mul_ps(radius, radius)), out + i);
+		}
+	}
+
+	using ShapeKernelFn = void(*)(const ShapeChunk&, const ShapeChunk&, uint32_t, uint8_t*);
+
+	static const ShapeKernelFn s_ShapeKernels[int(CollisionShapeType::Count) * int(CollisionShapeType::Count)] = {
+		// Sphere				Box				OrientedBox		Capsule
+		SphereSphereKernel,		SphereBoxKernel,	nullptr,		SphereCapsuleKernel,	// Sphere
+		nullptr,				BoxBoxKernel,		nullptr,		nullptr,				// Box
+		nullptr,				nullptr,			nullptr,		nullptr,				// OrientedBox
+		nullptr,				nullptr,			nullptr,		CapsuleCapsuleKernel,	// Capsule
+	};
+#endif
+
+	struct Narrowphase::ThreadScratch
+	{
+#if defined(BLAINN_NARROWPHASE_SSE)
+		struct Bucket
+		{
+			ShapeChunk A;
+			ShapeChunk B;
+			uint32_t PairIndex[ChunkSize];
+			uint32_t Count = 0;
+		};
+		// Only combinations with a kernel get one
+		std::unique_ptr<Bucket> Buckets[int(CollisionShapeType::Count) * int(CollisionShapeType::Count)];
+#endif
+		uint32_t Tested[int(CollisionShapeType::Count) * int(CollisionShapeType::Count)] = {};
+	};
+
+	Narrowphase::Narrowphase() = default;
+	Narrowphase::~Narrowphase() = default;
+
+	void Narrowphase::TestPairs(const NarrowphasePair* pairs, uint32_t count, uint8_t* outTouching, JobSystem* jobSystem)
+	{
+		constexpr uint32_t combinationCount = uint32_t(CollisionShapeType::Count) * uint32_t(CollisionShapeType::Count);
+
+		uint32_t threadCount = jobSystem ? jobSystem->GetConcurrency() : 1;
+		while (m_Scratch.size() < threadCount)
+			m_Scratch.push_back(std::make_unique<ThreadScratch>());
+		for (auto& scratch : m_Scratch)
+			std::fill(std::begin(scratch->Tested), std::end(scratch->Tested), 0u);
+
+		auto testRanges = [this, pairs, count, outTouching, jobSystem](uint32_t begin, uint32_t end)
+			{
+				ThreadScratch& scratch = *m_Scratch[jobSystem ? jobSystem->GetCurrentThreadIndex() : 0];
+				for (uint32_t range = begin; range < end; ++range)
+					TestRange(scratch, pairs, range * RangeSize, std::min(count, (range + 1) * RangeSize), outTouching);
+			};
+		uint32_t rangeCount = (count + RangeSize - 1) / RangeSize;
+		if (jobSystem)
+			jobSystem->ParallelFor(0, rangeCount, 1, testRanges);
+		else
+			testRanges(0, rangeCount);
+
+		m_Stats = {};
+		for (auto& scratch : m_Scratch)
+			for (uint32_t combination = 0; combination < combinationCount; ++combination)
+				m_Stats.Tested[combination] += scratch->Tested[combination];
+		for (uint32_t i = 0; i < count; ++i)
+			m_Stats.Touching += outTouching[i];
+#if defined(BLAINN_NARROWPHASE_SSE)
+		for (uint32_t combination = 0; combination < combinationCount; ++combination)
+			if (s_ShapeKernels[combination])
+				m_Stats.Batched += m_Stats.Tested[combination];
+#endif
+	}
+
+	void Narrowphase::TestRange(ThreadScratch& scratch, const NarrowphasePair* pairs, uint32_t begin, uint32_t end, uint8_t* outTouching) const
+	{
+#if defined(BLAINN_NARROWPHASE_SSE)
+		alignas(16) uint8_t touching[ChunkSize];
+		auto flush = [&touching, outTouching](ThreadScratch::Bucket& bucket, ShapeKernelFn kernel)
+			{
+				// padding lanes repeat the last pair, their results are dropped
+				uint32_t paddedCount = (bucket.Count + 3) & ~3u;
+				for (uint32_t i = bucket.Count; i < paddedCount; ++i)
+				{
+					bucket.A.Copy(i, bucket.Count - 1);
+					bucket.B.Copy(i, bucket.Count - 1);
+				}
+
+				kernel(bucket.A, bucket.B, paddedCount, touching);
+				for (uint32_t i = 0; i < bucket.Count; ++i)
+					outTouching[bucket.PairIndex[i]] = touching[i];
+				bucket.Count = 0;
+			};
+#endif
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const CollisionShape* a = pairs[i].A;
+			const CollisionShape* b = pairs[i].B;
+			if (!a || !b)
+			{
+				outTouching[i] = 0;
+				continue;
+			}
+			if (a->Type > b->Type)
+				std::swap(a, b);
+
+			uint32_t combination = GetCombinationIndex(a->Type, b->Type);
+			scratch.Tested[combination]++;
+
+#if defined(BLAINN_NARROWPHASE_SSE)
+			if (ShapeKernelFn kernel = s_ShapeKernels[combination])
+			{
+				auto& bucket = scratch.Buckets[combination];
+				if (!bucket)
+					bucket = std::make_unique<ThreadScratch::Bucket>();
+
+				bucket->A.Set(bucket->Count, *a);
+				bucket->B.Set(bucket->Count, *b);
+				bucket->PairIndex[bucket->Count] = i;
+				if (++bucket->Count == ChunkSize)
+					flush(*bucket, kernel);
+				continue;
+			}
+#endif
+			outTouching[i] = s_ShapeTests[combination](*a, *b) ? 1 : 0;
+		}
+
+#if defined(BLAINN_NARROWPHASE_SSE)
+		// leftovers, so a range never leaves pairs behind for the next one
+		for (uint32_t combination = 0; combination < uint32_t(std::size(scratch.Buckets)); ++combination)
+		{
+			auto& bucket = scratch.Buckets[combination];
+			if (bucket && bucket->Count > 0)
+				flush(*bucket, s_ShapeKernels[combination]);
+		}
+#endif
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Blainn
+{
+	class JobSystem;
+
+	enum class CollisionShapeType : uint8_t
+	{
+		Sphere,
+		// Axis aligned box
+		Box,
+		OrientedBox,
+		// Segment swept by a sphere
+		Capsule,
+		Count
+	};
+
+	// World space shape of any collider type, flat so the narrowphase can gather it into
+	// SoA without a virtual call
+	struct CollisionShape
+	{
+		CollisionShapeType Type = CollisionShapeType::Sphere;
+		DirectX::XMFLOAT3 Center{ 0.f, 0.f, 0.f };
+		// Half extents of Box and OrientedBox
+		DirectX::XMFLOAT3 Extents{ 0.f, 0.f, 0.f };
+		// Rotation quaternion of OrientedBox
+		DirectX::XMFLOAT4 Orientation{ 0.f, 0.f, 0.f, 1.f };
+		// Capsule segment runs from Center - HalfSegment to Center + HalfSegment
+		DirectX::XMFLOAT3 HalfSegment{ 0.f, 0.f, 0.f };
+		// Sphere and Capsule
+		float Radius = 0.f;
+	};
+
+	// World space AABB of the shape, as center and half extents
+	void GetShapeBounds(const CollisionShape& shape, DirectX::XMFLOAT3& outCenter, DirectX::XMFLOAT3& outExtents);
+
+	// Single pair test through the shape pair dispatch table
+	bool TestShapes(const CollisionShape& a, const CollisionShape& b);
+
+	struct NarrowphasePair
+	{
+		// Null for a collider that went away, the pair is then reported as not touching
+		const CollisionShape* A;
+		const CollisionShape* B;
+	};
+
+	struct NarrowphaseStats
+	{
+		// Pairs per combination, indexed by GetCombinationIndex
+		uint32_t Tested[int(CollisionShapeType::Count) * int(CollisionShapeType::Count)] = {};
+		uint32_t Touching = 0;
+		// Pairs that went through a SIMD kernel instead of the dispatch table
+		uint32_t Batched = 0;
+	};
+
+	// Streams candidate pairs into one batch per shape combination. Combinations with a
+	// SIMD kernel (sphere, box and capsule against each other, except box and capsule)
+	// gather their shapes into SoA buckets that are tested four pairs at a time once
+	// full, the rest goes straight through the dispatch table. Ranges of pairs are
+	// spread over the job system, every thread fills its own buckets.
+	class Narrowphase
+	{
+	public:
+		static constexpr uint32_t ChunkSize = 256;
+		static constexpr uint32_t RangeSize = 4096;
+
+		Narrowphase();
+		~Narrowphase();
+
+		static uint32_t GetCombinationIndex(CollisionShapeType a, CollisionShapeType b)
+		{
+			return uint32_t(a) * uint32_t(CollisionShapeType::Count) + uint32_t(b);
+		}
+
+		// Writes 1 to outTouching[i] when pairs[i] touches, 0 otherwise
+		void TestPairs(const NarrowphasePair* pairs, uint32_t count, uint8_t* outTouching, JobSystem* jobSystem = nullptr);
+
+		const NarrowphaseStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct ThreadScratch;
+
+		void TestRange(ThreadScratch& scratch, const NarrowphasePair* pairs, uint32_t begin, uint32_t end, uint8_t* outTouching) const;
+
+	private:
+		std::vector<std::unique_ptr<ThreadScratch>> m_Scratch;
+		NarrowphaseStats m_Stats;
+	};
+}
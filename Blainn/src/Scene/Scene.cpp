@@ -4,76 +4,192 @@
 #include "Components/ActorComponents/CharacterComponents/CameraComponent.h"
 #include "Components/ActorComponents/PhysicsComponents/CollisionComponent.h"
 #include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
 #include "Components/ComponentManager.h"
 #include "Core/Application.h"
 #include "Core/CBIndexManager.h"
 #include "Core/GameObject.h"
 #include "Core/GameTimer.h"
+#include "Core/JobSystem.h"
+#include "BroadphaseSystem.h"
+#include "ContinuousCollision.h"
+#include "SceneSystems.h"
+#include "SpatialIndexSystem.h"
 
 #include <iostream>
 
-extern const UINT32 g_NumObjects;
-
 namespace Blainn
 {
 	Scene::Scene()
+		: m_SystemScheduler(m_ComponentManager)
+	{
+		m_SystemScheduler.AddSystem<InputSystem>();
+		m_SystemScheduler.AddSystem<TransformSystem>(m_TransformHierarchy);
+		m_SystemScheduler.AddSystem<CollisionBoundsSystem>();
+		m_SystemScheduler.AddSystem<CameraSystem>();
+		m_SpatialIndex = m_SystemScheduler.AddSystem<SpatialIndexSystem>();
+		m_Broadphase = m_SystemScheduler.AddSystem<BroadphaseSystem>();
+		m_Broadphase->SetLayerMatrix(&m_CollisionLayers);
+	}
+
+	Scene::~Scene()
+	{
+		// objects kept alive elsewhere must not point into the scene or its systems,
+		// their transforms take their state back out of the hierarchy
+		m_TransformHierarchy.Erase(0, m_TransformHierarchy.GetEntryCount());
+		for (const auto& object : m_UpdateOrder)
+		{
+			object->UnregisterComponents();
+			object->m_ParentScene = nullptr;
+			object->m_UpdateOrderIndex = UINT32_MAX;
+			object->m_OrderedSubtreeSize = 0;
+		}
+	}
+
+	const AABBTree& Scene::GetSpatialIndex() const
 	{
+		return m_SpatialIndex->GetTree();
 	}
 
 	void Scene::UpdateScene(const GameTimer& gt)
 	{
 		ProcessPendingRemovals();
 		ProcessPendingAdditions();
-		for (auto& object : m_AllObjects)
+
+		m_UpdateStats = {};
+		// an OnUpdate may reparent objects and reshuffle the order, every object placed
+		// when the loop started ticks once. Objects stay alive until the removals after
+		// the loop, one taken out of the order in the meantime is skipped.
+		m_UpdateSnapshot.clear();
+		for (const auto& object : m_UpdateOrder)
+			m_UpdateSnapshot.push_back(object.get());
+		for (GameObject* object : m_UpdateSnapshot)
+		{
+			if (object->m_ParentScene != this)
+				continue;
 			object->OnUpdate(gt);
+			m_UpdateStats.ObjectTicks++;
+		}
 		ProcessPendingRemovals();
 		ProcessPendingAdditions();
 
-		auto collisions = ComponentManager::Get().GetComponents<CollisionComponent>();
+		JobSystem* jobSystem = &Application::Get().GetJobSystem();
+		m_UpdateStats.ComponentTicks += m_SystemScheduler.Run(gt, jobSystem);
 
-		if (m_PlayerCollision)
+		UpdateCollisions(jobSystem);
+		DispatchContactEvents();
+	}
+
+	void Scene::Defer(std::function<void()> command)
+	{
+		if (m_bDispatchingContacts)
+			m_DeferredCommands.push_back(std::move(command));
+		else
+			command();
+	}
+
+	void Scene::UpdateCollisions(JobSystem* jobSystem)
+	{
+		const std::vector<BroadphasePair>& pairs = m_Broadphase->GetPairs();
+		uint32_t pairCount = uint32_t(pairs.size());
+
+		// the narrowphase only reads shapes, handlers run later from the event buffer
+		m_NarrowphasePairs.resize(pairCount);
+		m_SweptPairs.clear();
+		for (uint32_t i = 0; i < pairCount; ++i)
+		{
+			CollisionComponent* collisionA = m_ComponentManager.GetComponentPtr<CollisionComponent>(m_Broadphase->GetCollision(pairs[i].ProxyA));
+			CollisionComponent* collisionB = m_ComponentManager.GetComponentPtr<CollisionComponent>(m_Broadphase->GetCollision(pairs[i].ProxyB));
+			m_NarrowphasePairs[i] = {
+				collisionA ? &collisionA->GetShape() : nullptr,
+				collisionB ? &collisionB->GetShape() : nullptr };
+
+			if (collisionA && collisionB && (collisionA->IsContinuous() || collisionB->IsContinuous()))
+				m_SweptPairs.push_back({ i, collisionA, collisionB, 1.f });
+		}
+		m_PairTouching.resize(pairCount);
+		m_Narrowphase.TestPairs(m_NarrowphasePairs.data(), pairCount, m_PairTouching.data(), jobSystem);
+
+		// fast colliders are tested along the way they moved, whether or not they
+		// still touch at the end of it
+		uint32_t sweptHits = 0;
+		for (SweptPair& swept : m_SweptPairs)
 		{
-			for (auto& collision : collisions)
+			float timeOfImpact;
+			if (!SweepShapes(swept.CollisionA->GetShape(), swept.CollisionA->GetDisplacement(),
+				swept.CollisionB->GetShape(), swept.CollisionB->GetDisplacement(), timeOfImpact))
+				continue;
+
+			swept.TimeOfImpact = timeOfImpact;
+			if (!m_PairTouching[swept.Pair])
 			{
-				if (m_PlayerCollision == collision) continue;
+				m_PairTouching[swept.Pair] = 1;
+				sweptHits++;
+			}
+		}
+
+		m_TouchingPairs.clear();
+		size_t sweptCursor = 0;
+		for (uint32_t i = 0; i < pairCount; ++i)
+		{
+			if (!m_PairTouching[i])
+				continue;
+
+			float timeOfImpact = 1.f;
+			while (sweptCursor < m_SweptPairs.size() && m_SweptPairs[sweptCursor].Pair < i)
+				sweptCursor++;
+			if (sweptCursor < m_SweptPairs.size() && m_SweptPairs[sweptCursor].Pair == i)
+				timeOfImpact = m_SweptPairs[sweptCursor].TimeOfImpact;
+
+			m_TouchingPairs.push_back({ m_Broadphase->GetCollision(pairs[i].ProxyA), m_Broadphase->GetCollision(pairs[i].ProxyB), timeOfImpact });
+		}
+		m_ContactCache.Update(m_TouchingPairs);
+
+		m_UpdateStats.BroadphasePairs = pairCount;
+		m_UpdateStats.FilteredPairs = m_Broadphase->GetSweepAndPrune().GetStats().FilteredPairs;
+		m_UpdateStats.GeometryRejected = pairCount - uint32_t(m_TouchingPairs.size());
+		m_UpdateStats.SweptPairs = uint32_t(m_SweptPairs.size());
+		m_UpdateStats.SweptHits = sweptHits;
+		m_UpdateStats.Contacts = uint32_t(m_ContactCache.GetContacts().size());
+		m_UpdateStats.ContactBegins = m_ContactCache.GetBeginCount();
+		m_UpdateStats.ContactEnds = m_ContactCache.GetEndCount();
+	}
 
-				if (m_PlayerCollision->Intersects(collision))
-				{
-					m_PlayerCollision->OnCollision(collision);
-				}
+	void Scene::DispatchContactEvents()
+	{
+		m_bDispatchingContacts = true;
+		for (const ContactEvent& event : m_ContactCache.GetEvents())
+		{
+			// Stays come every frame for every contact and only contact callbacks want them
+			if (event.Type == ContactEventType::Stay)
+			{
+				CollisionComponent* collisionA = m_ComponentManager.GetComponentPtr<CollisionComponent>(event.CollisionA);
+				CollisionComponent* collisionB = m_ComponentManager.GetComponentPtr<CollisionComponent>(event.CollisionB);
+				if (!(collisionA && collisionA->HasContactCallback()) && !(collisionB && collisionB->HasContactCallback()))
+					continue;
 			}
+
+			// resolved per event, a handler that did not defer may have removed colliders
+			std::shared_ptr<CollisionComponent> collisionA = m_ComponentManager.GetComponent<CollisionComponent>(event.CollisionA);
+			std::shared_ptr<CollisionComponent> collisionB = m_ComponentManager.GetComponent<CollisionComponent>(event.CollisionB);
+			if (event.Type != ContactEventType::End && (!collisionA || !collisionB))
+				continue;
+
+			if (collisionA)
+				collisionA->OnContact(event.Type, collisionB, event.TimeOfImpact);
+			if (collisionB && m_ComponentManager.GetComponentPtr<CollisionComponent>(event.CollisionB) == collisionB.get())
+				collisionB->OnContact(event.Type, collisionA, event.TimeOfImpact);
 		}
+		m_bDispatchingContacts = false;
 
-		// * runs N^2 times, well, very straightforward...
-		//for (auto& collisionA : collisions)
-		//{
-		//	for (auto& collisionB : collisions)
-		//	{
-		//		if (collisionA == collisionB) continue;
-
-		//		if (collisionA->Intersects(collisionB))
-		//		{
-		//			if (collisionA && collisionB)
-		//				collisionA->OnCollision(collisionB);
-		//		}
-		//	}
-		//}
-
-		// * this runs less times but i am creating the vector every frame which is not ideal. probably switcing
-		// * to an octree and reducing calculations this way is way more efficient and may be beneficial
-		// * this still runs N^2 times
-		//std::vector<std::shared_ptr<CollisionComponent>> colVec(collisions.begin(), collisions.end());
-		//for (int a = 0; a < colVec.size(); ++a)
-		//{
-		//	for (int b = a + 1; b < colVec.size(); ++b)
-		//	{
-		//		if (colVec[a]->Intersects(colVec[b]))
-		//		{
-		//			colVec[a]->OnCollision(colVec[b]);
-		//			colVec[b]->OnCollision(colVec[a]);
-		//		}
-		//	}
-		//}
+		// swapped out first, a deferred command may defer the next one
+		while (!m_DeferredCommands.empty())
+		{
+			std::vector<std::function<void()>> commands;
+			std::swap(commands, m_DeferredCommands);
+			for (auto& command : commands)
+				command();
+		}
 	}
 
 	void Scene::RenderScene()
@@ -125,6 +241,12 @@ namespace Blainn
 	{
 		m_AllObjects.push_back(obj);
 
+		// children registered after their parent are already part of its subtree
+		if (obj->m_ParentScene != this)
+			InsertIntoUpdateOrder(obj);
+		else
+			ResetCollisionMotion(*obj);
+
 		obj->OnBegin();
 	}
 
@@ -136,10 +258,162 @@ namespace Blainn
 
 		obj->OnDestroy();
 
+		// detaching the subtree first keeps RemoveChild from queueing obj once more
+		RemoveFromUpdateOrder(obj.get());
 		if (auto parent = obj->GetParent())
 			parent->RemoveChild(obj);
 	}
 
+	void Scene::InsertIntoUpdateOrder(std::shared_ptr<GameObject> obj)
+	{
+		// depth first, so the subtree stays contiguous with parents first
+		std::vector<std::shared_ptr<GameObject>> subtree;
+		std::vector<std::shared_ptr<GameObject>> stack{ obj };
+		while (!stack.empty())
+		{
+			auto node = stack.back();
+			stack.pop_back();
+			subtree.push_back(node);
+
+			const auto& children = node->GetChildren();
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+				stack.push_back(*it);
+		}
+
+		// parts of the subtree may already be placed, e.g. a child that got registered
+		// before its parent
+		for (auto& node : subtree)
+			if (node->m_ParentScene)
+				node->m_ParentScene->RemoveFromUpdateOrder(node.get());
+
+		size_t position = m_UpdateOrder.size();
+		GameObject* parent = obj->GetParentPtr();
+		if (parent && parent->m_ParentScene == this)
+			position = parent->m_UpdateOrderIndex + parent->m_OrderedSubtreeSize;
+
+		// spawned or reparented, a collider must not be swept from where it was before
+		for (auto& node : subtree)
+		{
+			node->m_ParentScene = this;
+			node->RegisterComponents(m_ComponentManager);
+			ResetCollisionMotion(*node);
+		}
+		// children follow their parent in the subtree, so in reverse every child's
+		// size is known before its parent's
+		for (auto it = subtree.rbegin(); it != subtree.rend(); ++it)
+		{
+			GameObject* node = it->get();
+			node->m_OrderedSubtreeSize = 1;
+			for (const auto& child : node->GetChildren())
+				node->m_OrderedSubtreeSize += child->m_OrderedSubtreeSize;
+		}
+
+		m_UpdateOrder.insert(m_UpdateOrder.begin() + position, subtree.begin(), subtree.end());
+		ReindexUpdateOrder(position, m_UpdateOrder.size());
+
+		std::vector<TransformHierarchy::Entry> entries;
+		entries.reserve(subtree.size());
+		for (auto& node : subtree)
+		{
+			GameObject* nodeParent = node->GetParentPtr();
+			bool bPlacedParent = nodeParent && nodeParent->m_ParentScene == this;
+			entries.push_back({ node->GetComponentPtr<TransformComponent>(),
+				bPlacedParent ? nodeParent->m_UpdateOrderIndex : TransformHierarchy::NoPosition,
+				node->m_OrderedSubtreeSize });
+		}
+		m_TransformHierarchy.Insert(uint32_t(position), entries);
+
+		if (parent && parent->m_ParentScene == this)
+			AddToOrderedSubtreeSizes(parent, int32_t(subtree.size()));
+	}
+
+	void Scene::RemoveFromUpdateOrder(GameObject* obj)
+	{
+		if (obj->m_ParentScene != this)
+			return;
+
+		size_t first = obj->m_UpdateOrderIndex;
+		size_t last = first + obj->m_OrderedSubtreeSize;
+		AddToOrderedSubtreeSizes(obj->GetParentPtr(), -int32_t(obj->m_OrderedSubtreeSize));
+		for (size_t i = first; i < last; ++i)
+		{
+			m_UpdateOrder[i]->UnregisterComponents();
+			m_UpdateOrder[i]->m_ParentScene = nullptr;
+			m_UpdateOrder[i]->m_UpdateOrderIndex = UINT32_MAX;
+			m_UpdateOrder[i]->m_OrderedSubtreeSize = 0;
+		}
+
+		m_UpdateOrder.erase(m_UpdateOrder.begin() + first, m_UpdateOrder.begin() + last);
+		ReindexUpdateOrder(first, m_UpdateOrder.size());
+		m_TransformHierarchy.Erase(uint32_t(first), uint32_t(last));
+	}
+
+	void Scene::MoveInUpdateOrder(GameObject* obj, GameObject* previousParent)
+	{
+		assert(obj->m_ParentScene == this);
+
+		size_t first = obj->m_UpdateOrderIndex;
+		uint32_t size = obj->m_OrderedSubtreeSize;
+
+		// the old ancestors still count the subtree, so when the new parent is one of
+		// them its size reaches past the subtree to the end of its own
+		size_t position = m_UpdateOrder.size();
+		GameObject* parent = obj->GetParentPtr();
+		if (parent)
+		{
+			assert(parent->m_ParentScene == this);
+			position = parent->m_UpdateOrderIndex + parent->m_OrderedSubtreeSize;
+		}
+
+		auto begin = m_UpdateOrder.begin();
+		if (position > first)
+		{
+			std::rotate(begin + first, begin + first + size, begin + position);
+			ReindexUpdateOrder(first, position);
+			m_TransformHierarchy.Rotate(uint32_t(first), uint32_t(first + size), uint32_t(position));
+		}
+		else
+		{
+			std::rotate(begin + position, begin + first, begin + first + size);
+			ReindexUpdateOrder(position, first + size);
+			m_TransformHierarchy.Rotate(uint32_t(position), uint32_t(first), uint32_t(first + size));
+		}
+		m_TransformHierarchy.SetParent(obj->m_UpdateOrderIndex, parent ? parent->m_UpdateOrderIndex : TransformHierarchy::NoPosition);
+
+		AddToOrderedSubtreeSizes(previousParent, -int32_t(size));
+		AddToOrderedSubtreeSizes(parent, int32_t(size));
+
+		for (size_t i = obj->m_UpdateOrderIndex; i < obj->m_UpdateOrderIndex + size; ++i)
+			ResetCollisionMotion(*m_UpdateOrder[i]);
+	}
+
+	void Scene::AddToOrderedSubtreeSizes(GameObject* ancestor, int32_t delta)
+	{
+		for (; ancestor && ancestor->m_ParentScene == this; ancestor = ancestor->GetParentPtr())
+		{
+			ancestor->m_OrderedSubtreeSize += delta;
+			m_TransformHierarchy.AddToSubtreeSize(ancestor->m_UpdateOrderIndex, delta);
+		}
+	}
+
+	void Scene::ResetCollisionMotion(GameObject& obj)
+	{
+		for (auto& collision : obj.GetComponents<CollisionComponent>())
+			collision->ResetMotion();
+	}
+
+	void Scene::ReindexUpdateOrder(size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; ++i)
+			m_UpdateOrder[i]->m_UpdateOrderIndex = uint32_t(i);
+	}
+
+	void Scene::RefreshTransform(GameObject& obj)
+	{
+		assert(obj.m_ParentScene == this);
+		m_TransformHierarchy.SetTransform(obj.m_UpdateOrderIndex, obj.GetComponentPtr<TransformComponent>());
+	}
+
 
 
 
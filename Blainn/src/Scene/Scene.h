@@ -1,25 +1,56 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include <stack>
-#include <windows.h>
 
 #include "Core/UUID.h"
+#include "CollisionLayers.h"
+#include "ContactCache.h"
+#include "Narrowphase.h"
+#include "SystemScheduler.h"
+#include "TransformHierarchy.h"
 
 namespace Blainn
 {
+	class AABBTree;
+	class BroadphaseSystem;
 	class CameraComponent;
 	class CollisionComponent;
 	class GameObject;
 	class GameTimer;
-	class StaticMeshComponent;
+	class JobSystem;
+	class SpatialIndexSystem;
+
+	struct SceneUpdateStats
+	{
+		uint32_t ObjectTicks = 0;
+		// Component OnUpdate calls, from game objects and from scene systems
+		uint32_t ComponentTicks = 0;
+		// Overlapping bounds the broadphase handed to the narrowphase
+		uint32_t BroadphasePairs = 0;
+		// Overlapping bounds dropped because their layers do not collide
+		uint32_t FilteredPairs = 0;
+		// Broadphase pairs the narrowphase found apart
+		uint32_t GeometryRejected = 0;
+		// Pairs with a fast collider that were swept
+		uint32_t SweptPairs = 0;
+		// Swept pairs that touched during the step but not at its end
+		uint32_t SweptHits = 0;
+		// Collider pairs touching after the collision step
+		uint32_t Contacts = 0;
+		uint32_t ContactBegins = 0;
+		uint32_t ContactEnds = 0;
+	};
 
 	class Scene
 	{
+		friend class GameObject;
 	public:
 		Scene();
+		~Scene();
 		Scene(const Scene& other) = delete;
 		Scene& operator=(const Scene& other) = delete;
 
@@ -39,31 +70,105 @@ namespace Blainn
 		std::shared_ptr<GameObject> QueueGameObject(std::shared_ptr<GameObject> gameObject);
 		void RemoveGameObject(std::shared_ptr<GameObject> gameObject);
 
-		const std::vector<StaticMeshComponent*>& GetRenderObjects() const { return m_AllRenderObjects; }
+		// Adding, removing or reparenting from a contact handler would pull colliders
+		// out from under the events still to be dispatched. Commands deferred here run
+		// once every contact event of the frame was handled, or right away when no
+		// dispatch is in progress.
+		void Defer(std::function<void()> command);
+
+		// Layers collide with each other unless turned off here, applied by the
+		// broadphase so filtered pairs never reach the narrowphase or any callback
+		void SetLayersCollide(uint32_t layerA, uint32_t layerB, bool bCollide) { m_CollisionLayers.SetLayersCollide(layerA, layerB, bCollide); }
+		const CollisionLayerMatrix& GetCollisionLayers() const { return m_CollisionLayers; }
+		// Begin, Stay and End events of the last collision step
+		const std::vector<ContactEvent>& GetContactEvents() const { return m_ContactCache.GetEvents(); }
+		// Pairs tested per shape combination in the last collision step
+		const NarrowphaseStats& GetNarrowphaseStats() const { return m_Narrowphase.GetStats(); }
+
+		SystemScheduler& GetSystemScheduler() { return m_SystemScheduler; }
+		// Components of the objects placed in this scene
+		ComponentManager& GetComponentManager() { return m_ComponentManager; }
+		const ComponentManager& GetComponentManager() const { return m_ComponentManager; }
+		// World transforms of the placed objects, in update order
+		const TransformHierarchy& GetTransformHierarchy() const { return m_TransformHierarchy; }
+		TransformHierarchy& GetTransformHierarchy() { return m_TransformHierarchy; }
+		// Bounds of every transformed object as of the last UpdateScene, for frustum,
+		// overlap and ray queries
+		const AABBTree& GetSpatialIndex() const;
+
+		// Every object of the scene, parents before children and subtrees contiguous
+		const std::vector<std::shared_ptr<GameObject>>& GetUpdateOrder() const { return m_UpdateOrder; }
+		// Counters of the last UpdateScene
+		const SceneUpdateStats& GetUpdateStats() const { return m_UpdateStats; }
+		void AddComponentTicks(uint32_t count) { m_UpdateStats.ComponentTicks += count; }
 
 		void SetMainCamera(std::shared_ptr<CameraComponent> camera) { m_MainCamera = camera; }
 		std::shared_ptr<CameraComponent> GetMainCamera() const { return m_MainCamera; }
 
-		void SetPlayerCollision(std::shared_ptr<CollisionComponent> collision) { m_PlayerCollision = collision; }
-		std::shared_ptr<CollisionComponent> GetPlayerCollision() const { return m_PlayerCollision; }
-
 	private:
+		// Narrowphase over the broadphase pairs and sweeps of the fast colliders among
+		// them, feeds the touching ones to the contact cache
+		void UpdateCollisions(JobSystem* jobSystem);
+		void DispatchContactEvents();
+
 		void ProcessPendingAdditions();
 		void ProcessPendingRemovals();
 
 		void RegisterObject(std::shared_ptr<GameObject> obj);
 		void RemoveFromScene(std::shared_ptr<GameObject> obj);
 
+		// Inserts obj with its whole subtree right after its parent's subtree,
+		// or at the end when obj is a root. Called by GameObject on reparenting.
+		void InsertIntoUpdateOrder(std::shared_ptr<GameObject> obj);
+		void RemoveFromUpdateOrder(GameObject* obj);
+		// Moves the placed subtree of obj, whose parent just changed from
+		// previousParent, behind its new parent's subtree or to the end. Only the
+		// range between the old and the new place is reindexed.
+		void MoveInUpdateOrder(GameObject* obj, GameObject* previousParent);
+		// Adds delta to the subtree size of ancestor and of every placed ancestor above it
+		void AddToOrderedSubtreeSizes(GameObject* ancestor, int32_t delta);
+		void ReindexUpdateOrder(size_t first, size_t last);
+		// Points the hierarchy entry of a placed object at its transform, called by
+		// GameObject as components come and go
+		void RefreshTransform(GameObject& obj);
+		void ResetCollisionMotion(GameObject& obj);
+
 	private:
 		std::vector<std::shared_ptr<GameObject>> m_AllObjects;
-		std::vector<StaticMeshComponent*> m_AllRenderObjects;
-		std::vector<StaticMeshComponent*> m_OpaqueObjects;
-		std::vector<StaticMeshComponent*> m_TransparentObjects;
+		std::vector<std::shared_ptr<GameObject>> m_UpdateOrder;
+		// m_UpdateOrder as the frame's update loop started, reparenting during the
+		// loop moves objects in the order but not in here
+		std::vector<GameObject*> m_UpdateSnapshot;
+		SceneUpdateStats m_UpdateStats;
 
 		std::vector<std::shared_ptr<GameObject>> m_PendingAdditions;
 		std::vector<std::shared_ptr<GameObject>> m_PendingRemovals;
 
+		// ahead of the scheduler, which hands them to the systems
+		ComponentManager m_ComponentManager;
+		TransformHierarchy m_TransformHierarchy;
+		SystemScheduler m_SystemScheduler;
+		std::shared_ptr<SpatialIndexSystem> m_SpatialIndex;
+		std::shared_ptr<BroadphaseSystem> m_Broadphase;
+		CollisionLayerMatrix m_CollisionLayers;
+
+		Narrowphase m_Narrowphase;
+		std::vector<NarrowphasePair> m_NarrowphasePairs;
+		std::vector<uint8_t> m_PairTouching;
+		struct SweptPair
+		{
+			uint32_t Pair;
+			CollisionComponent* CollisionA;
+			CollisionComponent* CollisionB;
+			float TimeOfImpact;
+		};
+		// Broadphase pairs with a fast collider, in pair order
+		std::vector<SweptPair> m_SweptPairs;
+		ContactCache m_ContactCache;
+		std::vector<ContactPair> m_TouchingPairs;
+		std::vector<std::function<void()>> m_DeferredCommands;
+		bool m_bDispatchingContacts = false;
+
 		std::shared_ptr<CameraComponent> m_MainCamera = nullptr;
-		std::shared_ptr<CollisionComponent> m_PlayerCollision = nullptr;
 	};
 }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "System.h"
+#include "TransformHierarchy.h"
+
+#include "Components/ActorComponents/CharacterComponents/CameraComponent.h"
+#include "Components/ActorComponents/CharacterComponents/InputComponent.h"
+#include "Components/ActorComponents/PhysicsComponents/CollisionComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
+
+namespace Blainn
+{
+	// Input handlers query window state and move transforms around, so they stay on
+	// the main thread and ahead of transform propagation.
+	class InputSystem : public ComponentUpdateSystem<InputComponent>
+	{
+	public:
+		InputSystem()
+			: ComponentUpdateSystem("Input")
+		{
+			Writes<TransformComponent>();
+			SetMainThreadOnly(true);
+		}
+	};
+
+	// Propagates world transforms through the scene's SoA TransformHierarchy instead
+	// of per-object parent chasing, root subtrees spread over the job system for big
+	// scenes.
+	class TransformSystem : public System
+	{
+	public:
+		TransformSystem(TransformHierarchy& hierarchy)
+			: System("Transform")
+			, m_Hierarchy(hierarchy)
+		{
+			Drives<TransformComponent>();
+		}
+
+		void OnUpdate(const GameTimer& gt, JobSystem* jobSystem) override
+		{
+			m_Hierarchy.Update(jobSystem);
+			SetComponentTicks(m_Hierarchy.GetUpdatedCount());
+		}
+
+	private:
+		TransformHierarchy& m_Hierarchy;
+	};
+
+	class CollisionBoundsSystem : public ComponentUpdateSystem<CollisionComponent>
+	{
+	public:
+		CollisionBoundsSystem()
+			: ComponentUpdateSystem("CollisionBounds", 64)
+		{
+			Reads<TransformComponent>();
+		}
+	};
+
+	class CameraSystem : public ComponentUpdateSystem<CameraComponent>
+	{
+	public:
+		CameraSystem()
+			: ComponentUpdateSystem("Camera", 16)
+		{
+			Reads<TransformComponent>();
+		}
+	};
+}
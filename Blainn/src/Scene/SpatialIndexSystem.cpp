@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "SpatialIndexSystem.h"
+
+#include "Components/ActorComponents/PhysicsComponents/CollisionComponent.h"
+#include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Core/GameObject.h"
+#include "Render/Model.h"
+
+namespace Blainn
+{
+	SpatialIndexSystem::SpatialIndexSystem()
+		: System("SpatialIndex")
+	{
+		// runs after the transforms and collision shapes of the frame are final
+		Reads<TransformComponent, CollisionComponent, StaticMeshComponent>();
+	}
+
+	void SpatialIndexSystem::OnUpdate(const GameTimer& gt, JobSystem* jobSystem)
+	{
+		auto& componentManager = GetComponentManager();
+
+		// a mesh or collision shape showing up changes bounds without moving anything
+		uint64_t meshSetVersion = componentManager.GetComponentSetVersion<StaticMeshComponent>();
+		uint64_t collisionSetVersion = componentManager.GetComponentSetVersion<CollisionComponent>();
+		bool bRefreshAll = meshSetVersion != m_MeshSetVersion || collisionSetVersion != m_CollisionSetVersion;
+		m_MeshSetVersion = meshSetVersion;
+		m_CollisionSetVersion = collisionSetVersion;
+
+		m_ReinsertedCount = 0;
+
+		// backwards, Untrack moves the last entry into the freed spot
+		for (uint32_t i = uint32_t(m_Tracked.size()); i-- > 0;)
+		{
+			TrackedProxy& tracked = m_Tracked[i];
+			TransformComponent* transform = componentManager.GetComponentPtr<TransformComponent>(tracked.Transform);
+			if (!transform)
+			{
+				Untrack(i);
+				continue;
+			}
+
+			if (!bRefreshAll && transform->GetWorldVersion() == tracked.WorldVersion)
+				continue;
+
+			AABB bounds = ComputeBounds(*transform);
+			DirectX::XMFLOAT3 center{
+				(bounds.Min.x + bounds.Max.x) * 0.5f,
+				(bounds.Min.y + bounds.Max.y) * 0.5f,
+				(bounds.Min.z + bounds.Max.z) * 0.5f };
+			DirectX::XMFLOAT3 displacement{ center.x - tracked.Center.x, center.y - tracked.Center.y, center.z - tracked.Center.z };
+
+			tracked.WorldVersion = transform->GetWorldVersion();
+			tracked.Center = center;
+			if (m_Tree.MoveProxy(tracked.Proxy, bounds, displacement))
+				m_ReinsertedCount++;
+		}
+
+		uint64_t transformSetVersion = componentManager.GetComponentSetVersion<TransformComponent>();
+		if (transformSetVersion != m_TransformSetVersion)
+		{
+			TrackNewTransforms();
+			m_TransformSetVersion = transformSetVersion;
+		}
+	}
+
+	void SpatialIndexSystem::TrackNewTransforms()
+	{
+		for (const auto& transform : GetComponentManager().GetComponents<TransformComponent>())
+		{
+			ComponentHandle handle = transform->GetStorageHandle();
+			if (handle.Index < m_TrackedBySlot.size())
+			{
+				uint32_t trackedIndex = m_TrackedBySlot[handle.Index];
+				if (trackedIndex != UINT32_MAX && m_Tracked[trackedIndex].Transform == handle)
+					continue;
+			}
+			else
+			{
+				m_TrackedBySlot.resize(handle.Index + 1, UINT32_MAX);
+			}
+
+			AABB bounds = ComputeBounds(*transform);
+
+			TrackedProxy tracked;
+			tracked.Transform = handle;
+			tracked.Proxy = m_Tree.CreateProxy(bounds, transform->GetOwnerHandle());
+			tracked.WorldVersion = transform->GetWorldVersion();
+			tracked.Center = {
+				(bounds.Min.x + bounds.Max.x) * 0.5f,
+				(bounds.Min.y + bounds.Max.y) * 0.5f,
+				(bounds.Min.z + bounds.Max.z) * 0.5f };
+
+			m_TrackedBySlot[handle.Index] = uint32_t(m_Tracked.size());
+			m_Tracked.push_back(tracked);
+		}
+	}
+
+	void SpatialIndexSystem::Untrack(uint32_t trackedIndex)
+	{
+		TrackedProxy& tracked = m_Tracked[trackedIndex];
+		m_Tree.DestroyProxy(tracked.Proxy);
+		m_TrackedBySlot[tracked.Transform.Index] = UINT32_MAX;
+
+		if (trackedIndex != m_Tracked.size() - 1)
+		{
+			tracked = m_Tracked.back();
+			m_TrackedBySlot[tracked.Transform.Index] = trackedIndex;
+		}
+		m_Tracked.pop_back();
+	}
+
+	AABB SpatialIndexSystem::ComputeBounds(const TransformComponent& transform)
+	{
+		using namespace DirectX;
+
+		XMFLOAT3 position = transform.GetWorldPosition();
+		AABB bounds{ position, position };
+
+		GameObject* owner = transform.GetOwnerPtr();
+		if (!owner)
+			return bounds;
+
+		if (StaticMeshComponent* mesh = owner->GetComponentPtr<StaticMeshComponent>())
+		{
+			BoundingBox worldBounds;
+			mesh->GetModel()->GetBounds().Transform(worldBounds, XMLoadFloat4x4(&transform.GetWorldMatrix()));
+			bounds = AABB::Combine(bounds, AABB::FromCenterExtents(worldBounds.Center, worldBounds.Extents));
+		}
+
+		if (CollisionComponent* collision = owner->GetComponentPtr<CollisionComponent>())
+		{
+			BoundingBox shapeBounds = collision->GetBounds();
+			bounds = AABB::Combine(bounds, AABB::FromCenterExtents(shapeBounds.Center, shapeBounds.Extents));
+		}
+
+		return bounds;
+	}
+}
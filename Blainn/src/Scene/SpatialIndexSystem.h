@@ -0,0 +1,53 @@
+#pragma once
+
+#include "AABBTree.h"
+#include "System.h"
+
+#include <vector>
+
+namespace Blainn
+{
+	class TransformComponent;
+
+	// Keeps one AABBTree proxy per TransformComponent. A proxy covers the owner's static
+	// mesh and collision shape, or just its position when it has neither. Proxies are
+	// only refreshed for transforms whose world version changed, and the fat AABBs
+	// absorb most of those moves without touching the tree.
+	class SpatialIndexSystem : public System
+	{
+	public:
+		SpatialIndexSystem();
+
+		void OnUpdate(const GameTimer& gt, JobSystem* jobSystem) override;
+
+		const AABBTree& GetTree() const { return m_Tree; }
+		// Proxies reinserted by the last update
+		uint32_t GetReinsertedCount() const { return m_ReinsertedCount; }
+
+	private:
+		struct TrackedProxy
+		{
+			ComponentHandle Transform;
+			int32_t Proxy = AABBTree::NullNode;
+			uint32_t WorldVersion = 0;
+			DirectX::XMFLOAT3 Center{ 0.f, 0.f, 0.f };
+		};
+
+		void TrackNewTransforms();
+		void Untrack(uint32_t trackedIndex);
+		static AABB ComputeBounds(const TransformComponent& transform);
+
+	private:
+		AABBTree m_Tree;
+
+		std::vector<TrackedProxy> m_Tracked;
+		// Indexed by ComponentHandle::Index, holds an index into m_Tracked
+		std::vector<uint32_t> m_TrackedBySlot;
+
+		uint64_t m_TransformSetVersion = UINT64_MAX;
+		uint64_t m_MeshSetVersion = UINT64_MAX;
+		uint64_t m_CollisionSetVersion = UINT64_MAX;
+
+		uint32_t m_ReinsertedCount = 0;
+	};
+}
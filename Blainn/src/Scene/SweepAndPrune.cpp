@@ -0,0 +1,299 @@
+#include "pch.h"
+#include "SweepAndPrune.h"
+
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BLAINN_SWEEP_SSE
+#endif
+
+namespace Blainn
+{
+	uint32_t SweepAndPrune::CreateProxy(const AABB& aabb, ComponentHandle userData, const CollisionFilter& filter)
+	{
+		uint32_t proxyId;
+		if (m_FreeList != NullProxy)
+		{
+			proxyId = m_FreeList;
+			m_FreeList = m_Proxies[proxyId].NextFree;
+		}
+		else
+		{
+			proxyId = uint32_t(m_Proxies.size());
+			m_Proxies.emplace_back();
+		}
+
+		Proxy& proxy = m_Proxies[proxyId];
+		proxy.UserData = userData;
+		proxy.SortedIndex = uint32_t(m_Sorted.size());
+		proxy.NextFree = NullProxy;
+
+		m_Sorted.push_back({ aabb, filter, proxyId });
+		m_ProxyCount++;
+		return proxyId;
+	}
+
+	void SweepAndPrune::DestroyProxy(uint32_t proxyId)
+	{
+		assert(proxyId < m_Proxies.size() && m_Proxies[proxyId].SortedIndex != NullProxy);
+
+		Proxy& proxy = m_Proxies[proxyId];
+		m_Sorted[proxy.SortedIndex].Proxy = NullProxy;
+		m_bHasDestroyed = true;
+
+		proxy.UserData = {};
+		proxy.SortedIndex = NullProxy;
+		proxy.NextFree = m_FreeList;
+		m_FreeList = proxyId;
+		m_ProxyCount--;
+	}
+
+	void SweepAndPrune::MoveProxy(uint32_t proxyId, const AABB& aabb)
+	{
+		assert(proxyId < m_Proxies.size() && m_Proxies[proxyId].SortedIndex != NullProxy);
+		m_Sorted[m_Proxies[proxyId].SortedIndex].Box = aabb;
+	}
+
+	void SweepAndPrune::SetFilter(uint32_t proxyId, const CollisionFilter& filter)
+	{
+		assert(proxyId < m_Proxies.size() && m_Proxies[proxyId].SortedIndex != NullProxy);
+		m_Sorted[m_Proxies[proxyId].SortedIndex].Filter = filter;
+	}
+
+	void SweepAndPrune::UpdatePairs(JobSystem* jobSystem)
+	{
+		m_Stats = {};
+		m_Pairs.clear();
+
+		RemoveDestroyed();
+		Sort();
+
+		for (uint32_t i = 0; i < uint32_t(m_Sorted.size()); ++i)
+			m_Proxies[m_Sorted[i].Proxy].SortedIndex = i;
+		m_SortedCount = uint32_t(m_Sorted.size());
+
+		PrepareSweep();
+
+		// chunks of the sweep write their own pair lists, merged in chunk order so the
+		// result does not depend on the worker count
+		uint32_t chunkCount = (m_SortedCount + SweepChunkSize - 1) / SweepChunkSize;
+		if (m_ChunkPairs.size() < chunkCount)
+			m_ChunkPairs.resize(chunkCount);
+		m_ChunkCounters.assign(chunkCount, {});
+
+		auto sweepChunks = [this](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t chunk = begin; chunk < end; ++chunk)
+				{
+					m_ChunkPairs[chunk].clear();
+					m_ChunkCounters[chunk] = SweepRange(chunk * SweepChunkSize,
+						std::min(m_SortedCount, (chunk + 1) * SweepChunkSize), m_ChunkPairs[chunk]);
+				}
+			};
+		if (jobSystem && chunkCount > 1)
+			jobSystem->ParallelFor(0, chunkCount, 1, sweepChunks);
+		else
+			sweepChunks(0, chunkCount);
+
+		for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			m_Pairs.insert(m_Pairs.end(), m_ChunkPairs[chunk].begin(), m_ChunkPairs[chunk].end());
+			m_Stats.AxisTests += m_ChunkCounters[chunk].AxisTests;
+			m_Stats.FilteredPairs += m_ChunkCounters[chunk].FilteredPairs;
+		}
+
+		m_Stats.Proxies = m_ProxyCount;
+		m_Stats.Pairs = uint32_t(m_Pairs.size());
+	}
+
+	void SweepAndPrune::RemoveDestroyed()
+	{
+		if (!m_bHasDestroyed)
+			return;
+
+		// stable, so what survives stays sorted
+		uint32_t oldSortedCount = m_SortedCount;
+		uint32_t write = 0;
+		for (uint32_t read = 0; read < uint32_t(m_Sorted.size()); ++read)
+		{
+			if (m_Sorted[read].Proxy == NullProxy)
+			{
+				if (read < oldSortedCount)
+					m_SortedCount--;
+				continue;
+			}
+			m_Sorted[write++] = m_Sorted[read];
+		}
+		m_Sorted.resize(write);
+		m_bHasDestroyed = false;
+	}
+
+	void SweepAndPrune::Sort()
+	{
+		const int axis = m_NextAxis;
+		auto lessByMin = [axis](const SortedEntry& a, const SortedEntry& b) { return GetMin(a.Box, axis) < GetMin(b.Box, axis); };
+
+		if (axis != m_Axis)
+		{
+			m_Axis = axis;
+			std::sort(m_Sorted.begin(), m_Sorted.end(), lessByMin);
+			m_Stats.bFullSort = true;
+			return;
+		}
+
+		// the old entries are almost sorted already, only neighbours that passed each
+		// other since the last update get shifted
+		auto begin = m_Sorted.begin();
+		auto sortedEnd = begin + m_SortedCount;
+		for (auto it = begin + (m_SortedCount > 0 ? 1 : 0); it < sortedEnd; ++it)
+		{
+			float key = GetMin(it->Box, axis);
+			if (GetMin((it - 1)->Box, axis) <= key)
+				continue;
+
+			SortedEntry entry = *it;
+			auto hole = it;
+			do
+			{
+				*hole = *(hole - 1);
+				--hole;
+				m_Stats.SortShifts++;
+			} while (hole > begin && GetMin((hole - 1)->Box, axis) > key);
+			*hole = entry;
+		}
+
+		if (sortedEnd != m_Sorted.end())
+		{
+			std::sort(sortedEnd, m_Sorted.end(), lessByMin);
+			std::inplace_merge(begin, sortedEnd, m_Sorted.end(), lessByMin);
+		}
+	}
+
+	void SweepAndPrune::PrepareSweep()
+	{
+		const int axis = m_Axis;
+		const int axisU = (axis + 1) % 3;
+		const int axisV = (axis + 2) % 3;
+		const uint32_t count = uint32_t(m_Sorted.size());
+
+		// SoA copy in sort order, padded with boxes that start at infinity so the
+		// 4 wide loop of SweepRange runs out on its own
+		const uint32_t paddedCount = count + 4;
+		m_SweepMin.resize(paddedCount);
+		m_SweepMax.resize(paddedCount);
+		m_SweepMinU.resize(paddedCount);
+		m_SweepMaxU.resize(paddedCount);
+		m_SweepMinV.resize(paddedCount);
+		m_SweepMaxV.resize(paddedCount);
+
+		// center statistics for picking the next update's axis
+		double sum[3] = { 0.0, 0.0, 0.0 };
+		double sumSq[3] = { 0.0, 0.0, 0.0 };
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const AABB& box = m_Sorted[i].Box;
+			m_SweepMin[i] = GetMin(box, axis);
+			m_SweepMax[i] = GetMax(box, axis);
+			m_SweepMinU[i] = GetMin(box, axisU);
+			m_SweepMaxU[i] = GetMax(box, axisU);
+			m_SweepMinV[i] = GetMin(box, axisV);
+			m_SweepMaxV[i] = GetMax(box, axisV);
+
+			double cx = 0.5 * (double(box.Min.x) + box.Max.x);
+			double cy = 0.5 * (double(box.Min.y) + box.Max.y);
+			double cz = 0.5 * (double(box.Min.z) + box.Max.z);
+			sum[0] += cx; sum[1] += cy; sum[2] += cz;
+			sumSq[0] += cx * cx; sumSq[1] += cy * cy; sumSq[2] += cz * cz;
+		}
+		for (uint32_t i = count; i < paddedCount; ++i)
+		{
+			m_SweepMin[i] = m_SweepMax[i] = std::numeric_limits<float>::infinity();
+			m_SweepMinU[i] = m_SweepMinV[i] = std::numeric_limits<float>::infinity();
+			m_SweepMaxU[i] = m_SweepMaxV[i] = -std::numeric_limits<float>::infinity();
+		}
+
+		if (count < 2)
+			return;
+
+		double variance[3];
+		for (int i = 0; i < 3; ++i)
+			variance[i] = sumSq[i] - sum[i] * sum[i] / count;
+
+		// some slack, so two similar axes do not trigger a full sort every update
+		int bestAxis = m_Axis;
+		for (int i = 0; i < 3; ++i)
+			if (variance[i] > variance[bestAxis] * 1.25)
+				bestAxis = i;
+		m_NextAxis = bestAxis;
+	}
+
+	SweepAndPrune::SweepCounters SweepAndPrune::SweepRange(uint32_t begin, uint32_t end, std::vector<BroadphasePair>& outPairs) const
+	{
+		const uint32_t count = uint32_t(m_Sorted.size());
+		const SortedEntry* entries = m_Sorted.data();
+		const float* minS = m_SweepMin.data();
+		const float* maxS = m_SweepMax.data();
+		const float* minU = m_SweepMinU.data();
+		const float* maxU = m_SweepMaxU.data();
+		const float* minV = m_SweepMinV.data();
+		const float* maxV = m_SweepMaxV.data();
+
+		SweepCounters counters;
+		// layers are only looked at for boxes that overlap, which are few
+		auto addPair = [&outPairs, &counters, entries](uint32_t i, uint32_t j)
+			{
+				if (!entries[i].Filter.Accepts(entries[j].Filter))
+				{
+					counters.FilteredPairs++;
+					return;
+				}
+				uint32_t a = entries[i].Proxy, b = entries[j].Proxy;
+				outPairs.push_back(a < b ? BroadphasePair{ a, b } : BroadphasePair{ b, a });
+			};
+
+		// every box starting before box i ends overlaps it on the sort axis, and the
+		// sort order already guarantees it does not end before box i starts
+		uint32_t axisTests = 0;
+		for (uint32_t i = begin; i < end; ++i)
+		{
+#if defined(BLAINN_SWEEP_SSE)
+			const __m128 sweepMax = _mm_set1_ps(maxS[i]);
+			const __m128 boxMinU = _mm_set1_ps(minU[i]), boxMaxU = _mm_set1_ps(maxU[i]);
+			const __m128 boxMinV = _mm_set1_ps(minV[i]), boxMaxV = _mm_set1_ps(maxV[i]);
+
+			for (uint32_t j = i + 1; j < count; j += 4)
+			{
+				__m128 inRange = _mm_cmple_ps(_mm_loadu_ps(minS + j), sweepMax);
+				__m128 overlapU = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(minU + j), boxMaxU), _mm_cmple_ps(boxMinU, _mm_loadu_ps(maxU + j)));
+				__m128 overlapV = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(minV + j), boxMaxV), _mm_cmple_ps(boxMinV, _mm_loadu_ps(maxV + j)));
+
+				uint32_t rangeMask = uint32_t(_mm_movemask_ps(inRange));
+				uint32_t overlapMask = uint32_t(_mm_movemask_ps(_mm_and_ps(inRange, _mm_and_ps(overlapU, overlapV))));
+				axisTests += 4;
+
+				for (uint32_t lane = 0; overlapMask != 0; ++lane, overlapMask >>= 1)
+					if (overlapMask & 1u)
+						addPair(i, j + lane);
+
+				// sorted, so once one lane is out of range all that follow are too
+				if (rangeMask != 0xFu)
+					break;
+			}
+#else
+			for (uint32_t j = i + 1; j < count && minS[j] <= maxS[i]; ++j)
+			{
+				axisTests++;
+				if (minU[j] <= maxU[i] && minU[i] <= maxU[j] && minV[j] <= maxV[i] && minV[i] <= maxV[j])
+					addPair(i, j);
+			}
+#endif
+		}
+		counters.AxisTests = axisTests;
+		return counters;
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "AABBTree.h"
+#include "CollisionLayers.h"
+#include "Components/ComponentManager.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	class JobSystem;
+
+	struct BroadphasePair
+	{
+		// ProxyA < ProxyB
+		uint32_t ProxyA;
+		uint32_t ProxyB;
+	};
+
+	struct SweepAndPruneStats
+	{
+		uint32_t Proxies = 0;
+		uint32_t Pairs = 0;
+		// Entries shifted by the insertion sort, stays low while motion is coherent
+		uint32_t SortShifts = 0;
+		// Overlapping boxes whose filters did not accept each other
+		uint32_t FilteredPairs = 0;
+		// Axis tests done by the sweep
+		uint32_t AxisTests = 0;
+		bool bFullSort = false;
+	};
+
+	// Persistent sort and sweep over one axis. Boxes stay sorted by their minimum
+	// between frames, so the insertion sort only shifts entries that passed each other
+	// since the last update. The axis is the one with the highest variance of box
+	// centers, switching axis costs one full sort. Freshly created proxies are sorted
+	// on their own and merged in, so spawning thousands of them is not quadratic.
+	class SweepAndPrune
+	{
+	public:
+		static constexpr uint32_t NullProxy = UINT32_MAX;
+		static constexpr uint32_t SweepChunkSize = 2048;
+
+		uint32_t CreateProxy(const AABB& aabb, ComponentHandle userData, const CollisionFilter& filter = {});
+		void DestroyProxy(uint32_t proxyId);
+		void MoveProxy(uint32_t proxyId, const AABB& aabb);
+		void SetFilter(uint32_t proxyId, const CollisionFilter& filter);
+
+		const AABB& GetAABB(uint32_t proxyId) const { return m_Sorted[m_Proxies[proxyId].SortedIndex].Box; }
+		ComponentHandle GetUserData(uint32_t proxyId) const { return m_Proxies[proxyId].UserData; }
+
+		// Sorts and sweeps, every pair of overlapping boxes ends up in GetPairs.
+		// The sweep is split into chunks for the job system when one is given.
+		void UpdatePairs(JobSystem* jobSystem = nullptr);
+		const std::vector<BroadphasePair>& GetPairs() const { return m_Pairs; }
+
+		uint32_t GetProxyCount() const { return m_ProxyCount; }
+		int GetSortAxis() const { return m_Axis; }
+		const SweepAndPruneStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Proxy
+		{
+			ComponentHandle UserData;
+			uint32_t SortedIndex = NullProxy;
+			uint32_t NextFree = NullProxy;
+		};
+
+		struct SortedEntry
+		{
+			AABB Box;
+			CollisionFilter Filter;
+			// NullProxy once destroyed, dropped by the next update
+			uint32_t Proxy;
+		};
+
+		static float GetMin(const AABB& box, int axis) { return axis == 0 ? box.Min.x : axis == 1 ? box.Min.y : box.Min.z; }
+		static float GetMax(const AABB& box, int axis) { return axis == 0 ? box.Max.x : axis == 1 ? box.Max.y : box.Max.z; }
+
+		struct SweepCounters
+		{
+			uint32_t AxisTests = 0;
+			uint32_t FilteredPairs = 0;
+		};
+
+		void RemoveDestroyed();
+		void Sort();
+		void PrepareSweep();
+		// Sweeps the sorted boxes [begin, end) against everything after them
+		SweepCounters SweepRange(uint32_t begin, uint32_t end, std::vector<BroadphasePair>& outPairs) const;
+
+	private:
+		std::vector<Proxy> m_Proxies;
+		uint32_t m_FreeList = NullProxy;
+		uint32_t m_ProxyCount = 0;
+
+		std::vector<SortedEntry> m_Sorted;
+		// Entries past this one were appended since the last update
+		uint32_t m_SortedCount = 0;
+		bool m_bHasDestroyed = false;
+
+		int m_Axis = 0;
+		int m_NextAxis = 0;
+
+		// Sort axis and the two others as SoA in sort order, rebuilt by every sweep
+		std::vector<float> m_SweepMin;
+		std::vector<float> m_SweepMax;
+		std::vector<float> m_SweepMinU;
+		std::vector<float> m_SweepMaxU;
+		std::vector<float> m_SweepMinV;
+		std::vector<float> m_SweepMaxV;
+
+		std::vector<std::vector<BroadphasePair>> m_ChunkPairs;
+		std::vector<SweepCounters> m_ChunkCounters;
+		std::vector<BroadphasePair> m_Pairs;
+		SweepAndPruneStats m_Stats;
+	};
+}
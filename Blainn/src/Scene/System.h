@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Components/ComponentManager.h"
+#include "Core/JobSystem.h"
+
+#include <string>
+
+namespace Blainn
+{
+	class GameTimer;
+
+	// A unit of per-frame scene work that declares which component families it reads
+	// and writes. The SystemScheduler runs systems whose declarations do not overlap
+	// at the same time, everything else keeps its registration order.
+	class System
+	{
+		friend class SystemScheduler;
+	public:
+		explicit System(std::string name)
+			: m_Name(std::move(name))
+		{}
+		virtual ~System() = default;
+
+		// jobSystem is null when the scene runs without worker threads
+		virtual void OnUpdate(const GameTimer& gt, JobSystem* jobSystem) = 0;
+
+		const std::string& GetName() const { return m_Name; }
+
+		const ComponentSignature& GetReads() const { return m_Reads; }
+		const ComponentSignature& GetWrites() const { return m_Writes; }
+		const ComponentSignature& GetDrives() const { return m_Drives; }
+		bool IsMainThreadOnly() const { return m_bMainThreadOnly; }
+		// Component updates done by the last OnUpdate
+		uint32_t GetComponentTicks() const { return m_ComponentTicks; }
+
+		bool ConflictsWith(const System& other) const
+		{
+			return (m_Writes & (other.m_Reads | other.m_Writes)).any()
+				|| (m_Reads & other.m_Writes).any();
+		}
+
+	protected:
+		template<typename... T>
+		void Reads() { (m_Reads.set(GetComponentTypeID<typename T::ComponentFamily>()), ...); }
+
+		template<typename... T>
+		void Writes() { (m_Writes.set(GetComponentTypeID<typename T::ComponentFamily>()), ...); }
+
+		// The system calls OnUpdate of these families itself, GameObject::OnUpdate skips them
+		template<typename... T>
+		void Drives()
+		{
+			Writes<T...>();
+			(m_Drives.set(GetComponentTypeID<typename T::ComponentFamily>()), ...);
+		}
+
+		// Components of the scene the system was added to
+		ComponentManager& GetComponentManager() const { return *m_ComponentManager; }
+
+		// For systems that touch window or input state
+		void SetMainThreadOnly(bool mainThreadOnly) { m_bMainThreadOnly = mainThreadOnly; }
+		void SetComponentTicks(uint32_t count) { m_ComponentTicks = count; }
+
+	private:
+		std::string m_Name;
+
+		ComponentSignature m_Reads;
+		ComponentSignature m_Writes;
+		ComponentSignature m_Drives;
+
+		bool m_bMainThreadOnly = false;
+		uint32_t m_ComponentTicks = 0;
+
+		ComponentManager* m_ComponentManager = nullptr;
+	};
+
+	// Calls OnUpdate on every registered component of family T, straight from the
+	// packed component set. A grain size of 0 keeps the loop on one thread, which is
+	// what components that reach into other components of the same family need.
+	template<typename T>
+	class ComponentUpdateSystem : public System
+	{
+	public:
+		ComponentUpdateSystem(std::string name, uint32_t grainSize = 0)
+			: System(std::move(name))
+			, m_GrainSize(grainSize)
+		{
+			Drives<T>();
+		}
+
+		void OnUpdate(const GameTimer& gt, JobSystem* jobSystem) override
+		{
+			const auto& components = GetComponentManager().GetComponents<typename T::ComponentFamily>();
+			uint32_t count = uint32_t(components.size());
+			SetComponentTicks(count);
+
+			if (!jobSystem || m_GrainSize == 0)
+			{
+				for (uint32_t i = 0; i < count; ++i)
+					components[i]->OnUpdate(gt);
+				return;
+			}
+
+			jobSystem->ParallelFor(0, count, m_GrainSize, [&components, &gt](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; ++i)
+						components[i]->OnUpdate(gt);
+				});
+		}
+
+	private:
+		uint32_t m_GrainSize;
+	};
+}
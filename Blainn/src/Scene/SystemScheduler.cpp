@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "SystemScheduler.h"
+
+#include "Core/GameTimer.h"
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+
+namespace Blainn
+{
+	void SystemScheduler::AddSystem(std::shared_ptr<System> system)
+	{
+		system->m_ComponentManager = &m_ComponentManager;
+		m_SystemDrivenFamilies |= system->GetDrives();
+		m_Systems.push_back(std::move(system));
+		m_bGraphDirty = true;
+	}
+
+	uint32_t SystemScheduler::Run(const GameTimer& gt, JobSystem* jobSystem)
+	{
+		if (m_bGraphDirty)
+			BuildGraph();
+
+		uint32_t componentTicks = 0;
+		for (const auto& level : m_Levels)
+			componentTicks += RunLevel(level, gt, jobSystem);
+		return componentTicks;
+	}
+
+	uint32_t SystemScheduler::GetLevelCount()
+	{
+		if (m_bGraphDirty)
+			BuildGraph();
+		return uint32_t(m_Levels.size());
+	}
+
+	void SystemScheduler::BuildGraph()
+	{
+		m_Levels.clear();
+
+		std::vector<uint32_t> systemLevels(m_Systems.size(), 0);
+		for (uint32_t i = 0; i < m_Systems.size(); ++i)
+		{
+			uint32_t level = 0;
+			for (uint32_t dependency = 0; dependency < i; ++dependency)
+				if (m_Systems[i]->ConflictsWith(*m_Systems[dependency]))
+					level = std::max(level, systemLevels[dependency] + 1);
+
+			systemLevels[i] = level;
+			if (level >= m_Levels.size())
+				m_Levels.resize(level + 1);
+			m_Levels[level].push_back(i);
+		}
+
+		m_bGraphDirty = false;
+	}
+
+	uint32_t SystemScheduler::RunLevel(const std::vector<uint32_t>& level, const GameTimer& gt, JobSystem* jobSystem)
+	{
+		uint32_t componentTicks = 0;
+		if (!jobSystem || level.size() == 1)
+		{
+			for (uint32_t index : level)
+			{
+				m_Systems[index]->OnUpdate(gt, jobSystem);
+				componentTicks += m_Systems[index]->GetComponentTicks();
+			}
+			return componentTicks;
+		}
+
+		JobCounter counter;
+		for (uint32_t index : level)
+		{
+			System* system = m_Systems[index].get();
+			if (!system->IsMainThreadOnly())
+				jobSystem->Schedule([system, &gt, jobSystem]() { system->OnUpdate(gt, jobSystem); }, &counter);
+		}
+
+		// main thread systems run here while the workers take the rest
+		for (uint32_t index : level)
+			if (m_Systems[index]->IsMainThreadOnly())
+				m_Systems[index]->OnUpdate(gt, jobSystem);
+
+		jobSystem->Wait(counter);
+
+		for (uint32_t index : level)
+			componentTicks += m_Systems[index]->GetComponentTicks();
+		return componentTicks;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "System.h"
+
+#include <memory>
+#include <vector>
+
+namespace Blainn
+{
+	class GameTimer;
+	class JobSystem;
+
+	// Orders scene systems into a dependency graph from their read/write declarations.
+	// A system depends on every earlier registered system it conflicts with. Systems are
+	// grouped into levels by their longest dependency chain, all systems of one level run
+	// concurrently on the job system and the next level starts once the previous is done.
+	class SystemScheduler
+	{
+	public:
+		// Systems added here work on the components of this manager only
+		explicit SystemScheduler(ComponentManager& componentManager)
+			: m_ComponentManager(componentManager)
+		{}
+
+		template<typename T, typename... Args>
+		std::shared_ptr<T> AddSystem(Args&&... args)
+		{
+			static_assert(std::is_base_of<System, T>::value, "T must be a System");
+
+			auto system = std::make_shared<T>(std::forward<Args>(args)...);
+			AddSystem(system);
+			return system;
+		}
+		void AddSystem(std::shared_ptr<System> system);
+
+		// Returns how many component updates the systems performed
+		uint32_t Run(const GameTimer& gt, JobSystem* jobSystem);
+
+		const std::vector<std::shared_ptr<System>>& GetSystems() const { return m_Systems; }
+		// Component families one of the systems updates instead of GameObject::OnUpdate
+		bool IsSystemDriven(ComponentTypeID family) const
+		{
+			return family < MaxComponentTypes && m_SystemDrivenFamilies.test(family);
+		}
+		uint32_t GetLevelCount();
+
+	private:
+		void BuildGraph();
+		uint32_t RunLevel(const std::vector<uint32_t>& level, const GameTimer& gt, JobSystem* jobSystem);
+
+	private:
+		ComponentManager& m_ComponentManager;
+		std::vector<std::shared_ptr<System>> m_Systems;
+		ComponentSignature m_SystemDrivenFamilies;
+
+		// system indices grouped by level, in registration order inside a level
+		std::vector<std::vector<uint32_t>> m_Levels;
+		bool m_bGraphDirty = true;
+	};
+}
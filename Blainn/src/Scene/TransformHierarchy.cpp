@@ -0,0 +1,346 @@
+#include "pch.h"
+#include "TransformHierarchy.h"
+
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+namespace Blainn
+{
+	TransformHierarchy::~TransformHierarchy()
+	{
+		// transforms outliving the arrays keep their state
+		Erase(0, GetEntryCount());
+	}
+
+	void TransformHierarchy::Update(JobSystem* jobSystem)
+	{
+		m_DirtyPositions.clear();
+		for (uint32_t node : m_DirtyNodes)
+		{
+			uint32_t position = m_NodePositions[node];
+			if (position != NoPosition)
+				m_DirtyPositions.push_back(position);
+		}
+		m_DirtyNodes.clear();
+		m_DirtyGeneration++;
+
+		uint32_t count = GetEntryCount();
+		m_UpdatedCount = 0;
+		if (uint64_t(m_DirtyPositions.size()) * SparseDirtyRatio < count)
+		{
+			// a subtree is a contiguous range, dirty entries inside one already done are skipped
+			std::sort(m_DirtyPositions.begin(), m_DirtyPositions.end());
+			uint32_t processedEnd = 0;
+			for (uint32_t position : m_DirtyPositions)
+			{
+				if (position < processedEnd)
+					continue;
+				processedEnd = position + m_SubtreeSizes[position];
+				m_UpdatedCount += RecomputeRange(position, processedEnd);
+			}
+			m_WorldStep++;
+			return;
+		}
+
+		m_Dirty.assign(count, 0);
+		for (uint32_t position : m_DirtyPositions)
+			m_Dirty[position] = 1;
+
+		if (!jobSystem || count < ParallelThreshold)
+		{
+			m_UpdatedCount = PropagateRange(0, count);
+			m_WorldStep++;
+			return;
+		}
+
+		// whole root subtrees per job, so every parent is done before its children
+		// without waiting on other jobs
+		m_ChunkEnds.clear();
+		uint32_t chunkBegin = 0;
+		for (uint32_t root = 0; root < count; root += m_SubtreeSizes[root])
+		{
+			assert(m_SubtreeSizes[root] > 0);
+			uint32_t end = root + m_SubtreeSizes[root];
+			if (end - chunkBegin >= ParallelGrainSize)
+			{
+				m_ChunkEnds.push_back(end);
+				chunkBegin = end;
+			}
+		}
+		if (chunkBegin < count)
+			m_ChunkEnds.push_back(count);
+
+		std::atomic<uint32_t> updatedCount{ 0 };
+		jobSystem->ParallelFor(0, uint32_t(m_ChunkEnds.size()), 1,
+			[this, &updatedCount](uint32_t begin, uint32_t end)
+			{
+				uint32_t first = begin == 0 ? 0 : m_ChunkEnds[begin - 1];
+				updatedCount.fetch_add(PropagateRange(first, m_ChunkEnds[end - 1]), std::memory_order_relaxed);
+			});
+		m_UpdatedCount = updatedCount.load();
+		m_WorldStep++;
+	}
+
+	void TransformHierarchy::Insert(uint32_t position, const std::vector<Entry>& entries)
+	{
+		if (entries.empty())
+			return;
+
+		uint32_t count = uint32_t(entries.size());
+		ForEachEntryArray([position, count](auto& array)
+		{
+			array.insert(array.begin() + position, count, typename std::decay_t<decltype(array)>::value_type{});
+		});
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Entry& entry = entries[i];
+			uint32_t entryPosition = position + i;
+			m_Nodes[entryPosition] = AllocateNode();
+			// parents come first, inside the block they already got their node
+			m_ParentNodes[entryPosition] = entry.Parent == NoPosition ? NoPosition : m_Nodes[entry.Parent];
+			m_SubtreeSizes[entryPosition] = entry.SubtreeSize;
+
+			ResetEntry(entryPosition);
+			if (entry.Transform)
+				AttachTransform(entryPosition, entry.Transform);
+		}
+		ReindexNodes(position, GetEntryCount());
+
+		QueueDirty(position);
+	}
+
+	void TransformHierarchy::Erase(uint32_t first, uint32_t last)
+	{
+		if (first >= last)
+			return;
+
+		for (uint32_t i = first; i < last; ++i)
+		{
+			if (m_Transforms[i])
+				DetachTransform(i);
+
+			// a node reused within the same update must be able to queue again
+			uint32_t node = m_Nodes[i];
+			m_NodePositions[node] = NoPosition;
+			m_DirtyStamps[node] = 0;
+			m_FreeNodes.push_back(node);
+		}
+
+		ForEachEntryArray([first, last](auto& array)
+		{
+			array.erase(array.begin() + first, array.begin() + last);
+		});
+		ReindexNodes(first, GetEntryCount());
+	}
+
+	void TransformHierarchy::Rotate(uint32_t first, uint32_t middle, uint32_t last)
+	{
+		ForEachEntryArray([first, middle, last](auto& array)
+		{
+			std::rotate(array.begin() + first, array.begin() + middle, array.begin() + last);
+		});
+		ReindexNodes(first, last);
+	}
+
+	void TransformHierarchy::AddToSubtreeSize(uint32_t position, int32_t delta)
+	{
+		m_SubtreeSizes[position] += delta;
+	}
+
+	void TransformHierarchy::SetParent(uint32_t position, uint32_t parent)
+	{
+		m_ParentNodes[position] = parent == NoPosition ? NoPosition : m_Nodes[parent];
+		QueueDirty(position);
+	}
+
+	void TransformHierarchy::SetTransform(uint32_t position, TransformComponent* transform)
+	{
+		if (m_Transforms[position] == transform)
+			return;
+
+		if (m_Transforms[position])
+			DetachTransform(position);
+		ResetEntry(position);
+		if (transform)
+			AttachTransform(position, transform);
+
+		QueueDirty(position);
+	}
+
+	void TransformHierarchy::QueueDirty(uint32_t position)
+	{
+		QueueDirtyNode(m_Nodes[position]);
+	}
+
+	uint32_t TransformHierarchy::AllocateNode()
+	{
+		if (!m_FreeNodes.empty())
+		{
+			uint32_t node = m_FreeNodes.back();
+			m_FreeNodes.pop_back();
+			return node;
+		}
+
+		m_NodePositions.push_back(NoPosition);
+		m_DirtyStamps.push_back(0);
+		return uint32_t(m_NodePositions.size() - 1);
+	}
+
+	void TransformHierarchy::ReindexNodes(uint32_t first, uint32_t last)
+	{
+		for (uint32_t i = first; i < last; ++i)
+			m_NodePositions[m_Nodes[i]] = i;
+	}
+
+	void TransformHierarchy::QueueDirtyNode(uint32_t node)
+	{
+		if (m_DirtyStamps[node] == m_DirtyGeneration)
+			return;
+
+		m_DirtyStamps[node] = m_DirtyGeneration;
+		m_DirtyNodes.push_back(node);
+	}
+
+	void TransformHierarchy::AttachTransform(uint32_t position, TransformComponent* transform)
+	{
+		m_Transforms[position] = transform;
+		m_LocalPositions[position] = transform->m_LocalTransform.Position;
+		m_LocalRotations[position] = transform->m_LocalTransform.Quaternion;
+		m_LocalScales[position] = transform->m_LocalTransform.Scale;
+		m_WorldMatrices[position] = transform->m_WorldMatrix;
+		m_WorldRotations[position] = transform->m_WorldTransform.Quaternion;
+		m_WorldScales[position] = transform->m_WorldTransform.Scale;
+
+		// steps of another hierarchy mean nothing here
+		History& history = m_History[position];
+		history.PreviousPosition = transform->m_PreviousWorldTransform.Position;
+		history.PreviousRotation = transform->m_PreviousWorldTransform.Quaternion;
+		history.PreviousScale = transform->m_PreviousWorldTransform.Scale;
+		history.WorldVersion = transform->m_WorldVersion;
+		history.WorldStep = 0;
+
+		transform->m_Hierarchy = this;
+		transform->m_HierarchyNode = m_Nodes[position];
+	}
+
+	void TransformHierarchy::DetachTransform(uint32_t position)
+	{
+		TransformComponent* transform = m_Transforms[position];
+		transform->m_LocalTransform.Position = m_LocalPositions[position];
+		transform->m_LocalTransform.Quaternion = m_LocalRotations[position];
+		transform->m_LocalTransform.Scale = m_LocalScales[position];
+		transform->m_WorldMatrix = m_WorldMatrices[position];
+		transform->m_WorldTransform.Position = m_WorldMatrices[position].Translation();
+		transform->m_WorldTransform.Quaternion = m_WorldRotations[position];
+		transform->m_WorldTransform.Scale = m_WorldScales[position];
+
+		const History& history = m_History[position];
+		transform->m_PreviousWorldTransform.Position = history.PreviousPosition;
+		transform->m_PreviousWorldTransform.Quaternion = history.PreviousRotation;
+		transform->m_PreviousWorldTransform.Scale = history.PreviousScale;
+		transform->m_WorldVersion = history.WorldVersion;
+
+		transform->m_Hierarchy = nullptr;
+		transform->m_HierarchyNode = NoPosition;
+		m_Transforms[position] = nullptr;
+	}
+
+	void TransformHierarchy::ResetEntry(uint32_t position)
+	{
+		m_Transforms[position] = nullptr;
+		m_LocalPositions[position] = DirectX::SimpleMath::Vector3(0.f, 0.f, 0.f);
+		m_LocalRotations[position] = DirectX::SimpleMath::Quaternion();
+		m_LocalScales[position] = DirectX::SimpleMath::Vector3(1.f, 1.f, 1.f);
+		m_WorldMatrices[position] = DirectX::SimpleMath::Matrix();
+		m_WorldRotations[position] = DirectX::SimpleMath::Quaternion();
+		m_WorldScales[position] = DirectX::SimpleMath::Vector3(1.f, 1.f, 1.f);
+		m_History[position] = {};
+	}
+
+	void TransformHierarchy::Compose(uint32_t position, uint32_t parent)
+	{
+		using namespace DirectX;
+
+		XMVECTOR scale = XMLoadFloat3(&m_LocalScales[position]);
+		XMVECTOR rotation = XMLoadFloat4(&m_LocalRotations[position]);
+		XMVECTOR translation = XMLoadFloat3(&m_LocalPositions[position]);
+
+		// S * R * T without the two extra matrix products
+		XMMATRIX world = XMMatrixRotationQuaternion(rotation);
+		world.r[0] = XMVectorMultiply(world.r[0], XMVectorSplatX(scale));
+		world.r[1] = XMVectorMultiply(world.r[1], XMVectorSplatY(scale));
+		world.r[2] = XMVectorMultiply(world.r[2], XMVectorSplatZ(scale));
+		world.r[3] = XMVectorSelect(g_XMIdentityR3, translation, g_XMSelect1110);
+
+		// entries without a transform keep identity, their children compose like roots
+		if (parent != NoPosition && m_Transforms[parent])
+		{
+			world = XMMatrixMultiply(world, XMLoadFloat4x4(&m_WorldMatrices[parent]));
+			// composing TRS directly matches Decompose as long as no shear is involved
+			rotation = XMQuaternionMultiply(rotation, XMLoadFloat4(&m_WorldRotations[parent]));
+			scale = XMVectorMultiply(scale, XMLoadFloat3(&m_WorldScales[parent]));
+		}
+
+		SnapshotPreviousWorld(position);
+		XMStoreFloat4x4(&m_WorldMatrices[position], world);
+		XMStoreFloat4(&m_WorldRotations[position], rotation);
+		XMStoreFloat3(&m_WorldScales[position], scale);
+
+		// nothing to blend from on the first write
+		History& history = m_History[position];
+		if (history.WorldVersion == 0)
+		{
+			XMStoreFloat3(&history.PreviousPosition, world.r[3]);
+			history.PreviousRotation = m_WorldRotations[position];
+			history.PreviousScale = m_WorldScales[position];
+		}
+		history.WorldVersion++;
+	}
+
+	void TransformHierarchy::SnapshotPreviousWorld(uint32_t position)
+	{
+		History& history = m_History[position];
+		if (history.WorldStep == m_WorldStep)
+			return;
+
+		history.PreviousPosition = m_WorldMatrices[position].Translation();
+		history.PreviousRotation = m_WorldRotations[position];
+		history.PreviousScale = m_WorldScales[position];
+		history.WorldStep = m_WorldStep;
+	}
+
+	uint32_t TransformHierarchy::RecomputeRange(uint32_t begin, uint32_t end)
+	{
+		uint32_t updatedCount = 0;
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			if (!m_Transforms[i])
+				continue;
+			Compose(i, GetParentPosition(i));
+			updatedCount++;
+		}
+		return updatedCount;
+	}
+
+	uint32_t TransformHierarchy::PropagateRange(uint32_t begin, uint32_t end)
+	{
+		uint32_t updatedCount = 0;
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			uint32_t parent = GetParentPosition(i);
+			if (parent != NoPosition && m_Dirty[parent])
+				m_Dirty[i] = 1;
+			if (!m_Dirty[i] || !m_Transforms[i])
+				continue;
+
+			Compose(i, parent);
+			updatedCount++;
+		}
+		return updatedCount;
+	}
+}
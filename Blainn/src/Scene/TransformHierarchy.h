@@ -0,0 +1,165 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "SimpleMath.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Blainn
+{
+	class JobSystem;
+	class TransformComponent;
+
+	// Structure of arrays storage of the transforms of a scene. The arrays mirror the
+	// scene's update order entry for entry, so a parent always sits before its children
+	// and every subtree is a contiguous range. Objects without a transform keep an
+	// identity entry, their children compose with it like roots.
+	//
+	// Placed TransformComponents read and write their entry directly, nothing is copied
+	// back into them. The scene applies its own inserts, erases and rotations to the
+	// arrays as objects are placed, removed and reparented, so no layout is ever rebuilt.
+	// Update recomputes the subtrees of the entries queued in the dirty list, or all of
+	// the arrays in one linear pass when too much of the scene moved.
+	class TransformHierarchy
+	{
+		friend class TransformComponent;
+	public:
+		// Below this many entries a linear pass is not worth splitting into jobs
+		static constexpr uint32_t ParallelThreshold = 4096;
+		static constexpr uint32_t ParallelGrainSize = 1024;
+		// With fewer dirty entries than one in this many only their subtrees are
+		// visited, otherwise one linear pass over the arrays is cheaper
+		static constexpr uint32_t SparseDirtyRatio = 16;
+		// Parent of roots, position of entries that are not placed anymore
+		static constexpr uint32_t NoPosition = UINT32_MAX;
+
+		struct Entry
+		{
+			// Null for objects without a transform
+			TransformComponent* Transform = nullptr;
+			// Position of the parent's entry once inserted, NoPosition for roots
+			uint32_t Parent = NoPosition;
+			uint32_t SubtreeSize = 1;
+		};
+
+		TransformHierarchy() = default;
+		~TransformHierarchy();
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+		void Update(JobSystem* jobSystem);
+
+		// Mirrors of the scene's update order operations, positions are the ones of the
+		// order. Inserted entries are one subtree, parents first.
+		void Insert(uint32_t position, const std::vector<Entry>& entries);
+		void Erase(uint32_t first, uint32_t last);
+		// Same as std::rotate over [first, last), middle becomes the first entry
+		void Rotate(uint32_t first, uint32_t middle, uint32_t last);
+		void AddToSubtreeSize(uint32_t position, int32_t delta);
+		// Reparents an entry, its subtree is recomputed by the next Update
+		void SetParent(uint32_t position, uint32_t parent);
+		// Moves a transform added to or removed from a placed object in or out of the arrays
+		void SetTransform(uint32_t position, TransformComponent* transform);
+
+		// Recomputes the subtree of the entry with the next Update, once per Update
+		void QueueDirty(uint32_t position);
+
+		uint32_t GetEntryCount() const { return uint32_t(m_Transforms.size()); }
+		// Transforms recomputed by the last Update
+		uint32_t GetUpdatedCount() const { return m_UpdatedCount; }
+		// Step being simulated, advanced by Update once world data is written
+		uint32_t GetWorldStep() const { return m_WorldStep; }
+
+	private:
+		// Nodes are stable ids of the entries, used by parent links and the dirty list
+		// so that moving entries only has to touch m_NodePositions
+		uint32_t AllocateNode();
+		void ReindexNodes(uint32_t first, uint32_t last);
+		void QueueDirtyNode(uint32_t node);
+
+		uint32_t GetParentPosition(uint32_t position) const
+		{
+			uint32_t parentNode = m_ParentNodes[position];
+			return parentNode == NoPosition ? NoPosition : m_NodePositions[parentNode];
+		}
+
+		// Copies the transform's own state into the entry, or the entry's state back out
+		void AttachTransform(uint32_t position, TransformComponent* transform);
+		void DetachTransform(uint32_t position);
+		void ResetEntry(uint32_t position);
+
+		// Composes the world state of one entry from its parent's
+		void Compose(uint32_t position, uint32_t parent);
+		// Keeps the world state the step started with, once per simulation step
+		void SnapshotPreviousWorld(uint32_t position);
+		// Both return how many transforms they recomputed. RecomputeRange recomputes
+		// every entry of [begin, end), PropagateRange the ones flagged in m_Dirty and
+		// everything below them.
+		uint32_t RecomputeRange(uint32_t begin, uint32_t end);
+		uint32_t PropagateRange(uint32_t begin, uint32_t end);
+
+		template<typename F>
+		void ForEachEntryArray(F&& f)
+		{
+			f(m_Transforms);
+			f(m_Nodes);
+			f(m_ParentNodes);
+			f(m_SubtreeSizes);
+			f(m_LocalPositions);
+			f(m_LocalRotations);
+			f(m_LocalScales);
+			f(m_WorldMatrices);
+			f(m_WorldRotations);
+			f(m_WorldScales);
+			f(m_History);
+		}
+
+	private:
+		// Indexed by position in the scene's update order
+		std::vector<TransformComponent*> m_Transforms;
+		std::vector<uint32_t> m_Nodes;
+		std::vector<uint32_t> m_ParentNodes;
+		std::vector<uint32_t> m_SubtreeSizes;
+
+		std::vector<DirectX::SimpleMath::Vector3> m_LocalPositions;
+		std::vector<DirectX::SimpleMath::Quaternion> m_LocalRotations;
+		std::vector<DirectX::SimpleMath::Vector3> m_LocalScales;
+
+		std::vector<DirectX::SimpleMath::Matrix> m_WorldMatrices;
+		std::vector<DirectX::SimpleMath::Quaternion> m_WorldRotations;
+		std::vector<DirectX::SimpleMath::Vector3> m_WorldScales;
+
+		// Only read for interpolation and change tracking, kept out of the hot arrays
+		struct History
+		{
+			DirectX::SimpleMath::Vector3 PreviousPosition{ 0.f, 0.f, 0.f };
+			DirectX::SimpleMath::Quaternion PreviousRotation{};
+			DirectX::SimpleMath::Vector3 PreviousScale{ 1.f, 1.f, 1.f };
+			uint32_t WorldVersion = 0;
+			// Simulation step the previous state was taken in, 0 is never simulated
+			uint32_t WorldStep = 0;
+		};
+		std::vector<History> m_History;
+
+		// Indexed by node
+		std::vector<uint32_t> m_NodePositions;
+		// Equal to m_DirtyGeneration while the node is queued in m_DirtyNodes
+		std::vector<uint32_t> m_DirtyStamps;
+		std::vector<uint32_t> m_FreeNodes;
+
+		std::vector<uint32_t> m_DirtyNodes;
+		// Bumping it invalidates every stamp at once
+		uint32_t m_DirtyGeneration = 1;
+		uint32_t m_WorldStep = 1;
+
+		// Scratch of Update: dirty roots as positions, per entry flags of the linear
+		// pass and the ends of its jobs' ranges
+		std::vector<uint32_t> m_DirtyPositions;
+		std::vector<uint8_t> m_Dirty;
+		std::vector<uint32_t> m_ChunkEnds;
+
+		uint32_t m_UpdatedCount = 0;
+	};
+}
@@ -22,15 +22,20 @@
 #include <utility>
 #include <vector>
 
+#if defined(_WIN32)
 #include <windows.h>
 #include <wrl.h>
 #include <dxgi1_4.h>
 #include <d3d12.h>
 #include <D3Dcompiler.h>
+#endif
+// The standalone job system build (BLAINN_JOBS_ONLY) has no DirectXMath
+#if !defined(BLAINN_JOBS_ONLY)
 #include <DirectXMath.h>
 #include <DirectXPackedVector.h>
 #include <DirectXColors.h>
 #include <DirectXCollision.h>
+#endif
 #include <string>
 #include <memory>
 #include <algorithm>
@@ -42,9 +47,11 @@
 #include <sstream>
 #include <cassert>
 
+#if defined(_WIN32)
 #include "Util/d3dx12.h"
 
 #include "Util/Util.h"
+#endif
 
 #include "Core/Delegates.h"
 
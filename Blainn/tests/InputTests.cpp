@@ -0,0 +1,139 @@
+#include "pch.h"
+
+#include "Core/Application.h"
+#include "Core/Input.h"
+#include "Core/Layer.h"
+
+#include <gtest/gtest.h>
+
+using namespace Blainn;
+
+namespace
+{
+	constexpr float TickRate = 60.f;
+	constexpr float StepTime = 1.f / TickRate;
+
+	// What every simulation step saw of one key
+	class KeyRecorder : public Layer
+	{
+	public:
+		void OnUpdate(const GameTimer& gt) override
+		{
+			Steps++;
+			Presses += Input::IsKeyPressed(KeyCode::Space);
+			Holds += Input::IsKeyHeld(KeyCode::Space);
+			Releases += Input::IsKeyReleased(KeyCode::Space);
+		}
+
+		uint32_t Steps = 0;
+		uint32_t Presses = 0;
+		uint32_t Holds = 0;
+		uint32_t Releases = 0;
+	};
+
+	// Runs frames of a chosen length without the headless loop
+	class TestApplication : public Application
+	{
+	public:
+		TestApplication(const ApplicationDesc& desc)
+			: Application(nullptr, desc)
+		{
+			SetHeadless(0);
+			Initialize();
+			PushLayer(&Recorder);
+		}
+
+		void RunFrame(float frameTime)
+		{
+			m_Timer.Step(frameTime);
+			Update(m_Timer);
+		}
+
+		KeyRecorder Recorder;
+	};
+
+	ApplicationDesc FixedTimestepDesc()
+	{
+		ApplicationDesc desc;
+		desc.NumWorkerThreads = 1;
+		desc.FixedTimestep = true;
+		desc.SimulationTickRate = TickRate;
+		return desc;
+	}
+}
+
+TEST(Input, PressWaitsForAFrameWithSteps)
+{
+	TestApplication app(FixedTimestepDesc());
+
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Pressed);
+	app.RunFrame(StepTime * 0.4f);
+	ASSERT_EQ(app.GetSimulationSteps(), 0u);
+	EXPECT_TRUE(Input::IsKeyPressed(KeyCode::Space));
+
+	app.RunFrame(StepTime * 0.8f);
+	ASSERT_EQ(app.GetSimulationSteps(), 1u);
+	EXPECT_EQ(app.Recorder.Presses, 1u);
+	EXPECT_TRUE(Input::IsKeyHeld(KeyCode::Space));
+
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Released);
+	app.RunFrame(StepTime * 1.f);
+	EXPECT_EQ(app.Recorder.Presses, 1u);
+	EXPECT_EQ(app.Recorder.Releases, 1u);
+}
+
+TEST(Input, PressReachesOneOfSeveralSteps)
+{
+	TestApplication app(FixedTimestepDesc());
+
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Pressed);
+	app.RunFrame(StepTime * 3.5f);
+	ASSERT_EQ(app.GetSimulationSteps(), 3u);
+	EXPECT_EQ(app.Recorder.Presses, 1u);
+	EXPECT_EQ(app.Recorder.Holds, 2u);
+
+	// key repeat of a key that is down is not another press
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Pressed);
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Released);
+	app.RunFrame(StepTime * 3.f);
+	ASSERT_GE(app.GetSimulationSteps(), 2u);
+	EXPECT_EQ(app.Recorder.Presses, 1u);
+	EXPECT_EQ(app.Recorder.Releases, 1u);
+}
+
+TEST(Input, TapBetweenStepsIsPressedThenReleased)
+{
+	TestApplication app(FixedTimestepDesc());
+
+	// down and up again within a frame that runs no step
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Pressed);
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Released);
+	app.RunFrame(StepTime * 0.4f);
+	ASSERT_EQ(app.GetSimulationSteps(), 0u);
+
+	app.RunFrame(StepTime * 3.f);
+	ASSERT_EQ(app.GetSimulationSteps(), 3u);
+	EXPECT_EQ(app.Recorder.Presses, 1u);
+	EXPECT_EQ(app.Recorder.Holds, 0u);
+	EXPECT_EQ(app.Recorder.Releases, 1u);
+	EXPECT_FALSE(Input::IsKeyReleased(KeyCode::Space));
+}
+
+TEST(Input, VariableTimestepSeesEveryPressOnce)
+{
+	ApplicationDesc desc;
+	desc.NumWorkerThreads = 1;
+	TestApplication app(desc);
+
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Pressed);
+	app.RunFrame(StepTime);
+	app.RunFrame(StepTime);
+	Input::UpdateKeyState(KeyCode::Space, KeyState::Released);
+	app.RunFrame(StepTime);
+	app.RunFrame(StepTime);
+
+	EXPECT_EQ(app.Recorder.Steps, 4u);
+	EXPECT_EQ(app.Recorder.Presses, 1u);
+	EXPECT_EQ(app.Recorder.Holds, 1u);
+	EXPECT_EQ(app.Recorder.Releases, 1u);
+}
@@ -0,0 +1,328 @@
+#include "Core/JobSystem.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	JobSystemDesc MakeDesc(uint32_t numWorkers)
+	{
+		JobSystemDesc desc;
+		desc.NumWorkers = numWorkers;
+		return desc;
+	}
+
+	constexpr uint32_t WorkerCounts[] = { 1, 2, 3, 7 };
+}
+
+TEST(JobSystem, DefaultDescHasAtLeastOneWorker)
+{
+	JobSystem jobs;
+	EXPECT_GE(jobs.GetWorkerCount(), 1u);
+	EXPECT_EQ(jobs.GetConcurrency(), jobs.GetWorkerCount() + 1);
+}
+
+TEST(JobSystem, RunsEveryJobExactlyOnce)
+{
+	for (uint32_t numWorkers : WorkerCounts)
+	{
+		JobSystem jobs(MakeDesc(numWorkers));
+
+		constexpr uint32_t JobCount = 20000;
+		std::vector<std::atomic<uint32_t>> hits(JobCount);
+		JobCounter counter;
+		for (uint32_t i = 0; i < JobCount; ++i)
+			jobs.Schedule([&hits, i]() { hits[i].fetch_add(1, std::memory_order_relaxed); }, &counter);
+		jobs.Wait(counter);
+
+		EXPECT_TRUE(counter.IsDone());
+		for (uint32_t i = 0; i < JobCount; ++i)
+			ASSERT_EQ(hits[i].load(), 1u) << "job " << i << " with " << numWorkers << " workers";
+	}
+}
+
+TEST(JobSystem, WaitOnIdleCounterReturns)
+{
+	JobSystem jobs(MakeDesc(2));
+	JobCounter counter;
+	jobs.Wait(counter);
+	EXPECT_TRUE(counter.IsDone());
+	EXPECT_EQ(counter.GetPending(), 0u);
+}
+
+TEST(JobSystem, ScheduleAfterRunsChainInOrder)
+{
+	JobSystem jobs(MakeDesc(3));
+
+	constexpr uint32_t ChainLength = 256;
+	std::vector<std::unique_ptr<JobCounter>> counters;
+	for (uint32_t i = 0; i < ChainLength; ++i)
+		counters.push_back(std::make_unique<JobCounter>());
+
+	std::vector<uint32_t> order;
+	order.reserve(ChainLength);
+
+	// every link only appends, the dependency makes the vector race free
+	jobs.Schedule([&order]() { order.push_back(0); }, counters[0].get());
+	for (uint32_t i = 1; i < ChainLength; ++i)
+		jobs.ScheduleAfter(*counters[i - 1], [&order, i]() { order.push_back(i); }, counters[i].get());
+
+	jobs.Wait(*counters.back());
+
+	ASSERT_EQ(order.size(), ChainLength);
+	for (uint32_t i = 0; i < ChainLength; ++i)
+		EXPECT_EQ(order[i], i);
+}
+
+TEST(JobSystem, ScheduleAfterFinishedDependencyRunsImmediately)
+{
+	JobSystem jobs(MakeDesc(2));
+
+	JobCounter dependency;
+	jobs.Schedule([]() {}, &dependency);
+	jobs.Wait(dependency);
+
+	std::atomic<bool> bRan{ false };
+	JobCounter counter;
+	jobs.ScheduleAfter(dependency, [&bRan]() { bRan = true; }, &counter);
+	jobs.Wait(counter);
+	EXPECT_TRUE(bRan);
+}
+
+TEST(JobSystem, DiamondDependenciesSeeEveryProducer)
+{
+	JobSystem jobs(MakeDesc(4));
+
+	for (uint32_t iteration = 0; iteration < 200; ++iteration)
+	{
+		constexpr uint32_t Width = 32;
+		std::vector<uint32_t> values(Width, 0);
+
+		JobCounter producers;
+		for (uint32_t i = 0; i < Width; ++i)
+			jobs.Schedule([&values, i]() { values[i] = i + 1; }, &producers);
+
+		uint32_t sum = 0;
+		JobCounter consumer;
+		jobs.ScheduleAfter(producers, [&values, &sum]()
+			{
+				sum = std::accumulate(values.begin(), values.end(), 0u);
+			}, &consumer);
+
+		jobs.Wait(consumer);
+		ASSERT_EQ(sum, Width * (Width + 1) / 2);
+	}
+}
+
+TEST(JobSystem, ParallelForCoversRangeExactlyOnce)
+{
+	struct Case { uint32_t Begin, End, Grain; };
+	const Case cases[] = {
+		{ 0, 0, 16 }, { 5, 5, 1 }, { 7, 3, 4 },
+		{ 0, 1, 1 }, { 0, 100, 0 }, { 0, 100, 1 },
+		{ 0, 100, 7 }, { 13, 1000, 64 }, { 0, 65536, 100 },
+		{ 0, 1000, 5000 },
+	};
+
+	for (uint32_t numWorkers : WorkerCounts)
+	{
+		JobSystem jobs(MakeDesc(numWorkers));
+		for (const Case& c : cases)
+		{
+			const uint32_t size = c.End > c.Begin ? c.End : 0;
+			std::vector<std::atomic<uint32_t>> hits(size);
+			std::atomic<uint32_t> maxChunk{ 0 };
+
+			jobs.ParallelFor(c.Begin, c.End, c.Grain, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+				{
+					ASSERT_LT(chunkBegin, chunkEnd);
+					uint32_t chunk = chunkEnd - chunkBegin;
+					uint32_t seen = maxChunk.load();
+					while (chunk > seen && !maxChunk.compare_exchange_weak(seen, chunk)) {}
+
+					for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+						hits[i].fetch_add(1, std::memory_order_relaxed);
+				});
+
+			for (uint32_t i = 0; i < size; ++i)
+			{
+				uint32_t expected = i >= c.Begin && i < c.End ? 1u : 0u;
+				ASSERT_EQ(hits[i].load(), expected)
+					<< "index " << i << " range [" << c.Begin << ", " << c.End << ") grain " << c.Grain;
+			}
+
+			if (c.End > c.Begin && c.End - c.Begin > std::max(c.Grain, 1u))
+			{
+				EXPECT_LE(maxChunk.load(), std::max(c.Grain, 1u));
+			}
+		}
+	}
+}
+
+TEST(JobSystem, NestedParallelFor)
+{
+	JobSystem jobs(MakeDesc(3));
+
+	constexpr uint32_t Outer = 64;
+	constexpr uint32_t Inner = 512;
+	std::vector<std::atomic<uint32_t>> hits(Outer * Inner);
+
+	jobs.ParallelFor(0, Outer, 1, [&](uint32_t outerBegin, uint32_t outerEnd)
+		{
+			for (uint32_t o = outerBegin; o < outerEnd; ++o)
+			{
+				jobs.ParallelFor(0, Inner, 32, [&, o](uint32_t innerBegin, uint32_t innerEnd)
+					{
+						for (uint32_t i = innerBegin; i < innerEnd; ++i)
+							hits[o * Inner + i].fetch_add(1, std::memory_order_relaxed);
+					});
+			}
+		});
+
+	for (uint32_t i = 0; i < Outer * Inner; ++i)
+		ASSERT_EQ(hits[i].load(), 1u) << "index " << i;
+}
+
+TEST(JobSystem, JobsCanScheduleAndWaitOnChildren)
+{
+	JobSystem jobs(MakeDesc(3));
+
+	constexpr uint32_t Parents = 64;
+	constexpr uint32_t Children = 64;
+	std::atomic<uint32_t> total{ 0 };
+
+	JobCounter parents;
+	for (uint32_t p = 0; p < Parents; ++p)
+	{
+		jobs.Schedule([&jobs, &total]()
+			{
+				JobCounter children;
+				for (uint32_t c = 0; c < Children; ++c)
+					jobs.Schedule([&total]() { total.fetch_add(1, std::memory_order_relaxed); }, &children);
+				jobs.Wait(children);
+			}, &parents);
+	}
+	jobs.Wait(parents);
+
+	EXPECT_EQ(total.load(), Parents * Children);
+}
+
+TEST(JobSystem, SchedulesFromManyExternalThreads)
+{
+	JobSystem jobs(MakeDesc(3));
+
+	constexpr uint32_t Producers = 4;
+	constexpr uint32_t JobsPerProducer = 5000;
+	std::atomic<uint32_t> total{ 0 };
+
+	std::vector<std::thread> producers;
+	for (uint32_t p = 0; p < Producers; ++p)
+	{
+		producers.emplace_back([&jobs, &total]()
+			{
+				JobCounter counter;
+				for (uint32_t i = 0; i < JobsPerProducer; ++i)
+					jobs.Schedule([&total]() { total.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				jobs.Wait(counter);
+			});
+	}
+	for (auto& producer : producers)
+		producer.join();
+
+	EXPECT_EQ(total.load(), Producers * JobsPerProducer);
+}
+
+TEST(JobSystem, ThreadIndexStaysInRange)
+{
+	JobSystem jobs(MakeDesc(4));
+	EXPECT_EQ(jobs.GetCurrentThreadIndex(), 0u);
+
+	std::vector<std::atomic<uint32_t>> perThread(jobs.GetConcurrency());
+	std::atomic<bool> bOutOfRange{ false };
+
+	jobs.ParallelFor(0, 100000, 16, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+		{
+			uint32_t index = jobs.GetCurrentThreadIndex();
+			if (index >= jobs.GetConcurrency())
+			{
+				bOutOfRange = true;
+				return;
+			}
+			perThread[index].fetch_add(chunkEnd - chunkBegin, std::memory_order_relaxed);
+		});
+
+	EXPECT_FALSE(bOutOfRange);
+	uint32_t total = 0;
+	for (auto& count : perThread)
+		total += count.load();
+	EXPECT_EQ(total, 100000u);
+
+	// A worker of one system is an external thread for every other one
+	JobSystem other(MakeDesc(1));
+	std::atomic<uint32_t> indexInOther{ ~0u };
+	JobCounter counter;
+	jobs.Schedule([&]() { indexInOther = other.GetCurrentThreadIndex(); }, &counter);
+	jobs.Wait(counter);
+	EXPECT_EQ(indexInOther.load(), 0u);
+}
+
+TEST(JobSystem, PinnedWorkersRunJobs)
+{
+	JobSystemDesc desc = MakeDesc(2);
+	desc.PinWorkers = true;
+	JobSystem jobs(desc);
+
+	std::atomic<uint32_t> total{ 0 };
+	jobs.ParallelFor(0, 4096, 64, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+		{
+			total.fetch_add(chunkEnd - chunkBegin, std::memory_order_relaxed);
+		});
+	EXPECT_EQ(total.load(), 4096u);
+}
+
+TEST(JobSystem, StressMixedWorkload)
+{
+	JobSystem jobs(MakeDesc(std::max(2u, std::thread::hardware_concurrency())));
+
+	for (uint32_t iteration = 0; iteration < 50; ++iteration)
+	{
+		std::atomic<uint64_t> sum{ 0 };
+		JobCounter roots;
+		JobCounter continuations;
+
+		for (uint32_t i = 0; i < 64; ++i)
+		{
+			jobs.Schedule([&jobs, &sum, i]()
+				{
+					jobs.ParallelFor(0, 256, 8, [&sum, i](uint32_t chunkBegin, uint32_t chunkEnd)
+						{
+							for (uint32_t k = chunkBegin; k < chunkEnd; ++k)
+								sum.fetch_add(i * 256 + k, std::memory_order_relaxed);
+						});
+				}, &roots);
+		}
+		for (uint32_t i = 0; i < 16; ++i)
+			jobs.ScheduleAfter(roots, [&sum]() { sum.fetch_add(1, std::memory_order_relaxed); }, &continuations);
+
+		jobs.Wait(continuations);
+		EXPECT_TRUE(roots.IsDone());
+
+		constexpr uint64_t N = 64 * 256;
+		ASSERT_EQ(sum.load(), N * (N - 1) / 2 + 16);
+	}
+}
+
+TEST(JobSystem, DestroysWithoutWork)
+{
+	for (uint32_t i = 0; i < 20; ++i)
+	{
+		JobSystem jobs(MakeDesc(WorkerCounts[i % std::size(WorkerCounts)]));
+		(void)jobs;
+	}
+}
@@ -0,0 +1,388 @@
+#include "pch.h"
+
+#include "Core/JobSystem.h"
+#include "Scene/Narrowphase.h"
+
+#include <DirectXCollision.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace Blainn;
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
+
+namespace
+{
+	constexpr CollisionShapeType ShapeTypes[] = {
+		CollisionShapeType::Sphere,
+		CollisionShapeType::Box,
+		CollisionShapeType::OrientedBox,
+		CollisionShapeType::Capsule,
+	};
+
+	CollisionShape MakeSphere(const XMFLOAT3& center, float radius)
+	{
+		CollisionShape shape;
+		shape.Type = CollisionShapeType::Sphere;
+		shape.Center = center;
+		shape.Radius = radius;
+		return shape;
+	}
+
+	CollisionShape MakeBox(const XMFLOAT3& center, const XMFLOAT3& extents)
+	{
+		CollisionShape shape;
+		shape.Type = CollisionShapeType::Box;
+		shape.Center = center;
+		shape.Extents = extents;
+		return shape;
+	}
+
+	CollisionShape MakeOrientedBox(const XMFLOAT3& center, const XMFLOAT3& extents, const XMFLOAT4& orientation)
+	{
+		CollisionShape shape = MakeBox(center, extents);
+		shape.Type = CollisionShapeType::OrientedBox;
+		shape.Orientation = orientation;
+		return shape;
+	}
+
+	CollisionShape MakeCapsule(const XMFLOAT3& center, const XMFLOAT3& halfSegment, float radius)
+	{
+		CollisionShape shape;
+		shape.Type = CollisionShapeType::Capsule;
+		shape.Center = center;
+		shape.HalfSegment = halfSegment;
+		shape.Radius = radius;
+		return shape;
+	}
+
+	// Shapes around the origin, sized so that about half of the random pairs touch
+	class ShapeGenerator
+	{
+	public:
+		explicit ShapeGenerator(uint32_t seed) : m_Random(seed) {}
+
+		CollisionShape Generate(CollisionShapeType type)
+		{
+			XMFLOAT3 center{ Uniform(-2.f, 2.f), Uniform(-2.f, 2.f), Uniform(-2.f, 2.f) };
+			switch (type)
+			{
+			case CollisionShapeType::Sphere:
+				return MakeSphere(center, Uniform(0.1f, 1.5f));
+			case CollisionShapeType::Box:
+				return MakeBox(center, { Uniform(0.1f, 1.5f), Uniform(0.1f, 1.5f), Uniform(0.1f, 1.5f) });
+			case CollisionShapeType::OrientedBox:
+				return MakeOrientedBox(center, { Uniform(0.1f, 1.5f), Uniform(0.1f, 1.5f), Uniform(0.1f, 1.5f) }, Orientation());
+			default:
+				return MakeCapsule(center, { Uniform(-1.5f, 1.5f), Uniform(-1.5f, 1.5f), Uniform(-1.5f, 1.5f) }, Uniform(0.05f, 1.f));
+			}
+		}
+
+		CollisionShape Generate() { return Generate(ShapeTypes[m_Random() % std::size(ShapeTypes)]); }
+
+		float Uniform(float low, float high) { return std::uniform_real_distribution<float>(low, high)(m_Random); }
+
+	private:
+		XMFLOAT4 Orientation()
+		{
+			std::normal_distribution<float> normal;
+			XMFLOAT4 q{ normal(m_Random), normal(m_Random), normal(m_Random), normal(m_Random) };
+			float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+			return { q.x / length, q.y / length, q.z / length, q.w / length };
+		}
+
+	private:
+		std::mt19937 m_Random;
+	};
+
+	std::vector<uint8_t> TestAll(Narrowphase& narrowphase, const std::vector<CollisionShape>& a, const std::vector<CollisionShape>& b,
+		JobSystem* jobSystem = nullptr)
+	{
+		std::vector<NarrowphasePair> pairs(a.size());
+		for (size_t i = 0; i < a.size(); ++i)
+			pairs[i] = { &a[i], &b[i] };
+
+		std::vector<uint8_t> touching(pairs.size(), 2);
+		narrowphase.TestPairs(pairs.data(), uint32_t(pairs.size()), touching.data(), jobSystem);
+		return touching;
+	}
+
+	bool IntersectsDirectX(const CollisionShape& a, const CollisionShape& b)
+	{
+		auto test = [](const auto& boundsA, const CollisionShape& b)
+			{
+				switch (b.Type)
+				{
+				case CollisionShapeType::Sphere:
+					return boundsA.Intersects(DirectX::BoundingSphere(b.Center, b.Radius));
+				case CollisionShapeType::Box:
+					return boundsA.Intersects(DirectX::BoundingBox(b.Center, b.Extents));
+				default:
+					return boundsA.Intersects(DirectX::BoundingOrientedBox(b.Center, b.Extents, b.Orientation));
+				}
+			};
+
+		switch (a.Type)
+		{
+		case CollisionShapeType::Sphere:
+			return test(DirectX::BoundingSphere(a.Center, a.Radius), b);
+		case CollisionShapeType::Box:
+			return test(DirectX::BoundingBox(a.Center, a.Extents), b);
+		default:
+			return test(DirectX::BoundingOrientedBox(a.Center, a.Extents, a.Orientation), b);
+		}
+	}
+
+	// Reference distances in double precision, independent of the narrowphase's math
+	struct Vector
+	{
+		double X, Y, Z;
+	};
+
+	Vector ToVector(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+	Vector operator+(const Vector& a, const Vector& b) { return { a.X + b.X, a.Y + b.Y, a.Z + b.Z }; }
+	Vector operator-(const Vector& a, const Vector& b) { return { a.X - b.X, a.Y - b.Y, a.Z - b.Z }; }
+	Vector operator*(const Vector& a, double s) { return { a.X * s, a.Y * s, a.Z * s }; }
+	double Dot(const Vector& a, const Vector& b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+	double Length(const Vector& a) { return std::sqrt(Dot(a, a)); }
+
+	Vector Rotate(const XMFLOAT4& q, const Vector& v)
+	{
+		// v + 2w (q x v) + 2 q x (q x v)
+		auto cross = [](const Vector& a, const Vector& b) { return Vector{ a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X }; };
+		Vector axis{ q.x, q.y, q.z };
+		Vector t = cross(axis, v) * 2.0;
+		return v + t * q.w + cross(axis, t);
+	}
+
+	double PointSegmentDistance(const Vector& point, const Vector& start, const Vector& segment)
+	{
+		double lengthSq = Dot(segment, segment);
+		double t = lengthSq > 0.0 ? std::clamp(Dot(point - start, segment) / lengthSq, 0.0, 1.0) : 0.0;
+		return Length(point - (start + segment * t));
+	}
+
+	double PointShapeDistance(const Vector& point, const CollisionShape& shape)
+	{
+		switch (shape.Type)
+		{
+		case CollisionShapeType::Sphere:
+			return std::max(Length(point - ToVector(shape.Center)) - shape.Radius, 0.0);
+		case CollisionShapeType::Capsule:
+		{
+			Vector half = ToVector(shape.HalfSegment);
+			return std::max(PointSegmentDistance(point, ToVector(shape.Center) - half, half * 2.0) - shape.Radius, 0.0);
+		}
+		default:
+		{
+			Vector local = point - ToVector(shape.Center);
+			if (shape.Type == CollisionShapeType::OrientedBox)
+				local = Rotate({ -shape.Orientation.x, -shape.Orientation.y, -shape.Orientation.z, shape.Orientation.w }, local);
+			Vector outside{
+				std::max(std::abs(local.X) - shape.Extents.x, 0.0),
+				std::max(std::abs(local.Y) - shape.Extents.y, 0.0),
+				std::max(std::abs(local.Z) - shape.Extents.z, 0.0) };
+			return Length(outside);
+		}
+		}
+	}
+
+	constexpr uint32_t ReferenceSamples = 4000;
+
+	// Distance between the capsule's segment and the other shape, less the other's
+	// radius, from points sampled along the segment. The sampled minimum is at most
+	// the segment length / ReferenceSamples above the exact one.
+	double CapsuleReferenceDistance(const CollisionShape& capsule, const CollisionShape& other)
+	{
+		Vector half = ToVector(capsule.HalfSegment);
+		Vector start = ToVector(capsule.Center) - half;
+		double distance = PointShapeDistance(start, other);
+		for (uint32_t i = 1; i <= ReferenceSamples; ++i)
+			distance = std::min(distance, PointShapeDistance(start + half * (2.0 * i / ReferenceSamples), other));
+		return distance;
+	}
+}
+
+TEST(Narrowphase, MatchesDirectXCollision)
+{
+	ShapeGenerator generator(1);
+	std::vector<CollisionShape> a, b;
+	constexpr CollisionShapeType boxesAndSpheres[] = { CollisionShapeType::Sphere, CollisionShapeType::Box, CollisionShapeType::OrientedBox };
+	for (uint32_t i = 0; i < 30000; ++i)
+	{
+		a.push_back(generator.Generate(boxesAndSpheres[i % 3]));
+		b.push_back(generator.Generate(boxesAndSpheres[(i / 3) % 3]));
+	}
+
+	JobSystemDesc desc;
+	desc.NumWorkers = 3;
+	JobSystem jobs(desc);
+	for (JobSystem* jobSystem : { static_cast<JobSystem*>(nullptr), &jobs })
+	{
+		Narrowphase narrowphase;
+		std::vector<uint8_t> touching = TestAll(narrowphase, a, b, jobSystem);
+
+		uint32_t touchingCount = 0;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			ASSERT_EQ(touching[i] != 0, IntersectsDirectX(a[i], b[i])) << "pair " << i;
+			touchingCount += touching[i];
+		}
+		// both outcomes are covered
+		EXPECT_GT(touchingCount, a.size() / 5);
+		EXPECT_LT(touchingCount, a.size() * 4 / 5);
+		EXPECT_EQ(narrowphase.GetStats().Touching, touchingCount);
+	}
+}
+
+TEST(Narrowphase, CapsulesMatchReferenceDistances)
+{
+	ShapeGenerator generator(2);
+	std::vector<CollisionShape> a, b;
+	for (uint32_t i = 0; i < 4000; ++i)
+	{
+		a.push_back(generator.Generate(CollisionShapeType::Capsule));
+		b.push_back(generator.Generate(ShapeTypes[i % std::size(ShapeTypes)]));
+	}
+
+	Narrowphase narrowphase;
+	std::vector<uint8_t> touching = TestAll(narrowphase, a, b);
+
+	uint32_t checked = 0;
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		double distance = CapsuleReferenceDistance(a[i], b[i]) - a[i].Radius;
+		// too close to call for a float test or the sampled reference
+		double margin = 2.0 * Length(ToVector(a[i].HalfSegment)) / ReferenceSamples + 1e-4;
+		if (std::abs(distance) < margin)
+			continue;
+
+		ASSERT_EQ(touching[i] != 0, distance < 0.0) << "pair " << i << " against shape type " << int(b[i].Type);
+		checked++;
+	}
+	EXPECT_GT(checked, a.size() * 9 / 10);
+}
+
+TEST(Narrowphase, KernelsMatchScalarTests)
+{
+	ShapeGenerator generator(3);
+	std::vector<CollisionShape> a, b;
+	for (uint32_t i = 0; i < 3 * Narrowphase::RangeSize + 7; ++i)
+	{
+		a.push_back(generator.Generate());
+		b.push_back(generator.Generate());
+	}
+	// degenerate capsules, points and parallel segments go through the same kernels
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		XMFLOAT3 center{ generator.Uniform(-1.f, 1.f), generator.Uniform(-1.f, 1.f), generator.Uniform(-1.f, 1.f) };
+		float length = generator.Uniform(0.f, 1.f);
+		a.push_back(MakeCapsule(center, { 0.f, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+		b.push_back(MakeCapsule({ 0.f, 0.f, 0.f }, { length, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+		a.push_back(MakeCapsule(center, { 0.f, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+		b.push_back(MakeCapsule({ 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+		a.push_back(MakeCapsule(center, { length, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+		b.push_back(MakeCapsule({ 0.f, 0.f, 0.f }, { -2.f * length, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+		a.push_back(MakeSphere(center, generator.Uniform(0.1f, 1.f)));
+		b.push_back(MakeCapsule({ 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, generator.Uniform(0.1f, 1.f)));
+	}
+
+	// every count leaves a different number of padding lanes in the last chunk
+	for (size_t count : { size_t(1), size_t(3), size_t(5), size_t(Narrowphase::ChunkSize + 1), a.size() })
+	{
+		std::vector<CollisionShape> headA(a.begin(), a.begin() + count);
+		std::vector<CollisionShape> headB(b.begin(), b.begin() + count);
+		Narrowphase narrowphase;
+		std::vector<uint8_t> touching = TestAll(narrowphase, headA, headB);
+		for (size_t i = 0; i < count; ++i)
+			ASSERT_EQ(touching[i] != 0, TestShapes(a[i], b[i])) << "pair " << i << " of " << count;
+	}
+}
+
+TEST(Narrowphase, CountsPairsPerCombination)
+{
+	ShapeGenerator generator(4);
+	std::vector<CollisionShape> a, b;
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		a.push_back(generator.Generate());
+		b.push_back(generator.Generate());
+	}
+
+	std::vector<NarrowphasePair> pairs(a.size());
+	for (size_t i = 0; i < a.size(); ++i)
+		pairs[i] = { &a[i], &b[i] };
+	// a collider that went away
+	pairs[10].A = nullptr;
+	pairs[20].B = nullptr;
+
+	Narrowphase narrowphase;
+	std::vector<uint8_t> touching(pairs.size(), 2);
+	narrowphase.TestPairs(pairs.data(), uint32_t(pairs.size()), touching.data());
+	EXPECT_EQ(touching[10], 0);
+	EXPECT_EQ(touching[20], 0);
+
+	uint32_t expected[int(CollisionShapeType::Count) * int(CollisionShapeType::Count)] = {};
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (i == 10 || i == 20)
+			continue;
+		CollisionShapeType first = std::min(a[i].Type, b[i].Type), second = std::max(a[i].Type, b[i].Type);
+		expected[Narrowphase::GetCombinationIndex(first, second)]++;
+	}
+
+	const NarrowphaseStats& stats = narrowphase.GetStats();
+	for (size_t combination = 0; combination < std::size(expected); ++combination)
+		EXPECT_EQ(stats.Tested[combination], expected[combination]) << "combination " << combination;
+	EXPECT_LE(stats.Batched, uint32_t(a.size() - 2));
+}
+
+// The golden section search in SegmentBoxDistanceSq against distances worked out by hand
+TEST(Narrowphase, CapsuleBoxClosestApproach)
+{
+	struct Case
+	{
+		const char* Name;
+		CollisionShape Box;
+		XMFLOAT3 Center;
+		XMFLOAT3 HalfSegment;
+		float Distance;
+	};
+
+	const CollisionShape unitBox = MakeBox({ 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f });
+	// turned 45 degrees about y, its vertical edges reach out to sqrt(2) on x
+	const float halfSin = std::sin(DirectX::XM_PI / 8.f), halfCos = std::cos(DirectX::XM_PI / 8.f);
+	const CollisionShape turnedBox = MakeOrientedBox({ 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f }, { 0.f, halfSin, 0.f, halfCos });
+	const float sqrt2 = std::sqrt(2.f);
+
+	const Case cases[] = {
+		{ "parallel to a face", unitBox, { 0.f, 1.5f, 0.f }, { 3.f, 0.f, 0.f }, 0.5f },
+		{ "past an edge", unitBox, { 1.5f, 1.5f, 0.f }, { 2.f, -2.f, 0.f }, sqrt2 / 2.f },
+		{ "pointing away", unitBox, { 3.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, 1.f },
+		{ "through the box", unitBox, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 5.f }, 0.f },
+		{ "along a turned edge", turnedBox, { sqrt2 + 0.25f, 0.f, 0.f }, { 0.f, 2.f, 0.f }, 0.25f },
+		// long, with the closest point about 1% in from its start
+		{ "near the start of a long segment", unitBox, { 98.5f, -96.f, 0.f }, { 100.f, -100.f, 0.f }, 0.5f / sqrt2 },
+		{ "near the end of a long segment", unitBox, { 98.5f, -96.f, 0.f }, { -100.f, 100.f, 0.f }, 0.5f / sqrt2 },
+	};
+
+	constexpr float tolerance = 1e-3f;
+	for (const Case& test : cases)
+	{
+		SCOPED_TRACE(test.Name);
+		float inside = test.Distance + tolerance;
+		float outside = std::max(test.Distance - tolerance, 0.f);
+
+		EXPECT_TRUE(TestShapes(test.Box, MakeCapsule(test.Center, test.HalfSegment, inside)));
+		EXPECT_TRUE(TestShapes(MakeCapsule(test.Center, test.HalfSegment, inside), test.Box));
+		if (test.Distance > 0.f)
+		{
+			EXPECT_FALSE(TestShapes(test.Box, MakeCapsule(test.Center, test.HalfSegment, outside)));
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#include "pch.h"
+
+#include "Components/ActorComponents/CharacterComponents/CameraComponent.h"
+#include "Components/ActorComponents/DirectionalLightComponent.h"
+#include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Core/Application.h"
+#include "Core/GameObject.h"
+#include "Render/Model.h"
+#include "Render/NullRenderingBackend.h"
+#include "Render/RenderQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace Blainn;
+
+namespace
+{
+	// Every object draws this many queue items, one per submesh
+	constexpr uint32_t SubmeshesPerModel = 8;
+	// Objects cycle through the models, so the queue has enough batches to be split
+	// into several chunks
+	constexpr uint32_t ModelCount = 16;
+
+	// Only their addresses are used as materials
+	const char s_Materials[4] = {};
+
+	class TestModel : public Model
+	{
+	public:
+		explicit TestModel(const std::filesystem::path& modelFilePath)
+			: Model(modelFilePath)
+		{
+			m_Bounds = DirectX::BoundingBox({ 0.f, 0.f, 0.f }, { 0.2f, 0.2f, 0.2f });
+			// every fourth submesh is transparent, it stays out of the shadow maps
+			for (uint32_t i = 0; i < SubmeshesPerModel; ++i)
+				AddSubmesh(&s_Materials[i % std::size(s_Materials)], i % 4 == 3);
+		}
+	};
+
+	class TestBackend : public NullRenderingBackend
+	{
+	public:
+		std::shared_ptr<Model> LoadModel(const std::filesystem::path& modelFilePath) override
+		{
+			return std::make_shared<TestModel>(modelFilePath);
+		}
+	};
+
+	// Runs frames on the test backend without the headless loop
+	class TestApplication : public Application
+	{
+	public:
+		TestApplication(const ApplicationDesc& desc)
+			: Application(nullptr, desc)
+		{
+			SetHeadless(0);
+			Initialize();
+
+			m_RenderingBackend = std::make_shared<TestBackend>();
+			m_RenderingBackend->Init(nullptr);
+			m_RenderingBackend->Resize(m_ClientWidth, m_ClientHeight);
+			m_RenderingBackend->CreateResources();
+			// frames repeat exactly only while the cascades draw everything
+			m_RenderingBackend->SetCacheStaticShadows(false);
+		}
+
+		const NullRenderingBackend& GetBackend() const
+		{
+			return static_cast<const NullRenderingBackend&>(*m_RenderingBackend);
+		}
+
+		void RunFrame(bool bParallel)
+		{
+			m_RenderingBackend->SetParallelRecording(bParallel);
+			m_Timer.Step(1.f / 60.f);
+			Update(m_Timer);
+			Draw(m_Timer);
+		}
+	};
+
+	struct RecordedFrame
+	{
+		std::vector<NullRenderCommand> Commands;
+		RenderingStats Stats;
+		uint32_t QueueItems = 0;
+	};
+
+	RecordedFrame Record(TestApplication& app, bool bParallel)
+	{
+		app.RunFrame(bParallel);
+
+		const NullRenderingBackend& backend = app.GetBackend();
+		RecordedFrame frame;
+		frame.Stats = backend.GetStats();
+		frame.QueueItems = backend.GetGeometryQueue().GetItemCount();
+
+		// every chunk binds its first material again, keep only material changes
+		uint32_t boundMaterial = ~0u;
+		for (const NullRenderCommand& command : backend.GetCommands())
+		{
+			if (command.CommandType == NullRenderCommand::SetMaterial)
+			{
+				if (command.Arg0 == boundMaterial)
+					continue;
+				boundMaterial = command.Arg0;
+			}
+			frame.Commands.push_back(command);
+		}
+		return frame;
+	}
+
+	void AddObjects(Scene& scene, uint32_t first, uint32_t count)
+	{
+		// a grid in front of the camera, all of it visible
+		constexpr uint32_t Columns = 200;
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			auto object = std::make_shared<GameObject>();
+			scene.QueueGameObject(object);
+			object->AddComponent<StaticMeshComponent>("Model" + std::to_string(i % ModelCount));
+			object->AddComponent<TransformComponent>()->SetWorldPosition(
+				{ float(i % Columns) * 0.5f - 50.f, float(i / Columns) * 0.5f - 32.f, float(i % 7) });
+		}
+	}
+}
+
+TEST(NullRenderingBackend, ParallelRecordingMatchesSerial)
+{
+	ApplicationDesc desc;
+	desc.Name = "NullRenderingBackendTests";
+	// enough workers to split the geometry queue, whatever the host has
+	desc.NumWorkerThreads = 3;
+	TestApplication app(desc);
+	Scene& scene = *app.GetScene();
+
+	auto camera = std::make_shared<GameObject>();
+	scene.QueueGameObject(camera);
+	camera->AddComponent<TransformComponent>()->SetWorldPosition({ 0.f, 0.f, -100.f });
+	scene.SetMainCamera(camera->AddComponent<CameraComponent>(int(desc.WindowWidth), int(desc.WindowHeight), 60.f, 0.1f, 1000.f));
+
+	auto light = std::make_shared<GameObject>();
+	scene.QueueGameObject(light);
+	DirectionalLight dl;
+	dl.Color = { 1.f, 1.f, 1.f };
+	light->AddComponent<TransformComponent>()->SetWorldYawPitchRoll({ -45.f, 60.f, -45.f });
+	light->AddComponent<DirectionalLightComponent>(&dl);
+
+	uint32_t objectCount = 0;
+	for (uint32_t queueItems : { 0u, 8u, 800u, 8000u, 80000u, 200000u })
+	{
+		SCOPED_TRACE(queueItems);
+
+		uint32_t targetObjects = queueItems / SubmeshesPerModel;
+		AddObjects(scene, objectCount, targetObjects - objectCount);
+		objectCount = targetObjects;
+
+		// new objects upload their instances over the next frames
+		for (uint32_t i = 0; i < 4; ++i)
+			app.RunFrame(false);
+
+		RecordedFrame serial = Record(app, false);
+		RecordedFrame parallel = Record(app, true);
+
+		EXPECT_EQ(serial.QueueItems, queueItems);
+		EXPECT_EQ(parallel.QueueItems, queueItems);
+
+		EXPECT_EQ(serial.Stats.DrawCalls, parallel.Stats.DrawCalls);
+		EXPECT_EQ(serial.Stats.Instances, parallel.Stats.Instances);
+		EXPECT_EQ(serial.Stats.UploadBytes, parallel.Stats.UploadBytes);
+		// large queues are recorded in several chunks
+		if (queueItems >= 8000)
+		{
+			EXPECT_GT(parallel.Stats.CommandLists, serial.Stats.CommandLists);
+		}
+		else
+		{
+			EXPECT_GE(parallel.Stats.CommandLists, serial.Stats.CommandLists);
+		}
+
+		ASSERT_EQ(serial.Commands.size(), parallel.Commands.size());
+		for (size_t i = 0; i < serial.Commands.size(); ++i)
+		{
+			ASSERT_EQ(serial.Commands[i].CommandType, parallel.Commands[i].CommandType) << "command " << i;
+			ASSERT_EQ(serial.Commands[i].Arg0, parallel.Commands[i].Arg0) << "command " << i;
+			ASSERT_EQ(serial.Commands[i].Arg1, parallel.Commands[i].Arg1) << "command " << i;
+		}
+	}
+}
@@ -0,0 +1,214 @@
+#include "pch.h"
+
+#include "Components/ActorComponents/StaticMeshComponent.h"
+#include "Components/ActorComponents/TransformComponent.h"
+#include "Core/Application.h"
+#include "Core/GameObject.h"
+#include "Scene/System.h"
+
+#include <gtest/gtest.h>
+
+using namespace Blainn;
+
+namespace
+{
+	class TickCounter : public Component<TickCounter>
+	{
+	public:
+		TickCounter(std::shared_ptr<GameObject> owner)
+			: Component(owner)
+		{}
+
+		void OnUpdate(const GameTimer& gt) override { Ticks++; }
+
+		uint32_t Ticks = 0;
+	};
+
+	// Runs frames without the headless loop, and other scenes with the same timer
+	class TestApplication : public Application
+	{
+	public:
+		TestApplication(const ApplicationDesc& desc)
+			: Application(nullptr, desc)
+		{
+			SetHeadless(0);
+			Initialize();
+		}
+
+		void RunFrame()
+		{
+			m_Timer.Step(1.f / 60.f);
+			Update(m_Timer);
+		}
+
+		void UpdateOtherScene(Scene& scene)
+		{
+			scene.UpdateScene(m_Timer);
+		}
+	};
+
+	ApplicationDesc SceneTestDesc()
+	{
+		ApplicationDesc desc;
+		desc.Name = "SceneTests";
+		desc.NumWorkerThreads = 1;
+		return desc;
+	}
+}
+
+TEST(Scene, SystemsOnlySeeTheirScene)
+{
+	TestApplication app(SceneTestDesc());
+	Scene& scene = *app.GetScene();
+	Scene otherScene;
+	otherScene.GetSystemScheduler().AddSystem<ComponentUpdateSystem<TickCounter>>("Ticks");
+
+	auto object = std::make_shared<GameObject>();
+	scene.QueueGameObject(object);
+	auto counter = object->AddComponent<TickCounter>();
+
+	auto otherObject = std::make_shared<GameObject>();
+	otherScene.QueueGameObject(otherObject);
+	auto otherCounter = otherObject->AddComponent<TickCounter>();
+
+	app.RunFrame();
+	app.UpdateOtherScene(otherScene);
+
+	EXPECT_EQ(scene.GetComponentManager().GetComponents<TickCounter>().size(), 1u);
+	EXPECT_EQ(otherScene.GetComponentManager().GetComponents<TickCounter>().size(), 1u);
+	EXPECT_EQ(counter->GetComponentManager(), &scene.GetComponentManager());
+	EXPECT_EQ(otherCounter->GetComponentManager(), &otherScene.GetComponentManager());
+
+	// the system drives the family in the other scene only, each counter ticks once
+	EXPECT_TRUE(otherScene.GetSystemScheduler().IsSystemDriven(GetComponentTypeID<TickCounter>()));
+	EXPECT_FALSE(scene.GetSystemScheduler().IsSystemDriven(GetComponentTypeID<TickCounter>()));
+	EXPECT_EQ(counter->Ticks, 1u);
+	EXPECT_EQ(otherCounter->Ticks, 1u);
+}
+
+TEST(Scene, RemovedObjectsLeaveTheComponentSets)
+{
+	TestApplication app(SceneTestDesc());
+	Scene& scene = *app.GetScene();
+	const ComponentManager& components = scene.GetComponentManager();
+
+	auto parent = std::make_shared<GameObject>();
+	scene.QueueGameObject(parent);
+	auto parentTransform = parent->AddComponent<TransformComponent>();
+	auto child = parent->AddChild<GameObject>();
+	auto childTransform = child->AddComponent<TransformComponent>();
+
+	// queued objects are not placed yet
+	EXPECT_TRUE(components.GetComponents<TransformComponent>().empty());
+
+	app.RunFrame();
+	EXPECT_EQ(components.GetComponents<TransformComponent>().size(), 2u);
+
+	// components added or removed while placed follow right away
+	auto counter = child->AddComponent<TickCounter>();
+	EXPECT_EQ(components.GetComponents<TickCounter>().size(), 1u);
+	child->RemoveComponent(counter);
+	EXPECT_TRUE(components.GetComponents<TickCounter>().empty());
+	EXPECT_EQ(counter->GetComponentManager(), nullptr);
+
+	scene.RemoveGameObject(parent);
+	app.RunFrame();
+	EXPECT_TRUE(components.GetComponents<TransformComponent>().empty());
+	EXPECT_EQ(parentTransform->GetComponentManager(), nullptr);
+	EXPECT_EQ(childTransform->GetComponentManager(), nullptr);
+	EXPECT_EQ(parent->GetScene(), nullptr);
+	EXPECT_EQ(child->GetScene(), nullptr);
+}
+
+TEST(Scene, SharedMeshStaysWhileAnOwnerIsPlaced)
+{
+	TestApplication app(SceneTestDesc());
+	Scene& scene = *app.GetScene();
+	const ComponentManager& components = scene.GetComponentManager();
+
+	auto first = std::make_shared<GameObject>();
+	scene.QueueGameObject(first);
+	auto mesh = first->AddComponent<StaticMeshComponent>("SharedMesh");
+	auto second = std::make_shared<GameObject>();
+	scene.QueueGameObject(second);
+	ASSERT_EQ(second->AddComponent<StaticMeshComponent>("SharedMesh"), mesh);
+
+	app.RunFrame();
+	EXPECT_EQ(components.GetComponents<StaticMeshComponent>().size(), 1u);
+
+	scene.RemoveGameObject(first);
+	app.RunFrame();
+	EXPECT_EQ(components.GetComponents<StaticMeshComponent>().size(), 1u);
+
+	scene.RemoveGameObject(second);
+	app.RunFrame();
+	EXPECT_TRUE(components.GetComponents<StaticMeshComponent>().empty());
+}
+
+TEST(Scene, TransformsQueueWithTheirOwnScene)
+{
+	TestApplication app(SceneTestDesc());
+	Scene& scene = *app.GetScene();
+	Scene otherScene;
+
+	auto object = std::make_shared<GameObject>();
+	scene.QueueGameObject(object);
+	auto transform = object->AddComponent<TransformComponent>();
+
+	auto otherObject = std::make_shared<GameObject>();
+	otherScene.QueueGameObject(otherObject);
+	auto otherTransform = otherObject->AddComponent<TransformComponent>();
+
+	app.RunFrame();
+	app.UpdateOtherScene(otherScene);
+
+	// the application's scene updates first and must leave the other one's move queued
+	transform->SetLocalPosition({ 1.f, 0.f, 0.f });
+	otherTransform->SetLocalPosition({ 2.f, 0.f, 0.f });
+	app.RunFrame();
+	EXPECT_EQ(transform->GetWorldPosition().x, 1.f);
+	EXPECT_EQ(otherTransform->GetWorldPosition().x, 0.f);
+
+	app.UpdateOtherScene(otherScene);
+	EXPECT_EQ(otherTransform->GetWorldPosition().x, 2.f);
+}
+
+TEST(Scene, TransformsFollowReparentingInPlace)
+{
+	TestApplication app(SceneTestDesc());
+	Scene& scene = *app.GetScene();
+
+	auto first = std::make_shared<GameObject>();
+	scene.QueueGameObject(first);
+	first->AddComponent<TransformComponent>()->SetLocalPosition({ 1.f, 0.f, 0.f });
+	auto second = std::make_shared<GameObject>();
+	scene.QueueGameObject(second);
+	auto secondTransform = second->AddComponent<TransformComponent>();
+	secondTransform->SetLocalPosition({ 10.f, 0.f, 0.f });
+	auto child = first->AddChild<GameObject>();
+	auto childTransform = child->AddComponent<TransformComponent>();
+	childTransform->SetLocalPosition({ 1.f, 0.f, 0.f });
+
+	app.RunFrame();
+	EXPECT_EQ(scene.GetTransformHierarchy().GetEntryCount(), scene.GetUpdateOrder().size());
+	EXPECT_EQ(childTransform->GetWorldPosition().x, 2.f);
+
+	second->AddChild(child);
+	app.RunFrame();
+	EXPECT_EQ(childTransform->GetWorldPosition().x, 11.f);
+	// only the moved subtree is recomputed
+	EXPECT_EQ(scene.GetTransformHierarchy().GetUpdatedCount(), 1u);
+
+	// without its parent's transform the child composes like a root
+	second->RemoveComponent(secondTransform);
+	app.RunFrame();
+	EXPECT_EQ(childTransform->GetWorldPosition().x, 1.f);
+	EXPECT_EQ(secondTransform->GetWorldPosition().x, 10.f);
+
+	scene.RemoveGameObject(second);
+	app.RunFrame();
+	EXPECT_EQ(scene.GetTransformHierarchy().GetEntryCount(), scene.GetUpdateOrder().size());
+	// taken out of the scene the transform keeps its state
+	EXPECT_EQ(childTransform->GetWorldPosition().x, 1.f);
+	EXPECT_EQ(childTransform->GetLocalPosition().x, 1.f);
+}
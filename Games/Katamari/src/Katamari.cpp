@@ -5,7 +5,7 @@
 class KatamariApp : public Blainn::Application
 {
 public:
-	KatamariApp(HINSTANCE instance, const Blainn::ApplicationDesc& appDesc)
+	KatamariApp(Blainn::NativeInstanceHandle instance, const Blainn::ApplicationDesc& appDesc)
 		: Blainn::Application(instance, appDesc)
 	{}
 
@@ -15,8 +15,11 @@ public:
 	}
 };
 
-Blainn::Application* Blainn::CreateApplication(HINSTANCE hInstance)
+Blainn::Application* Blainn::CreateApplication(Blainn::NativeInstanceHandle instance)
 {
 	Blainn::ApplicationDesc appDesc{};
-	return new KatamariApp(hInstance, appDesc);
+	// rolling and pickups run at 60 Hz whatever the display does
+	appDesc.FixedTimestep = true;
+	appDesc.SimulationTickRate = 60.f;
+	return new KatamariApp(instance, appDesc);
 }
\ No newline at end of file
@@ -9,15 +9,19 @@
 #include "Components/ActorComponents/StaticMeshComponent.h"
 #include "Components/ActorComponents/TransformComponent.h"
 #include "Core/GameObject.h"
-#include "DX12/DXModel.h"
+#include "Platform/Platform.h"
 #include "Scene/Actor.h"
 
 #include "Player.h"
 
+#if defined(_WIN32)
+#include "DX12/DXModel.h"
+
 #include "dx12lib/Scene.h"
 #include "dx12lib/SceneNode.h"
 #include "dx12lib/Material.h"
 #include "dx12lib/Mesh.h"
+#endif
 
 using namespace Blainn;
 
@@ -28,20 +32,28 @@ KatamariLayer::KatamariLayer()
 
 void KatamariLayer::OnAttach()
 {
+	m_Scene->SetLayersCollide(PickupLayer, PickupLayer, false);
+	m_Scene->SetLayersCollide(PickupLayer, DefaultLayer, false);
+
 	auto player = std::make_shared<Player>();
 	//camera->AddComponent<PlayerInputComponent>();
 	m_Scene->QueueGameObject(player);
 	m_Scene->SetMainCamera(player->GetCameraComponent());
-	m_Scene->SetPlayerCollision(player->GetCollisionComponent());
 
 	auto plane = std::make_shared<Blainn::Actor>();
 	m_Scene->QueueGameObject(plane);
 	auto floorScene = plane->AddComponent<Blainn::StaticMeshComponent>("../../Resources/Models/plane/Plane.gltf");
-	dx12lib::MaterialProperties matProp = dx12lib::Material::Pearl;
-	//matProp.SpecularPower = 5.f;
-	//matProp.Ambient = DirectX::SimpleMath::Vector4(0.1f);
-	std::shared_ptr<dx12lib::Material> mat = std::make_shared<dx12lib::Material>(matProp);
-	floorScene->GetModel()->GetScene()->GetRootNode()->GetMesh()->SetMaterial(mat);
+#if defined(_WIN32)
+	// the plane is a single mesh, only models of the D3D12 backend have materials
+	if (auto floorModel = std::dynamic_pointer_cast<Blainn::DXModel>(floorScene->GetModel()))
+	{
+		dx12lib::MaterialProperties matProp = dx12lib::Material::Pearl;
+		//matProp.SpecularPower = 5.f;
+		//matProp.Ambient = DirectX::SimpleMath::Vector4(0.1f);
+		std::shared_ptr<dx12lib::Material> mat = std::make_shared<dx12lib::Material>(matProp);
+		floorModel->SetMaterial(0, mat);
+	}
+#endif
 
 	plane->GetComponent<TransformComponent>()->SetWorldPosition({ 0.f, -1.0f, 0.f });
 	plane->GetComponent<TransformComponent>()->SetWorldScale({ 100.f, 1.f, 100.f });
@@ -51,7 +63,7 @@ void KatamariLayer::OnAttach()
 	coolCube->AddComponent<Blainn::StaticMeshComponent>("../../Resources/Models/CoolTexturedCube.fbx");
 	coolCube->AddComponent<Blainn::TransformComponent>()->SetWorldPosition({ 0.f, 0.f, 5.f });
 	auto randomObjCol = coolCube->AddComponent<Blainn::SphereCollisionComponent>(1.f);
-	randomObjCol->SetCollisionCallback([](std::shared_ptr<CollisionComponent> other) { OutputDebugStringW(L"Colliding with the object\n"); });
+	randomObjCol->SetCollisionCallback([](std::shared_ptr<CollisionComponent> other) { Platform::DebugPrint("Colliding with the object\n"); });
 	//ball->GetComponent<TransformComponent>()->SetWorldScale({ 0.01f, 0.01f, 0.01f });
 	//coolCube->GetComponent<TransformComponent>()->SetWorldYawPitchRoll({ -90.0f, 0.0f, 180.0f });
 
@@ -104,7 +116,7 @@ void KatamariLayer::OnAttach()
 			auto ict = instancedCube->AddComponent<Blainn::TransformComponent>();
 			ict->SetWorldPosition({ float(i), 0.f, float(j)});
 			ict->SetWorldScale({ sin(float(i)/10.f) + 1.1f, sin(float(i)/10.f) + 1.1f, sin(float(i)/10.f) + 1.1f });
-			instancedCube->AddComponent<Blainn::SphereCollisionComponent>(0.3f);
+			instancedCube->AddComponent<Blainn::SphereCollisionComponent>(0.3f)->SetCollisionLayer(PickupLayer);
 			
 			if (j % 10 == 0)
 			{
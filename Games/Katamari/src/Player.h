@@ -13,6 +13,14 @@ namespace Blainn
 	class CameraComponent;
 }
 
+// Collision layers of the game, pickups only ever need to be tested against the player
+enum KatamariCollisionLayer : uint32_t
+{
+	DefaultLayer = 0,
+	PlayerLayer = 1,
+	PickupLayer = 2,
+};
+
 class Player : public Blainn::Actor
 {
 	using Super = Blainn::Actor;
@@ -31,6 +39,8 @@ public:
 		m_StaticMeshComponent = m_StaticMesh->AddComponent<Blainn::StaticMeshComponent>("../../Resources/Models/PlainCube.fbx");
 		m_StaticMesh->AddComponent<KatamariCubeInput>();
 		m_CollisionComponent = m_StaticMesh->AddComponent<Blainn::SphereCollisionComponent>(.5f);
+		m_CollisionComponent->SetCollisionLayer(PlayerLayer);
+		m_CollisionComponent->SetContinuous(true);
 
 		m_CollisionComponent->SetCollisionCallback([this, cameraInput](std::shared_ptr<Blainn::CollisionComponent> other)
 			{
@@ -57,22 +67,31 @@ public:
 				auto localOffset = DirectX::SimpleMath::Vector3::Transform(relativePos, thisWorldRot);
 				auto localRot = thisWorldRot * otherWorldRot;
 
-				otherOwner->RemoveComponent(other);
-				otherOwner->AttachTo(thisOwner->shared_from_this());
-				otherTransform->SetLocalPosition(localOffset);
-				otherTransform->SetLocalQuat(localRot);
-
-				auto sphereCollision = dynamic_cast<Blainn::SphereCollisionComponent*>(this->m_CollisionComponent.get());
-				if (sphereCollision)
-				{
-					float oldRadius = sphereCollision->GetRadius();
-					float newRadius = std::clamp(oldRadius + 0.05f, 0.f, 6.f);
-					sphereCollision->UpdateRadius(newRadius);
-				}
+				// reparenting and removing the collider are structural, they wait until
+				// every contact of this frame went out
+				auto attach = [this, cameraInput, other, otherOwner, thisOwner, otherTransform, localOffset, localRot]()
+					{
+						otherOwner->RemoveComponent(other);
+						otherOwner->AttachTo(thisOwner->shared_from_this());
+						otherTransform->SetLocalPosition(localOffset);
+						otherTransform->SetLocalQuat(localRot);
+
+						auto sphereCollision = dynamic_cast<Blainn::SphereCollisionComponent*>(this->m_CollisionComponent.get());
+						if (sphereCollision)
+						{
+							float oldRadius = sphereCollision->GetRadius();
+							float newRadius = std::clamp(oldRadius + 0.05f, 0.f, 6.f);
+							sphereCollision->UpdateRadius(newRadius);
+						}
 				
-				float oldCameraRadius = cameraInput->GetRadius();
-				float newCameraRadius = std::clamp(oldCameraRadius + 0.1f, 0.f, 25.f);
-				cameraInput->UpdateRadius(newCameraRadius);
+						float oldCameraRadius = cameraInput->GetRadius();
+						float newCameraRadius = std::clamp(oldCameraRadius + 0.1f, 0.f, 25.f);
+						cameraInput->UpdateRadius(newCameraRadius);
+					};
+				if (Blainn::Scene* scene = thisOwner->GetScene())
+					scene->Defer(attach);
+				else
+					attach();
 			});
 
 		Super::OnAttach();
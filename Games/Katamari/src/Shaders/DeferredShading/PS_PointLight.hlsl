@@ -2,6 +2,7 @@
 
 ConstantBuffer<PerPassData> PassCB : register( b0 );
 ConstantBuffer<PointLight> PointLightCB : register( b1, space1 );
+StructuredBuffer<PointLightInstance> LightInstancesSB : register( t0, space1 );
 
 Texture2D GBuffer_AlbedoOpacity		: register(t0);
 Texture2D GBuffer_Normal			: register(t1);
@@ -134,15 +135,15 @@ float3 DoLightingCalculation(
 	return (diffuseColor + specAlbedo) * lightStrength;
 }
 
-float4 PS_PointLight(float4 position : SV_Position, float2 screenUV : TEXCOORD0) : SV_Target
+float4 ShadePointLight(PointLight light, float2 screenUV)
 {
     // Fetch all necessary data for this pixel from the G-Buffer
     GBufferPixelData gbuffer = FetchGBufferData(screenUV);
 
-    float3 lightVec_WS = PointLightCB.PositionWS.xyz - gbuffer.PositionWS;
+    float3 lightVec_WS = light.PositionWS.xyz - gbuffer.PositionWS;
     float  distance = length(lightVec_WS);
 
-    if (distance > PointLightCB.Radius)
+    if (distance > light.Radius)
     {
         discard;
     }
@@ -153,12 +154,12 @@ float4 PS_PointLight(float4 position : SV_Position, float2 screenUV : TEXCOORD0)
 
     float3 N_WS = normalize(gbuffer.NormalWS); 
 
-    float attenuation = max(1.0f - distance / PointLightCB.Radius, 0);
+    float attenuation = max(1.0f - distance / light.Radius, 0);
     attenuation *= attenuation;
 
-    //attenuation *= saturate(1.0 - pow(distance / PointLightCB.Radius, 2.0));
+    //attenuation *= saturate(1.0 - pow(distance / light.Radius, 2.0));
 
-    float3 lightStrength = PointLightCB.Color.rgb * attenuation;
+    float3 lightStrength = light.Color.rgb * attenuation;
 
     float3 finalLightColor = DoLightingCalculation(
                                 lightStrength,
@@ -170,4 +171,15 @@ float4 PS_PointLight(float4 position : SV_Position, float2 screenUV : TEXCOORD0)
                                 gbuffer.Albedo);
 
     return float4(finalLightColor, 1.0);
-}
\ No newline at end of file
+}
+
+float4 PS_PointLight(float4 position : SV_Position, float2 screenUV : TEXCOORD0) : SV_Target
+{
+    return ShadePointLight(PointLightCB, screenUV);
+}
+
+float4 PS_PointLightInstanced(float4 position : SV_Position, float2 screenUV : TEXCOORD0,
+    nointerpolation uint instanceID : INSTANCEID) : SV_Target
+{
+    return ShadePointLight(LightInstancesSB[instanceID].Light, screenUV);
+}
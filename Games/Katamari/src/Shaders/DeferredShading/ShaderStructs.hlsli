@@ -59,6 +59,13 @@ struct PointLight
     // Total:                              16 * 5 = 80 bytes
 };
 
+// One light of a batched point light pass
+struct PointLightInstance
+{
+    float4x4 World; // Light volume
+    PointLight Light;
+};
+
 struct SpotLight
 {
     float4 PositionWS; // Light position in world space.
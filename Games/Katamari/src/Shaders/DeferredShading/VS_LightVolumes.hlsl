@@ -48,3 +48,31 @@ VertexShaderOutput VS_LightVolume(VertexPosition IN : POSITION)
 	return OUT;
 }
 
+// Laid out like PointLightInstance, the light itself is only read by the pixel shader
+struct LightVolumeInstance
+{
+	float4x4 World;
+	float4 Light[5];
+};
+
+StructuredBuffer<LightVolumeInstance> LightInstancesSB : register(t0, space1);
+
+struct InstancedVertexShaderOutput
+{
+	float4 PositionH : SV_POSITION;
+	float2 ScreenUV : TEXCOORD0;
+	nointerpolation uint InstanceID : INSTANCEID;
+};
+
+InstancedVertexShaderOutput VS_LightVolumeInstanced(VertexPosition IN, uint instanceID : SV_InstanceID)
+{
+	InstancedVertexShaderOutput OUT;
+
+	float4 worldPos = mul(float4(IN.PositionOS, 1.0f), LightInstancesSB[instanceID].World);
+	OUT.PositionH = mul(worldPos, PerPassCB.ViewProj);
+	OUT.ScreenUV = OUT.PositionH.xy / OUT.PositionH.w; // Get NDC
+	OUT.ScreenUV = OUT.ScreenUV * float2(0.5f, -0.5f) + 0.5f; // Map to [0,1] and flip Y
+	OUT.InstanceID = instanceID;
+
+	return OUT;
+}
@@ -8,8 +8,8 @@ namespace Pong
 	class PongApplication : public Blainn::Application
 	{
 	public:
-		PongApplication(HINSTANCE hInstance, const Blainn::ApplicationDesc& appDesc)
-			: Application(hInstance, appDesc)
+		PongApplication(Blainn::NativeInstanceHandle instance, const Blainn::ApplicationDesc& appDesc)
+			: Application(instance, appDesc)
 		{
 
 		}
@@ -24,7 +24,7 @@ namespace Pong
 	};
 }
 
-Blainn::Application* Blainn::CreateApplication(HINSTANCE hInstance)
+Blainn::Application* Blainn::CreateApplication(Blainn::NativeInstanceHandle instance)
 {
 	ApplicationDesc appDesc{};
 	appDesc.Fullscreen = false;
@@ -32,5 +32,5 @@ Blainn::Application* Blainn::CreateApplication(HINSTANCE hInstance)
 	appDesc.WindowHeight = 600;
 	appDesc.WindowWidth = 800;
 	
-	return new Pong::PongApplication(hInstance, appDesc);
+	return new Pong::PongApplication(instance, appDesc);
 }
\ No newline at end of file
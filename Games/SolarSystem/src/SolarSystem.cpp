@@ -8,7 +8,7 @@ namespace solar
 	class SolarSystemApp : public Blainn::Application
 	{
 	public:
-		SolarSystemApp(HINSTANCE instance, const Blainn::ApplicationDesc& appDesc)
+		SolarSystemApp(Blainn::NativeInstanceHandle instance, const Blainn::ApplicationDesc& appDesc)
 			: Blainn::Application(instance, appDesc)
 		{
 
@@ -23,12 +23,12 @@ namespace solar
 
 }
 
-Blainn::Application* Blainn::CreateApplication(HINSTANCE hInstance)
+Blainn::Application* Blainn::CreateApplication(Blainn::NativeInstanceHandle instance)
 {
 	Blainn::ApplicationDesc appDesc;
 	appDesc.WindowWidth = 800;
 	appDesc.WindowHeight = 600;
 	appDesc.Name = "Solar System";
 
-	return new solar::SolarSystemApp(hInstance, appDesc);
+	return new solar::SolarSystemApp(instance, appDesc);
 }
\ No newline at end of file